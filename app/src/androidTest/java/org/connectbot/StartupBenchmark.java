@@ -0,0 +1,96 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot;
+
+import org.connectbot.bean.HostBean;
+import org.connectbot.util.HostDatabase;
+import org.connectbot.util.StartupTrace;
+import org.junit.Before;
+import org.junit.Rule;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import android.content.Context;
+import android.content.Intent;
+import android.os.SystemClock;
+import android.util.Log;
+import androidx.test.core.app.ApplicationProvider;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+import androidx.test.rule.ActivityTestRule;
+
+import static androidx.test.espresso.Espresso.onView;
+import static androidx.test.espresso.action.ViewActions.click;
+import static androidx.test.espresso.contrib.RecyclerViewActions.actionOnHolderItem;
+import static androidx.test.espresso.matcher.ViewMatchers.withId;
+import static org.connectbot.ConnectbotMatchers.withHostNickname;
+import static org.junit.Assert.assertTrue;
+
+/**
+ * Measures the startup milestones {@link StartupTrace} records: time from
+ * launching the host list until it shows the hosts, and until the first
+ * connection, to a local shell, is up. Only the first launch in a process
+ * includes opening the databases, so run this on its own for cold numbers.
+ * Results are written to logcat under CB.StartupBench.
+ */
+@RunWith(AndroidJUnit4.class)
+public class StartupBenchmark {
+	private static final String TAG = "CB.StartupBench";
+
+	private static final String NICKNAME = "Bench";
+
+	private static final long TIMEOUT_MILLIS = 30000L;
+
+	@Rule
+	public final ActivityTestRule<HostListActivity> mActivityRule = new ActivityTestRule<>(
+			HostListActivity.class, false, false);
+
+	@Before
+	public void setUp() {
+		Context context = ApplicationProvider.getApplicationContext();
+		HostDatabase.resetInMemoryInstance(context);
+
+		HostBean host = new HostBean();
+		host.setProtocol("local");
+		host.setNickname(NICKNAME);
+		HostDatabase.get(context).saveHost(host);
+
+		StartupTrace.reset();
+	}
+
+	@Test
+	public void timeToHostListAndFirstConnect() {
+		mActivityRule.launchActivity(new Intent());
+		long hostList = awaitMilestone(StartupTrace.HOST_LIST_SHOWN);
+
+		onView(withId(R.id.list)).perform(actionOnHolderItem(withHostNickname(NICKNAME), click()));
+		long firstConnect = awaitMilestone(StartupTrace.FIRST_CONNECT);
+
+		Log.i(TAG, String.format("Time to host list: %d ms, to first connect: %d ms",
+				hostList, firstConnect));
+	}
+
+	private static long awaitMilestone(String milestone) {
+		long deadline = SystemClock.elapsedRealtime() + TIMEOUT_MILLIS;
+		long elapsed;
+		while ((elapsed = StartupTrace.getElapsed(milestone)) < 0
+				&& SystemClock.elapsedRealtime() < deadline)
+			SystemClock.sleep(10);
+
+		assertTrue("never reached " + milestone, elapsed >= 0);
+		return elapsed;
+	}
+}
@@ -0,0 +1,110 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import android.graphics.Bitmap;
+import android.graphics.Canvas;
+import android.graphics.Color;
+import android.graphics.Paint;
+import android.graphics.Typeface;
+import android.util.Log;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+/**
+ * Times a full-screen repaint of a 300x100 cell terminal, drawn the way
+ * {@link TerminalBridge} draws rows, with one to all available cores.
+ * Results are written to logcat under CB.RowRenderBench.
+ */
+@RunWith(AndroidJUnit4.class)
+public class RowRenderPoolBenchmark {
+	private static final String TAG = "CB.RowRenderBench";
+
+	private static final int COLUMNS = 300;
+	private static final int ROWS = 100;
+	private static final int RUN_LENGTH = 12;
+	private static final int WARMUP_FRAMES = 3;
+	private static final int FRAMES = 10;
+
+	@Test
+	public void fullRepaintVersusCoreCount() {
+		final Paint template = new Paint();
+		template.setAntiAlias(true);
+		template.setTypeface(Typeface.MONOSPACE);
+		template.setTextSize(12f);
+
+		Paint.FontMetrics fm = template.getFontMetrics();
+		final int charTop = (int) Math.ceil(fm.top);
+		final int charHeight = (int) Math.ceil(fm.descent - fm.top);
+		final int charWidth = (int) Math.ceil(template.measureText("X"));
+
+		final char[][] text = new char[ROWS][COLUMNS];
+		for (int r = 0; r < ROWS; r++)
+			for (int c = 0; c < COLUMNS; c++)
+				text[r][c] = (char) ('!' + (r * 7 + c * 13) % 94);
+
+		Bitmap bitmap = Bitmap.createBitmap(COLUMNS * charWidth, ROWS * charHeight,
+				Bitmap.Config.ARGB_8888);
+
+		// Same clip, fill and drawText sequence as TerminalBridge.drawRow,
+		// with a color change every RUN_LENGTH cells.
+		RowRenderPool.RowPainter painter = new RowRenderPool.RowPainter() {
+			@Override
+			public void paintRow(Canvas canvas, Paint paint, int row) {
+				for (int c = 0; c < COLUMNS; c += RUN_LENGTH) {
+					int run = Math.min(RUN_LENGTH, COLUMNS - c);
+					canvas.save();
+					canvas.clipRect(c * charWidth, row * charHeight,
+							(c + run) * charWidth, (row + 1) * charHeight);
+					paint.setColor(Color.BLACK);
+					canvas.drawPaint(paint);
+					paint.setColor((c / RUN_LENGTH) % 2 == 0 ? Color.WHITE : Color.GREEN);
+					canvas.drawText(text[row], c, run, c * charWidth,
+							row * charHeight - charTop, paint);
+					canvas.restore();
+				}
+			}
+		};
+
+		int[] rows = new int[ROWS];
+		for (int i = 0; i < ROWS; i++)
+			rows[i] = i;
+
+		int cores = Runtime.getRuntime().availableProcessors();
+		for (int threads = 1; threads <= cores; threads++) {
+			RowRenderPool pool = new RowRenderPool(threads);
+			try {
+				for (int i = 0; i < WARMUP_FRAMES; i++)
+					pool.render(bitmap, template, rows, ROWS, painter);
+
+				long start = System.nanoTime();
+				for (int i = 0; i < FRAMES; i++)
+					pool.render(bitmap, template, rows, ROWS, painter);
+				long perFrameMicros = (System.nanoTime() - start) / FRAMES / 1000;
+
+				Log.i(TAG, String.format("%dx%d full repaint on %d thread(s): %.2f ms",
+						COLUMNS, ROWS, threads, perFrameMicros / 1000.0));
+			} finally {
+				pool.shutdown();
+			}
+		}
+
+		bitmap.recycle();
+	}
+}
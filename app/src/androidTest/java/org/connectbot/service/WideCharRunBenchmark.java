@@ -0,0 +1,121 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import android.graphics.Bitmap;
+import android.graphics.Canvas;
+import android.graphics.Color;
+import android.graphics.Paint;
+import android.graphics.Typeface;
+import android.util.Log;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+/**
+ * Times a full repaint of an 80x24 screen of CJK text drawn one wide
+ * character at a time, as {@link TerminalBridge} used to, against runs
+ * drawn with {@link WideCharRun}. Results are written to logcat under
+ * CB.WideCharBench.
+ */
+@RunWith(AndroidJUnit4.class)
+public class WideCharRunBenchmark {
+	private static final String TAG = "CB.WideCharBench";
+
+	private static final int COLUMNS = 80;
+	private static final int ROWS = 24;
+	private static final int WARMUP_FRAMES = 5;
+	private static final int FRAMES = 50;
+
+	private char[][] text;
+	private int charWidth, charHeight, charTop;
+
+	@Test
+	public void cjkRepaint() {
+		Paint paint = new Paint();
+		paint.setAntiAlias(true);
+		paint.setTypeface(Typeface.MONOSPACE);
+		paint.setTextSize(24f);
+
+		Paint.FontMetrics fm = paint.getFontMetrics();
+		charTop = (int) Math.ceil(fm.top);
+		charHeight = (int) Math.ceil(fm.descent - fm.top);
+		charWidth = (int) Math.ceil(paint.measureText("X"));
+
+		// Wide characters followed by their padding cell, as vt320 stores them.
+		text = new char[ROWS][COLUMNS];
+		for (int r = 0; r < ROWS; r++) {
+			for (int c = 0; c < COLUMNS; c += 2) {
+				text[r][c] = (char) (0x4e00 + (r * 31 + c * 17) % 0x5000);
+				text[r][c + 1] = ' ';
+			}
+		}
+
+		Bitmap bitmap = Bitmap.createBitmap(COLUMNS * charWidth, ROWS * charHeight,
+				Bitmap.Config.ARGB_8888);
+		Canvas canvas = new Canvas(bitmap);
+
+		for (int i = 0; i < WARMUP_FRAMES; i++) {
+			drawPerCharacter(canvas, paint);
+			drawRuns(canvas, paint);
+		}
+
+		long start = System.nanoTime();
+		for (int i = 0; i < FRAMES; i++)
+			drawPerCharacter(canvas, paint);
+		long perCharacterMicros = (System.nanoTime() - start) / FRAMES / 1000;
+
+		start = System.nanoTime();
+		for (int i = 0; i < FRAMES; i++)
+			drawRuns(canvas, paint);
+		long runMicros = (System.nanoTime() - start) / FRAMES / 1000;
+
+		Log.i(TAG, String.format("%dx%d CJK repaint: per character %.2f ms, batched runs %.2f ms",
+				COLUMNS, ROWS, perCharacterMicros / 1000.0, runMicros / 1000.0));
+
+		bitmap.recycle();
+	}
+
+	private void drawPerCharacter(Canvas canvas, Paint paint) {
+		for (int l = 0; l < ROWS; l++) {
+			for (int c = 0; c < COLUMNS; c += 2) {
+				canvas.save();
+				paint.setColor(Color.BLACK);
+				canvas.clipRect(c * charWidth, l * charHeight,
+						(c + 2) * charWidth, (l + 1) * charHeight);
+				canvas.drawPaint(paint);
+				paint.setColor(Color.WHITE);
+				canvas.drawText(text[l], c, 1, c * charWidth, l * charHeight - charTop, paint);
+				canvas.restore();
+			}
+		}
+	}
+
+	private void drawRuns(Canvas canvas, Paint paint) {
+		for (int l = 0; l < ROWS; l++) {
+			canvas.save();
+			paint.setColor(Color.BLACK);
+			canvas.clipRect(0, l * charHeight, COLUMNS * charWidth, (l + 1) * charHeight);
+			canvas.drawPaint(paint);
+			paint.setColor(Color.WHITE);
+			WideCharRun.draw(canvas, paint, text[l], 0, COLUMNS,
+					0, l * charHeight - charTop, charWidth);
+			canvas.restore();
+		}
+	}
+}
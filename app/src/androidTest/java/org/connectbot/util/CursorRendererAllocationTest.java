@@ -0,0 +1,106 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import org.connectbot.service.TerminalKeyListener;
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import android.graphics.Bitmap;
+import android.graphics.Canvas;
+import android.graphics.Color;
+import android.os.Debug;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+
+/**
+ * Draws the cursor the way {@link org.connectbot.TerminalView#onDraw} does
+ * for every frame and checks that none of it allocates once warmed up.
+ */
+@RunWith(AndroidJUnit4.class)
+@SuppressWarnings("deprecation") // allocation counting is all we need here
+public class CursorRendererAllocationTest {
+	private static final int CHAR_WIDTH = 12;
+	private static final int CHAR_HEIGHT = 24;
+	private static final int FRAMES = 200;
+
+	private static final int[] META_STATES = {
+			0,
+			TerminalKeyListener.OUR_SHIFT_ON,
+			TerminalKeyListener.OUR_ALT_LOCK | TerminalKeyListener.OUR_CTRL_ON,
+	};
+
+	private Bitmap screen;
+	private Bitmap target;
+	private Canvas canvas;
+	private CursorRenderer renderer;
+
+	@Before
+	public void setUp() {
+		screen = Bitmap.createBitmap(80 * CHAR_WIDTH, 24 * CHAR_HEIGHT, Bitmap.Config.ARGB_8888);
+		screen.eraseColor(Color.BLUE);
+		target = Bitmap.createBitmap(screen.getWidth(), screen.getHeight(), Bitmap.Config.ARGB_8888);
+		canvas = new Canvas(target);
+
+		renderer = new CursorRenderer(Color.WHITE);
+		renderer.setCharSize(CHAR_WIDTH, CHAR_HEIGHT);
+	}
+
+	@After
+	public void tearDown() {
+		screen.recycle();
+		target.recycle();
+	}
+
+	private void drawFrame(int frame) {
+		int x = (frame % 80) * CHAR_WIDTH;
+		int y = (frame % 24) * CHAR_HEIGHT;
+		canvas.drawBitmap(screen, 0, 0, null);
+		renderer.draw(canvas, screen, x, y, CHAR_WIDTH * (frame % 2 + 1), CHAR_HEIGHT,
+				META_STATES[frame % META_STATES.length], frame % 5 == 0 ? '`' : 0);
+		renderer.drawSelection(canvas, 0, 0, 10 * CHAR_WIDTH, 2 * CHAR_HEIGHT);
+	}
+
+	@Test
+	public void cursorFramesDoNotAllocate() {
+		for (int i = 0; i < FRAMES; i++)
+			drawFrame(i);
+
+		Debug.resetThreadAllocCount();
+		Debug.startAllocCounting();
+		try {
+			for (int i = 0; i < FRAMES; i++)
+				drawFrame(i);
+		} finally {
+			Debug.stopAllocCounting();
+		}
+
+		assertEquals(0, Debug.getThreadAllocCount());
+	}
+
+	@Test
+	public void cursorIsInverted() {
+		canvas.drawBitmap(screen, 0, 0, null);
+		renderer.draw(canvas, screen, CHAR_WIDTH, CHAR_HEIGHT, CHAR_WIDTH, CHAR_HEIGHT, 0, 0);
+
+		assertEquals(Color.YELLOW, target.getPixel(CHAR_WIDTH + CHAR_WIDTH / 2, CHAR_HEIGHT + CHAR_HEIGHT / 2));
+		assertEquals(Color.BLUE, target.getPixel(CHAR_WIDTH / 2, CHAR_HEIGHT / 2));
+	}
+}
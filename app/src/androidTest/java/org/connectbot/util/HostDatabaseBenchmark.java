@@ -0,0 +1,114 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import org.connectbot.bean.HostBean;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import android.content.Context;
+import android.util.Log;
+import androidx.test.core.app.ApplicationProvider;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+import androidx.test.platform.app.InstrumentationRegistry;
+
+/**
+ * Times how long the UI thread spends in the host database for what a
+ * session typically writes: a connect, a burst of zoom steps and a few
+ * color changes. Each call is measured once followed by a flush of the
+ * {@link DatabaseWriter}, which costs what the synchronous writes used to,
+ * and once only queued. Results are written to logcat under CB.DbWriteBench.
+ */
+@RunWith(AndroidJUnit4.class)
+public class HostDatabaseBenchmark {
+	private static final String TAG = "CB.DbWriteBench";
+
+	private static final int ZOOM_STEPS = 10;
+	private static final int COLORS = 4;
+	private static final int WARMUP_SESSIONS = 3;
+	private static final int SESSIONS = 20;
+
+	private HostDatabase hostdb;
+	private HostBean host;
+
+	@Before
+	public void setUp() {
+		Context context = ApplicationProvider.getApplicationContext();
+		hostdb = HostDatabase.get(context);
+		hostdb.resetDatabase();
+
+		host = new HostBean("bench", "ssh", "user", "example.com", 22);
+		hostdb.saveHost(host);
+	}
+
+	@Test
+	public void synchronousVersusQueued() {
+		for (int i = 0; i < WARMUP_SESSIONS; i++) {
+			timeSessionOnMainThread(true);
+			timeSessionOnMainThread(false);
+		}
+
+		long synchronousNanos = 0;
+		long queuedNanos = 0;
+		for (int i = 0; i < SESSIONS; i++) {
+			synchronousNanos += timeSessionOnMainThread(true);
+			queuedNanos += timeSessionOnMainThread(false);
+			DatabaseWriter.get().flush();
+		}
+
+		int calls = 1 + ZOOM_STEPS + COLORS;
+		Log.i(TAG, String.format("UI thread time per session of %d writes: synchronous %.2f ms, queued %.2f ms",
+				calls, synchronousNanos / SESSIONS / 1e6, queuedNanos / SESSIONS / 1e6));
+
+		hostdb.resetDatabase();
+	}
+
+	private long timeSessionOnMainThread(final boolean synchronous) {
+		final long[] elapsed = new long[1];
+		InstrumentationRegistry.getInstrumentation().runOnMainSync(new Runnable() {
+			@Override
+			public void run() {
+				long start = System.nanoTime();
+				runSession(synchronous);
+				elapsed[0] = System.nanoTime() - start;
+			}
+		});
+		return elapsed[0];
+	}
+
+	private void runSession(boolean synchronous) {
+		DatabaseWriter writer = DatabaseWriter.get();
+
+		hostdb.touchHost(host);
+		if (synchronous)
+			writer.flush();
+
+		for (int i = 0; i < ZOOM_STEPS; i++) {
+			host.setFontSize(8 + i);
+			hostdb.saveHost(host);
+			if (synchronous)
+				writer.flush();
+		}
+
+		for (int i = 0; i < COLORS; i++) {
+			hostdb.setGlobalColor(i, 0xff000000 | (i * 0x111111));
+			if (synchronous)
+				writer.flush();
+		}
+	}
+}
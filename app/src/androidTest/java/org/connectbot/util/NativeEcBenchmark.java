@@ -0,0 +1,99 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import java.math.BigInteger;
+import java.security.KeyPair;
+import java.security.KeyPairGenerator;
+import java.security.interfaces.ECPrivateKey;
+import java.security.interfaces.ECPublicKey;
+import java.security.spec.ECParameterSpec;
+import java.security.spec.ECPoint;
+
+import org.junit.Test;
+import org.junit.runner.RunWith;
+import org.keyczar.jce.EcCore;
+
+import android.util.Log;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assume.assumeTrue;
+
+/**
+ * Times public key recovery for EC keys on each curve with
+ * {@link NativeEc} and with {@link EcCore}, checking that both agree with
+ * the key pair generator. Results are written to logcat under
+ * CB.NativeEcBench.
+ */
+@RunWith(AndroidJUnit4.class)
+public class NativeEcBenchmark {
+	private static final String TAG = "CB.NativeEcBench";
+
+	private static final int[] CURVE_BITS = { 256, 384, 521 };
+	private static final int KEYS = 5;
+	private static final int ITERATIONS = 20;
+
+	@Test
+	public void nativeVersusEcCorePerCurve() throws Exception {
+		assumeTrue(NativeEc.isAvailable());
+
+		for (int bits : CURVE_BITS) {
+			KeyPairGenerator generator = KeyPairGenerator.getInstance("EC");
+			generator.initialize(bits);
+
+			KeyPair[] pairs = new KeyPair[KEYS];
+			for (int i = 0; i < KEYS; i++)
+				pairs[i] = generator.generateKeyPair();
+
+			// Both must give the public key that came with the pair; this
+			// also builds the native table before timing.
+			for (KeyPair pair : pairs) {
+				ECPoint expected = ((ECPublicKey) pair.getPublic()).getW();
+				ECPrivateKey priv = (ECPrivateKey) pair.getPrivate();
+				ECPoint w = NativeEc.multiplyGenerator(priv.getParams(), priv.getS());
+				assertNotNull(w);
+				assertEquals(expected, w);
+				assertEquals(expected, recoverWithEcCore(priv));
+			}
+
+			long start = System.nanoTime();
+			for (int i = 0; i < ITERATIONS; i++) {
+				ECPrivateKey priv = (ECPrivateKey) pairs[i % KEYS].getPrivate();
+				NativeEc.multiplyGenerator(priv.getParams(), priv.getS());
+			}
+			long nativeMicros = (System.nanoTime() - start) / ITERATIONS / 1000;
+
+			start = System.nanoTime();
+			for (int i = 0; i < ITERATIONS; i++)
+				recoverWithEcCore((ECPrivateKey) pairs[i % KEYS].getPrivate());
+			long ecCoreMicros = (System.nanoTime() - start) / ITERATIONS / 1000;
+
+			Log.i(TAG, String.format("P-%d public key: native %.2f ms, EcCore %.2f ms",
+					bits, nativeMicros / 1000.0, ecCoreMicros / 1000.0));
+		}
+	}
+
+	private static ECPoint recoverWithEcCore(ECPrivateKey priv) {
+		ECParameterSpec params = priv.getParams();
+		ECPoint g = params.getGenerator();
+		BigInteger[] w = EcCore.multiplyPointA(new BigInteger[] { g.getAffineX(), g.getAffineY() },
+				priv.getS(), params);
+		return new ECPoint(w[0], w[1]);
+	}
+}
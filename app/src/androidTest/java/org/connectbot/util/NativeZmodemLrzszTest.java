@@ -0,0 +1,245 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import java.io.ByteArrayOutputStream;
+import java.io.File;
+import java.io.FileDescriptor;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.util.Random;
+
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import com.google.ase.Exec;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static androidx.test.InstrumentationRegistry.getInstrumentation;
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertTrue;
+import static org.junit.Assume.assumeTrue;
+
+/**
+ * Transfers files between {@link NativeZmodem} and lrzsz's sz and rz running
+ * on a PTY, the way they would run on a remote host. Skipped unless the
+ * binaries have been pushed to /data/local/tmp or are part of the system.
+ */
+@RunWith(AndroidJUnit4.class)
+public class NativeZmodemLrzszTest {
+	private static final String SHELL = "/system/bin/sh";
+	private static final String[] SEARCH_PATH = {
+			"/data/local/tmp", "/system/xbin", "/system/bin" };
+
+	private static final int FILE_SIZE = 300000;
+
+	private File directory;
+	private byte[] contents;
+
+	@Before
+	public void setUp() {
+		assumeTrue(NativeZmodem.isAvailable());
+
+		directory = new File(getInstrumentation().getTargetContext().getCacheDir(), "zmodem");
+		directory.mkdirs();
+		for (File file : directory.listFiles())
+			file.delete();
+
+		// Every byte value, so the escaping gets exercised.
+		contents = new byte[FILE_SIZE];
+		new Random(42).nextBytes(contents);
+	}
+
+	@Test(timeout = 60000)
+	public void receivesFromSz() throws Exception {
+		File sz = find("sz");
+		assumeTrue(sz != null);
+
+		File source = new File(directory, "from-sz.bin");
+		write(source, contents);
+
+		int[] pid = new int[1];
+		FileDescriptor pty = Exec.createSubprocess(SHELL, "-c",
+				"cd " + directory + " && exec " + sz + " -b " + source.getName(), pid);
+		TestHost host = new TestHost(pty, null);
+		NativeZmodem session = run(host, pty);
+
+		assertTrue(session.isSucceeded());
+		assertEquals("from-sz.bin", host.receivedName);
+		assertEquals(FILE_SIZE, host.receivedSize);
+		assertArrayEquals(contents, host.received.toByteArray());
+		assertTrue(host.receivedComplete);
+		assertEquals(0, Exec.waitFor(pid[0]));
+	}
+
+	@Test(timeout = 60000)
+	public void sendsToRz() throws Exception {
+		File rz = find("rz");
+		assumeTrue(rz != null);
+
+		int[] pid = new int[1];
+		FileDescriptor pty = Exec.createSubprocess(SHELL, "-c",
+				"cd " + directory + " && exec " + rz + " -b", pid);
+		TestHost host = new TestHost(pty, "to-rz.bin");
+		NativeZmodem session = run(host, pty);
+
+		assertTrue(session.isSucceeded());
+		assertTrue(host.sentComplete);
+		assertEquals(0, Exec.waitFor(pid[0]));
+		assertArrayEquals(contents, read(new File(directory, "to-rz.bin")));
+	}
+
+	/**
+	 * Wait for the ZMODEM start from the program on {@code pty} and run the
+	 * session to its end.
+	 */
+	private NativeZmodem run(TestHost host, FileDescriptor pty) throws IOException {
+		FileInputStream in = new FileInputStream(pty);
+		byte[] buffer = new byte[16384];
+		byte[] start = NativeZmodem.START;
+
+		// Skip whatever comes before the session, e.g. "rz\r" from sz.
+		int matched = 0;
+		while (matched < start.length) {
+			int b = in.read();
+			assertTrue("program exited before starting ZMODEM", b >= 0);
+			if (b == start[matched])
+				matched++;
+			else if (b != start[0])
+				matched = 0;
+			else if (matched != 2)
+				matched = 1;
+		}
+
+		NativeZmodem session = new NativeZmodem(host);
+		try {
+			session.feed(start, 0, start.length);
+			while (!session.isFinished()) {
+				while (!session.isFinished() && session.pump()) {
+					// keep the window full
+				}
+				if (session.isFinished())
+					break;
+
+				int n = in.read(buffer);
+				assertTrue("program exited during the session", n >= 0);
+				session.feed(buffer, 0, n);
+			}
+			return session;
+		} finally {
+			session.destroy();
+		}
+	}
+
+	private File find(String program) {
+		for (String path : SEARCH_PATH) {
+			File file = new File(path, program);
+			if (file.canExecute())
+				return file;
+		}
+		return null;
+	}
+
+	private static void write(File file, byte[] data) throws IOException {
+		FileOutputStream out = new FileOutputStream(file);
+		try {
+			out.write(data);
+		} finally {
+			out.close();
+		}
+	}
+
+	private static byte[] read(File file) throws IOException {
+		RandomAccessFile in = new RandomAccessFile(file, "r");
+		try {
+			byte[] data = new byte[(int) in.length()];
+			in.readFully(data);
+			return data;
+		} finally {
+			in.close();
+		}
+	}
+
+	private class TestHost implements NativeZmodem.Host {
+		private final FileOutputStream out;
+		private String toSend;
+
+		String receivedName;
+		long receivedSize;
+		boolean receivedComplete;
+		final ByteArrayOutputStream received = new ByteArrayOutputStream();
+
+		boolean sentComplete;
+
+		TestHost(FileDescriptor pty, String toSend) {
+			out = new FileOutputStream(pty);
+			this.toSend = toSend;
+		}
+
+		@Override
+		public void write(byte[] data) throws IOException {
+			out.write(data);
+		}
+
+		@Override
+		public boolean openReceived(String name, long size) {
+			receivedName = name;
+			receivedSize = size;
+			return true;
+		}
+
+		@Override
+		public boolean writeReceived(byte[] data, int length) {
+			received.write(data, 0, length);
+			return true;
+		}
+
+		@Override
+		public void closeReceived(boolean complete) {
+			receivedComplete = complete;
+		}
+
+		@Override
+		public String nextToSend() {
+			String name = toSend;
+			toSend = null;
+			return name;
+		}
+
+		@Override
+		public long sizeToSend() {
+			return contents.length;
+		}
+
+		@Override
+		public int readToSend(long offset, byte[] data, int length) {
+			int n = (int) Math.min(length, contents.length - offset);
+			System.arraycopy(contents, (int) offset, data, 0, n);
+			return n;
+		}
+
+		@Override
+		public void closeSent(boolean complete) {
+			sentComplete = complete;
+		}
+	}
+}
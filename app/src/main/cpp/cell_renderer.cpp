@@ -0,0 +1,221 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cell_renderer.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CONNECTBOT_NEON 1
+#endif
+
+namespace connectbot {
+
+namespace {
+
+// Exact round(x / 255) for x <= 255 * 255, the same in every code path.
+inline uint32_t Div255(uint32_t x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+}  // namespace
+
+void BlendSpanScalar(uint32_t* dst, const uint8_t* coverage, int n,
+                     uint32_t fg, uint32_t bg) {
+  for (int i = 0; i < n; i++) {
+    uint32_t a = coverage[i];
+    uint32_t inv = 255 - a;
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+      uint32_t f = (fg >> shift) & 0xff;
+      uint32_t b = (bg >> shift) & 0xff;
+      out |= Div255(f * a + b * inv) << shift;
+    }
+    dst[i] = out;
+  }
+}
+
+#if defined(__SSE2__)
+
+namespace {
+
+// Blends two pixels held as 8 x u16 channels.
+inline __m128i Blend2(__m128i a, __m128i fg16, __m128i bg16) {
+  const __m128i k255 = _mm_set1_epi16(255);
+  const __m128i k128 = _mm_set1_epi16(128);
+  __m128i x = _mm_add_epi16(_mm_mullo_epi16(fg16, a),
+                            _mm_mullo_epi16(bg16, _mm_sub_epi16(k255, a)));
+  x = _mm_add_epi16(x, k128);
+  x = _mm_add_epi16(x, _mm_srli_epi16(x, 8));
+  return _mm_srli_epi16(x, 8);
+}
+
+}  // namespace
+
+void BlendSpan(uint32_t* dst, const uint8_t* coverage, int n, uint32_t fg,
+               uint32_t bg) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i fg16 = _mm_unpacklo_epi8(_mm_set1_epi32(fg), zero);
+  const __m128i bg16 = _mm_unpacklo_epi8(_mm_set1_epi32(bg), zero);
+
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    uint32_t a4;
+    memcpy(&a4, coverage + i, sizeof(a4));
+    if (a4 == 0) {
+      __m128i px = _mm_set1_epi32(bg);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), px);
+      continue;
+    }
+
+    // Spread each coverage byte across the four channels of its pixel.
+    __m128i a = _mm_cvtsi32_si128(a4);
+    a = _mm_unpacklo_epi8(a, a);
+    a = _mm_unpacklo_epi16(a, a);
+    __m128i lo = Blend2(_mm_unpacklo_epi8(a, zero), fg16, bg16);
+    __m128i hi = Blend2(_mm_unpackhi_epi8(a, zero), fg16, bg16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(lo, hi));
+  }
+  BlendSpanScalar(dst + i, coverage + i, n - i, fg, bg);
+}
+
+#elif defined(CONNECTBOT_NEON)
+
+void BlendSpan(uint32_t* dst, const uint8_t* coverage, int n, uint32_t fg,
+               uint32_t bg) {
+  uint8x8_t fgc[4], bgc[4];
+  for (int c = 0; c < 4; c++) {
+    fgc[c] = vdup_n_u8((fg >> (8 * c)) & 0xff);
+    bgc[c] = vdup_n_u8((bg >> (8 * c)) & 0xff);
+  }
+  const uint16x8_t k128 = vdupq_n_u16(128);
+
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    uint8x8_t a = vld1_u8(coverage + i);
+    uint8x8_t inv = vmvn_u8(a);
+    uint8x8x4_t out;
+    for (int c = 0; c < 4; c++) {
+      uint16x8_t x = vmlal_u8(vmull_u8(fgc[c], a), bgc[c], inv);
+      x = vaddq_u16(x, k128);
+      out.val[c] = vshrn_n_u16(vsraq_n_u16(x, x, 8), 8);
+    }
+    vst4_u8(reinterpret_cast<uint8_t*>(dst + i), out);
+  }
+  BlendSpanScalar(dst + i, coverage + i, n - i, fg, bg);
+}
+
+#else
+
+void BlendSpan(uint32_t* dst, const uint8_t* coverage, int n, uint32_t fg,
+               uint32_t bg) {
+  BlendSpanScalar(dst, coverage, n, fg, bg);
+}
+
+#endif
+
+CellRenderer::CellRenderer(int cell_width, int cell_height, int underline_row)
+    : cell_width_(cell_width),
+      cell_height_(cell_height),
+      underline_row_(underline_row) {}
+
+void CellRenderer::AddGlyph(uint16_t ch, bool wide, const uint8_t* coverage,
+                            size_t stride) {
+  const size_t width = (wide ? 2 : 1) * cell_width_;
+  Glyph glyph;
+  glyph.offset = atlas_.size();
+  glyph.empty = true;
+
+  atlas_.resize(atlas_.size() + width * cell_height_);
+  uint8_t* dst = &atlas_[glyph.offset];
+  for (int y = 0; y < cell_height_; y++) {
+    const uint8_t* src = coverage + y * stride;
+    memcpy(dst + y * width, src, width);
+    if (glyph.empty) {
+      glyph.empty = std::all_of(src, src + width,
+                                [](uint8_t a) { return a == 0; });
+    }
+  }
+
+  glyphs_[Key(ch, wide)] = glyph;
+}
+
+bool CellRenderer::HasGlyph(uint16_t ch, bool wide) const {
+  return glyphs_.find(Key(ch, wide)) != glyphs_.end();
+}
+
+int CellRenderer::RenderRow(uint32_t* pixels, size_t stride, int row,
+                            int columns, const uint16_t* chars,
+                            const uint32_t* fg, const uint32_t* bg,
+                            const uint8_t* flags) const {
+  // Look every glyph up first so a miss leaves the row untouched.
+  std::vector<const Glyph*>& found = found_;
+  found.resize(columns);
+  for (int col = 0; col < columns;) {
+    const bool wide = (flags[col] & kCellWide) != 0 && col + 1 < columns;
+    auto it = glyphs_.find(Key(chars[col], wide));
+    if (it == glyphs_.end()) {
+      if ((flags[col] & kCellInvisible) == 0) {
+        return col;
+      }
+      found[col] = nullptr;
+    } else {
+      found[col] = &it->second;
+    }
+    col += wide ? 2 : 1;
+  }
+
+  uint32_t* top = pixels + static_cast<size_t>(row) * cell_height_ * stride;
+  for (int col = 0; col < columns;) {
+    const uint8_t f = flags[col];
+    const bool wide = (f & kCellWide) != 0 && col + 1 < columns;
+    const int width = (wide ? 2 : 1) * cell_width_;
+
+    uint32_t fore = ArgbToPixel(fg[col]);
+    uint32_t back = ArgbToPixel(bg[col]);
+    if (f & kCellInverse) {
+      std::swap(fore, back);
+    }
+
+    const Glyph* glyph = found[col];
+    const bool blank = (f & kCellInvisible) != 0 || glyph->empty;
+    const uint8_t* coverage = blank ? nullptr : &atlas_[glyph->offset];
+
+    uint32_t* dst = top + col * cell_width_;
+    for (int y = 0; y < cell_height_; y++, dst += stride) {
+      if (y == underline_row_ && (f & kCellUnderline) != 0) {
+        std::fill(dst, dst + width, fore);
+      } else if (blank) {
+        std::fill(dst, dst + width, back);
+      } else {
+        BlendSpan(dst, coverage + y * width, width, fore, back);
+      }
+    }
+
+    col += wide ? 2 : 1;
+  }
+
+  return -1;
+}
+
+}  // namespace connectbot
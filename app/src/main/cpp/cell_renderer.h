@@ -0,0 +1,108 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CONNECTBOT_CELL_RENDERER_H_
+#define CONNECTBOT_CELL_RENDERER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace connectbot {
+
+// Per-cell flags passed to CellRenderer::RenderRow.
+enum CellFlags {
+  kCellUnderline = 1 << 0,
+  kCellInverse = 1 << 1,
+  kCellInvisible = 1 << 2,
+  // The cell and the one after it hold one double-width glyph.
+  kCellWide = 1 << 3,
+};
+
+// Composites terminal cells into a 32-bit RGBA pixel buffer (the memory
+// layout of an Android ARGB_8888 bitmap) from a glyph atlas of 8-bit
+// coverage masks. Background fill, glyph blending, underline and inverse
+// all happen in a single pass over each cell, using SSE2 or NEON where
+// available.
+//
+// The atlas is filled by the caller, normally once per font size, and can be
+// extended as new characters show up.
+class CellRenderer {
+ public:
+  CellRenderer(int cell_width, int cell_height, int underline_row);
+
+  int cell_width() const { return cell_width_; }
+  int cell_height() const { return cell_height_; }
+
+  // Adds the glyph for |ch|. |coverage| holds cell_height rows of
+  // |cells| * cell_width bytes, each row |stride| bytes apart.
+  void AddGlyph(uint16_t ch, bool wide, const uint8_t* coverage, size_t stride);
+
+  bool HasGlyph(uint16_t ch, bool wide) const;
+
+  size_t glyph_count() const { return glyphs_.size(); }
+
+  // Draws |columns| cells as text row |row|. Colors are 0xAARRGGBB as used
+  // by android.graphics.Color. |pixels| points at the top-left pixel of the
+  // buffer and |stride| is the distance between pixel rows, in pixels.
+  //
+  // Returns -1 on success. If a glyph is missing from the atlas, nothing is
+  // drawn and the column of the first missing glyph is returned instead.
+  int RenderRow(uint32_t* pixels, size_t stride, int row, int columns,
+                const uint16_t* chars, const uint32_t* fg, const uint32_t* bg,
+                const uint8_t* flags) const;
+
+ private:
+  struct Glyph {
+    size_t offset;  // Into atlas_.
+    bool empty;     // No coverage at all, e.g. a space.
+  };
+
+  static uint32_t Key(uint16_t ch, bool wide) {
+    return (static_cast<uint32_t>(ch) << 1) | (wide ? 1 : 0);
+  }
+
+  const int cell_width_;
+  const int cell_height_;
+  const int underline_row_;
+
+  std::vector<uint8_t> atlas_;
+  std::unordered_map<uint32_t, Glyph> glyphs_;
+
+  // Scratch space for RenderRow, kept to avoid allocating per row. This is
+  // why a renderer may only draw on one thread, the Java render thread.
+  mutable std::vector<const Glyph*> found_;
+};
+
+// Blends |n| pixels of |fg| over |bg| by |coverage| into |dst|. Colors are
+// in the buffer's RGBA byte order. Exposed for testing.
+void BlendSpan(uint32_t* dst, const uint8_t* coverage, int n, uint32_t fg,
+               uint32_t bg);
+
+// Portable version of BlendSpan, for checking the SIMD paths against.
+void BlendSpanScalar(uint32_t* dst, const uint8_t* coverage, int n,
+                     uint32_t fg, uint32_t bg);
+
+// Converts 0xAARRGGBB to the RGBA byte order of the pixel buffer.
+inline uint32_t ArgbToPixel(uint32_t argb) {
+  return (argb & 0xff00ff00) | ((argb >> 16) & 0xff) | ((argb & 0xff) << 16);
+}
+
+}  // namespace connectbot
+
+#endif  // CONNECTBOT_CELL_RENDERER_H_
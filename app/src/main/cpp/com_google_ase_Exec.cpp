@@ -168,6 +168,127 @@ JNIEXPORT jobject JNICALL Java_com_google_ase_Exec_createSubprocess(
   return result;
 }
 
+static int create_piped_subprocess(
+  const char* cmd, const char* arg0, const char* arg1, int* pProcessId, int* fds) {
+  int in[2], out[2], err[2];
+  pid_t pid;
+
+  if (pipe(in) < 0) {
+    LOG("[ cannot create stdin pipe - %s ]\n", strerror(errno));
+    return -1;
+  }
+  if (pipe(out) < 0) {
+    LOG("[ cannot create stdout pipe - %s ]\n", strerror(errno));
+    close(in[0]); close(in[1]);
+    return -1;
+  }
+  if (pipe(err) < 0) {
+    LOG("[ cannot create stderr pipe - %s ]\n", strerror(errno));
+    close(in[0]); close(in[1]);
+    close(out[0]); close(out[1]);
+    return -1;
+  }
+
+  pid = fork();
+  if (pid < 0) {
+    LOG("- fork failed: %s -\n", strerror(errno));
+    close(in[0]); close(in[1]);
+    close(out[0]); close(out[1]);
+    close(err[0]); close(err[1]);
+    return -1;
+  }
+
+  if (pid == 0) {
+    setsid();
+
+    dup2(in[0], 0);
+    dup2(out[1], 1);
+    dup2(err[1], 2);
+
+    close(in[0]); close(in[1]);
+    close(out[0]); close(out[1]);
+    close(err[0]); close(err[1]);
+
+    execl(cmd, cmd, arg0, arg1, NULL);
+    exit(-1);
+  }
+
+  close(in[0]);
+  close(out[1]);
+  close(err[1]);
+
+  fcntl(in[1], F_SETFD, FD_CLOEXEC);
+  fcntl(out[0], F_SETFD, FD_CLOEXEC);
+  fcntl(err[0], F_SETFD, FD_CLOEXEC);
+
+  fds[0] = in[1];
+  fds[1] = out[0];
+  fds[2] = err[0];
+  *pProcessId = (int) pid;
+  return 0;
+}
+
+static jobject newFileDescriptor(JNIEnv* env, jclass Class_java_io_FileDescriptor, int fd) {
+  jmethodID init = env->GetMethodID(Class_java_io_FileDescriptor,
+                                    "<init>", "()V");
+  jobject result = env->NewObject(Class_java_io_FileDescriptor, init);
+
+  if (!result) {
+    LOG("Couldn't create a FileDescriptor.");
+  } else {
+    jfieldID descriptor = env->GetFieldID(Class_java_io_FileDescriptor,
+                                        "descriptor", "I");
+    env->SetIntField(result, descriptor, fd);
+  }
+
+  return result;
+}
+
+JNIEXPORT jobjectArray JNICALL Java_com_google_ase_Exec_createPipedSubprocess(
+    JNIEnv* env, jclass clazz, jstring cmd, jstring arg0, jstring arg1,
+    jintArray processIdArray) {
+  char* cmd_8 = JNU_GetStringNativeChars(env, cmd);
+  char* arg0_8 = JNU_GetStringNativeChars(env, arg0);
+  char* arg1_8 = JNU_GetStringNativeChars(env, arg1);
+
+  int procId = -1;
+  int fds[3];
+  int rc = create_piped_subprocess(cmd_8, arg0_8, arg1_8, &procId, fds);
+
+  free(cmd_8);
+  free(arg0_8);
+  free(arg1_8);
+
+  if (rc < 0) {
+    return NULL;
+  }
+
+  if (processIdArray) {
+    int procIdLen = env->GetArrayLength(processIdArray);
+    if (procIdLen > 0) {
+      env->SetIntArrayRegion(processIdArray, 0, 1, &procId);
+    }
+  }
+
+  jclass Class_java_io_FileDescriptor = env->FindClass("java/io/FileDescriptor");
+  jobjectArray result = env->NewObjectArray(3, Class_java_io_FileDescriptor, NULL);
+  if (!result) {
+    LOG("Couldn't create a FileDescriptor array.");
+    close(fds[0]);
+    close(fds[1]);
+    close(fds[2]);
+    return NULL;
+  }
+
+  for (int i = 0; i < 3; i++) {
+    jobject fd = newFileDescriptor(env, Class_java_io_FileDescriptor, fds[i]);
+    env->SetObjectArrayElement(result, i, fd);
+    env->DeleteLocalRef(fd);
+  }
+
+  return result;
+}
+
 JNIEXPORT void Java_com_google_ase_Exec_setPtyWindowSize(
     JNIEnv* env, jclass clazz, jobject fileDescriptor, jint row, jint col,
     jint xpixel, jint ypixel) {
@@ -15,6 +15,14 @@ extern "C" {
 JNIEXPORT jobject JNICALL Java_com_google_ase_Exec_createSubprocess
   (JNIEnv *, jclass, jstring, jstring, jstring, jintArray);
 
+/*
+ * Class:     com_google_ase_Exec
+ * Method:    createPipedSubprocess
+ * Signature: (Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;[I)[Ljava/io/FileDescriptor;
+ */
+JNIEXPORT jobjectArray JNICALL Java_com_google_ase_Exec_createPipedSubprocess
+  (JNIEnv *, jclass, jstring, jstring, jstring, jintArray);
+
 /*
  * Class:     com_google_ase_Exec
  * Method:    setPtyWindowSize
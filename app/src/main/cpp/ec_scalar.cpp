@@ -0,0 +1,698 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ec_scalar.h"
+
+#include <string.h>
+
+#include <vector>
+
+namespace connectbot {
+
+namespace {
+
+typedef uint32_t Limb;
+typedef uint64_t DoubleLimb;
+
+const uint8_t kP256Prime[] = {
+    0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+const uint8_t kP256Order[] = {
+    0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xbc, 0xe6, 0xfa, 0xad, 0xa7, 0x17, 0x9e, 0x84,
+    0xf3, 0xb9, 0xca, 0xc2, 0xfc, 0x63, 0x25, 0x51,
+};
+const uint8_t kP256Gx[] = {
+    0x6b, 0x17, 0xd1, 0xf2, 0xe1, 0x2c, 0x42, 0x47, 0xf8, 0xbc, 0xe6, 0xe5,
+    0x63, 0xa4, 0x40, 0xf2, 0x77, 0x03, 0x7d, 0x81, 0x2d, 0xeb, 0x33, 0xa0,
+    0xf4, 0xa1, 0x39, 0x45, 0xd8, 0x98, 0xc2, 0x96,
+};
+const uint8_t kP256Gy[] = {
+    0x4f, 0xe3, 0x42, 0xe2, 0xfe, 0x1a, 0x7f, 0x9b, 0x8e, 0xe7, 0xeb, 0x4a,
+    0x7c, 0x0f, 0x9e, 0x16, 0x2b, 0xce, 0x33, 0x57, 0x6b, 0x31, 0x5e, 0xce,
+    0xcb, 0xb6, 0x40, 0x68, 0x37, 0xbf, 0x51, 0xf5,
+};
+
+const uint8_t kP384Prime[] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+};
+const uint8_t kP384Order[] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xc7, 0x63, 0x4d, 0x81, 0xf4, 0x37, 0x2d, 0xdf, 0x58, 0x1a, 0x0d, 0xb2,
+    0x48, 0xb0, 0xa7, 0x7a, 0xec, 0xec, 0x19, 0x6a, 0xcc, 0xc5, 0x29, 0x73,
+};
+const uint8_t kP384Gx[] = {
+    0xaa, 0x87, 0xca, 0x22, 0xbe, 0x8b, 0x05, 0x37, 0x8e, 0xb1, 0xc7, 0x1e,
+    0xf3, 0x20, 0xad, 0x74, 0x6e, 0x1d, 0x3b, 0x62, 0x8b, 0xa7, 0x9b, 0x98,
+    0x59, 0xf7, 0x41, 0xe0, 0x82, 0x54, 0x2a, 0x38, 0x55, 0x02, 0xf2, 0x5d,
+    0xbf, 0x55, 0x29, 0x6c, 0x3a, 0x54, 0x5e, 0x38, 0x72, 0x76, 0x0a, 0xb7,
+};
+const uint8_t kP384Gy[] = {
+    0x36, 0x17, 0xde, 0x4a, 0x96, 0x26, 0x2c, 0x6f, 0x5d, 0x9e, 0x98, 0xbf,
+    0x92, 0x92, 0xdc, 0x29, 0xf8, 0xf4, 0x1d, 0xbd, 0x28, 0x9a, 0x14, 0x7c,
+    0xe9, 0xda, 0x31, 0x13, 0xb5, 0xf0, 0xb8, 0xc0, 0x0a, 0x60, 0xb1, 0xce,
+    0x1d, 0x7e, 0x81, 0x9d, 0x7a, 0x43, 0x1d, 0x7c, 0x90, 0xea, 0x0e, 0x5f,
+};
+
+const uint8_t kP521Prime[] = {
+    0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+const uint8_t kP521Order[] = {
+    0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfa, 0x51, 0x86,
+    0x87, 0x83, 0xbf, 0x2f, 0x96, 0x6b, 0x7f, 0xcc, 0x01, 0x48, 0xf7, 0x09,
+    0xa5, 0xd0, 0x3b, 0xb5, 0xc9, 0xb8, 0x89, 0x9c, 0x47, 0xae, 0xbb, 0x6f,
+    0xb7, 0x1e, 0x91, 0x38, 0x64, 0x09,
+};
+const uint8_t kP521Gx[] = {
+    0x00, 0xc6, 0x85, 0x8e, 0x06, 0xb7, 0x04, 0x04, 0xe9, 0xcd, 0x9e, 0x3e,
+    0xcb, 0x66, 0x23, 0x95, 0xb4, 0x42, 0x9c, 0x64, 0x81, 0x39, 0x05, 0x3f,
+    0xb5, 0x21, 0xf8, 0x28, 0xaf, 0x60, 0x6b, 0x4d, 0x3d, 0xba, 0xa1, 0x4b,
+    0x5e, 0x77, 0xef, 0xe7, 0x59, 0x28, 0xfe, 0x1d, 0xc1, 0x27, 0xa2, 0xff,
+    0xa8, 0xde, 0x33, 0x48, 0xb3, 0xc1, 0x85, 0x6a, 0x42, 0x9b, 0xf9, 0x7e,
+    0x7e, 0x31, 0xc2, 0xe5, 0xbd, 0x66,
+};
+const uint8_t kP521Gy[] = {
+    0x01, 0x18, 0x39, 0x29, 0x6a, 0x78, 0x9a, 0x3b, 0xc0, 0x04, 0x5c, 0x8a,
+    0x5f, 0xb4, 0x2c, 0x7d, 0x1b, 0xd9, 0x98, 0xf5, 0x44, 0x49, 0x57, 0x9b,
+    0x44, 0x68, 0x17, 0xaf, 0xbd, 0x17, 0x27, 0x3e, 0x66, 0x2c, 0x97, 0xee,
+    0x72, 0x99, 0x5e, 0xf4, 0x26, 0x40, 0xc5, 0x50, 0xb9, 0x01, 0x3f, 0xad,
+    0x07, 0x61, 0x35, 0x3c, 0x70, 0x86, 0xa2, 0x72, 0xc2, 0x40, 0x88, 0xbe,
+    0x94, 0x76, 0x9f, 0xd1, 0x66, 0x50,
+};
+
+// Mask of all ones if |a| == |b|, otherwise zero, without branching.
+inline Limb EqualMask(Limb a, Limb b) {
+  Limb x = a ^ b;
+  return ((x | (0u - x)) >> 31) - 1;
+}
+
+// Overwrites secrets in a way the compiler may not drop.
+void Wipe(void* p, size_t len) {
+  volatile uint8_t* v = static_cast<volatile uint8_t*>(p);
+  while (len--) {
+    *v++ = 0;
+  }
+}
+
+// Strips leading zero bytes; the rest must fit into |n| limbs.
+template <int N>
+bool FromBytes(const uint8_t* in, size_t len, Limb* out) {
+  while (len > 4 * N) {
+    if (*in != 0) {
+      return false;
+    }
+    in++;
+    len--;
+  }
+  memset(out, 0, N * sizeof(Limb));
+  for (size_t i = 0; i < len; i++) {
+    size_t bit = 8 * (len - 1 - i);
+    out[bit / 32] |= static_cast<Limb>(in[i]) << (bit % 32);
+  }
+  return true;
+}
+
+template <int N>
+void ToBytes(const Limb* in, uint8_t* out, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    size_t bit = 8 * (len - 1 - i);
+    out[i] = static_cast<uint8_t>(in[bit / 32] >> (bit % 32));
+  }
+}
+
+// r = a + b, returning the carry out.
+template <int N>
+Limb Add(Limb* r, const Limb* a, const Limb* b) {
+  DoubleLimb carry = 0;
+  for (int i = 0; i < N; i++) {
+    carry += static_cast<DoubleLimb>(a[i]) + b[i];
+    r[i] = static_cast<Limb>(carry);
+    carry >>= 32;
+  }
+  return static_cast<Limb>(carry);
+}
+
+// r = a - b, returning the borrow out.
+template <int N>
+Limb Sub(Limb* r, const Limb* a, const Limb* b) {
+  DoubleLimb borrow = 0;
+  for (int i = 0; i < N; i++) {
+    DoubleLimb d = static_cast<DoubleLimb>(a[i]) - b[i] - borrow;
+    r[i] = static_cast<Limb>(d);
+    borrow = (d >> 32) & 1;
+  }
+  return static_cast<Limb>(borrow);
+}
+
+// r = mask ? a : b
+template <int N>
+void Select(Limb* r, const Limb* a, const Limb* b, Limb mask) {
+  for (int i = 0; i < N; i++) {
+    r[i] = (a[i] & mask) | (b[i] & ~mask);
+  }
+}
+
+// Mask of all ones if |a| is zero.
+template <int N>
+Limb ZeroMask(const Limb* a) {
+  Limb acc = 0;
+  for (int i = 0; i < N; i++) {
+    acc |= a[i];
+  }
+  return EqualMask(acc, 0);
+}
+
+// Arithmetic modulo an odd prime p, with R = 2^(32 N).
+template <int N>
+struct Field {
+  Limb p[N];
+  Limb one[N];  // R mod p, 1 in Montgomery form.
+  Limb r2[N];   // R^2 mod p, to convert into Montgomery form.
+  Limb n0;      // -p^-1 mod 2^32.
+
+  void Init(const uint8_t* prime, size_t len) {
+    FromBytes<N>(prime, len, p);
+
+    // Newton's iteration doubles the correct low bits of the inverse.
+    Limb inv = 1;
+    for (int i = 0; i < 5; i++) {
+      inv *= 2 - p[0] * inv;
+    }
+    n0 = 0u - inv;
+
+    // 2^(64 N) mod p by doubling, which is only done once per curve.
+    Limb x[N] = {1};
+    for (int i = 0; i < 32 * N; i++) {
+      AddMod(x, x, x);
+    }
+    memcpy(one, x, sizeof(one));
+    for (int i = 0; i < 32 * N; i++) {
+      AddMod(x, x, x);
+    }
+    memcpy(r2, x, sizeof(r2));
+  }
+
+  void AddMod(Limb* r, const Limb* a, const Limb* b) const {
+    Limb sum[N], reduced[N];
+    Limb carry = Add<N>(sum, a, b);
+    Limb borrow = Sub<N>(reduced, sum, p);
+    // Keep the reduced value if the sum overflowed or was at least p.
+    Select<N>(r, reduced, sum, 0u - (carry | (borrow ^ 1)));
+  }
+
+  void SubMod(Limb* r, const Limb* a, const Limb* b) const {
+    Limb diff[N], fixed[N];
+    Limb borrow = Sub<N>(diff, a, b);
+    Add<N>(fixed, diff, p);
+    Select<N>(r, fixed, diff, 0u - borrow);
+  }
+
+  // Montgomery multiplication, r = a * b / R mod p. r may alias a or b.
+  void Mul(Limb* r, const Limb* a, const Limb* b) const {
+    Limb t[N + 2];
+    memset(t, 0, sizeof(t));
+    for (int i = 0; i < N; i++) {
+      DoubleLimb carry = 0;
+      for (int j = 0; j < N; j++) {
+        carry += static_cast<DoubleLimb>(a[j]) * b[i] + t[j];
+        t[j] = static_cast<Limb>(carry);
+        carry >>= 32;
+      }
+      carry += t[N];
+      t[N] = static_cast<Limb>(carry);
+      t[N + 1] = static_cast<Limb>(carry >> 32);
+
+      Limb m = t[0] * n0;
+      carry = (static_cast<DoubleLimb>(m) * p[0] + t[0]) >> 32;
+      for (int j = 1; j < N; j++) {
+        carry += static_cast<DoubleLimb>(m) * p[j] + t[j];
+        t[j - 1] = static_cast<Limb>(carry);
+        carry >>= 32;
+      }
+      carry += t[N];
+      t[N - 1] = static_cast<Limb>(carry);
+      t[N] = t[N + 1] + static_cast<Limb>(carry >> 32);
+    }
+
+    Limb reduced[N];
+    Limb borrow = Sub<N>(reduced, t, p);
+    Select<N>(r, reduced, t, 0u - (t[N] | (borrow ^ 1)));
+  }
+
+  void Sqr(Limb* r, const Limb* a) const { Mul(r, a, a); }
+
+  void ToMont(Limb* r, const Limb* a) const { Mul(r, a, r2); }
+
+  void FromMont(Limb* r, const Limb* a) const {
+    Limb unit[N] = {1};
+    Mul(r, a, unit);
+  }
+
+  // r = a^(p - 2) = 1 / a. The exponent is public, so this branches on it.
+  void Invert(Limb* r, const Limb* a) const {
+    Limb e[N], two[N] = {2};
+    Sub<N>(e, p, two);
+    Limb acc[N];
+    memcpy(acc, one, sizeof(acc));
+    for (int i = 32 * N - 1; i >= 0; i--) {
+      Sqr(acc, acc);
+      if ((e[i / 32] >> (i % 32)) & 1) {
+        Mul(acc, acc, a);
+      }
+    }
+    memcpy(r, acc, sizeof(acc));
+  }
+};
+
+template <int N>
+struct Affine {
+  Limb x[N];
+  Limb y[N];
+};
+
+// (X / Z^2, Y / Z^3); Z = 0 is the point at infinity.
+template <int N>
+struct Jacobian {
+  Limb x[N];
+  Limb y[N];
+  Limb z[N];
+};
+
+// Point doubling for a = -3 (dbl-2001-b). r may alias a.
+template <int N>
+void Double(const Field<N>& f, Jacobian<N>* r, const Jacobian<N>& a) {
+  Limb delta[N], gamma[N], beta[N], alpha[N], t1[N], t2[N];
+  f.Sqr(delta, a.z);
+  f.Sqr(gamma, a.y);
+  f.Mul(beta, a.x, gamma);
+  f.SubMod(t1, a.x, delta);
+  f.AddMod(t2, a.x, delta);
+  f.Mul(alpha, t1, t2);
+  f.AddMod(t1, alpha, alpha);
+  f.AddMod(alpha, t1, alpha);
+
+  Limb z3[N];
+  f.AddMod(t1, a.y, a.z);
+  f.Sqr(t1, t1);
+  f.SubMod(t1, t1, gamma);
+  f.SubMod(z3, t1, delta);
+
+  Limb beta4[N], x3[N];
+  f.AddMod(beta4, beta, beta);
+  f.AddMod(beta4, beta4, beta4);
+  f.Sqr(x3, alpha);
+  f.SubMod(x3, x3, beta4);
+  f.SubMod(x3, x3, beta4);
+
+  f.SubMod(t1, beta4, x3);
+  f.Mul(t1, alpha, t1);
+  f.Sqr(t2, gamma);
+  f.AddMod(t2, t2, t2);
+  f.AddMod(t2, t2, t2);
+  f.AddMod(t2, t2, t2);
+  f.SubMod(r->y, t1, t2);
+  memcpy(r->x, x3, sizeof(x3));
+  memcpy(r->z, z3, sizeof(z3));
+}
+
+// r = a + b with b affine (madd-2007-bl). Neither may be infinity and they
+// must differ; callers fix up those cases. r may alias a.
+template <int N>
+void AddMixed(const Field<N>& f, Jacobian<N>* r, const Jacobian<N>& a,
+              const Affine<N>& b) {
+  Limb z1z1[N], u2[N], s2[N], h[N], hh[N], i[N], j[N], rr[N], v[N], t[N];
+  f.Sqr(z1z1, a.z);
+  f.Mul(u2, b.x, z1z1);
+  f.Mul(s2, b.y, a.z);
+  f.Mul(s2, s2, z1z1);
+  f.SubMod(h, u2, a.x);
+  f.Sqr(hh, h);
+  f.AddMod(i, hh, hh);
+  f.AddMod(i, i, i);
+  f.Mul(j, h, i);
+  f.SubMod(rr, s2, a.y);
+  f.AddMod(rr, rr, rr);
+  f.Mul(v, a.x, i);
+
+  Limb x3[N], y3[N], z3[N];
+  f.Sqr(x3, rr);
+  f.SubMod(x3, x3, j);
+  f.SubMod(x3, x3, v);
+  f.SubMod(x3, x3, v);
+
+  f.SubMod(t, v, x3);
+  f.Mul(y3, rr, t);
+  f.Mul(t, a.y, j);
+  f.SubMod(y3, y3, t);
+  f.SubMod(y3, y3, t);
+
+  f.AddMod(z3, a.z, h);
+  f.Sqr(z3, z3);
+  f.SubMod(z3, z3, z1z1);
+  f.SubMod(z3, z3, hh);
+
+  memcpy(r->x, x3, sizeof(x3));
+  memcpy(r->y, y3, sizeof(y3));
+  memcpy(r->z, z3, sizeof(z3));
+}
+
+// r = a + b for distinct points that are not infinity (add-2007-bl).
+template <int N>
+void AddJacobian(const Field<N>& f, Jacobian<N>* r, const Jacobian<N>& a,
+                 const Jacobian<N>& b) {
+  Limb z1z1[N], z2z2[N], u1[N], u2[N], s1[N], s2[N], h[N], i[N], j[N];
+  Limb rr[N], v[N], t[N];
+  f.Sqr(z1z1, a.z);
+  f.Sqr(z2z2, b.z);
+  f.Mul(u1, a.x, z2z2);
+  f.Mul(u2, b.x, z1z1);
+  f.Mul(s1, a.y, b.z);
+  f.Mul(s1, s1, z2z2);
+  f.Mul(s2, b.y, a.z);
+  f.Mul(s2, s2, z1z1);
+  f.SubMod(h, u2, u1);
+  f.AddMod(i, h, h);
+  f.Sqr(i, i);
+  f.Mul(j, h, i);
+  f.SubMod(rr, s2, s1);
+  f.AddMod(rr, rr, rr);
+  f.Mul(v, u1, i);
+
+  Limb x3[N], y3[N], z3[N];
+  f.Sqr(x3, rr);
+  f.SubMod(x3, x3, j);
+  f.SubMod(x3, x3, v);
+  f.SubMod(x3, x3, v);
+
+  f.SubMod(t, v, x3);
+  f.Mul(y3, rr, t);
+  f.Mul(t, s1, j);
+  f.SubMod(y3, y3, t);
+  f.SubMod(y3, y3, t);
+
+  f.AddMod(z3, a.z, b.z);
+  f.Sqr(z3, z3);
+  f.SubMod(z3, z3, z1z1);
+  f.SubMod(z3, z3, z2z2);
+  f.Mul(z3, z3, h);
+
+  memcpy(r->x, x3, sizeof(x3));
+  memcpy(r->y, y3, sizeof(y3));
+  memcpy(r->z, z3, sizeof(z3));
+}
+
+// Number of multiples of each window in the fixed-base table, 1 to 15.
+const int kWindowBits = 4;
+const int kWindowEntries = (1 << kWindowBits) - 1;
+
+template <int N>
+struct Curve {
+  Field<N> field;
+  Limb order[N];
+  Affine<N> g;  // Montgomery form.
+  int windows;
+  size_t length;
+  // windows * kWindowEntries points: entry (i, d - 1) is d * 16^i * G.
+  std::vector<Affine<N> > table;
+
+  Curve(const uint8_t* prime, const uint8_t* n, const uint8_t* gx,
+        const uint8_t* gy, size_t len, int bits)
+      : windows((bits + kWindowBits - 1) / kWindowBits), length(len) {
+    field.Init(prime, len);
+    FromBytes<N>(n, len, order);
+    Limb x[N], y[N];
+    FromBytes<N>(gx, len, x);
+    FromBytes<N>(gy, len, y);
+    field.ToMont(g.x, x);
+    field.ToMont(g.y, y);
+    BuildTable();
+  }
+
+  void BuildTable() {
+    std::vector<Jacobian<N> > points(windows * kWindowEntries);
+    Jacobian<N> base;
+    memcpy(base.x, g.x, sizeof(base.x));
+    memcpy(base.y, g.y, sizeof(base.y));
+    memcpy(base.z, field.one, sizeof(base.z));
+    for (int w = 0; w < windows; w++) {
+      Jacobian<N>* row = &points[w * kWindowEntries];
+      row[0] = base;
+      Double(field, &row[1], base);
+      for (int d = 2; d < kWindowEntries; d++) {
+        AddJacobian(field, &row[d], row[d - 1], base);
+      }
+      // 16 * base = 2 * (8 * base)
+      Double(field, &base, row[7]);
+    }
+
+    // Convert all of them with a single inversion (Montgomery's trick).
+    size_t count = points.size();
+    std::vector<Limb> prefix(count * N);
+    memcpy(&prefix[0], points[0].z, sizeof(points[0].z));
+    for (size_t k = 1; k < count; k++) {
+      field.Mul(&prefix[k * N], &prefix[(k - 1) * N], points[k].z);
+    }
+    Limb inv[N];
+    field.Invert(inv, &prefix[(count - 1) * N]);
+
+    table.resize(count);
+    for (size_t k = count; k-- > 0;) {
+      Limb zinv[N], zinv2[N], zinv3[N];
+      if (k > 0) {
+        field.Mul(zinv, inv, &prefix[(k - 1) * N]);
+        field.Mul(inv, inv, points[k].z);
+      } else {
+        memcpy(zinv, inv, sizeof(zinv));
+      }
+      field.Sqr(zinv2, zinv);
+      field.Mul(zinv3, zinv2, zinv);
+      field.Mul(table[k].x, points[k].x, zinv2);
+      field.Mul(table[k].y, points[k].y, zinv3);
+    }
+  }
+
+  // Parses the scalar; false unless 0 < k < n.
+  bool ParseScalar(const uint8_t* scalar, size_t len, Limb* k) const {
+    if (!FromBytes<N>(scalar, len, k)) {
+      return false;
+    }
+    Limb diff[N];
+    Limb below = Sub<N>(diff, k, order);
+    Wipe(diff, sizeof(diff));
+    return (below & ~ZeroMask<N>(k)) != 0;
+  }
+
+  void Output(const Jacobian<N>& q, uint8_t* out_x, uint8_t* out_y) const {
+    Limb zinv[N], zinv2[N], t[N];
+    field.Invert(zinv, q.z);
+    field.Sqr(zinv2, zinv);
+    field.Mul(t, q.x, zinv2);
+    field.FromMont(t, t);
+    ToBytes<N>(t, out_x, length);
+    field.Mul(zinv, zinv, zinv2);
+    field.Mul(t, q.y, zinv);
+    field.FromMont(t, t);
+    ToBytes<N>(t, out_y, length);
+  }
+
+  bool MultiplyBase(const uint8_t* scalar, size_t len, uint8_t* out_x,
+                    uint8_t* out_y) const {
+    Limb k[N];
+    if (!ParseScalar(scalar, len, k)) {
+      Wipe(k, sizeof(k));
+      return false;
+    }
+
+    Jacobian<N> q;
+    memset(&q, 0, sizeof(q));
+    Limb infinity = ~0u;
+    for (int w = 0; w < windows; w++) {
+      Limb digit = (k[w / 8] >> (kWindowBits * (w % 8))) & kWindowEntries;
+
+      // Read every entry of the window and keep the wanted one.
+      const Affine<N>* row = &table[w * kWindowEntries];
+      Affine<N> s;
+      memset(&s, 0, sizeof(s));
+      for (int d = 0; d < kWindowEntries; d++) {
+        Limb mask = EqualMask(digit, d + 1);
+        Select<N>(s.x, row[d].x, s.x, mask);
+        Select<N>(s.y, row[d].y, s.y, mask);
+      }
+
+      // The partial sum is below 16^w and the entry a multiple of it, so
+      // they never coincide; only infinity needs fixing up.
+      Jacobian<N> r;
+      AddMixed(field, &r, q, s);
+      Select<N>(r.x, s.x, r.x, infinity);
+      Select<N>(r.y, s.y, r.y, infinity);
+      Select<N>(r.z, field.one, r.z, infinity);
+
+      Limb zero = EqualMask(digit, 0);
+      Select<N>(q.x, q.x, r.x, zero);
+      Select<N>(q.y, q.y, r.y, zero);
+      Select<N>(q.z, q.z, r.z, zero);
+      infinity &= zero;
+    }
+
+    Output(q, out_x, out_y);
+    Wipe(k, sizeof(k));
+    Wipe(&q, sizeof(q));
+    return true;
+  }
+
+  bool MultiplyBaseReference(const uint8_t* scalar, size_t len,
+                             uint8_t* out_x, uint8_t* out_y) const {
+    Limb k[N];
+    if (!ParseScalar(scalar, len, k)) {
+      return false;
+    }
+
+    Jacobian<N> q;
+    bool infinity = true;
+    for (int i = 32 * N - 1; i >= 0; i--) {
+      if (!infinity) {
+        Double(field, &q, q);
+      }
+      if ((k[i / 32] >> (i % 32)) & 1) {
+        if (infinity) {
+          memcpy(q.x, g.x, sizeof(q.x));
+          memcpy(q.y, g.y, sizeof(q.y));
+          memcpy(q.z, field.one, sizeof(q.z));
+          infinity = false;
+        } else {
+          AddMixed(field, &q, q, g);
+        }
+      }
+    }
+
+    Output(q, out_x, out_y);
+    return true;
+  }
+};
+
+// Built on first use; C++11 makes the initialization thread-safe.
+const Curve<8>& P256() {
+  static const Curve<8> curve(kP256Prime, kP256Order, kP256Gx, kP256Gy,
+                              sizeof(kP256Prime), 256);
+  return curve;
+}
+
+const Curve<12>& P384() {
+  static const Curve<12> curve(kP384Prime, kP384Order, kP384Gx, kP384Gy,
+                               sizeof(kP384Prime), 384);
+  return curve;
+}
+
+const Curve<17>& P521() {
+  static const Curve<17> curve(kP521Prime, kP521Order, kP521Gx, kP521Gy,
+                               sizeof(kP521Prime), 521);
+  return curve;
+}
+
+// Compares big-endian numbers, ignoring leading zeros.
+bool SameNumber(const uint8_t* a, size_t a_len, const uint8_t* b,
+                size_t b_len) {
+  while (a_len > 0 && *a == 0) {
+    a++;
+    a_len--;
+  }
+  while (b_len > 0 && *b == 0) {
+    b++;
+    b_len--;
+  }
+  return a_len == b_len && memcmp(a, b, a_len) == 0;
+}
+
+}  // namespace
+
+size_t EcCoordinateLength(EcCurve curve) {
+  switch (curve) {
+    case kEcP256:
+      return sizeof(kP256Prime);
+    case kEcP384:
+      return sizeof(kP384Prime);
+    case kEcP521:
+      return sizeof(kP521Prime);
+  }
+  return 0;
+}
+
+bool EcFindCurve(const uint8_t* p, size_t p_len, const uint8_t* gx,
+                 size_t gx_len, const uint8_t* gy, size_t gy_len,
+                 EcCurve* curve) {
+  static const struct {
+    EcCurve curve;
+    const uint8_t* p;
+    const uint8_t* gx;
+    const uint8_t* gy;
+    size_t length;
+  } kCurves[] = {
+    {kEcP256, kP256Prime, kP256Gx, kP256Gy, sizeof(kP256Prime)},
+    {kEcP384, kP384Prime, kP384Gx, kP384Gy, sizeof(kP384Prime)},
+    {kEcP521, kP521Prime, kP521Gx, kP521Gy, sizeof(kP521Prime)},
+  };
+
+  for (size_t i = 0; i < sizeof(kCurves) / sizeof(kCurves[0]); i++) {
+    if (SameNumber(p, p_len, kCurves[i].p, kCurves[i].length)
+        && SameNumber(gx, gx_len, kCurves[i].gx, kCurves[i].length)
+        && SameNumber(gy, gy_len, kCurves[i].gy, kCurves[i].length)) {
+      *curve = kCurves[i].curve;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool EcMultiplyBase(EcCurve curve, const uint8_t* scalar, size_t scalar_len,
+                    uint8_t* x, uint8_t* y) {
+  switch (curve) {
+    case kEcP256:
+      return P256().MultiplyBase(scalar, scalar_len, x, y);
+    case kEcP384:
+      return P384().MultiplyBase(scalar, scalar_len, x, y);
+    case kEcP521:
+      return P521().MultiplyBase(scalar, scalar_len, x, y);
+  }
+  return false;
+}
+
+bool EcMultiplyBaseReference(EcCurve curve, const uint8_t* scalar,
+                             size_t scalar_len, uint8_t* x, uint8_t* y) {
+  switch (curve) {
+    case kEcP256:
+      return P256().MultiplyBaseReference(scalar, scalar_len, x, y);
+    case kEcP384:
+      return P384().MultiplyBaseReference(scalar, scalar_len, x, y);
+    case kEcP521:
+      return P521().MultiplyBaseReference(scalar, scalar_len, x, y);
+  }
+  return false;
+}
+
+}  // namespace connectbot
@@ -0,0 +1,62 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CONNECTBOT_EC_SCALAR_H_
+#define CONNECTBOT_EC_SCALAR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace connectbot {
+
+// The NIST prime curves SSH uses for ecdsa-sha2-nistp* keys.
+enum EcCurve {
+  kEcP256,
+  kEcP384,
+  kEcP521,
+};
+
+// Length in bytes of a coordinate on |curve|.
+size_t EcCoordinateLength(EcCurve curve);
+
+// Finds the curve with field prime |p| and generator (|gx|, |gy|), all
+// big-endian and possibly with extra leading zeros. Returns false if it is
+// not one of the curves above.
+bool EcFindCurve(const uint8_t* p, size_t p_len, const uint8_t* gx,
+                 size_t gx_len, const uint8_t* gy, size_t gy_len,
+                 EcCurve* curve);
+
+// Computes |scalar| * G, e.g. the public key of a private key, and writes the
+// affine coordinates big-endian to |x| and |y|, EcCoordinateLength bytes each.
+//
+// Field elements are kept in Montgomery form in Jacobian coordinates, and G
+// comes from a fixed-base table of every 4-bit window, d * 16^i * G, built
+// the first time a curve is used. The scalar is then handled with one table
+// lookup and one mixed addition per window, with no branches or memory
+// accesses that depend on its bits.
+//
+// Returns false if the scalar is zero or not below the group order.
+bool EcMultiplyBase(EcCurve curve, const uint8_t* scalar, size_t scalar_len,
+                    uint8_t* x, uint8_t* y);
+
+// Same as EcMultiplyBase with a plain double-and-add that branches on the
+// bits of the scalar. Only for tests and benchmarks.
+bool EcMultiplyBaseReference(EcCurve curve, const uint8_t* scalar,
+                             size_t scalar_len, uint8_t* x, uint8_t* y);
+
+}  // namespace connectbot
+
+#endif  // CONNECTBOT_EC_SCALAR_H_
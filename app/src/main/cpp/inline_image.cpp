@@ -0,0 +1,282 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "inline_image.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+namespace connectbot {
+
+namespace {
+
+// Parameters are clamped so that long digit strings cannot overflow.
+const int kMaxParam = 1 << 20;
+
+// The VT340's default palette, in percent.
+const uint8_t kDefaultPalette[16][3] = {
+    {0, 0, 0},    {20, 20, 80}, {80, 13, 13}, {20, 80, 20},
+    {80, 20, 80}, {20, 80, 80}, {80, 80, 20}, {53, 53, 53},
+    {26, 26, 26}, {33, 33, 60}, {60, 26, 26}, {33, 60, 33},
+    {60, 33, 60}, {33, 60, 60}, {60, 60, 33}, {80, 80, 80},
+};
+
+uint32_t Opaque(int r, int g, int b) {
+  return 0xff000000u | (r << 16) | (g << 8) | b;
+}
+
+int PercentToByte(int percent) {
+  return (std::min(percent, 100) * 255 + 50) / 100;
+}
+
+// Standard HLS hue to one RGB component, for lightness and saturation in
+// [0, 1].
+double HueToComponent(double m1, double m2, double hue) {
+  if (hue < 0) {
+    hue += 360;
+  } else if (hue >= 360) {
+    hue -= 360;
+  }
+  if (hue < 60) {
+    return m1 + (m2 - m1) * hue / 60;
+  } else if (hue < 180) {
+    return m2;
+  } else if (hue < 240) {
+    return m1 + (m2 - m1) * (240 - hue) / 60;
+  }
+  return m1;
+}
+
+}  // namespace
+
+SixelDecoder::SixelDecoder(int max_width, int max_height)
+    : max_width_(max_width),
+      max_height_(max_height),
+      state_(kData),
+      param_index_(0),
+      color_(0),
+      x_(0),
+      band_(0),
+      repeat_(1),
+      width_(0),
+      height_(0),
+      raster_width_(0),
+      raster_height_(0),
+      stride_(0),
+      rows_(0) {
+  memset(params_, 0, sizeof(params_));
+  for (int i = 0; i < 256; i++) {
+    const uint8_t* rgb = kDefaultPalette[i % 16];
+    palette_[i] = Opaque(PercentToByte(rgb[0]), PercentToByte(rgb[1]),
+                         PercentToByte(rgb[2]));
+  }
+  color_ = palette_[0];
+}
+
+void SixelDecoder::Feed(const char* data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    char c = data[i];
+    if (state_ != kData) {
+      if (c >= '0' && c <= '9') {
+        int& p = params_[param_index_];
+        p = std::min(p * 10 + (c - '0'), kMaxParam);
+        continue;
+      } else if (c == ';') {
+        if (param_index_ < kMaxParams - 1) {
+          params_[++param_index_] = 0;
+        }
+        continue;
+      }
+      EndParams();
+    }
+
+    if (c >= '?' && c <= '~') {
+      Sixel(c - '?');
+      repeat_ = 1;
+      continue;
+    }
+
+    switch (c) {
+    case '!':
+      state_ = kRepeat;
+      break;
+    case '#':
+      state_ = kColor;
+      break;
+    case '"':
+      state_ = kRaster;
+      break;
+    case '$':
+      x_ = 0;
+      break;
+    case '-':
+      x_ = 0;
+      band_++;
+      break;
+    default:
+      // line breaks and anything unknown
+      break;
+    }
+    if (state_ != kData) {
+      memset(params_, 0, sizeof(params_));
+      param_index_ = 0;
+    }
+  }
+}
+
+void SixelDecoder::EndParams() {
+  switch (state_) {
+  case kRepeat:
+    repeat_ = std::max(params_[0], 1);
+    break;
+  case kColor: {
+    int reg = params_[0] & 0xff;
+    if (param_index_ >= 4) {
+      DefineColor(reg, params_[1], params_[2], params_[3], params_[4]);
+    }
+    color_ = palette_[reg];
+    break;
+  }
+  case kRaster:
+    // Pan;Pad;Ph;Pv: aspect ratio, then the size in pixels
+    raster_width_ = std::min(params_[2], max_width_);
+    raster_height_ = std::min(params_[3], max_height_);
+    Reserve(raster_width_, raster_height_);
+    break;
+  case kData:
+    break;
+  }
+  state_ = kData;
+}
+
+void SixelDecoder::DefineColor(int reg, int space, int a, int b, int c) {
+  if (space == 2) {
+    palette_[reg] = Opaque(PercentToByte(a), PercentToByte(b),
+                           PercentToByte(c));
+  } else if (space == 1) {
+    // DEC's HLS puts blue at 0 degrees where the usual model has red.
+    double hue = (a % 360) + 240;
+    double light = std::min(b, 100) / 100.0;
+    double sat = std::min(c, 100) / 100.0;
+    double m2 = light <= 0.5 ? light * (1 + sat) : light + sat - light * sat;
+    double m1 = 2 * light - m2;
+    int r = static_cast<int>(HueToComponent(m1, m2, hue + 120) * 255 + 0.5);
+    int g = static_cast<int>(HueToComponent(m1, m2, hue) * 255 + 0.5);
+    int bl = static_cast<int>(HueToComponent(m1, m2, hue - 120) * 255 + 0.5);
+    palette_[reg] = Opaque(r, g, bl);
+  }
+}
+
+void SixelDecoder::Sixel(int bits) {
+  int x_end = std::min(x_ + repeat_, max_width_);
+  int top = band_ * 6;
+  if (x_end > x_ && top < max_height_) {
+    int bottom = std::min(top + 6, max_height_);
+    if (bits != 0) {
+      Reserve(x_end, bottom);
+      for (int y = top; y < bottom; y++) {
+        if ((bits & (1 << (y - top))) == 0) {
+          continue;
+        }
+        uint32_t* row = &pixels_[static_cast<size_t>(y) * stride_];
+        std::fill(row + x_, row + x_end, color_);
+      }
+    }
+    width_ = std::max(width_, x_end);
+    height_ = std::max(height_, bottom);
+  }
+  x_ = std::min(x_ + repeat_, kMaxParam);
+}
+
+void SixelDecoder::Reserve(int width, int height) {
+  if (width > stride_) {
+    int stride = std::min(std::max(width, 2 * stride_), max_width_);
+    std::vector<uint32_t> wider(static_cast<size_t>(stride) * rows_);
+    for (int y = 0; y < rows_; y++) {
+      std::copy(pixels_.begin() + static_cast<size_t>(y) * stride_,
+                pixels_.begin() + static_cast<size_t>(y + 1) * stride_,
+                wider.begin() + static_cast<size_t>(y) * stride);
+    }
+    pixels_.swap(wider);
+    stride_ = stride;
+  }
+  if (height > rows_) {
+    rows_ = std::min(std::max(height, 2 * rows_), max_height_);
+    pixels_.resize(static_cast<size_t>(stride_) * rows_);
+  }
+}
+
+int SixelDecoder::width() const {
+  return std::max(width_, raster_width_);
+}
+
+int SixelDecoder::height() const {
+  // Bands are six pixels high; the raster attributes say how much of the
+  // last one is really part of the image.
+  return raster_height_ > height_ - 6 ? raster_height_ : height_;
+}
+
+void SixelDecoder::CopyPixels(uint32_t* out) const {
+  int w = width();
+  int h = height();
+  for (int y = 0; y < h; y++) {
+    uint32_t* dst = out + static_cast<size_t>(y) * w;
+    int copy = y < rows_ ? std::min(w, stride_) : 0;
+    if (copy > 0) {
+      memcpy(dst, &pixels_[static_cast<size_t>(y) * stride_],
+             copy * sizeof(uint32_t));
+    }
+    std::fill(dst + copy, dst + w, 0);
+  }
+}
+
+Base64Decoder::Base64Decoder(size_t max_bytes)
+    : max_bytes_(max_bytes), bits_(0), bit_count_(0), overflow_(false) {}
+
+bool Base64Decoder::Feed(const char* data, size_t len) {
+  for (size_t i = 0; i < len && !overflow_; i++) {
+    char c = data[i];
+    int value;
+    if (c >= 'A' && c <= 'Z') {
+      value = c - 'A';
+    } else if (c >= 'a' && c <= 'z') {
+      value = c - 'a' + 26;
+    } else if (c >= '0' && c <= '9') {
+      value = c - '0' + 52;
+    } else if (c == '+' || c == '-') {
+      value = 62;
+    } else if (c == '/' || c == '_') {
+      value = 63;
+    } else {
+      continue;
+    }
+
+    bits_ = (bits_ << 6) | value;
+    bit_count_ += 6;
+    if (bit_count_ >= 8) {
+      bit_count_ -= 8;
+      if (bytes_.size() >= max_bytes_) {
+        overflow_ = true;
+        break;
+      }
+      bytes_.push_back(static_cast<uint8_t>(bits_ >> bit_count_));
+    }
+  }
+  return !overflow_;
+}
+
+}  // namespace connectbot
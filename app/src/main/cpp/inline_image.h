@@ -0,0 +1,101 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CONNECTBOT_INLINE_IMAGE_H_
+#define CONNECTBOT_INLINE_IMAGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace connectbot {
+
+// Decodes a sixel image (the payload of DCS P1;P2;P3 q ... ST) as it
+// arrives, in any number of pieces. Pixels that no sixel sets stay
+// transparent so the cell background shows through. Drawing outside
+// |max_width| x |max_height| is clipped, which bounds the memory a remote
+// host can make us allocate.
+class SixelDecoder {
+ public:
+  SixelDecoder(int max_width, int max_height);
+
+  void Feed(const char* data, size_t len);
+
+  // Size of the image so far: what has been drawn, or what the raster
+  // attributes announced.
+  int width() const;
+  int height() const;
+
+  // Copies the image as width() x height() ARGB pixels.
+  void CopyPixels(uint32_t* out) const;
+
+ private:
+  enum State { kData, kRepeat, kColor, kRaster };
+  static const int kMaxParams = 5;
+
+  void EndParams();
+  void DefineColor(int reg, int space, int a, int b, int c);
+  void Sixel(int bits);
+  void Reserve(int width, int height);
+
+  const int max_width_;
+  const int max_height_;
+
+  State state_;
+  int params_[kMaxParams];
+  int param_index_;
+
+  uint32_t palette_[256];
+  uint32_t color_;
+  int x_;
+  int band_;
+  int repeat_;
+
+  int width_;
+  int height_;
+  int raster_width_;
+  int raster_height_;
+
+  // Row-major pixels, |stride_| wide and |rows_| high.
+  std::vector<uint32_t> pixels_;
+  int stride_;
+  int rows_;
+};
+
+// Decodes base64 as it arrives, skipping line breaks and anything else
+// that is not part of the alphabet.
+class Base64Decoder {
+ public:
+  explicit Base64Decoder(size_t max_bytes);
+
+  // Returns false once the decoded data would be larger than |max_bytes|;
+  // everything after that is dropped.
+  bool Feed(const char* data, size_t len);
+
+  const std::vector<uint8_t>& bytes() const { return bytes_; }
+
+ private:
+  const size_t max_bytes_;
+  uint32_t bits_;
+  int bit_count_;
+  bool overflow_;
+  std::vector<uint8_t> bytes_;
+};
+
+}  // namespace connectbot
+
+#endif  // CONNECTBOT_INLINE_IMAGE_H_
@@ -0,0 +1,124 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "org_connectbot_util_NativeCellRenderer.h"
+
+#include <android/bitmap.h>
+
+#include "android/log.h"
+#include "cell_renderer.h"
+
+#define LOG_TAG "CellRenderer"
+#define LOG(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using connectbot::CellRenderer;
+
+namespace {
+
+// Returned by nativeRenderRow when the row could not be drawn at all.
+const jint kRenderFailed = -2;
+
+CellRenderer* FromHandle(jlong handle) {
+  return reinterpret_cast<CellRenderer*>(handle);
+}
+
+}  // namespace
+
+JNIEXPORT jlong JNICALL Java_org_connectbot_util_NativeCellRenderer_nativeCreate(
+    JNIEnv* env, jclass clazz, jint cellWidth, jint cellHeight,
+    jint underlineRow) {
+  return reinterpret_cast<jlong>(
+      new CellRenderer(cellWidth, cellHeight, underlineRow));
+}
+
+JNIEXPORT void JNICALL Java_org_connectbot_util_NativeCellRenderer_nativeDestroy(
+    JNIEnv* env, jclass clazz, jlong handle) {
+  delete FromHandle(handle);
+}
+
+JNIEXPORT jboolean JNICALL Java_org_connectbot_util_NativeCellRenderer_nativeAddGlyph(
+    JNIEnv* env, jclass clazz, jlong handle, jchar ch, jboolean wide,
+    jbyteArray coverage, jint stride) {
+  CellRenderer* renderer = FromHandle(handle);
+  jsize length = env->GetArrayLength(coverage);
+  jsize needed = stride * (renderer->cell_height() - 1)
+      + (wide ? 2 : 1) * renderer->cell_width();
+  if (stride < 0 || length < needed) {
+    LOG("Glyph coverage too short: %d < %d", length, needed);
+    return JNI_FALSE;
+  }
+
+  jbyte* bytes = env->GetByteArrayElements(coverage, NULL);
+  if (bytes == NULL) {
+    return JNI_FALSE;
+  }
+  renderer->AddGlyph(ch, wide, reinterpret_cast<uint8_t*>(bytes), stride);
+  env->ReleaseByteArrayElements(coverage, bytes, JNI_ABORT);
+  return JNI_TRUE;
+}
+
+JNIEXPORT jint JNICALL Java_org_connectbot_util_NativeCellRenderer_nativeRenderRow(
+    JNIEnv* env, jclass clazz, jlong handle, jobject bitmap, jint row,
+    jcharArray chars, jintArray fg, jintArray bg, jbyteArray flags,
+    jint columns) {
+  CellRenderer* renderer = FromHandle(handle);
+
+  AndroidBitmapInfo info;
+  if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS
+      || info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+    LOG("Unsupported bitmap");
+    return kRenderFailed;
+  }
+
+  if (row < 0 || columns < 0
+      || static_cast<uint32_t>(columns * renderer->cell_width()) > info.width
+      || static_cast<uint32_t>((row + 1) * renderer->cell_height()) > info.height
+      || env->GetArrayLength(chars) < columns
+      || env->GetArrayLength(fg) < columns
+      || env->GetArrayLength(bg) < columns
+      || env->GetArrayLength(flags) < columns) {
+    LOG("Row %d with %d columns does not fit", row, columns);
+    return kRenderFailed;
+  }
+
+  void* pixels;
+  if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
+    LOG("Could not lock bitmap pixels");
+    return kRenderFailed;
+  }
+
+  // No JNI calls are allowed until these are released.
+  jchar* c = static_cast<jchar*>(env->GetPrimitiveArrayCritical(chars, NULL));
+  jint* f = static_cast<jint*>(env->GetPrimitiveArrayCritical(fg, NULL));
+  jint* b = static_cast<jint*>(env->GetPrimitiveArrayCritical(bg, NULL));
+  jbyte* fl = static_cast<jbyte*>(env->GetPrimitiveArrayCritical(flags, NULL));
+
+  jint result = kRenderFailed;
+  if (c != NULL && f != NULL && b != NULL && fl != NULL) {
+    result = renderer->RenderRow(
+        static_cast<uint32_t*>(pixels), info.stride / 4, row, columns, c,
+        reinterpret_cast<uint32_t*>(f), reinterpret_cast<uint32_t*>(b),
+        reinterpret_cast<uint8_t*>(fl));
+  }
+
+  if (fl != NULL) env->ReleasePrimitiveArrayCritical(flags, fl, JNI_ABORT);
+  if (b != NULL) env->ReleasePrimitiveArrayCritical(bg, b, JNI_ABORT);
+  if (f != NULL) env->ReleasePrimitiveArrayCritical(fg, f, JNI_ABORT);
+  if (c != NULL) env->ReleasePrimitiveArrayCritical(chars, c, JNI_ABORT);
+
+  AndroidBitmap_unlockPixels(env, bitmap);
+  return result;
+}
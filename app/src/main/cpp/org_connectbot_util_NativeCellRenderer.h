@@ -0,0 +1,45 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_connectbot_util_NativeCellRenderer */
+
+#ifndef _Included_org_connectbot_util_NativeCellRenderer
+#define _Included_org_connectbot_util_NativeCellRenderer
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_connectbot_util_NativeCellRenderer
+ * Method:    nativeCreate
+ * Signature: (III)J
+ */
+JNIEXPORT jlong JNICALL Java_org_connectbot_util_NativeCellRenderer_nativeCreate
+  (JNIEnv *, jclass, jint, jint, jint);
+
+/*
+ * Class:     org_connectbot_util_NativeCellRenderer
+ * Method:    nativeDestroy
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_connectbot_util_NativeCellRenderer_nativeDestroy
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_connectbot_util_NativeCellRenderer
+ * Method:    nativeAddGlyph
+ * Signature: (JCZ[BI)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_connectbot_util_NativeCellRenderer_nativeAddGlyph
+  (JNIEnv *, jclass, jlong, jchar, jboolean, jbyteArray, jint);
+
+/*
+ * Class:     org_connectbot_util_NativeCellRenderer
+ * Method:    nativeRenderRow
+ * Signature: (JLandroid/graphics/Bitmap;I[C[I[I[BI)I
+ */
+JNIEXPORT jint JNICALL Java_org_connectbot_util_NativeCellRenderer_nativeRenderRow
+  (JNIEnv *, jclass, jlong, jobject, jint, jcharArray, jintArray, jintArray, jbyteArray, jint);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
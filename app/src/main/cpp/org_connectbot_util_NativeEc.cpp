@@ -0,0 +1,86 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "org_connectbot_util_NativeEc.h"
+
+#include <vector>
+
+#include "android/log.h"
+#include "ec_scalar.h"
+
+#define LOG_TAG "NativeEc"
+#define LOG(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using connectbot::EcCoordinateLength;
+using connectbot::EcCurve;
+using connectbot::EcFindCurve;
+using connectbot::EcMultiplyBase;
+
+namespace {
+
+std::vector<uint8_t> GetBytes(JNIEnv* env, jbyteArray array) {
+  std::vector<uint8_t> bytes(env->GetArrayLength(array));
+  if (!bytes.empty()) {
+    env->GetByteArrayRegion(array, 0, bytes.size(),
+                            reinterpret_cast<jbyte*>(bytes.data()));
+  }
+  return bytes;
+}
+
+// Clears the private scalar before the vector frees it.
+void Wipe(std::vector<uint8_t>* bytes) {
+  volatile uint8_t* v = bytes->data();
+  for (size_t i = 0; i < bytes->size(); i++) {
+    v[i] = 0;
+  }
+}
+
+}  // namespace
+
+JNIEXPORT jbyteArray JNICALL Java_org_connectbot_util_NativeEc_nativeMultiplyBase(
+    JNIEnv* env, jclass clazz, jbyteArray p, jbyteArray gx, jbyteArray gy,
+    jbyteArray scalar) {
+  std::vector<uint8_t> prime = GetBytes(env, p);
+  std::vector<uint8_t> x = GetBytes(env, gx);
+  std::vector<uint8_t> y = GetBytes(env, gy);
+  if (prime.empty() || x.empty() || y.empty()) {
+    return NULL;
+  }
+
+  EcCurve curve;
+  if (!EcFindCurve(prime.data(), prime.size(), x.data(), x.size(), y.data(),
+                   y.size(), &curve)) {
+    return NULL;
+  }
+
+  std::vector<uint8_t> k = GetBytes(env, scalar);
+  size_t len = EcCoordinateLength(curve);
+  std::vector<uint8_t> point(2 * len);
+  bool ok = !k.empty()
+      && EcMultiplyBase(curve, k.data(), k.size(), &point[0], &point[len]);
+  Wipe(&k);
+  if (!ok) {
+    LOG("Private scalar out of range");
+    return NULL;
+  }
+
+  jbyteArray result = env->NewByteArray(point.size());
+  if (result != NULL) {
+    env->SetByteArrayRegion(result, 0, point.size(),
+                            reinterpret_cast<const jbyte*>(point.data()));
+  }
+  return result;
+}
@@ -0,0 +1,21 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_connectbot_util_NativeEc */
+
+#ifndef _Included_org_connectbot_util_NativeEc
+#define _Included_org_connectbot_util_NativeEc
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_connectbot_util_NativeEc
+ * Method:    nativeMultiplyBase
+ * Signature: ([B[B[B[B)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_org_connectbot_util_NativeEc_nativeMultiplyBase
+  (JNIEnv *, jclass, jbyteArray, jbyteArray, jbyteArray, jbyteArray);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,156 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "org_connectbot_util_NativeImageDecoder.h"
+
+#include <vector>
+
+#include "android/log.h"
+#include "inline_image.h"
+
+#define LOG_TAG "NativeImageDecoder"
+#define LOG(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using connectbot::Base64Decoder;
+using connectbot::SixelDecoder;
+
+namespace {
+
+// Formats for nativeCreate(); must match NativeImageDecoder.java.
+const jint kFormatSixel = 0;
+const jint kFormatBase64 = 1;
+
+// Characters are copied out of the Java array this many at a time.
+const jint kChunk = 4096;
+
+struct Decoder {
+  Decoder(jint format, jint max_width, jint max_height, jint max_bytes)
+      : sixel(format == kFormatSixel ? new SixelDecoder(max_width, max_height)
+                                     : NULL),
+        base64(format == kFormatBase64 ? new Base64Decoder(max_bytes)
+                                       : NULL) {}
+
+  ~Decoder() {
+    delete sixel;
+    delete base64;
+  }
+
+  SixelDecoder* sixel;
+  Base64Decoder* base64;
+};
+
+Decoder* FromHandle(jlong handle) {
+  return reinterpret_cast<Decoder*>(handle);
+}
+
+}  // namespace
+
+JNIEXPORT jlong JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeCreate(
+    JNIEnv* env, jclass clazz, jint format, jint maxWidth, jint maxHeight,
+    jint maxBytes) {
+  if (format != kFormatSixel && format != kFormatBase64) {
+    LOG("Unknown image format %d", format);
+    return 0;
+  }
+  return reinterpret_cast<jlong>(
+      new Decoder(format, maxWidth, maxHeight, maxBytes));
+}
+
+JNIEXPORT void JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeDestroy(
+    JNIEnv* env, jclass clazz, jlong handle) {
+  delete FromHandle(handle);
+}
+
+JNIEXPORT jboolean JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeFeed(
+    JNIEnv* env, jclass clazz, jlong handle, jcharArray data, jint offset,
+    jint length) {
+  Decoder* decoder = FromHandle(handle);
+  if (offset < 0 || length < 0
+      || env->GetArrayLength(data) - offset < length) {
+    LOG("Feed out of bounds: %d + %d", offset, length);
+    return JNI_FALSE;
+  }
+
+  jchar wide[kChunk];
+  char narrow[kChunk];
+  bool ok = true;
+  while (length > 0 && ok) {
+    jint n = length < kChunk ? length : kChunk;
+    env->GetCharArrayRegion(data, offset, n, wide);
+    // Both formats are plain ASCII; anything else is noise to skip.
+    for (jint i = 0; i < n; i++) {
+      narrow[i] = wide[i] < 0x80 ? static_cast<char>(wide[i]) : ' ';
+    }
+    if (decoder->sixel != NULL) {
+      decoder->sixel->Feed(narrow, n);
+    } else {
+      ok = decoder->base64->Feed(narrow, n);
+    }
+    offset += n;
+    length -= n;
+  }
+  return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeGetWidth(
+    JNIEnv* env, jclass clazz, jlong handle) {
+  Decoder* decoder = FromHandle(handle);
+  return decoder->sixel != NULL ? decoder->sixel->width() : 0;
+}
+
+JNIEXPORT jint JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeGetHeight(
+    JNIEnv* env, jclass clazz, jlong handle) {
+  Decoder* decoder = FromHandle(handle);
+  return decoder->sixel != NULL ? decoder->sixel->height() : 0;
+}
+
+JNIEXPORT jintArray JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeGetPixels(
+    JNIEnv* env, jclass clazz, jlong handle) {
+  SixelDecoder* sixel = FromHandle(handle)->sixel;
+  if (sixel == NULL) {
+    return NULL;
+  }
+  size_t count = static_cast<size_t>(sixel->width()) * sixel->height();
+  if (count == 0) {
+    return NULL;
+  }
+
+  std::vector<uint32_t> pixels(count);
+  sixel->CopyPixels(&pixels[0]);
+  jintArray array = env->NewIntArray(count);
+  if (array == NULL) {
+    return NULL;
+  }
+  env->SetIntArrayRegion(array, 0, count,
+                         reinterpret_cast<const jint*>(&pixels[0]));
+  return array;
+}
+
+JNIEXPORT jbyteArray JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeGetBytes(
+    JNIEnv* env, jclass clazz, jlong handle) {
+  Base64Decoder* base64 = FromHandle(handle)->base64;
+  if (base64 == NULL) {
+    return NULL;
+  }
+  const std::vector<uint8_t>& bytes = base64->bytes();
+  jbyteArray array = env->NewByteArray(bytes.size());
+  if (array == NULL || bytes.empty()) {
+    return array;
+  }
+  env->SetByteArrayRegion(array, 0, bytes.size(),
+                          reinterpret_cast<const jbyte*>(&bytes[0]));
+  return array;
+}
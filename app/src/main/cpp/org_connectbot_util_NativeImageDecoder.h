@@ -0,0 +1,69 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_connectbot_util_NativeImageDecoder */
+
+#ifndef _Included_org_connectbot_util_NativeImageDecoder
+#define _Included_org_connectbot_util_NativeImageDecoder
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_connectbot_util_NativeImageDecoder
+ * Method:    nativeCreate
+ * Signature: (IIII)J
+ */
+JNIEXPORT jlong JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeCreate
+  (JNIEnv *, jclass, jint, jint, jint, jint);
+
+/*
+ * Class:     org_connectbot_util_NativeImageDecoder
+ * Method:    nativeDestroy
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeDestroy
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_connectbot_util_NativeImageDecoder
+ * Method:    nativeFeed
+ * Signature: (J[CII)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeFeed
+  (JNIEnv *, jclass, jlong, jcharArray, jint, jint);
+
+/*
+ * Class:     org_connectbot_util_NativeImageDecoder
+ * Method:    nativeGetWidth
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeGetWidth
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_connectbot_util_NativeImageDecoder
+ * Method:    nativeGetHeight
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeGetHeight
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_connectbot_util_NativeImageDecoder
+ * Method:    nativeGetPixels
+ * Signature: (J)[I
+ */
+JNIEXPORT jintArray JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeGetPixels
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_connectbot_util_NativeImageDecoder
+ * Method:    nativeGetBytes
+ * Signature: (J)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_org_connectbot_util_NativeImageDecoder_nativeGetBytes
+  (JNIEnv *, jclass, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
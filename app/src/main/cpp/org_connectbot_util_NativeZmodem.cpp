@@ -0,0 +1,269 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "org_connectbot_util_NativeZmodem.h"
+
+#include <vector>
+
+#include "android/log.h"
+#include "zmodem.h"
+
+#define LOG_TAG "NativeZmodem"
+#define LOG(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using connectbot::ZmodemEngine;
+using connectbot::ZmodemHost;
+
+namespace {
+
+// Bits of nativeGetState(); must match NativeZmodem.java.
+const jint kStateFinished = 1;
+const jint kStateSucceeded = 2;
+const jint kStateSending = 4;
+
+// Calls back into a NativeZmodem.Host. Only used on the thread that called
+// into native code, with that thread's JNIEnv. Once a callback throws, the
+// exception stays pending for the caller and every later callback fails
+// without touching Java.
+class JavaHost : public ZmodemHost {
+ public:
+  JavaHost(JNIEnv* env, jobject host)
+      : env_(env), host_(env->NewGlobalRef(host)), buffer_(NULL),
+        buffer_size_(0) {
+    jclass clazz = env->GetObjectClass(host);
+    write_ = env->GetMethodID(clazz, "write", "([B)V");
+    open_received_ = env->GetMethodID(clazz, "openReceived",
+                                      "(Ljava/lang/String;J)Z");
+    write_received_ = env->GetMethodID(clazz, "writeReceived", "([BI)Z");
+    close_received_ = env->GetMethodID(clazz, "closeReceived", "(Z)V");
+    next_to_send_ = env->GetMethodID(clazz, "nextToSend",
+                                     "()Ljava/lang/String;");
+    size_to_send_ = env->GetMethodID(clazz, "sizeToSend", "()J");
+    read_to_send_ = env->GetMethodID(clazz, "readToSend", "(J[BI)I");
+    close_sent_ = env->GetMethodID(clazz, "closeSent", "(Z)V");
+    env->DeleteLocalRef(clazz);
+  }
+
+  ~JavaHost() {
+    if (buffer_ != NULL) {
+      env_->DeleteGlobalRef(buffer_);
+    }
+    env_->DeleteGlobalRef(host_);
+  }
+
+  void Attach(JNIEnv* env) { env_ = env; }
+
+  bool Write(const uint8_t* data, size_t len) override {
+    if (env_->ExceptionCheck()) {
+      return false;
+    }
+    jbyteArray array = env_->NewByteArray(len);
+    if (array == NULL) {
+      return false;
+    }
+    env_->SetByteArrayRegion(array, 0, len,
+                             reinterpret_cast<const jbyte*>(data));
+    env_->CallVoidMethod(host_, write_, array);
+    env_->DeleteLocalRef(array);
+    return !env_->ExceptionCheck();
+  }
+
+  bool OpenReceived(const std::string& name, int64_t size) override {
+    if (env_->ExceptionCheck()) {
+      return false;
+    }
+    // File names are raw bytes on the wire; pass only printable ASCII
+    // through NewStringUTF, which rejects invalid modified UTF-8.
+    std::string safe;
+    for (size_t i = 0; i < name.size(); i++) {
+      char c = name[i];
+      safe.push_back(c >= 0x20 && c < 0x7f ? c : '_');
+    }
+    jstring jname = env_->NewStringUTF(safe.c_str());
+    if (jname == NULL) {
+      return false;
+    }
+    jboolean ok = env_->CallBooleanMethod(host_, open_received_, jname,
+                                          static_cast<jlong>(size));
+    env_->DeleteLocalRef(jname);
+    return !env_->ExceptionCheck() && ok;
+  }
+
+  bool WriteReceived(const uint8_t* data, size_t len) override {
+    if (env_->ExceptionCheck() || !Reserve(len)) {
+      return false;
+    }
+    env_->SetByteArrayRegion(buffer_, 0, len,
+                             reinterpret_cast<const jbyte*>(data));
+    jboolean ok = env_->CallBooleanMethod(host_, write_received_, buffer_,
+                                          static_cast<jint>(len));
+    return !env_->ExceptionCheck() && ok;
+  }
+
+  void CloseReceived(bool complete) override {
+    if (!env_->ExceptionCheck()) {
+      env_->CallVoidMethod(host_, close_received_,
+                           static_cast<jboolean>(complete));
+    }
+  }
+
+  bool NextToSend(std::string* name, int64_t* size) override {
+    if (env_->ExceptionCheck()) {
+      return false;
+    }
+    jstring jname = static_cast<jstring>(
+        env_->CallObjectMethod(host_, next_to_send_));
+    if (env_->ExceptionCheck() || jname == NULL) {
+      return false;
+    }
+    const char* chars = env_->GetStringUTFChars(jname, NULL);
+    if (chars == NULL) {
+      env_->DeleteLocalRef(jname);
+      return false;
+    }
+    name->assign(chars);
+    env_->ReleaseStringUTFChars(jname, chars);
+    env_->DeleteLocalRef(jname);
+
+    *size = env_->CallLongMethod(host_, size_to_send_);
+    return !env_->ExceptionCheck();
+  }
+
+  int64_t ReadToSend(int64_t offset, uint8_t* data, size_t len) override {
+    if (env_->ExceptionCheck() || !Reserve(len)) {
+      return -1;
+    }
+    jint n = env_->CallIntMethod(host_, read_to_send_,
+                                 static_cast<jlong>(offset), buffer_,
+                                 static_cast<jint>(len));
+    if (env_->ExceptionCheck() || n < 0 || static_cast<size_t>(n) > len) {
+      return -1;
+    }
+    env_->GetByteArrayRegion(buffer_, 0, n, reinterpret_cast<jbyte*>(data));
+    return n;
+  }
+
+  void CloseSent(bool complete) override {
+    if (!env_->ExceptionCheck()) {
+      env_->CallVoidMethod(host_, close_sent_,
+                           static_cast<jboolean>(complete));
+    }
+  }
+
+ private:
+  // Makes sure the reusable transfer array holds at least |len| bytes.
+  bool Reserve(size_t len) {
+    if (buffer_size_ >= len) {
+      return true;
+    }
+    jbyteArray array = env_->NewByteArray(len);
+    if (array == NULL) {
+      return false;
+    }
+    if (buffer_ != NULL) {
+      env_->DeleteGlobalRef(buffer_);
+    }
+    buffer_ = static_cast<jbyteArray>(env_->NewGlobalRef(array));
+    env_->DeleteLocalRef(array);
+    buffer_size_ = len;
+    return true;
+  }
+
+  JNIEnv* env_;
+  jobject host_;
+  jbyteArray buffer_;
+  size_t buffer_size_;
+
+  jmethodID write_;
+  jmethodID open_received_;
+  jmethodID write_received_;
+  jmethodID close_received_;
+  jmethodID next_to_send_;
+  jmethodID size_to_send_;
+  jmethodID read_to_send_;
+  jmethodID close_sent_;
+};
+
+struct Session {
+  Session(JNIEnv* env, jobject host) : host(env, host), engine(&this->host) {}
+
+  JavaHost host;
+  ZmodemEngine engine;
+};
+
+Session* FromHandle(JNIEnv* env, jlong handle) {
+  Session* session = reinterpret_cast<Session*>(handle);
+  session->host.Attach(env);
+  return session;
+}
+
+}  // namespace
+
+JNIEXPORT jlong JNICALL Java_org_connectbot_util_NativeZmodem_nativeCreate(
+    JNIEnv* env, jclass clazz, jobject host) {
+  return reinterpret_cast<jlong>(new Session(env, host));
+}
+
+JNIEXPORT jint JNICALL Java_org_connectbot_util_NativeZmodem_nativeFeed(
+    JNIEnv* env, jclass clazz, jlong handle, jbyteArray data, jint offset,
+    jint length) {
+  Session* session = FromHandle(env, handle);
+  if (length <= 0) {
+    return 0;
+  }
+  std::vector<uint8_t> bytes(length);
+  env->GetByteArrayRegion(data, offset, length,
+                          reinterpret_cast<jbyte*>(bytes.data()));
+  if (env->ExceptionCheck()) {
+    return 0;
+  }
+  return session->engine.Feed(bytes.data(), bytes.size());
+}
+
+JNIEXPORT jboolean JNICALL Java_org_connectbot_util_NativeZmodem_nativePump(
+    JNIEnv* env, jclass clazz, jlong handle) {
+  return FromHandle(env, handle)->engine.Pump();
+}
+
+JNIEXPORT void JNICALL Java_org_connectbot_util_NativeZmodem_nativeCancel(
+    JNIEnv* env, jclass clazz, jlong handle) {
+  FromHandle(env, handle)->engine.Cancel();
+}
+
+JNIEXPORT jint JNICALL Java_org_connectbot_util_NativeZmodem_nativeGetState(
+    JNIEnv* env, jclass clazz, jlong handle) {
+  const ZmodemEngine& engine = FromHandle(env, handle)->engine;
+  jint state = 0;
+  if (engine.finished()) {
+    state |= kStateFinished;
+  }
+  if (engine.succeeded()) {
+    state |= kStateSucceeded;
+  }
+  if (engine.sending()) {
+    state |= kStateSending;
+  }
+  return state;
+}
+
+JNIEXPORT void JNICALL Java_org_connectbot_util_NativeZmodem_nativeDestroy(
+    JNIEnv* env, jclass clazz, jlong handle) {
+  Session* session = FromHandle(env, handle);
+  if (!session->engine.finished()) {
+    LOG("Destroying an unfinished ZMODEM session");
+  }
+  delete session;
+}
@@ -0,0 +1,61 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class org_connectbot_util_NativeZmodem */
+
+#ifndef _Included_org_connectbot_util_NativeZmodem
+#define _Included_org_connectbot_util_NativeZmodem
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     org_connectbot_util_NativeZmodem
+ * Method:    nativeCreate
+ * Signature: (Lorg/connectbot/util/NativeZmodem$Host;)J
+ */
+JNIEXPORT jlong JNICALL Java_org_connectbot_util_NativeZmodem_nativeCreate
+  (JNIEnv *, jclass, jobject);
+
+/*
+ * Class:     org_connectbot_util_NativeZmodem
+ * Method:    nativeFeed
+ * Signature: (J[BII)I
+ */
+JNIEXPORT jint JNICALL Java_org_connectbot_util_NativeZmodem_nativeFeed
+  (JNIEnv *, jclass, jlong, jbyteArray, jint, jint);
+
+/*
+ * Class:     org_connectbot_util_NativeZmodem
+ * Method:    nativePump
+ * Signature: (J)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_connectbot_util_NativeZmodem_nativePump
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_connectbot_util_NativeZmodem
+ * Method:    nativeCancel
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_connectbot_util_NativeZmodem_nativeCancel
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_connectbot_util_NativeZmodem
+ * Method:    nativeGetState
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_org_connectbot_util_NativeZmodem_nativeGetState
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_connectbot_util_NativeZmodem
+ * Method:    nativeDestroy
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_connectbot_util_NativeZmodem_nativeDestroy
+  (JNIEnv *, jclass, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
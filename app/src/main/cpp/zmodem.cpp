@@ -0,0 +1,838 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "zmodem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace connectbot {
+
+namespace {
+
+const uint8_t kPad = '*';
+const uint8_t kDle = 0x18;  // ZDLE, which is also CAN
+const uint8_t kBin16 = 'A';
+const uint8_t kHex = 'B';
+const uint8_t kBin32 = 'C';
+const uint8_t kXon = 0x11;
+
+// Frame types.
+const int kRqInit = 0;
+const int kRInit = 1;
+const int kSInit = 2;
+const int kAck = 3;
+const int kFile = 4;
+const int kSkip = 5;
+const int kNak = 6;
+const int kAbort = 7;
+const int kFin = 8;
+const int kRPos = 9;
+const int kData = 10;
+const int kEof = 11;
+const int kFErr = 12;
+const int kCompl = 15;
+const int kCan = 16;
+const int kFreeCnt = 17;
+const int kCommand = 18;
+
+// ZDLE sequences that end a data subpacket or stand for DEL.
+const uint8_t kCrcE = 'h';
+const uint8_t kCrcG = 'i';
+const uint8_t kCrcQ = 'j';
+const uint8_t kCrcW = 'k';
+const uint8_t kRub0 = 'l';
+const uint8_t kRub1 = 'm';
+
+// ZRINIT capability flags.
+const uint8_t kCanFdx = 0x01;
+const uint8_t kCanOvIo = 0x02;
+const uint8_t kCanFc32 = 0x20;
+const uint8_t kEscCtl = 0x40;
+
+// ZFILE conversion option: binary transfer.
+const uint8_t kConvBinary = 1;
+
+// Results of Unescape() that are not a data byte.
+const int kPending = -1;
+const int kInvalid = -2;
+const int kFrameEnd = 0x100;
+
+const size_t kBlockSize = 1024;
+const uint32_t kWindow = 32768;
+const size_t kMaxSubpacket = 8192;
+
+const char kHexDigits[] = "0123456789abcdef";
+
+struct CrcTables {
+  uint16_t crc16[256];
+  uint32_t crc32[256];
+
+  CrcTables() {
+    for (int i = 0; i < 256; i++) {
+      uint16_t c16 = i << 8;
+      uint32_t c32 = i;
+      for (int bit = 0; bit < 8; bit++) {
+        c16 = (c16 & 0x8000) ? (c16 << 1) ^ 0x1021 : c16 << 1;
+        c32 = (c32 & 1) ? (c32 >> 1) ^ 0xedb88320 : c32 >> 1;
+      }
+      crc16[i] = c16;
+      crc32[i] = c32;
+    }
+  }
+};
+
+const CrcTables& Tables() {
+  static const CrcTables tables;
+  return tables;
+}
+
+uint32_t Crc32Of(const uint8_t* data, size_t len, uint8_t end) {
+  uint32_t crc = ZmodemCrc32(0xffffffff, data, len);
+  return ~ZmodemCrc32(crc, &end, 1);
+}
+
+uint16_t Crc16Of(const uint8_t* data, size_t len, uint8_t end) {
+  return ZmodemCrc16(ZmodemCrc16(0, data, len), &end, 1);
+}
+
+int HexValue(uint8_t c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+}  // namespace
+
+const uint8_t ZmodemEngine::kStart[5] = { kPad, kPad, kDle, kHex, '0' };
+
+uint16_t ZmodemCrc16(uint16_t crc, const uint8_t* data, size_t len) {
+  const uint16_t* table = Tables().crc16;
+  for (size_t i = 0; i < len; i++) {
+    crc = (crc << 8) ^ table[((crc >> 8) ^ data[i]) & 0xff];
+  }
+  return crc;
+}
+
+uint32_t ZmodemCrc32(uint32_t crc, const uint8_t* data, size_t len) {
+  const uint32_t* table = Tables().crc32;
+  for (size_t i = 0; i < len; i++) {
+    crc = (crc >> 8) ^ table[(crc ^ data[i]) & 0xff];
+  }
+  return crc;
+}
+
+ZmodemEngine::ZmodemEngine(ZmodemHost* host)
+    : host_(host),
+      role_(kUnknown),
+      done_(false),
+      failed_(false),
+      parse_(kSeekPad),
+      expect_(kNothing),
+      escaped_(false),
+      cancels_(0),
+      header_len_(0),
+      header_need_(0),
+      header_crc32_(false),
+      data_crc32_(false),
+      subpacket_end_(0),
+      crc_len_(0),
+      overs_(0),
+      receiving_file_(false),
+      received_(0),
+      send_(kIdle),
+      sending_file_(false),
+      use_crc32_(false),
+      escape_controls_(false),
+      receiver_buffer_(0),
+      position_(0),
+      acked_(0),
+      last_query_(0),
+      last_sent_(0) {
+  subpacket_.reserve(kMaxSubpacket);
+}
+
+size_t ZmodemEngine::Feed(const uint8_t* data, size_t len) {
+  size_t used = 0;
+  while (used < len && !done_) {
+    uint8_t c = data[used];
+    if (parse_ != kSeekOver) {
+      cancels_ = (c == kDle) ? cancels_ + 1 : 0;
+      if (cancels_ >= 5) {
+        // The remote end gave up.
+        used++;
+        Finish(false);
+        break;
+      }
+    }
+    if (!Consume(c)) {
+      break;
+    }
+    used++;
+  }
+  Flush();
+  return used;
+}
+
+bool ZmodemEngine::Consume(uint8_t c) {
+  switch (parse_) {
+  case kSeekPad:
+    if (c == kPad) {
+      parse_ = kSeekDle;
+    }
+    return true;
+
+  case kSeekDle:
+    if (c == kDle) {
+      parse_ = kSeekFormat;
+    } else if (c != kPad) {
+      parse_ = kSeekPad;
+    }
+    return true;
+
+  case kSeekFormat:
+    header_len_ = 0;
+    escaped_ = false;
+    if (c == kHex) {
+      header_need_ = 14;
+      parse_ = kHexHeader;
+    } else if (c == kBin16 || c == kBin32) {
+      header_crc32_ = c == kBin32;
+      header_need_ = header_crc32_ ? 9 : 7;
+      parse_ = kBinHeader;
+    } else {
+      parse_ = kSeekPad;
+    }
+    return true;
+
+  case kHexHeader: {
+    int value = HexValue(c);
+    if (value < 0) {
+      parse_ = kSeekPad;
+      return true;
+    }
+    if (header_len_ % 2 == 0) {
+      header_[header_len_ / 2] = value << 4;
+    } else {
+      header_[header_len_ / 2] |= value;
+    }
+    if (++header_len_ < header_need_) {
+      return true;
+    }
+    parse_ = kSeekPad;
+    header_crc32_ = false;
+    if (ZmodemCrc16(0, header_, 7) == 0) {
+      OnHeader(header_);
+    }
+    return true;
+  }
+
+  case kBinHeader: {
+    int b = Unescape(c);
+    if (b == kPending) {
+      return true;
+    } else if (b < 0 || b >= kFrameEnd) {
+      parse_ = kSeekPad;
+      return true;
+    }
+    header_[header_len_++] = b;
+    if (header_len_ < header_need_) {
+      return true;
+    }
+    parse_ = kSeekPad;
+    bool ok;
+    if (header_crc32_) {
+      uint32_t crc = ~ZmodemCrc32(0xffffffff, header_, 5);
+      ok = crc == (header_[5] | header_[6] << 8 | header_[7] << 16
+                   | static_cast<uint32_t>(header_[8]) << 24);
+    } else {
+      ok = ZmodemCrc16(0, header_, 7) == 0;
+    }
+    if (ok) {
+      OnHeader(header_);
+    }
+    return true;
+  }
+
+  case kSubpacket: {
+    int b = Unescape(c);
+    if (b == kPending) {
+      return true;
+    } else if (b == kInvalid || subpacket_.size() >= kMaxSubpacket) {
+      OnSubpacket(false);
+    } else if (b >= kFrameEnd) {
+      subpacket_end_ = b & 0xff;
+      crc_len_ = 0;
+      parse_ = kSubpacketCrc;
+    } else {
+      subpacket_.push_back(b);
+    }
+    return true;
+  }
+
+  case kSubpacketCrc: {
+    int b = Unescape(c);
+    if (b == kPending) {
+      return true;
+    } else if (b < 0 || b >= kFrameEnd) {
+      OnSubpacket(false);
+      return true;
+    }
+    crc_[crc_len_++] = b;
+    if (crc_len_ < (data_crc32_ ? 4u : 2u)) {
+      return true;
+    }
+    bool ok;
+    if (data_crc32_) {
+      uint32_t crc = Crc32Of(subpacket_.data(), subpacket_.size(),
+                             subpacket_end_);
+      ok = crc == (crc_[0] | crc_[1] << 8 | crc_[2] << 16
+                   | static_cast<uint32_t>(crc_[3]) << 24);
+    } else {
+      uint16_t crc = Crc16Of(subpacket_.data(), subpacket_.size(),
+                             subpacket_end_);
+      ok = crc == (crc_[0] << 8 | crc_[1]);
+    }
+    OnSubpacket(ok);
+    return true;
+  }
+
+  case kSeekOver:
+    // The sender ends the session with "OO" after our ZFIN. Anything else is
+    // the shell again. The end of the ZFIN header may come first.
+    if (overs_ == 0 && ((c & 0x7f) == '\r' || (c & 0x7f) == '\n'
+                        || c == kXon)) {
+      return true;
+    }
+    if (c != 'O') {
+      Finish(true);
+      return false;
+    }
+    if (++overs_ == 2) {
+      Finish(true);
+    }
+    return true;
+  }
+  return true;
+}
+
+int ZmodemEngine::Unescape(uint8_t c) {
+  if (escaped_) {
+    escaped_ = false;
+    switch (c) {
+    case kCrcE:
+    case kCrcG:
+    case kCrcQ:
+    case kCrcW:
+      return kFrameEnd | c;
+    case kRub0:
+      return 0x7f;
+    case kRub1:
+      return 0xff;
+    default:
+      if ((c & 0x60) == 0x40) {
+        return c ^ 0x40;
+      }
+      return kInvalid;
+    }
+  }
+  if (c == kDle) {
+    escaped_ = true;
+    return kPending;
+  }
+  // Flow control from the line is never data.
+  if ((c & 0x7f) == 0x11 || (c & 0x7f) == 0x13) {
+    return kPending;
+  }
+  return c;
+}
+
+void ZmodemEngine::OnHeader(const uint8_t* header) {
+  int type = header[0];
+  uint32_t pos = header[1] | header[2] << 8 | header[3] << 16
+      | static_cast<uint32_t>(header[4]) << 24;
+
+  if (role_ == kUnknown) {
+    if (type == kRqInit) {
+      role_ = kReceiver;
+    } else if (type == kRInit) {
+      role_ = kSender;
+    } else {
+      return;
+    }
+  }
+
+  if (type == kCan || type == kAbort) {
+    Finish(false);
+  } else if (role_ == kReceiver) {
+    OnReceiverHeader(type, pos);
+  } else {
+    OnSenderHeader(type, pos, header + 1);
+  }
+}
+
+void ZmodemEngine::OnReceiverHeader(int type, uint32_t pos) {
+  switch (type) {
+  case kRqInit:
+  case kEof:
+    if (type == kEof) {
+      // A ZEOF that does not match what we have is stale; the sender will
+      // try again.
+      if (!receiving_file_ || pos != received_) {
+        return;
+      }
+      host_->CloseReceived(true);
+      receiving_file_ = false;
+    }
+    // Full duplex with overlapped I/O and no buffer limit, so the sender
+    // can stream.
+    SendHexHeader(kRInit,
+                  static_cast<uint32_t>(kCanFdx | kCanOvIo | kCanFc32) << 24);
+    break;
+
+  case kSInit:
+    expect_ = kSessionInit;
+    StartData(header_crc32_);
+    break;
+
+  case kFile:
+    expect_ = kFileInfo;
+    StartData(header_crc32_);
+    break;
+
+  case kData:
+    if (!receiving_file_) {
+      return;
+    }
+    if (pos != received_) {
+      SendHexHeader(kRPos, received_);
+      return;
+    }
+    expect_ = kFileData;
+    StartData(header_crc32_);
+    break;
+
+  case kFin:
+    if (receiving_file_) {
+      host_->CloseReceived(false);
+      receiving_file_ = false;
+    }
+    SendHexHeader(kFin, 0);
+    overs_ = 0;
+    parse_ = kSeekOver;
+    break;
+
+  case kCommand:
+    // Never run commands for the remote end.
+    expect_ = kCommandLine;
+    StartData(header_crc32_);
+    break;
+
+  case kFreeCnt:
+    SendHexHeader(kAck, 0);
+    break;
+
+  default:
+    break;
+  }
+}
+
+void ZmodemEngine::OnSenderHeader(int type, uint32_t pos,
+                                  const uint8_t* flags) {
+  switch (type) {
+  case kRInit:
+    use_crc32_ = (flags[3] & kCanFc32) != 0;
+    escape_controls_ = (flags[3] & kEscCtl) != 0;
+    receiver_buffer_ = flags[0] | flags[1] << 8;
+    if (send_ == kFileOffered) {
+      // The receiver missed our ZFILE.
+      SendBinaryHeader(kFile, 0, kConvBinary);
+      SendSubpacket(reinterpret_cast<const uint8_t*>(file_info_.data()),
+                    file_info_.size(), kCrcW);
+      break;
+    }
+    if (sending_file_) {
+      host_->CloseSent(send_ == kEofSent);
+      sending_file_ = false;
+    }
+    if (send_ != kFinSent) {
+      OfferNextFile();
+    }
+    break;
+
+  case kRPos:
+    if (!sending_file_) {
+      return;
+    }
+    position_ = pos;
+    acked_ = pos;
+    last_query_ = pos;
+    SendBinaryHeader(kData, position_, 0);
+    send_ = kStreaming;
+    break;
+
+  case kAck:
+    if (send_ == kStreaming || send_ == kAckWait) {
+      if (pos > acked_ && pos <= position_) {
+        acked_ = pos;
+      }
+      if (send_ == kAckWait && acked_ == position_) {
+        SendBinaryHeader(kData, position_, 0);
+        send_ = kStreaming;
+      }
+    }
+    break;
+
+  case kSkip:
+    if (sending_file_) {
+      host_->CloseSent(false);
+      sending_file_ = false;
+      OfferNextFile();
+    }
+    break;
+
+  case kNak:
+    if (send_ == kFileOffered) {
+      SendBinaryHeader(kFile, 0, kConvBinary);
+      SendSubpacket(reinterpret_cast<const uint8_t*>(file_info_.data()),
+                    file_info_.size(), kCrcW);
+    }
+    break;
+
+  case kFin:
+    if (send_ == kFinSent) {
+      out_.push_back('O');
+      out_.push_back('O');
+      Flush();
+      Finish(true);
+    }
+    break;
+
+  case kFErr:
+    Cancel();
+    break;
+
+  default:
+    break;
+  }
+}
+
+void ZmodemEngine::StartData(bool crc32) {
+  data_crc32_ = crc32;
+  escaped_ = false;
+  subpacket_.clear();
+  parse_ = kSubpacket;
+}
+
+void ZmodemEngine::OnSubpacket(bool ok) {
+  Expect expect = expect_;
+  parse_ = kSeekPad;
+  expect_ = kNothing;
+
+  if (!ok) {
+    // Ask for the rest again and ignore everything until the next header.
+    if (expect == kFileData) {
+      SendHexHeader(kRPos, received_);
+    } else {
+      SendHexHeader(kNak, 0);
+    }
+    return;
+  }
+
+  switch (expect) {
+  case kFileInfo:
+    OnFileInfo();
+    return;
+
+  case kSessionInit:
+    SendHexHeader(kAck, 0);
+    return;
+
+  case kCommandLine:
+    SendHexHeader(kCompl, 1);
+    return;
+
+  case kFileData:
+    if (!subpacket_.empty()
+        && !host_->WriteReceived(subpacket_.data(), subpacket_.size())) {
+      Cancel();
+      return;
+    }
+    received_ += subpacket_.size();
+    if (subpacket_end_ == kCrcW || subpacket_end_ == kCrcQ) {
+      SendHexHeader(kAck, received_);
+    }
+    if (subpacket_end_ == kCrcG || subpacket_end_ == kCrcQ) {
+      expect_ = kFileData;
+      StartData(data_crc32_);
+    }
+    return;
+
+  case kNothing:
+    return;
+  }
+}
+
+void ZmodemEngine::OnFileInfo() {
+  // "name\0size mtime mode ...", where everything after the name is
+  // optional.
+  subpacket_.push_back(0);
+  const char* info = reinterpret_cast<const char*>(subpacket_.data());
+  std::string name(info);
+  int64_t size = -1;
+  size_t rest = name.size() + 1;
+  if (rest < subpacket_.size() && info[rest] >= '0' && info[rest] <= '9') {
+    size = strtoll(info + rest, NULL, 10);
+  }
+
+  if (receiving_file_) {
+    host_->CloseReceived(false);
+    receiving_file_ = false;
+  }
+  if (!name.empty() && host_->OpenReceived(name, size)) {
+    receiving_file_ = true;
+    received_ = 0;
+    SendHexHeader(kRPos, 0);
+  } else {
+    SendHexHeader(kSkip, 0);
+  }
+}
+
+void ZmodemEngine::OfferNextFile() {
+  std::string name;
+  int64_t size = -1;
+  if (!host_->NextToSend(&name, &size)) {
+    SendHexHeader(kFin, 0);
+    send_ = kFinSent;
+    return;
+  }
+
+  file_info_ = name;
+  file_info_.push_back('\0');
+  if (size >= 0) {
+    char digits[24];
+    snprintf(digits, sizeof(digits), "%lld", static_cast<long long>(size));
+    file_info_ += digits;
+  }
+  file_info_.push_back('\0');
+
+  sending_file_ = true;
+  send_ = kFileOffered;
+  SendBinaryHeader(kFile, 0, kConvBinary);
+  SendSubpacket(reinterpret_cast<const uint8_t*>(file_info_.data()),
+                file_info_.size(), kCrcW);
+}
+
+bool ZmodemEngine::Pump() {
+  if (done_ || send_ != kStreaming) {
+    return false;
+  }
+
+  bool sent = false;
+  uint8_t block[kBlockSize];
+  while (send_ == kStreaming && position_ - acked_ < kWindow) {
+    int64_t n = host_->ReadToSend(position_, block, sizeof(block));
+    if (n < 0) {
+      Cancel();
+      return false;
+    }
+    sent = true;
+    if (n == 0) {
+      SendSubpacket(NULL, 0, kCrcE);
+      SendBinaryHeader(kEof, position_, 0);
+      send_ = kEofSent;
+      break;
+    }
+
+    position_ += n;
+    uint8_t end = kCrcG;
+    if (receiver_buffer_ != 0 && position_ - acked_ >= receiver_buffer_) {
+      // The receiver cannot overlap disk and line I/O; wait for it to catch
+      // up before the next frame.
+      end = kCrcW;
+      send_ = kAckWait;
+    } else if (position_ - last_query_ >= kWindow / 4) {
+      end = kCrcQ;
+      last_query_ = position_;
+    }
+    SendSubpacket(block, n, end);
+  }
+  return Flush() && sent;
+}
+
+void ZmodemEngine::Cancel() {
+  if (done_) {
+    return;
+  }
+  // Eight CANs abort rz and sz; the backspaces erase them from the
+  // remote tty's line buffer in case nobody was listening.
+  for (int i = 0; i < 8; i++) {
+    out_.push_back(kDle);
+  }
+  for (int i = 0; i < 8; i++) {
+    out_.push_back('\b');
+  }
+  Flush();
+  Finish(false);
+}
+
+void ZmodemEngine::SendHexHeader(int type, uint32_t pos) {
+  uint8_t header[7];
+  header[0] = type;
+  header[1] = pos;
+  header[2] = pos >> 8;
+  header[3] = pos >> 16;
+  header[4] = pos >> 24;
+  uint16_t crc = ZmodemCrc16(0, header, 5);
+  header[5] = crc >> 8;
+  header[6] = crc;
+
+  out_.push_back(kPad);
+  out_.push_back(kPad);
+  out_.push_back(kDle);
+  out_.push_back(kHex);
+  for (int i = 0; i < 7; i++) {
+    out_.push_back(kHexDigits[header[i] >> 4]);
+    out_.push_back(kHexDigits[header[i] & 0xf]);
+  }
+  out_.push_back('\r');
+  out_.push_back('\n' | 0x80);
+  if (type != kFin && type != kAck) {
+    out_.push_back(kXon);
+  }
+  last_sent_ = 0;
+}
+
+void ZmodemEngine::SendBinaryHeader(int type, uint32_t pos, uint8_t flags) {
+  uint8_t header[5];
+  header[0] = type;
+  header[1] = pos;
+  header[2] = pos >> 8;
+  header[3] = pos >> 16;
+  header[4] = (pos >> 24) | flags;
+
+  out_.push_back(kPad);
+  out_.push_back(kDle);
+  out_.push_back(use_crc32_ ? kBin32 : kBin16);
+  for (int i = 0; i < 5; i++) {
+    PutEscaped(header[i]);
+  }
+  if (use_crc32_) {
+    uint32_t crc = ~ZmodemCrc32(0xffffffff, header, 5);
+    for (int i = 0; i < 4; i++) {
+      PutEscaped(crc >> (8 * i));
+    }
+  } else {
+    uint16_t crc = ZmodemCrc16(0, header, 5);
+    PutEscaped(crc >> 8);
+    PutEscaped(crc);
+  }
+}
+
+void ZmodemEngine::SendSubpacket(const uint8_t* data, size_t len,
+                                 uint8_t end) {
+  for (size_t i = 0; i < len; i++) {
+    PutEscaped(data[i]);
+  }
+  out_.push_back(kDle);
+  out_.push_back(end);
+  if (use_crc32_) {
+    uint32_t crc = Crc32Of(data, len, end);
+    for (int i = 0; i < 4; i++) {
+      PutEscaped(crc >> (8 * i));
+    }
+  } else {
+    uint16_t crc = Crc16Of(data, len, end);
+    PutEscaped(crc >> 8);
+    PutEscaped(crc);
+  }
+  if (end == kCrcW) {
+    out_.push_back(kXon);
+  }
+}
+
+void ZmodemEngine::PutEscaped(uint8_t c) {
+  bool escape;
+  switch (c) {
+  case kDle:
+  case 0x10:
+  case 0x90:
+  case 0x11:
+  case 0x91:
+  case 0x13:
+  case 0x93:
+    escape = true;
+    break;
+  case '\r':
+  case '\r' | 0x80:
+    // Telnet-style "@\r" sequences can be eaten by the line.
+    escape = (last_sent_ & 0x7f) == '@';
+    break;
+  case 0x7f:
+  case 0xff:
+    if (escape_controls_) {
+      out_.push_back(kDle);
+      out_.push_back(c == 0x7f ? kRub0 : kRub1);
+      last_sent_ = c;
+      return;
+    }
+    escape = false;
+    break;
+  default:
+    escape = escape_controls_ && (c & 0x60) == 0;
+    break;
+  }
+
+  if (escape) {
+    out_.push_back(kDle);
+    c ^= 0x40;
+  }
+  out_.push_back(c);
+  last_sent_ = c;
+}
+
+bool ZmodemEngine::Flush() {
+  if (out_.empty()) {
+    return !failed_;
+  }
+  bool ok = host_->Write(out_.data(), out_.size());
+  out_.clear();
+  if (!ok) {
+    Finish(false);
+  }
+  return ok;
+}
+
+void ZmodemEngine::Finish(bool ok) {
+  if (done_) {
+    return;
+  }
+  if (receiving_file_) {
+    host_->CloseReceived(false);
+    receiving_file_ = false;
+  }
+  if (sending_file_) {
+    host_->CloseSent(false);
+    sending_file_ = false;
+  }
+  done_ = true;
+  failed_ = !ok;
+}
+
+}  // namespace connectbot
@@ -0,0 +1,163 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CONNECTBOT_ZMODEM_H_
+#define CONNECTBOT_ZMODEM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace connectbot {
+
+// What the ZMODEM engine needs from its surroundings: a way to talk to the
+// remote end and access to local files. Any call may fail by returning
+// false (or a negative count), which cancels the session.
+class ZmodemHost {
+ public:
+  virtual ~ZmodemHost() {}
+
+  // Bytes for the remote end.
+  virtual bool Write(const uint8_t* data, size_t len) = 0;
+
+  // Receiving: the remote end offers |name| of |size| bytes, or -1 if it did
+  // not say. Returns false to skip the file.
+  virtual bool OpenReceived(const std::string& name, int64_t size) = 0;
+  virtual bool WriteReceived(const uint8_t* data, size_t len) = 0;
+  virtual void CloseReceived(bool complete) = 0;
+
+  // Sending: the next file to offer, or false when there are no more.
+  virtual bool NextToSend(std::string* name, int64_t* size) = 0;
+  // Fills |data| from |offset| of the current file. Returns the number of
+  // bytes read, 0 at the end of the file or -1 on error.
+  virtual int64_t ReadToSend(int64_t offset, uint8_t* data, size_t len) = 0;
+  virtual void CloseSent(bool complete) = 0;
+};
+
+// CRC-16/XMODEM as used by ZMODEM headers and CRC-16 data subpackets.
+uint16_t ZmodemCrc16(uint16_t crc, const uint8_t* data, size_t len);
+
+// CRC-32 (IEEE) without the final inversion; start from 0xffffffff and
+// invert the result.
+uint32_t ZmodemCrc32(uint32_t crc, const uint8_t* data, size_t len);
+
+// A ZMODEM session over a byte stream that is already open, e.g. a terminal
+// session after rz or sz started on the remote end. The engine takes the
+// receiving or the sending side depending on the first header it sees:
+// ZRQINIT from sz or ZRINIT from rz.
+//
+// Received data subpackets are checked with CRC-16 or CRC-32 as the sender
+// chose. When sending, CRC-32 is used if the receiver can do it and data is
+// streamed in 1 KiB subpackets. ZCRCQ asks for an acknowledgement every
+// quarter of a 32 KiB window, so a bad packet costs at most one window. All
+// control characters that could upset the line are ZDLE-escaped.
+//
+// The engine does no I/O of its own: Feed it what the remote end sends, and
+// call Pump while sending to push file data as far as the window allows.
+class ZmodemEngine {
+ public:
+  // The start of the header rz and sz open a session with: ZPAD ZPAD ZDLE
+  // ZHEX, followed by the high digit of ZRQINIT or ZRINIT.
+  static const uint8_t kStart[5];
+
+  explicit ZmodemEngine(ZmodemHost* host);
+
+  // Handles bytes from the remote end. Returns how many were used; once the
+  // session is over the rest belongs to the terminal again.
+  size_t Feed(const uint8_t* data, size_t len);
+
+  // Sends file data while the window allows. Returns false when nothing
+  // more can be sent until the remote end answers.
+  bool Pump();
+
+  // Aborts the session on both ends.
+  void Cancel();
+
+  bool finished() const { return done_; }
+  bool succeeded() const { return done_ && !failed_; }
+  bool sending() const { return role_ == kSender; }
+
+ private:
+  enum Role { kUnknown, kReceiver, kSender };
+  enum Parse {
+    kSeekPad, kSeekDle, kSeekFormat, kHexHeader, kBinHeader, kSubpacket,
+    kSubpacketCrc, kSeekOver,
+  };
+  enum Expect { kNothing, kFileInfo, kFileData, kSessionInit, kCommandLine };
+  enum Send { kIdle, kFileOffered, kStreaming, kAckWait, kEofSent, kFinSent };
+
+  bool Consume(uint8_t c);
+  int Unescape(uint8_t c);
+  void OnHeader(const uint8_t* header);
+  void OnReceiverHeader(int type, uint32_t pos);
+  void OnSenderHeader(int type, uint32_t pos, const uint8_t* header);
+  void OnSubpacket(bool ok);
+  void OnFileInfo();
+  void StartData(bool crc32);
+  void OfferNextFile();
+
+  void SendHexHeader(int type, uint32_t pos);
+  void SendBinaryHeader(int type, uint32_t pos, uint8_t flags);
+  void SendSubpacket(const uint8_t* data, size_t len, uint8_t end);
+  void PutEscaped(uint8_t c);
+  bool Flush();
+  void Finish(bool ok);
+
+  ZmodemHost* const host_;
+  Role role_;
+  bool done_;
+  bool failed_;
+
+  // Parser.
+  Parse parse_;
+  Expect expect_;
+  bool escaped_;
+  int cancels_;
+  uint8_t header_[9];
+  size_t header_len_;
+  size_t header_need_;
+  bool header_crc32_;
+  bool data_crc32_;
+  std::vector<uint8_t> subpacket_;
+  uint8_t subpacket_end_;
+  uint8_t crc_[4];
+  size_t crc_len_;
+  int overs_;
+
+  // Receiving.
+  bool receiving_file_;
+  uint32_t received_;
+
+  // Sending.
+  Send send_;
+  bool sending_file_;
+  bool use_crc32_;
+  bool escape_controls_;
+  uint32_t receiver_buffer_;
+  uint32_t position_;
+  uint32_t acked_;
+  uint32_t last_query_;
+  std::string file_info_;
+
+  std::vector<uint8_t> out_;
+  uint8_t last_sent_;
+};
+
+}  // namespace connectbot
+
+#endif  // CONNECTBOT_ZMODEM_H_
@@ -51,6 +51,24 @@ public class Exec {
   public static native FileDescriptor createSubprocess(String cmd, String arg0, String arg1,
       int[] processId);
 
+  /**
+   * Starts a process connected to pipes instead of a PTY, so its output can be consumed without
+   * terminal emulation.
+   *
+   * @param cmd
+   *          The command to execute
+   * @param arg0
+   *          The first argument to the command, may be null
+   * @param arg1
+   *          the second argument to the command, may be null
+   * @param processId
+   *          A one-element array to which the process ID of the started process will be written.
+   * @return the file descriptors for the process's stdin, stdout and stderr in that order, or
+   *         null if the process could not be started.
+   */
+  public static native FileDescriptor[] createPipedSubprocess(String cmd, String arg0,
+      String arg1, int[] processId);
+
   public static native void setPtyWindowSize(FileDescriptor fd, int row, int col, int xpixel,
       int ypixel);
 
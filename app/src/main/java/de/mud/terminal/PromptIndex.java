@@ -0,0 +1,235 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.mud.terminal;
+
+/**
+ * Index of the shell integration marks (OSC 133) seen in a buffer: where
+ * each prompt starts, where its command's output starts and where that
+ * output ends. Marks are kept by absolute line number, counting the lines
+ * that have already fallen off the top of the scrollback, so nothing needs
+ * to be rewritten when the buffer scrolls; converting back to a buffer row
+ * is a subtraction. Commands are kept in a ring of fixed size in the order
+ * they ran, so the most recent ones are found in constant time and any
+ * other by a binary search over the commands, never by scanning rows.
+ *
+ * @author Kenny Root
+ */
+public class PromptIndex {
+	/** Returned when there is no matching mark. */
+	public static final int NONE = -1;
+
+	private static final int CAPACITY = 512;
+
+	private final long[] prompt = new long[CAPACITY];
+	private final long[] command = new long[CAPACITY];
+	private final long[] output = new long[CAPACITY];
+	private final long[] end = new long[CAPACITY];
+	private final int[] exitCode = new int[CAPACITY];
+
+	/** Slot of the oldest command and the number of commands held. */
+	private int first, count;
+
+	/** Lines dropped from the top of the buffer so far. */
+	private long origin;
+
+	private int slot(int i) {
+		return (first + i) % CAPACITY;
+	}
+
+	private int toRow(long line) {
+		return line < origin ? NONE : (int) (line - origin);
+	}
+
+	/**
+	 * Record that {@code n} lines were dropped from the top of the buffer,
+	 * forgetting the commands whose prompts went with them.
+	 */
+	public synchronized void linesDropped(int n) {
+		origin += n;
+		forgetDropped();
+	}
+
+	/**
+	 * Record that buffer rows were laid out again, e.g. for a new width: a
+	 * mark on row {@code from + i} moves to row {@code rows[i]}, marks below
+	 * those rows move by {@code shift} and marks above them stay. Commands
+	 * whose prompts move above the top of the buffer are forgotten.
+	 */
+	public synchronized void rowsMoved(int from, int[] rows, int shift) {
+		for (int i = 0; i < count; i++) {
+			int s = slot(i);
+			prompt[s] = moveLine(prompt[s], from, rows, shift);
+			command[s] = moveLine(command[s], from, rows, shift);
+			output[s] = moveLine(output[s], from, rows, shift);
+			end[s] = moveLine(end[s], from, rows, shift);
+		}
+		forgetDropped();
+	}
+
+	private long moveLine(long line, int from, int[] rows, int shift) {
+		// also leaves marks that were never set alone
+		if (line < origin + from)
+			return line;
+		long row = line - origin - from;
+		return row < rows.length ? origin + rows[(int) row] : line + shift;
+	}
+
+	private void forgetDropped() {
+		while (count > 0 && prompt[first] < origin) {
+			first = slot(1);
+			count--;
+		}
+	}
+
+	/**
+	 * A prompt starts at buffer row {@code row}. Anything recorded at or below
+	 * it was on a part of the screen that has since been redrawn.
+	 */
+	public synchronized void markPrompt(int row) {
+		long line = origin + row;
+		while (count > 0 && prompt[slot(count - 1)] >= line)
+			count--;
+
+		if (count == CAPACITY) {
+			first = slot(1);
+			count--;
+		}
+
+		int s = slot(count++);
+		prompt[s] = line;
+		command[s] = -1;
+		output[s] = -1;
+		end[s] = -1;
+		exitCode[s] = 0;
+	}
+
+	/** The command line being typed starts at buffer row {@code row}. */
+	public synchronized void markCommand(int row) {
+		if (count > 0)
+			command[slot(count - 1)] = origin + row;
+	}
+
+	/** Output of the current command starts at buffer row {@code row}. */
+	public synchronized void markOutput(int row) {
+		if (count > 0)
+			output[slot(count - 1)] = origin + row;
+	}
+
+	/** The current command finished with its output ending before {@code row}. */
+	public synchronized void markEnd(int row, int status) {
+		if (count > 0) {
+			int s = slot(count - 1);
+			end[s] = origin + row;
+			exitCode[s] = status;
+		}
+	}
+
+	public synchronized boolean isEmpty() {
+		return count == 0;
+	}
+
+	/**
+	 * @return index of the last command whose prompt is at or above
+	 *         {@code line}, or -1
+	 */
+	private int lastAtOrBefore(long line) {
+		int lo = 0, hi = count - 1, found = -1;
+		while (lo <= hi) {
+			int mid = (lo + hi) >>> 1;
+			if (prompt[slot(mid)] <= line) {
+				found = mid;
+				lo = mid + 1;
+			} else {
+				hi = mid - 1;
+			}
+		}
+		return found;
+	}
+
+	/**
+	 * @return the buffer row of the closest prompt above {@code row}, or
+	 *         {@link #NONE}
+	 */
+	public synchronized int getPreviousPrompt(int row) {
+		int i = lastAtOrBefore(origin + row - 1);
+		return i < 0 ? NONE : toRow(prompt[slot(i)]);
+	}
+
+	/**
+	 * @return the buffer row of the closest prompt below {@code row}, or
+	 *         {@link #NONE}
+	 */
+	public synchronized int getNextPrompt(int row) {
+		int i = lastAtOrBefore(origin + row) + 1;
+		return i >= count ? NONE : toRow(prompt[slot(i)]);
+	}
+
+	/**
+	 * Find the output of the command shown at buffer row {@code row}.
+	 *
+	 * @return the first row of output and the row after its last one, or
+	 *         {@code null} if the row is not part of a command with output
+	 */
+	public synchronized int[] getOutputRange(int row) {
+		return getOutputRangeAt(lastAtOrBefore(origin + row));
+	}
+
+	/**
+	 * Find the output of the most recent command that has finished.
+	 *
+	 * @see #getOutputRange
+	 */
+	public synchronized int[] getLastOutputRange() {
+		for (int i = count - 1; i >= 0 && i >= count - 2; i--) {
+			if (end[slot(i)] >= 0)
+				return getOutputRangeAt(i);
+		}
+		return null;
+	}
+
+	/**
+	 * @return the exit status of the most recent command that has finished
+	 */
+	public synchronized int getLastExitCode() {
+		for (int i = count - 1; i >= 0 && i >= count - 2; i--) {
+			if (end[slot(i)] >= 0)
+				return exitCode[slot(i)];
+		}
+		return 0;
+	}
+
+	private int[] getOutputRangeAt(int i) {
+		if (i < 0)
+			return null;
+
+		int s = slot(i);
+		long start = output[s];
+		if (start < 0)
+			start = command[s] >= 0 ? command[s] + 1 : prompt[s] + 1;
+
+		long stop = end[s];
+		if (stop < 0)
+			stop = i + 1 < count ? prompt[slot(i + 1)] : -1;
+		if (stop < 0 || stop <= start)
+			return null;
+
+		int startRow = toRow(start);
+		if (startRow == NONE)
+			startRow = 0;
+		return new int[] { startRow, toRow(stop) };
+	}
+}
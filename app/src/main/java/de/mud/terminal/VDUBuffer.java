@@ -26,6 +26,7 @@
 package de.mud.terminal;
 
 import java.util.Arrays;
+import java.util.HashMap;
 
 /**
  * Implementation of a Video Display Unit (VDU) buffer. This class contains
@@ -47,6 +48,7 @@ public class VDUBuffer {
   public boolean[] update;        /* contains the lines that need update */
   public char[][] charArray;                  /* contains the characters */
   public long[][] charAttributes;            /* contains character attrs */
+  public boolean[] lineWrapped;  /* rows autowrap continued on the next */
   public int bufSize;
   public int maxBufSize;                                 /* buffer sizes */
   public int screenBase;                      /* the actual screen start */
@@ -111,6 +113,61 @@ public class VDUBuffer {
   /** how much to left shift the blue component */
   public final static int COLOR_BLUE_SHIFT = 0;
 
+  /** Hyperlink id in the unused top bits; 0 means the cell is not a link. */
+  public final static long LINK = 0xff00000000000000L;
+  public final static int LINK_SHIFT = 56;
+  /** The number of distinct hyperlinks that can be referenced at once. */
+  public final static int MAX_LINKS = 0xff;
+
+  /**
+   * Cells holding a code point outside the BMP or a grapheme cluster store a
+   * handle in the UTF-16 surrogate range instead of the text itself. Lone
+   * surrogates are never stored otherwise, so the handle can travel with its
+   * row through scrolling without any per-row bookkeeping.
+   */
+  public final static char CLUSTER_BASE = '\ud800';
+  /** The number of distinct clusters that can be referenced at once. */
+  public final static int MAX_CLUSTERS = 0x800;
+
+  /**
+   * Cells covered by an inline image hold this noncharacter. Their
+   * attributes carry the image id and which cell-sized tile of the image
+   * they show in place of the colors, so that images scroll with the text.
+   */
+  public final static char IMAGE_CELL = '\ufdd0';
+  public final static int IMAGE_ID_SHIFT = 6;
+  public final static long IMAGE_ID = 0xffffffL << IMAGE_ID_SHIFT;
+  public final static int IMAGE_COLUMN_SHIFT = 30;
+  public final static long IMAGE_COLUMN = 0xfffL << IMAGE_COLUMN_SHIFT;
+  public final static int IMAGE_ROW_SHIFT = 42;
+  public final static long IMAGE_ROW = 0xfffL << IMAGE_ROW_SHIFT;
+  /** The largest image id that fits into the attributes. */
+  public final static int MAX_IMAGE_ID = 0xffffff;
+
+  /* interned cluster text, allocated the first time a cluster is stored */
+  private String[] clusters;
+  private HashMap<String, Integer> clusterIndex;
+  private int clusterCount;
+
+  /** Shell integration marks, kept in step with scrollback as it rotates. */
+  public final PromptIndex prompts = new PromptIndex();
+
+  /** Lines dropped from the top of the buffer so far; row r holds absolute
+   * line linesDropped + r, which stays the same while the buffer scrolls. */
+  public long linesDropped;
+
+  /** Changes whenever lines already in the buffer are rewritten or renumbered
+   * rather than only scrolled, e.g. on resize. */
+  public int historyVersion;
+
+  /* rows at the top of the buffer still laid out for an earlier width */
+  private int pendingReflow;
+
+  /* interned hyperlink targets indexed by link id, allocated on first use */
+  private String[] links;
+  private HashMap<String, Integer> linkIndex;
+  private int linkCount;
+
   /**
    * Create a new video display buffer with the passed width and height in
    * characters.
@@ -180,6 +237,202 @@ public class VDUBuffer {
     return charArray[screenBase + l][c];
   }
 
+  /**
+   * @return true if {@code ch} is a handle to text in the cluster table
+   * @see #internCluster
+   */
+  public static boolean isClusterHandle(char ch) {
+    return ch >= CLUSTER_BASE && ch < CLUSTER_BASE + MAX_CLUSTERS;
+  }
+
+  /**
+   * Get the text a cluster handle stands for.
+   * @param handle a character for which {@link #isClusterHandle} is true
+   * @return the text, or the replacement character if the handle is unknown
+   */
+  public String getCluster(char handle) {
+    String text = null;
+    if (clusters != null && isClusterHandle(handle))
+      text = clusters[handle - CLUSTER_BASE];
+    return text != null ? text : "\ufffd";
+  }
+
+  /**
+   * Get the text shown in a cell, resolving cluster handles.
+   * @param c x-coordinate (column)
+   * @param l y-coordinate (line) relative to the start of the buffer
+   */
+  public String getCellText(int c, int l) {
+    char ch = charArray[l][c];
+    if (ch == IMAGE_CELL)
+      return " ";
+    return isClusterHandle(ch) ? getCluster(ch) : String.valueOf(ch);
+  }
+
+  /**
+   * Get the attributes for a cell showing one tile of an inline image.
+   * @param id the image id, at most {@link #MAX_IMAGE_ID}
+   * @param column tile column, counted from the image's left edge
+   * @param row tile row, counted from the image's top edge
+   */
+  public static long imageAttributes(int id, int column, int row) {
+    return (((long) id << IMAGE_ID_SHIFT) & IMAGE_ID)
+        | (((long) column << IMAGE_COLUMN_SHIFT) & IMAGE_COLUMN)
+        | (((long) row << IMAGE_ROW_SHIFT) & IMAGE_ROW);
+  }
+
+  /** @return the image id in the attributes of an {@link #IMAGE_CELL} */
+  public static int getImageId(long attributes) {
+    return (int) ((attributes & IMAGE_ID) >>> IMAGE_ID_SHIFT);
+  }
+
+  /** @return the tile column in the attributes of an {@link #IMAGE_CELL} */
+  public static int getImageColumn(long attributes) {
+    return (int) ((attributes & IMAGE_COLUMN) >>> IMAGE_COLUMN_SHIFT);
+  }
+
+  /** @return the tile row in the attributes of an {@link #IMAGE_CELL} */
+  public static int getImageRow(long attributes) {
+    return (int) ((attributes & IMAGE_ROW) >>> IMAGE_ROW_SHIFT);
+  }
+
+  /**
+   * Store text that does not fit in one UTF-16 unit and get a handle for it
+   * that can be put into a cell. Identical text shares one handle. When the
+   * table is full, entries no longer referenced by any cell are reclaimed.
+   * @param text the code point or grapheme cluster
+   * @return the handle, or the replacement character if the table is full
+   */
+  public char internCluster(String text) {
+    if (clusters == null) {
+      clusters = new String[MAX_CLUSTERS];
+      clusterIndex = new HashMap<String, Integer>();
+    }
+
+    Integer existing = clusterIndex.get(text);
+    if (existing != null)
+      return (char) (CLUSTER_BASE + existing);
+
+    if (clusterCount == MAX_CLUSTERS)
+      collectClusters();
+
+    for (int i = 0; i < MAX_CLUSTERS; i++) {
+      if (clusters[i] == null) {
+        clusters[i] = text;
+        clusterIndex.put(text, i);
+        clusterCount++;
+        return (char) (CLUSTER_BASE + i);
+      }
+    }
+
+    return '\ufffd';
+  }
+
+  /**
+   * Drop every cluster that no cell in the buffer refers to anymore.
+   */
+  private void collectClusters() {
+    boolean[] live = new boolean[MAX_CLUSTERS];
+    for (int r = 0; r < charArray.length && charArray[r] != null; r++) {
+      char[] row = charArray[r];
+      for (int c = 0; c < row.length; c++)
+        if (isClusterHandle(row[c]))
+          live[row[c] - CLUSTER_BASE] = true;
+    }
+
+    for (int i = 0; i < MAX_CLUSTERS; i++) {
+      if (!live[i] && clusters[i] != null) {
+        clusterIndex.remove(clusters[i]);
+        clusters[i] = null;
+        clusterCount--;
+      }
+    }
+  }
+
+  /**
+   * Get the hyperlink id stored in a set of cell attributes.
+   * @return the id, or 0 if the attributes do not belong to a link
+   */
+  public static int getLinkId(long attributes) {
+    return (int) ((attributes & LINK) >>> LINK_SHIFT);
+  }
+
+  /**
+   * Get the target of a hyperlink.
+   * @param id a link id taken from cell attributes
+   * @return the URI, or {@code null} if there is no such link
+   */
+  public String getLink(int id) {
+    if (links == null || id <= 0 || id > MAX_LINKS)
+      return null;
+    return links[id - 1];
+  }
+
+  /**
+   * Get the target of the hyperlink shown at a position.
+   * @param c x-coordinate (column)
+   * @param l y-coordinate (line) relative to the start of the buffer
+   * @return the URI, or {@code null} if the cell is not part of a link
+   */
+  public String getLinkAt(int c, int l) {
+    if (l < 0 || l >= charAttributes.length || charAttributes[l] == null
+        || c < 0 || c >= charAttributes[l].length)
+      return null;
+    return getLink(getLinkId(charAttributes[l][c]));
+  }
+
+  /**
+   * Store a hyperlink target and get the id cells refer to it by. The same
+   * target always gets the same id while any cell still uses it. When all
+   * ids are taken, the ones no longer found in the buffer are reclaimed.
+   * @param uri the link target
+   * @return the id, or 0 if no id is free
+   */
+  public int internLink(String uri) {
+    if (links == null) {
+      links = new String[MAX_LINKS];
+      linkIndex = new HashMap<String, Integer>();
+    }
+
+    Integer existing = linkIndex.get(uri);
+    if (existing != null)
+      return existing + 1;
+
+    if (linkCount == MAX_LINKS)
+      collectLinks();
+
+    for (int i = 0; i < MAX_LINKS; i++) {
+      if (links[i] == null) {
+        links[i] = uri;
+        linkIndex.put(uri, i);
+        linkCount++;
+        return i + 1;
+      }
+    }
+
+    return 0;
+  }
+
+  /**
+   * Drop every link whose cells have all been overwritten or scrolled out.
+   */
+  private void collectLinks() {
+    boolean[] live = new boolean[MAX_LINKS + 1];
+    for (int r = 0; r < charAttributes.length && charAttributes[r] != null; r++) {
+      long[] row = charAttributes[r];
+      for (int c = 0; c < row.length; c++)
+        live[getLinkId(row[c])] = true;
+    }
+
+    for (int i = 0; i < MAX_LINKS; i++) {
+      if (!live[i + 1] && links[i] != null) {
+        linkIndex.remove(links[i]);
+        links[i] = null;
+        linkCount--;
+      }
+    }
+  }
+
   /**
    * Get the attributes for the specified position.
    * @param c x-coordinate (column)
@@ -190,6 +443,26 @@ public class VDUBuffer {
     return charAttributes[screenBase + l][c];
   }
 
+  /**
+   * Mark whether a screen line was continued on the next one by autowrap
+   * rather than ended by the output. Lines that are wrapped together are
+   * laid out again as one when the width changes.
+   * @param l y-coordinate (line)
+   * @param wrapped true if the text goes on in the next line
+   */
+  public void setWrapped(int l, boolean wrapped) {
+    lineWrapped[screenBase + l] = wrapped;
+  }
+
+  /**
+   * Check whether a line of the buffer continues on the next one.
+   * @param l y-coordinate (line) relative to the start of the buffer
+   * @see #setWrapped
+   */
+  public boolean isWrapped(int l) {
+    return l >= 0 && l < bufSize && lineWrapped[l];
+  }
+
   /**
    * Insert a character at a specific position on the screen.
    * All character right to from this position will be moved one to the right.
@@ -335,6 +608,7 @@ public class VDUBuffer {
   public synchronized void insertLine(int l, int n, boolean scrollDown) {
     char cbuf[][] = null;
     long abuf[][] = null;
+    boolean wbuf[] = null;
     int offset = 0;
     int oldBase = screenBase;
 
@@ -361,16 +635,22 @@ public class VDUBuffer {
       if(size < 0) size = 0;
       cbuf = new char[size][width];
       abuf = new long[size][width];
+      wbuf = new boolean[size];
 
       System.arraycopy(charArray, oldBase + l, cbuf, 0, bottom - l - (n - 1));
       System.arraycopy(charAttributes, oldBase + l,
                        abuf, 0, bottom - l - (n - 1));
+      System.arraycopy(lineWrapped, oldBase + l,
+                       wbuf, 0, bottom - l - (n - 1));
       System.arraycopy(cbuf, 0, charArray, oldBase + l + n,
                        bottom - l - (n - 1));
       System.arraycopy(abuf, 0, charAttributes, oldBase + l + n,
                        bottom - l - (n - 1));
+      System.arraycopy(wbuf, 0, lineWrapped, oldBase + l + n,
+                       bottom - l - (n - 1));
       cbuf = charArray;
       abuf = charAttributes;
+      wbuf = lineWrapped;
     } else {
       try {
         if (n > (bottom - top) + 1) n = (bottom - top) + 1;
@@ -390,10 +670,12 @@ public class VDUBuffer {
 
           cbuf = new char[newBufSize][width];
           abuf = new long[newBufSize][width];
+          wbuf = new boolean[newBufSize];
         } else {
           offset = n;
           cbuf = charArray;
           abuf = charAttributes;
+          wbuf = lineWrapped;
         }
         // copy anything from the top of the buffer (+offset) to the new top
         // up to the screenBase.
@@ -404,6 +686,9 @@ public class VDUBuffer {
           System.arraycopy(charAttributes, offset,
                            abuf, 0,
                            oldBase - offset);
+          System.arraycopy(lineWrapped, offset,
+                           wbuf, 0,
+                           oldBase - offset);
         }
         // copy anything from the top of the screen (screenBase) up to the
         // topMargin to the new screen
@@ -414,6 +699,9 @@ public class VDUBuffer {
           System.arraycopy(charAttributes, oldBase,
                            abuf, newScreenBase,
                            top);
+          System.arraycopy(lineWrapped, oldBase,
+                           wbuf, newScreenBase,
+                           top);
         }
         // copy anything from the topMargin up to the amount of lines inserted
         // to the gap left over between scrollback buffer and screenBase
@@ -424,6 +712,9 @@ public class VDUBuffer {
           System.arraycopy(charAttributes, oldBase + top,
                            abuf, oldBase - offset,
                            n);
+          System.arraycopy(lineWrapped, oldBase + top,
+                           wbuf, oldBase - offset,
+                           n);
         }
         // copy anything from topMargin + n up to the line linserted to the
         // topMargin
@@ -433,6 +724,9 @@ public class VDUBuffer {
         System.arraycopy(charAttributes, oldBase + top + n,
                          abuf, newScreenBase + top,
                          l - top - (n - 1));
+        System.arraycopy(lineWrapped, oldBase + top + n,
+                         wbuf, newScreenBase + top,
+                         l - top - (n - 1));
         //
         // copy the all lines next to the inserted to the new buffer
         if (l < height - 1) {
@@ -442,6 +736,9 @@ public class VDUBuffer {
           System.arraycopy(charAttributes, oldBase + l + 1,
                            abuf, newScreenBase + l + 1,
                            (height - 1) - l);
+          System.arraycopy(lineWrapped, oldBase + l + 1,
+                           wbuf, newScreenBase + l + 1,
+                           (height - 1) - l);
         }
       } catch (ArrayIndexOutOfBoundsException e) {
         // this should not happen anymore, but I will leave the code
@@ -472,10 +769,18 @@ public class VDUBuffer {
       cbuf[(newScreenBase + l) + (scrollDown ? i : -i)] = new char[width];
       Arrays.fill(cbuf[(newScreenBase + l) + (scrollDown ? i : -i)], ' ');
       abuf[(newScreenBase + l) + (scrollDown ? i : -i)] = new long[width];
+      wbuf[(newScreenBase + l) + (scrollDown ? i : -i)] = false;
+    }
+
+    if (offset > 0) {
+      prompts.linesDropped(offset);
+      linesDropped += offset;
+      pendingReflow = Math.max(pendingReflow - offset, 0);
     }
 
     charArray = cbuf;
     charAttributes = abuf;
+    lineWrapped = wbuf;
     screenBase = newScreenBase;
     windowBase = newWindowBase;
     bufSize = newBufSize;
@@ -508,6 +813,8 @@ public class VDUBuffer {
 	                     charArray, screenBase + l, numRows);
 	    System.arraycopy(charAttributes, screenBase + l + 1,
 	                     charAttributes, screenBase + l, numRows);
+	    System.arraycopy(lineWrapped, screenBase + l + 1,
+	                     lineWrapped, screenBase + l, numRows);
     }
 
     int newBottomRow = screenBase + bottom - 1;
@@ -515,6 +822,7 @@ public class VDUBuffer {
     charAttributes[newBottomRow] = discardedAttributes;
     Arrays.fill(charArray[newBottomRow], ' ');
     Arrays.fill(charAttributes[newBottomRow], 0);
+    lineWrapped[newBottomRow] = false;
 
     markLine(l, bottom - l);
   }
@@ -537,6 +845,9 @@ public class VDUBuffer {
     for (int i = 0; i < h && l + i < height; i++) {
       Arrays.fill(charAttributes[targetRow], c, endColumn, curAttr);
       Arrays.fill(charArray[targetRow], c, endColumn, ' ');
+      // an erased line end no longer runs on into the next line
+      if (endColumn >= width)
+        lineWrapped[targetRow] = false;
       targetRow++;
     }
     markLine(l, h);
@@ -557,6 +868,31 @@ public class VDUBuffer {
     deleteArea(c, l, w, h, 0);
   }
 
+  /**
+   * Blank every cell, in the scrollback as well as on the screen, that
+   * still shows a tile of the given inline image, so that the id can be
+   * handed out again without old cells picking up the new image.
+   * @param id the image id, see {@link #imageAttributes}
+   */
+  public synchronized void clearImage(int id) {
+    boolean changed = false;
+    for (int row = 0; row < bufSize; row++) {
+      char[] chars = charArray[row];
+      long[] attributes = charAttributes[row];
+      for (int c = 0; c < chars.length; c++) {
+        if (chars[c] == IMAGE_CELL && getImageId(attributes[c]) == id) {
+          chars[c] = ' ';
+          attributes[c] = 0;
+          changed = true;
+        }
+      }
+    }
+    if (changed) {
+      historyVersion++;
+      update[0] = true;
+    }
+  }
+
   /**
    * Sets whether the cursor is visible or not.
    * @param doshow
@@ -604,6 +940,9 @@ public class VDUBuffer {
    * @see #getBufferSize
    */
   public void setWindowBase(int line) {
+    // the lines above keep their distance from the screen when laid out again
+    if (line < screenBase && pendingReflow > 0)
+      line += reflowHistory();
     if (line > screenBase)
       line = screenBase;
     else if (line < 0) line = 0;
@@ -693,14 +1032,24 @@ public class VDUBuffer {
     if (amount < maxBufSize) {
       char cbuf[][] = new char[amount][width];
       long abuf[][] = new long[amount][width];
+      boolean wbuf[] = new boolean[amount];
       int copyStart = bufSize - amount < 0 ? 0 : bufSize - amount;
       int copyCount = bufSize - amount < 0 ? bufSize : amount;
       if (charArray != null)
         System.arraycopy(charArray, copyStart, cbuf, 0, copyCount);
       if (charAttributes != null)
         System.arraycopy(charAttributes, copyStart, abuf, 0, copyCount);
+      if (lineWrapped != null)
+        System.arraycopy(lineWrapped, copyStart, wbuf, 0, copyCount);
       charArray = cbuf;
       charAttributes = abuf;
+      lineWrapped = wbuf;
+      if (copyStart > 0) {
+        prompts.linesDropped(copyStart);
+        linesDropped += copyStart;
+        pendingReflow = Math.max(pendingReflow - copyStart, 0);
+      }
+      historyVersion++;
       bufSize = copyCount;
       screenBase = bufSize - height;
       windowBase = screenBase;
@@ -711,6 +1060,69 @@ public class VDUBuffer {
     redraw();
   }
 
+  /**
+   * Add lines above the oldest line of the scrollback buffer, for instance
+   * history fetched from the remote end after the fact. Only as many lines
+   * as still fit into the buffer are taken, the newest ones first.
+   * @param source buffer holding the lines, with the same width as this one
+   * @param l first line to take, relative to the start of source's buffer
+   * @param n number of lines to take
+   * @return number of lines added
+   */
+  public synchronized int insertHistory(VDUBuffer source, int l, int n) {
+    int first = l;
+    if (n > maxBufSize - bufSize) {
+      first += n - (maxBufSize - bufSize);
+      n = maxBufSize - bufSize;
+    }
+    if (n <= 0)
+      return 0;
+
+    char cbuf[][] = new char[bufSize + n][];
+    long abuf[][] = new long[bufSize + n][];
+    for (int i = 0; i < n; i++) {
+      char[] chars = new char[width];
+      long[] attrs = new long[width];
+      Arrays.fill(chars, ' ');
+      char[] srcChars = source.charArray[first + i];
+      long[] srcAttrs = source.charAttributes[first + i];
+      int w = Math.min(width, srcChars.length);
+      for (int c = 0; c < w; c++) {
+        char ch = srcChars[c];
+        chars[c] = isClusterHandle(ch) ? internCluster(source.getCluster(ch)) : ch;
+        long attr = srcAttrs[c] & ~LINK;
+        String link = source.getLink(getLinkId(srcAttrs[c]));
+        if (link != null)
+          attr |= ((long) internLink(link) << LINK_SHIFT) & LINK;
+        attrs[c] = attr;
+      }
+      cbuf[i] = chars;
+      abuf[i] = attrs;
+    }
+    boolean wbuf[] = new boolean[bufSize + n];
+    System.arraycopy(charArray, 0, cbuf, n, bufSize);
+    System.arraycopy(charAttributes, 0, abuf, n, bufSize);
+    System.arraycopy(lineWrapped, 0, wbuf, n, bufSize);
+
+    charArray = cbuf;
+    charAttributes = abuf;
+    lineWrapped = wbuf;
+    // keep the rows still waiting to be laid out in one block at the top
+    if (pendingReflow > 0)
+      pendingReflow += n;
+    bufSize += n;
+    screenBase += n;
+    windowBase += n;
+    prompts.linesDropped(-n);
+    linesDropped -= n;
+    historyVersion++;
+
+    update[0] = true;
+    if (display != null)
+      display.updateScrollBar();
+    return n;
+  }
+
   /**
    * Retrieve current scrollback buffer size.
    * @see #setBufferSize
@@ -729,16 +1141,15 @@ public class VDUBuffer {
 
   /**
    * Change the size of the screen. This will include adjustment of the
-   * scrollback buffer.
+   * scrollback buffer. When the width changes, the lines on the screen are
+   * wrapped again at the new width and the cursor stays with its text. The
+   * lines above the screen are left as they are until they are needed, see
+   * {@link #reflowHistory}, so resizing does not get slower with the length
+   * of the history.
    * @param w of the screen
    * @param h of the screen
    */
-  public void setScreenSize(int w, int h, boolean broadcast) {
-    char cbuf[][];
-    long abuf[][];
-    int maxSize = bufSize;
-    int oldAbsR = screenBase + getCursorRow();
-
+  public synchronized void setScreenSize(int w, int h, boolean broadcast) {
     if (w < 1 || h < 1) return;
 
     if (debug > 0)
@@ -747,73 +1158,287 @@ public class VDUBuffer {
     if (h > maxBufSize)
       maxBufSize = h;
 
-    if (h > bufSize) {
-      bufSize = h;
-      screenBase = 0;
-      windowBase = 0;
-    }
-
-    if (windowBase + h >= bufSize)
-      windowBase = bufSize - h;
-
-    if (screenBase + h >= bufSize)
-      screenBase = bufSize - h;
-
-
-    cbuf = new char[bufSize][w];
-    abuf = new long[bufSize][w];
-
-
-    for (int i = 0; i < bufSize; i++) {
-      Arrays.fill(cbuf[i], ' ');
+    // rows from first on are taken from the reflow, the ones above as they are
+    int first = screenBase;
+    int floor = pendingReflow;
+    Reflow reflow = new Reflow(w, screenBase,
+                               Math.min(screenBase + getCursorRow(), bufSize - 1),
+                               getCursorColumn());
+    if (charArray == null) {
+      first = 0;
+    } else if (w != width) {
+      // start with the part of a line that wrapped onto the top of the screen
+      while (first > 0 && lineWrapped[first - 1])
+        first--;
+      reflow.add(this, first, bufSize);
+      floor = first;
+    } else {
+      reflow.keep(this, first, bufSize);
     }
 
-    if (bufSize < maxSize)
-      maxSize = bufSize;
-
-    int rowLength;
-    if (charArray != null && charAttributes != null) {
-      for (int i = 0; i < maxSize && charArray[i] != null; i++) {
-        rowLength = charArray[i].length;
-        System.arraycopy(charArray[i], 0, cbuf[i], 0,
-                         w < rowLength ? w : rowLength);
-        System.arraycopy(charAttributes[i], 0, abuf[i], 0,
-                         w < rowLength ? w : rowLength);
+    int base = first + reflow.top;
+    int cursor = first + reflow.cursorRow;
+    // a taller screen shows more of the lines above, if they fit the width
+    int end = first + reflow.count;
+    if (base > end - h)
+      base = Math.max(end - h, floor);
+    if (cursor >= base + h)
+      base = cursor - h + 1;
+
+    int size = base + h;
+    int drop = Math.max(size - maxBufSize, 0);
+    char cbuf[][] = new char[size - drop][];
+    long abuf[][] = new long[size - drop][];
+    boolean wbuf[] = new boolean[size - drop];
+    for (int i = drop; i < size; i++) {
+      if (i < first) {
+        cbuf[i - drop] = charArray[i];
+        abuf[i - drop] = charAttributes[i];
+        wbuf[i - drop] = lineWrapped[i];
+      } else if (i < end) {
+        cbuf[i - drop] = reflow.chars[i - first];
+        abuf[i - drop] = reflow.attrs[i - first];
+        wbuf[i - drop] = reflow.wrapped[i - first];
+      } else {
+        cbuf[i - drop] = new char[w];
+        Arrays.fill(cbuf[i - drop], ' ');
+        abuf[i - drop] = new long[w];
       }
     }
+    // the rest of the bottom line may have been cut off below the screen
+    wbuf[size - drop - 1] = false;
+
+    // the marks move with the rows they were on
+    if (reflow.rows != null) {
+      for (int i = 0; i < reflow.rows.length; i++)
+        reflow.rows[i] = Math.min(first + reflow.rows[i], size - 1);
+      prompts.rowsMoved(first, reflow.rows, 0);
+    }
 
-    int C = getCursorColumn();
-    if (C < 0)
-      C = 0;
-    else if (C >= w)
-      C = w - 1;
-
-    int R = getCursorRow();
-    // If the screen size has grown and now there are more rows on the screen,
-    // slide the cursor down to the end of the text.
-    if (R + screenBase <= oldAbsR)
-      R = oldAbsR - screenBase;
-    if (R < 0)
-      R = 0;
-    else if (R >= h)
-      R = h - 1;
-
-    setCursorPosition(C, R);
+    if (drop > 0) {
+      prompts.linesDropped(drop);
+      linesDropped += drop;
+    }
 
     charArray = cbuf;
     charAttributes = abuf;
+    lineWrapped = wbuf;
+    bufSize = size - drop;
+    screenBase = base - drop;
+    windowBase = screenBase;
+    pendingReflow = Math.max(floor - drop, 0);
+    setCursorPosition(reflow.cursorColumn, cursor - base);
     width = w;
     height = h;
     topMargin = 0;
     bottomMargin = h - 1;
     update = new boolean[h + 1];
     update[0] = true;
+    historyVersion++;
     /*  FIXME: ???
     if(resizeStrategy == RESIZE_FONT)
       setBounds(getBounds());
     */
   }
 
+  /**
+   * Wrap the lines above the screen again at the current width if a resize
+   * left them at an earlier one. This happens the first time they are
+   * scrolled into view or read as a whole rather than on every resize.
+   * @return how far the rows below them moved down, negative for up
+   */
+  public synchronized int reflowHistory() {
+    if (pendingReflow == 0)
+      return 0;
+
+    Reflow reflow = new Reflow(width, -1, -1, 0);
+    reflow.add(this, 0, pendingReflow);
+
+    int rest = bufSize - pendingReflow;
+    int drop = Math.max(reflow.count + rest - maxBufSize, 0);
+    int size = reflow.count - drop + rest;
+    char cbuf[][] = new char[size][];
+    long abuf[][] = new long[size][];
+    boolean wbuf[] = new boolean[size];
+    System.arraycopy(reflow.chars, drop, cbuf, 0, reflow.count - drop);
+    System.arraycopy(reflow.attrs, drop, abuf, 0, reflow.count - drop);
+    System.arraycopy(reflow.wrapped, drop, wbuf, 0, reflow.count - drop);
+    System.arraycopy(charArray, pendingReflow, cbuf, reflow.count - drop, rest);
+    System.arraycopy(charAttributes, pendingReflow, abuf, reflow.count - drop, rest);
+    System.arraycopy(lineWrapped, pendingReflow, wbuf, reflow.count - drop, rest);
+
+    // the marks move with the rows they were on...
+    int shift = size - bufSize;
+    for (int i = 0; i < reflow.rows.length; i++)
+      reflow.rows[i] -= drop;
+    prompts.rowsMoved(0, reflow.rows, shift);
+    // ...and the rows that did not move keep their absolute line numbers
+    linesDropped -= shift;
+
+    charArray = cbuf;
+    charAttributes = abuf;
+    lineWrapped = wbuf;
+    bufSize = size;
+    screenBase += shift;
+    windowBase += shift;
+    pendingReflow = 0;
+    historyVersion++;
+
+    update[0] = true;
+    if (display != null)
+      display.updateScrollBar();
+    return shift;
+  }
+
+  /**
+   * Rows of the buffer laid out again for a new width. Rows marked as
+   * wrapped are joined with the next one before the text is split up
+   * again, so rows of any width can be fed in. Follows where the top of the
+   * screen and the cursor end up.
+   */
+  private static class Reflow {
+    private final int width;
+    private final int topRow, oldCursorRow, oldCursorColumn;
+
+    char[][] chars = new char[16][];
+    long[][] attrs = new long[16][];
+    boolean[] wrapped = new boolean[16];
+    int count;
+
+    /* new rows of the screen top and the cursor, relative to the first one */
+    int top, cursorRow, cursorColumn;
+
+    /* new row of the start of each row fed in, relative to the first one */
+    int[] rows;
+    private int rowsFrom;
+
+    Reflow(int width, int topRow, int cursorRow, int cursorColumn) {
+      this.width = width;
+      this.topRow = topRow;
+      this.oldCursorRow = cursorRow;
+      this.oldCursorColumn = cursorColumn;
+    }
+
+    /**
+     * Take rows {@code from} up to {@code to} as they are.
+     */
+    void keep(VDUBuffer buffer, int from, int to) {
+      rows = new int[to - from];
+      rowsFrom = from;
+      for (int r = from; r < to; r++) {
+        rows[r - from] = count;
+        if (r == topRow)
+          top = count;
+        if (r == oldCursorRow) {
+          cursorRow = count;
+          cursorColumn = Math.min(oldCursorColumn, width - 1);
+        }
+        newRow(buffer.charArray[r], buffer.charAttributes[r]);
+        wrapped[count - 1] = buffer.lineWrapped[r];
+      }
+    }
+
+    /**
+     * Wrap the lines held by rows {@code from} up to {@code to} again.
+     */
+    void add(VDUBuffer buffer, int from, int to) {
+      rows = new int[to - from];
+      rowsFrom = from;
+      for (int r = from; r < to; ) {
+        int last = r;
+        while (last < to - 1 && buffer.lineWrapped[last])
+          last++;
+        addLine(buffer, r, last);
+        r = last + 1;
+      }
+    }
+
+    private void addLine(VDUBuffer buffer, int first, int last) {
+      // where the marks are counted from the start of the line
+      int topAt = -1, cursorAt = -1;
+      int length = 0;
+      for (int r = first; r <= last; r++) {
+        if (r == topRow)
+          topAt = length;
+        if (r == oldCursorRow)
+          cursorAt = length + oldCursorColumn;
+        if (r < last)
+          length += buffer.charArray[r].length;
+      }
+
+      // blanks at the end of the line are not part of the text...
+      char[] tailChars = buffer.charArray[last];
+      long[] tailAttrs = buffer.charAttributes[last];
+      int tail = tailChars.length;
+      while (tail > 0 && tailChars[tail - 1] == ' ' && tailAttrs[tail - 1] == 0)
+        tail--;
+      // ...unless a mark is on one of them
+      length = Math.max(length + tail, Math.max(topAt, cursorAt) + 1);
+
+      newRow(null, null);
+      int column = 0;
+      int r = first, c = 0;
+      // rows before this one have their new row in rows already
+      int mapped = first;
+      boolean secondHalf = false;
+      for (int i = 0; i < length; i++) {
+        while (r <= last && c >= buffer.charArray[r].length) {
+          r++;
+          c = 0;
+        }
+        char ch = ' ';
+        long attr = 0;
+        if (r <= last) {
+          ch = buffer.charArray[r][c];
+          attr = buffer.charAttributes[r][c];
+          c++;
+        }
+
+        // a wide character is never split over two rows
+        boolean wide = (attr & FULLWIDTH) != 0 && !secondHalf;
+        secondHalf = wide;
+        if (column == width || (wide && column == width - 1 && width > 1)) {
+          wrapped[count - 1] = true;
+          newRow(null, null);
+          column = 0;
+        }
+
+        while (mapped <= Math.min(r, last))
+          rows[mapped++ - rowsFrom] = count - 1;
+        if (i == topAt)
+          top = count - 1;
+        if (i == cursorAt) {
+          cursorRow = count - 1;
+          cursorColumn = column;
+        }
+
+        chars[count - 1][column] = ch;
+        attrs[count - 1][column] = attr;
+        column++;
+      }
+      // rows holding only trailing blanks end up on the last new row
+      while (mapped <= last)
+        rows[mapped++ - rowsFrom] = count - 1;
+    }
+
+    private void newRow(char[] rowChars, long[] rowAttrs) {
+      if (count == chars.length) {
+        chars = Arrays.copyOf(chars, count * 2);
+        attrs = Arrays.copyOf(attrs, count * 2);
+        wrapped = Arrays.copyOf(wrapped, count * 2);
+      }
+      if (rowChars == null) {
+        rowChars = new char[width];
+        Arrays.fill(rowChars, ' ');
+        rowAttrs = new long[width];
+      }
+      chars[count] = rowChars;
+      attrs[count] = rowAttrs;
+      wrapped[count] = false;
+      count++;
+    }
+  }
+
   /**
    * Get amount of rows on the screen.
    */
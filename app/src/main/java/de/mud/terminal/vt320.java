@@ -27,6 +27,11 @@ package de.mud.terminal;
 
 import android.text.AndroidCharacter;
 
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
+import java.io.IOException;
+import java.util.HashMap;
+import java.util.Map;
 import java.util.Properties;
 
 /**
@@ -71,6 +76,61 @@ public abstract class vt320 extends VDUBuffer implements VDUInput {
   public void beep() { /* do nothing by default */
   }
 
+  /** Formats for {@link #beginImage}. */
+  public final static int IMAGE_SIXEL = 0;
+  public final static int IMAGE_FILE = 1;
+
+  /**
+   * Takes the payload of an inline image escape sequence while it arrives.
+   */
+  public interface ImageReceiver {
+    /** More of the payload; may be called many times. */
+    void append(char[] data, int offset, int length);
+
+    /** The sequence ended normally. */
+    void finish();
+
+    /** The sequence was cancelled or the terminal was reset. */
+    void abort();
+  }
+
+  /**
+   * An inline image is starting: a sixel image (DCS P1;P2;P3 q) or a file
+   * sent with iTerm2's OSC 1337 ; File= sequence.
+   * @param format {@link #IMAGE_SIXEL} or {@link #IMAGE_FILE}
+   * @param params the sixel parameters, or the arguments of File= up to
+   *        the colon that starts the base64 data
+   * @return where to send the payload, or null to discard it
+   */
+  protected ImageReceiver beginImage(int format, String params) {
+    return null;
+  }
+
+  /**
+   * Put an image received through {@link #beginImage} on the screen,
+   * starting at the cursor and scrolling as needed. The cursor ends up at
+   * the start column of the line below the image, as with xterm's sixels.
+   * @param id image id to store in the cells, see
+   *        {@link VDUBuffer#imageAttributes}
+   * @param columns width of the image in cells
+   * @param rows height of the image in cells
+   */
+  public void placeImage(int id, int columns, int rows) {
+    int left = C;
+    int w = Math.min(columns, width - left);
+    for (int row = 0; row < rows; row++) {
+      for (int col = 0; col < w; col++)
+        putChar(left + col, R, IMAGE_CELL, imageAttributes(id, col, row));
+      if (R == getBottomMargin() || R >= height - 1)
+        insertLine(R, 1, SCROLL_UP);
+      else
+        R++;
+    }
+    C = left;
+    setCursorPosition(C, R);
+    redraw();
+  }
+
   /**
    * Convenience function for putString(char[], int, int)
    */
@@ -94,43 +154,182 @@ public abstract class vt320 extends VDUBuffer implements VDUInput {
       int lastChar = -1;
       char c;
       boolean isWide = false;
+      // code units joined onto lastChar to form one grapheme cluster
+      StringBuilder cluster = null;
+      boolean joinNext = false;
 
       for (int i = 0; i < len; i++) {
         c = s[start + i];
         // Shortcut for my favorite ASCII
         if (c <= 0x7F) {
           if (lastChar != -1)
-            putChar((char) lastChar, isWide, false);
-          lastChar = c;
+            putCluster(lastChar, cluster, isWide);
           isWide = false;
-        } else if (!Character.isLowSurrogate(c) && !Character.isHighSurrogate(c)) {
-          if (Character.getType(c) == Character.NON_SPACING_MARK) {
-            if (lastChar != -1) {
-              char nc = Precomposer.precompose((char) lastChar, c);
-              putChar(nc, isWide, false);
-              lastChar = -1;
-            }
+          joinNext = false;
+          pendingHighSurrogate = 0;
+          if (term_state == TSTATE_IMAGE && isImageData(c)) {
+            // hand the payload of an image over a whole run at a time
+            int end = i + 1;
+            while (end < len && isImageData(s[start + end]))
+              end++;
+            if (image != null)
+              image.append(s, start + i, end - i);
+            i = end - 1;
+            lastChar = -1;
+            continue;
+          }
+          lastChar = c;
+          continue;
+        }
+
+        int cp = c;
+        if (Character.isHighSurrogate(c)) {
+          if (i + 1 < len && Character.isLowSurrogate(s[start + i + 1])) {
+            cp = Character.toCodePoint(c, s[start + i + 1]);
+            i++;
           } else {
-            if (lastChar != -1)
-              putChar((char) lastChar, isWide, false);
-            lastChar = c;
-            if (fullwidths != null) {
-                final byte width = fullwidths[i];
-                isWide = (width == AndroidCharacter.EAST_ASIAN_WIDTH_WIDE)
-                    || (width == AndroidCharacter.EAST_ASIAN_WIDTH_FULL_WIDTH);
+            // the rest of the pair arrives with the next read
+            pendingHighSurrogate = c;
+            continue;
+          }
+        } else if (Character.isLowSurrogate(c)) {
+          if (pendingHighSurrogate == 0)
+            continue;
+          cp = Character.toCodePoint(pendingHighSurrogate, c);
+        }
+        pendingHighSurrogate = 0;
+
+        // only placeImage may create image cells
+        if (cp == IMAGE_CELL)
+          cp = REPLACEMENT_CHARACTER;
+
+        if (lastChar != -1 && (joinNext || extendsCluster(lastChar, cluster, cp))) {
+          if (cluster == null || cluster.length() == 0) {
+            int type = Character.getType(cp);
+            if (lastChar < 0x10000 && cp < 0x10000 && type == Character.NON_SPACING_MARK) {
+              char nc = Precomposer.precompose((char) lastChar, (char) cp);
+              if (nc != lastChar) {
+                lastChar = nc;
+                continue;
+              }
             }
+            if (cluster == null)
+              cluster = new StringBuilder();
           }
+          cluster.appendCodePoint(cp);
+          joinNext = cp == ZERO_WIDTH_JOINER;
+          if (cp == EMOJI_PRESENTATION)
+            isWide = true;
+          continue;
+        }
+
+        if (Character.getType(cp) == Character.NON_SPACING_MARK)
+          continue; // nothing to combine with
+
+        if (lastChar != -1)
+          putCluster(lastChar, cluster, isWide);
+        lastChar = cp;
+        joinNext = false;
+        if (cp >= 0x10000) {
+          isWide = isWideCodePoint(cp);
+        } else if (fullwidths != null) {
+          final byte width = fullwidths[start + i];
+          isWide = (width == AndroidCharacter.EAST_ASIAN_WIDTH_WIDE)
+              || (width == AndroidCharacter.EAST_ASIAN_WIDTH_FULL_WIDTH);
+        } else {
+          isWide = false;
         }
       }
 
       if (lastChar != -1)
-        putChar((char) lastChar, isWide, false);
+        putCluster(lastChar, cluster, isWide);
 
       setCursorPosition(C, R);
       redraw();
     }
   }
 
+  private static final int ZERO_WIDTH_JOINER = 0x200d;
+  private static final int EMOJI_PRESENTATION = 0xfe0f;
+  private static final int REPLACEMENT_CHARACTER = 0xfffd;
+
+  /** Link attribute of the OSC 8 hyperlink being written, or 0 for none. */
+  private long link;
+
+  /** High surrogate at the end of the last putString waiting for its pair. */
+  private char pendingHighSurrogate;
+
+  /**
+   * @return true if {@code cp} belongs in the same cell as the code points
+   *         before it rather than starting a new one
+   */
+  private static boolean extendsCluster(int base, StringBuilder cluster, int cp) {
+    switch (Character.getType(cp)) {
+      case Character.NON_SPACING_MARK:
+      case Character.ENCLOSING_MARK:
+      case Character.COMBINING_SPACING_MARK:
+        return true;
+    }
+    if (cp == ZERO_WIDTH_JOINER
+        || (cp >= 0xfe00 && cp <= 0xfe0f)      // variation selectors
+        || (cp >= 0x1f3fb && cp <= 0x1f3ff)    // emoji skin tone modifiers
+        || (cp >= 0xe0020 && cp <= 0xe007f)    // tags for subdivision flags
+        || (cp >= 0xe0100 && cp <= 0xe01ef))   // variation selectors supplement
+      return true;
+    // two regional indicators make up one flag
+    return isRegionalIndicator(cp) && isRegionalIndicator(base)
+        && (cluster == null || cluster.length() == 0);
+  }
+
+  private static boolean isRegionalIndicator(int cp) {
+    return cp >= 0x1f1e6 && cp <= 0x1f1ff;
+  }
+
+  /**
+   * East Asian width of a code point outside the BMP, which the platform
+   * only reports per UTF-16 unit. Covers emoji and the supplementary
+   * ideographic planes.
+   */
+  static boolean isWideCodePoint(int cp) {
+    return (cp >= 0x1f300 && cp <= 0x1f64f)    // misc symbols, emoticons
+        || (cp >= 0x1f680 && cp <= 0x1f6ff)    // transport and map
+        || (cp >= 0x1f900 && cp <= 0x1faff)    // supplemental symbols
+        || (cp >= 0x1f1e6 && cp <= 0x1f1ff)    // regional indicators
+        || cp == 0x1f004 || cp == 0x1f0cf || cp == 0x1f18e
+        || (cp >= 0x1f191 && cp <= 0x1f19a)
+        || (cp >= 0x1f200 && cp <= 0x1f2ff)    // enclosed ideographs
+        || (cp >= 0x16fe0 && cp <= 0x18cff)    // Tangut
+        || (cp >= 0x1b000 && cp <= 0x1b2ff)    // kana supplement
+        || (cp >= 0x20000 && cp <= 0x3fffd);   // CJK extensions
+  }
+
+  /**
+   * Put one cell's worth of text. Anything that does not fit in a single
+   * UTF-16 unit is interned in the buffer's cluster table.
+   */
+  private void putCluster(int base, StringBuilder cluster, boolean isWide) {
+    boolean hasCluster = cluster != null && cluster.length() > 0;
+    if (base < 0x10000 && !hasCluster) {
+      putChar((char) base, isWide, false);
+      return;
+    }
+
+    StringBuilder text = new StringBuilder(hasCluster ? cluster.length() + 2 : 2);
+    text.appendCodePoint(base);
+    if (hasCluster) {
+      text.append(cluster);
+      cluster.setLength(0);
+    }
+
+    if (term_state == TSTATE_DATA) {
+      putChar(internCluster(text.toString()), isWide, false);
+    } else {
+      // inside a control string such as a window title: pass the text on
+      for (int i = 0; i < text.length(); i++)
+        putChar(text.charAt(i), false, false);
+    }
+  }
+
   protected void sendTelnetCommand(byte cmd) {
 
   }
@@ -161,13 +360,10 @@ public void setScreenSize(int c, int r, boolean broadcast) {
       debugStr.setLength(0);
     }
 
+    // the buffer keeps the cursor on the screen and with the text it was at
+    setCursorPosition(C, R);
     super.setScreenSize(c,r,false);
 
-    // Don't let the cursor go off the screen. Scroll down if needed.
-    if (R >= r) {
-      screenBase += R - (r - 1);
-      setWindowBase(screenBase);
-    }
     R = getCursorRow();
     C = getCursorColumn();
 
@@ -715,6 +911,7 @@ public void setScreenSize(int c, int r, boolean broadcast) {
   private final static int TSTATE_CSI_TICKS = 16;
   private final static int TSTATE_CSI_EQUAL = 17; /* ESC [ = */
   private final static int TSTATE_TITLE = 18; /* xterm title */
+  private final static int TSTATE_IMAGE = 19; /* sixel or iTerm2 image data */
 
   /* Keys we support */
   public final static int KEY_PAUSE = 1;
@@ -833,6 +1030,10 @@ public void setScreenSize(int c, int r, boolean broadcast) {
 
   private String osc,dcs;  /* to memorize OSC & DCS control sequence */
 
+  /* receiver of the inline image being sent, or null to discard it */
+  private ImageReceiver image;
+  private final char[] imageChar = new char[1];
+
   /** vt320 state variable (internal) */
   private int term_state = TSTATE_DATA;
   /** in vms mode, set by Terminal.VMS property */
@@ -1264,6 +1465,38 @@ public void setScreenSize(int c, int r, boolean broadcast) {
     }
   }
 
+  /** @return true if {@code dcs} holds only the parameters of a sixel image */
+  private static boolean isSixelIntroducer(String dcs) {
+    for (int i = 0; i < dcs.length(); i++) {
+      char c = dcs.charAt(i);
+      if ((c < '0' || c > '9') && c != ';')
+        return false;
+    }
+    return true;
+  }
+
+  /** @return true if {@code c} can be part of an image payload */
+  private static boolean isImageData(char c) {
+    return (c >= 0x20 && c < 0x7f) || c == '\r' || c == '\n';
+  }
+
+  private void startImage(int format, String params) {
+    image = beginImage(format, params);
+    term_state = TSTATE_IMAGE;
+  }
+
+  private void endImage(boolean complete) {
+    ImageReceiver receiver = image;
+    image = null;
+    term_state = TSTATE_DATA;
+    if (receiver != null) {
+      if (complete)
+        receiver.finish();
+      else
+        receiver.abort();
+    }
+  }
+
   private void handle_dcs(String dcs) {
     debugStr.append("DCS: ")
       .append(dcs);
@@ -1272,7 +1505,46 @@ public void setScreenSize(int c, int r, boolean broadcast) {
   }
 
   private void handle_osc(String osc) {
-	  if (osc.length() > 2 && osc.substring(0, 2).equals("4;")) {
+	  if (osc.startsWith("8;")) {
+			// Hyperlink: 8;params;URI, with an empty URI closing the link
+			int uriStart = osc.indexOf(';', 2) + 1;
+			int uriEnd = osc.length();
+			if (uriEnd > 0 && osc.charAt(uriEnd - 1) == ESC)
+				uriEnd--;
+
+			if (uriStart == 0 || uriStart >= uriEnd) {
+				link = 0;
+			} else {
+				int id = internLink(osc.substring(uriStart, uriEnd));
+				link = ((long) id << LINK_SHIFT) & LINK;
+			}
+		} else if (osc.startsWith("133;") && osc.length() > 4) {
+			// Shell integration: A prompt, B command, C output, D[;status] done
+			int row = screenBase + R;
+			switch (osc.charAt(4)) {
+			case 'A':
+				prompts.markPrompt(row);
+				break;
+			case 'B':
+				prompts.markCommand(row);
+				break;
+			case 'C':
+				prompts.markOutput(row);
+				break;
+			case 'D':
+				int status = 0;
+				String[] params = osc.split(";");
+				if (params.length > 2) {
+					try {
+						status = Integer.parseInt(params[2].replace(ESC, ' ').trim());
+					} catch (NumberFormatException e) {
+						// no usable status
+					}
+				}
+				prompts.markEnd(row, status);
+				break;
+			}
+		} else if (osc.length() > 2 && osc.substring(0, 2).equals("4;")) {
 			// Define color palette
 			String[] colorData = osc.split(";");
 
@@ -1779,6 +2051,8 @@ public void setScreenSize(int c, int r, boolean broadcast) {
                   if (R <= getBottomMargin() && R >= getTopMargin())
                     bot = getBottomMargin() + 1;
 
+                  // the line goes on, remember that for copying and resizing
+                  setWrapped(R, true);
                   if (R < bot - 1)
                     R++;
                   else {
@@ -1859,6 +2133,7 @@ public void setScreenSize(int c, int r, boolean broadcast) {
                     if (R <= getBottomMargin() && R >= getTopMargin())
                       bot = getBottomMargin() + 1;
 
+                    setWrapped(R, true);
                     if (R < bot - 1)
                       R++;
                     else {
@@ -1873,18 +2148,21 @@ public void setScreenSize(int c, int r, boolean broadcast) {
                 }
               }
 
+              // an open hyperlink is not part of the SGR state
+              long cellAttributes = attributes | link;
+
               if (insertmode == 1) {
                 if (isWide) {
-                  insertChar(C++, R, c, attributes | FULLWIDTH);
-                  insertChar(C, R, ' ', attributes | FULLWIDTH);
+                  insertChar(C++, R, c, cellAttributes | FULLWIDTH);
+                  insertChar(C, R, ' ', cellAttributes | FULLWIDTH);
                 } else
-                  insertChar(C, R, c, attributes);
+                  insertChar(C, R, c, cellAttributes);
               } else {
                 if (isWide) {
-                  putChar(C++, R, c, attributes | FULLWIDTH);
-                  putChar(C, R, ' ', attributes | FULLWIDTH);
+                  putChar(C++, R, c, cellAttributes | FULLWIDTH);
+                  putChar(C, R, ' ', cellAttributes | FULLWIDTH);
                 } else
-                  putChar(C, R, c, attributes);
+                  putChar(C, R, c, cellAttributes);
               }
 
               /*
@@ -1902,6 +2180,10 @@ public void setScreenSize(int c, int r, boolean broadcast) {
         } /* switch(c) */
         break;
       case TSTATE_OSC:
+        if (c == ':' && osc.startsWith("1337;File=")) {
+          startImage(IMAGE_FILE, osc.substring(10));
+          break;
+        }
         if ((c < 0x20) && (c != ESC)) {// NP - No printing character
           handle_osc(osc);
           term_state = TSTATE_DATA;
@@ -2182,8 +2464,35 @@ public void setScreenSize(int c, int r, boolean broadcast) {
           term_state = TSTATE_DATA;
           break;
         }
+        if (c == 'q' && isSixelIntroducer(dcs)) {
+          startImage(IMAGE_SIXEL, dcs);
+          break;
+        }
         dcs = dcs + c;
         break;
+      case TSTATE_IMAGE:
+        switch (c) {
+          case ESC:
+            // ESC \ ends the image; so does any other escape sequence
+            endImage(true);
+            term_state = TSTATE_ESC;
+            break;
+          case 7: // BEL
+          case 0x9c: // ST
+            endImage(true);
+            break;
+          case 0x18: // CAN
+          case 0x1a: // SUB
+            endImage(false);
+            break;
+          default:
+            if (image != null) {
+              imageChar[0] = c;
+              image.append(imageChar, 0, 1);
+            }
+            break;
+        }
+        break;
 
       case TSTATE_DCEQ:
         term_state = TSTATE_DATA;
@@ -3105,6 +3414,8 @@ public void setScreenSize(int c, int r, boolean broadcast) {
 
     onegl = -1; // Single shift override
 
+    link = 0;
+
     /* reset tabs */
     int nw = width;
     if (nw < 132) nw = 132;
@@ -3122,7 +3433,189 @@ public void setScreenSize(int c, int r, boolean broadcast) {
       display.resetColors();
 
     showCursor(true);
+    if (term_state == TSTATE_IMAGE)
+      endImage(false);
     /*FIXME:*/
     term_state = TSTATE_DATA;
   }
+
+  /**
+   * @return true if the emulator is between escape sequences, so that
+   * {@link #saveScreenState} captures everything needed to continue parsing
+   */
+  public boolean isIdle() {
+    return term_state == TSTATE_DATA && pendingHighSurrogate == 0;
+  }
+
+  /**
+   * Write the visible screen and the modes that affect how further output
+   * is drawn. Scrollback is not included. Only meaningful when
+   * {@link #isIdle} is true.
+   * @see #restoreScreenState
+   */
+  public void saveScreenState(DataOutputStream out) throws IOException {
+    out.writeInt(width);
+    out.writeInt(height);
+
+    // text behind cluster handles and link ids used on screen
+    Map<Character, String> usedClusters = new HashMap<Character, String>();
+    Map<Integer, String> usedLinks = new HashMap<Integer, String>();
+    for (int l = 0; l < height; l++) {
+      char[] chars = charArray[screenBase + l];
+      long[] attrs = charAttributes[screenBase + l];
+      for (int c = 0; c < width; c++) {
+        if (isClusterHandle(chars[c]) && !usedClusters.containsKey(chars[c]))
+          usedClusters.put(chars[c], getCluster(chars[c]));
+        int id = getLinkId(attrs[c]);
+        if (id != 0 && !usedLinks.containsKey(id))
+          usedLinks.put(id, getLink(id));
+      }
+    }
+    int openLink = getLinkId(link);
+    if (openLink != 0 && !usedLinks.containsKey(openLink))
+      usedLinks.put(openLink, getLink(openLink));
+
+    out.writeInt(usedClusters.size());
+    for (Map.Entry<Character, String> cluster : usedClusters.entrySet()) {
+      out.writeChar(cluster.getKey());
+      out.writeUTF(cluster.getValue());
+    }
+    out.writeInt(usedLinks.size());
+    for (Map.Entry<Integer, String> l : usedLinks.entrySet()) {
+      out.writeInt(l.getKey());
+      out.writeUTF(l.getValue() != null ? l.getValue() : "");
+    }
+
+    // attributes are written as runs since most of a row shares them
+    for (int l = 0; l < height; l++) {
+      char[] chars = charArray[screenBase + l];
+      long[] attrs = charAttributes[screenBase + l];
+      for (int c = 0; c < width; c++)
+        out.writeChar(chars[c]);
+      for (int c = 0; c < width; ) {
+        int run = 1;
+        while (c + run < width && attrs[c + run] == attrs[c])
+          run++;
+        out.writeShort(run);
+        out.writeLong(attrs[c]);
+        c += run;
+      }
+      out.writeBoolean(lineWrapped[screenBase + l]);
+    }
+
+    out.writeInt(C);
+    out.writeInt(R);
+    out.writeLong(attributes);
+    out.writeLong(link);
+    out.writeInt(getTopMargin());
+    out.writeInt(getBottomMargin());
+    out.writeBoolean(showcursor);
+    out.writeInt(insertmode);
+    out.writeBoolean(wraparound);
+    out.writeBoolean(moveoutsidemargins);
+    out.writeBoolean(vt52mode);
+    out.writeBoolean(useibmcharset);
+    out.writeBoolean(usedcharsets);
+    out.writeInt(lastwaslf);
+    for (int i = 0; i < 4; i++)
+      out.writeChar(gx[i]);
+    out.writeChar(gl);
+    out.writeChar(gr);
+    out.writeInt(onegl);
+    out.writeInt(Sc);
+    out.writeInt(Sr);
+    out.writeInt(Stm);
+    out.writeInt(Sbm);
+    out.writeLong(Sa);
+    out.writeChar(Sgl);
+    out.writeChar(Sgr);
+    for (int i = 0; i < 4; i++)
+      out.writeChar(Sgx != null ? Sgx[i] : 'B');
+    out.writeInt(Tabs.length);
+    out.write(Tabs);
+  }
+
+  /**
+   * Replace the visible screen and modes with ones written by
+   * {@link #saveScreenState}, resizing the screen to match.
+   */
+  public void restoreScreenState(DataInputStream in) throws IOException {
+    int w = in.readInt();
+    int h = in.readInt();
+    if (w != width || h != height)
+      setScreenSize(w, h, false);
+
+    Map<Character, Character> clusterHandles = new HashMap<Character, Character>();
+    for (int i = in.readInt(); i > 0; i--) {
+      char handle = in.readChar();
+      clusterHandles.put(handle, internCluster(in.readUTF()));
+    }
+    Map<Integer, Integer> linkIds = new HashMap<Integer, Integer>();
+    for (int i = in.readInt(); i > 0; i--) {
+      int id = in.readInt();
+      linkIds.put(id, internLink(in.readUTF()));
+    }
+
+    for (int l = 0; l < height; l++) {
+      char[] chars = charArray[screenBase + l];
+      long[] attrs = charAttributes[screenBase + l];
+      for (int c = 0; c < width; c++) {
+        char ch = in.readChar();
+        Character mapped = isClusterHandle(ch) ? clusterHandles.get(ch) : null;
+        chars[c] = mapped != null ? mapped : ch;
+      }
+      for (int c = 0; c < width; ) {
+        int run = in.readShort();
+        long attr = remapLink(in.readLong(), linkIds);
+        for (int i = 0; i < run && c < width; i++)
+          attrs[c++] = attr;
+      }
+      setWrapped(l, in.readBoolean());
+    }
+
+    C = in.readInt();
+    R = in.readInt();
+    attributes = in.readLong();
+    link = remapLink(in.readLong(), linkIds);
+    setMargins(in.readInt(), in.readInt());
+    showcursor = in.readBoolean();
+    insertmode = in.readInt();
+    wraparound = in.readBoolean();
+    moveoutsidemargins = in.readBoolean();
+    vt52mode = in.readBoolean();
+    useibmcharset = in.readBoolean();
+    usedcharsets = in.readBoolean();
+    lastwaslf = in.readInt();
+    for (int i = 0; i < 4; i++)
+      gx[i] = in.readChar();
+    gl = in.readChar();
+    gr = in.readChar();
+    onegl = in.readInt();
+    Sc = in.readInt();
+    Sr = in.readInt();
+    Stm = in.readInt();
+    Sbm = in.readInt();
+    Sa = in.readLong();
+    Sgl = in.readChar();
+    Sgr = in.readChar();
+    if (Sgx == null)
+      Sgx = new char[4];
+    for (int i = 0; i < 4; i++)
+      Sgx[i] = in.readChar();
+    Tabs = new byte[in.readInt()];
+    in.readFully(Tabs);
+
+    term_state = TSTATE_DATA;
+    pendingHighSurrogate = 0;
+    setCursorPosition(C, R);
+    markLine(0, height);
+    redraw();
+  }
+
+  private static long remapLink(long attr, Map<Integer, Integer> linkIds) {
+    Integer id = linkIds.get(getLinkId(attr));
+    if (id == null)
+      return attr & ~LINK;
+    return (attr & ~LINK) | (((long) id << LINK_SHIFT) & LINK);
+  }
 }
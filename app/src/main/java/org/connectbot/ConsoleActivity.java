@@ -17,17 +17,30 @@
 
 package org.connectbot;
 
+import java.io.ByteArrayOutputStream;
+import java.io.File;
+import java.io.InterruptedIOException;
+import java.io.OutputStream;
 import java.lang.ref.WeakReference;
 import java.util.ArrayList;
+import java.util.HashMap;
 import java.util.List;
+import java.util.Map;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.Future;
 
 import org.connectbot.bean.HostBean;
 import org.connectbot.service.BridgeDisconnectedListener;
+import org.connectbot.service.BroadcastGroup;
+import org.connectbot.service.ExecOutputProvider;
+import org.connectbot.service.OnHostStatusChangedListener;
 import org.connectbot.service.PromptHelper;
 import org.connectbot.service.TerminalBridge;
 import org.connectbot.service.TerminalKeyListener;
 import org.connectbot.service.TerminalManager;
+import org.connectbot.util.NativeZmodem;
 import org.connectbot.util.PreferenceConstants;
+import org.connectbot.util.TerminalTileLayout;
 import org.connectbot.util.TerminalViewPager;
 
 import android.annotation.SuppressLint;
@@ -47,6 +60,7 @@ import android.os.Bundle;
 import android.os.Handler;
 import android.os.IBinder;
 import android.os.Message;
+import android.os.SystemClock;
 import android.preference.PreferenceManager;
 import androidx.annotation.Nullable;
 import com.google.android.material.tabs.TabLayout;
@@ -86,18 +100,26 @@ import android.widget.LinearLayout;
 import android.widget.ListView;
 import android.widget.RelativeLayout;
 import android.widget.TextView;
+import android.widget.Toast;
 import de.mud.terminal.vt320;
 
 public class ConsoleActivity extends AppCompatActivity implements BridgeDisconnectedListener {
 	public final static String TAG = "CB.ConsoleActivity";
 
 	protected static final int REQUEST_EDIT = 1;
+	protected static final int REQUEST_UPLOAD = 2;
 
 	private static final int KEYBOARD_DISPLAY_TIME = 3000;
 	private static final int KEYBOARD_REPEAT_INITIAL = 500;
 	private static final int KEYBOARD_REPEAT = 100;
 	private static final String STATE_SELECTED_URI = "selectedUri";
 
+	/** How long a command started with "Run on all hosts" may run on each host. */
+	private static final long RUN_ON_ALL_TIMEOUT = 60 * 1000;
+
+	/** {@link SystemClock#elapsedRealtime()} when the user asked for the requested host. */
+	public static final String EXTRA_REQUESTED_AT = "org.connectbot.requested_at";
+
 	protected TerminalViewPager pager = null;
 	protected TabLayout tabs = null;
 	protected Toolbar toolbar = null;
@@ -132,7 +154,12 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 
 	private Animation keyboard_fade_in, keyboard_fade_out;
 
-	private MenuItem disconnect, copy, paste, portForward, resize, urlscan;
+	private MenuItem disconnect, copy, paste, portForward, resize, urlscan, splitScreen;
+	private MenuItem previousPrompt, nextPrompt, copyLastOutput, record, playRecording;
+	private MenuItem sendFile, runOnAll, broadcast;
+
+	/** Whether each page tiles several terminals instead of showing one. */
+	private boolean splitScreenMode = false;
 
 	private boolean forcedOrientation;
 
@@ -154,6 +181,7 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 
 			// let manager know about our event handling services
 			bound.disconnectListener = ConsoleActivity.this;
+			bound.registerOnHostStatusChangedListener(hostStatusListener);
 			bound.setResizeAllowed(true);
 
 			final String requestedNickname = (requested != null) ? requested.getFragment() : null;
@@ -164,6 +192,7 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 				try {
 					Log.d(TAG, String.format("We couldn't find an existing bridge with URI=%s (nickname=%s), so creating one now", requested.toString(), requestedNickname));
 					requestedBridge = bound.openConnection(requested);
+					noteRequestedAt(requestedBridge, getIntent());
 				} catch (Exception e) {
 					Log.e(TAG, "Problem while trying to create new requested bridge from URI", e);
 				}
@@ -189,12 +218,30 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 
 		@Override
 		public void onServiceDisconnected(ComponentName className) {
+			bound.unregisterOnHostStatusChangedListener(hostStatusListener);
 			bound = null;
 			adapter.notifyDataSetChanged();
 			updateEmptyVisible();
 		}
 	};
 
+	/**
+	 * Bridges can also appear without this activity asking for them, such as
+	 * the panes of a tmux session running in control mode.
+	 */
+	private final OnHostStatusChangedListener hostStatusListener = new OnHostStatusChangedListener() {
+		@Override
+		public void onHostStatusChanged() {
+			handler.post(new Runnable() {
+				@Override
+				public void run() {
+					adapter.notifyDataSetChanged();
+					updateEmptyVisible();
+				}
+			});
+		}
+	};
+
 	protected Handler promptHandler = new Handler() {
 		@Override
 		public void handleMessage(Message msg) {
@@ -406,7 +453,11 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 	}
 
 	protected View findCurrentView(int id) {
-		View view = pager.findViewWithTag(adapter.getBridgeAtPosition(pager.getCurrentItem()));
+		TerminalView terminal = adapter.getCurrentTerminalView();
+		if (terminal == null) {
+			return null;
+		}
+		View view = pager.findViewWithTag(terminal.bridge);
 		if (view == null) {
 			return null;
 		}
@@ -941,9 +992,274 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 			}
 		});
 
+		previousPrompt = menu.add(R.string.console_menu_previous_prompt);
+		previousPrompt.setEnabled(activeTerminal);
+		previousPrompt.setOnMenuItemClickListener(new OnMenuItemClickListener() {
+			@Override
+			public boolean onMenuItemClick(MenuItem item) {
+				TerminalView terminalView = adapter.getCurrentTerminalView();
+				if (terminalView != null)
+					terminalView.bridge.scrollToPreviousPrompt();
+				return true;
+			}
+		});
+
+		nextPrompt = menu.add(R.string.console_menu_next_prompt);
+		nextPrompt.setEnabled(activeTerminal);
+		nextPrompt.setOnMenuItemClickListener(new OnMenuItemClickListener() {
+			@Override
+			public boolean onMenuItemClick(MenuItem item) {
+				TerminalView terminalView = adapter.getCurrentTerminalView();
+				if (terminalView != null)
+					terminalView.bridge.scrollToNextPrompt();
+				return true;
+			}
+		});
+
+		copyLastOutput = menu.add(R.string.console_menu_copy_last_output);
+		copyLastOutput.setEnabled(activeTerminal);
+		copyLastOutput.setOnMenuItemClickListener(new OnMenuItemClickListener() {
+			@Override
+			public boolean onMenuItemClick(MenuItem item) {
+				TerminalView terminalView = adapter.getCurrentTerminalView();
+				if (terminalView == null)
+					return true;
+
+				String output = terminalView.bridge.getLastCommandOutput();
+				if (output == null)
+					return true;
+
+				clipboard.setText(output);
+				Toast.makeText(ConsoleActivity.this,
+						getResources().getQuantityString(R.plurals.console_copy_done,
+								output.length(), output.length()),
+						Toast.LENGTH_LONG).show();
+				return true;
+			}
+		});
+
+		sendFile = menu.add(R.string.console_menu_send_file);
+		sendFile.setEnabled(sessionOpen && NativeZmodem.isAvailable());
+		sendFile.setOnMenuItemClickListener(new OnMenuItemClickListener() {
+			@Override
+			public boolean onMenuItemClick(MenuItem item) {
+				Intent intent = new Intent(Intent.ACTION_GET_CONTENT);
+				intent.addCategory(Intent.CATEGORY_OPENABLE);
+				intent.setType("*/*");
+				startActivityForResult(intent, REQUEST_UPLOAD);
+				return true;
+			}
+		});
+
+		broadcast = menu.add(R.string.console_menu_broadcast);
+		broadcast.setCheckable(true);
+		broadcast.setChecked(activeTerminal && view.bridge.getBroadcastGroup() != null);
+		broadcast.setEnabled(sessionOpen);
+		broadcast.setOnMenuItemClickListener(new OnMenuItemClickListener() {
+			@Override
+			public boolean onMenuItemClick(MenuItem item) {
+				TerminalView terminalView = adapter.getCurrentTerminalView();
+				if (terminalView == null || bound == null)
+					return true;
+
+				BroadcastGroup group = bound.getBroadcastGroup();
+				if (!group.remove(terminalView.bridge)) {
+					group.add(terminalView.bridge);
+					int members = group.size();
+					Toast.makeText(ConsoleActivity.this,
+							getResources().getQuantityString(R.plurals.console_broadcast_members,
+									members, members),
+							Toast.LENGTH_SHORT).show();
+				}
+				return true;
+			}
+		});
+
+		runOnAll = menu.add(R.string.console_menu_run_on_all);
+		runOnAll.setEnabled(canRunOnAll());
+		runOnAll.setOnMenuItemClickListener(new OnMenuItemClickListener() {
+			@Override
+			public boolean onMenuItemClick(MenuItem item) {
+				final EditText commandView = new EditText(ConsoleActivity.this);
+				commandView.setSingleLine();
+				new androidx.appcompat.app.AlertDialog.Builder(
+								ConsoleActivity.this, R.style.AlertDialogTheme)
+						.setTitle(R.string.console_run_on_all_title)
+						.setView(commandView)
+						.setPositiveButton(R.string.button_run, new DialogInterface.OnClickListener() {
+							@Override
+							public void onClick(DialogInterface dialog, int which) {
+								String command = commandView.getText().toString().trim();
+								if (command.length() > 0)
+									runOnAllHosts(command);
+							}
+						}).setNegativeButton(android.R.string.cancel, null).create().show();
+				return true;
+			}
+		});
+
+		record = menu.add(R.string.console_menu_record);
+		record.setCheckable(true);
+		record.setEnabled(activeTerminal);
+		record.setOnMenuItemClickListener(new OnMenuItemClickListener() {
+			@Override
+			public boolean onMenuItemClick(MenuItem item) {
+				TerminalView terminalView = adapter.getCurrentTerminalView();
+				if (terminalView == null)
+					return true;
+
+				TerminalBridge bridge = terminalView.bridge;
+				if (bridge.isRecording()) {
+					bridge.stopRecording();
+				} else if (!bridge.startRecording(new File(getFilesDir(), "recordings"))) {
+					Toast.makeText(ConsoleActivity.this, R.string.console_record_failed,
+							Toast.LENGTH_LONG).show();
+				}
+				return true;
+			}
+		});
+
+		playRecording = menu.add(R.string.console_menu_play_recording);
+		playRecording.setEnabled(false);
+		playRecording.setOnMenuItemClickListener(new OnMenuItemClickListener() {
+			@Override
+			public boolean onMenuItemClick(MenuItem item) {
+				TerminalView terminalView = adapter.getCurrentTerminalView();
+				if (terminalView == null || terminalView.bridge.getLastRecording() == null)
+					return true;
+
+				Intent intent = new Intent(ConsoleActivity.this, PlaybackActivity.class);
+				intent.putExtra(PlaybackActivity.EXTRA_RECORDING,
+						terminalView.bridge.getLastRecording().getAbsolutePath());
+				startActivity(intent);
+				return true;
+			}
+		});
+
+		splitScreen = menu.add(R.string.console_menu_split_screen);
+		splitScreen.setCheckable(true);
+		splitScreen.setChecked(splitScreenMode);
+		splitScreen.setEnabled(adapter.getBridgeCount() > 1);
+		splitScreen.setOnMenuItemClickListener(new OnMenuItemClickListener() {
+			@Override
+			public boolean onMenuItemClick(MenuItem item) {
+				setSplitScreenMode(!splitScreenMode);
+				return true;
+			}
+		});
+
 		return true;
 	}
 
+	private boolean canRunOnAll() {
+		if (bound == null)
+			return false;
+
+		for (TerminalBridge bridge : bound.getBridges()) {
+			if (bridge.canExec())
+				return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Run {@code command} on every connected host that supports it, outside of
+	 * their terminals, and show what each host printed once they have all
+	 * finished or run out of time.
+	 */
+	private void runOnAllHosts(final String command) {
+		if (bound == null)
+			return;
+
+		final List<TerminalBridge> targets = new ArrayList<>();
+		final Map<TerminalBridge, ByteArrayOutputStream> outputs = new HashMap<>();
+		for (TerminalBridge bridge : bound.getBridges()) {
+			if (bridge.canExec()) {
+				targets.add(bridge);
+				outputs.put(bridge, new ByteArrayOutputStream());
+			}
+		}
+
+		if (targets.isEmpty())
+			return;
+
+		final List<Future<Integer>> results = bound.execOnBridges(targets, command,
+				new ExecOutputProvider() {
+					@Override
+					public OutputStream getStdout(TerminalBridge bridge) {
+						return outputs.get(bridge);
+					}
+
+					@Override
+					public OutputStream getStderr(TerminalBridge bridge) {
+						return outputs.get(bridge);
+					}
+				}, RUN_ON_ALL_TIMEOUT);
+
+		Thread collector = new Thread(new Runnable() {
+			@Override
+			public void run() {
+				final StringBuilder report = new StringBuilder();
+				for (int i = 0; i < targets.size(); i++) {
+					TerminalBridge bridge = targets.get(i);
+					String nickname = bridge.host.getNickname();
+					try {
+						report.append(getString(R.string.console_run_exit_status, nickname,
+								results.get(i).get()));
+					} catch (ExecutionException e) {
+						if (e.getCause() instanceof InterruptedIOException) {
+							report.append(getString(R.string.console_run_timed_out, nickname));
+						} else {
+							report.append(getString(R.string.console_run_failed, nickname,
+									e.getCause().getMessage()));
+						}
+					} catch (InterruptedException e) {
+						return;
+					}
+					report.append('\n').append(outputs.get(bridge).toString()).append('\n');
+				}
+
+				handler.post(new Runnable() {
+					@Override
+					public void run() {
+						if (isFinishing())
+							return;
+
+						new androidx.appcompat.app.AlertDialog.Builder(
+										ConsoleActivity.this, R.style.AlertDialogTheme)
+								.setTitle(command)
+								.setMessage(report.toString())
+								.setPositiveButton(android.R.string.ok, null)
+								.create().show();
+					}
+				});
+			}
+		});
+		collector.setName("RunOnAllHosts");
+		collector.setDaemon(true);
+		collector.start();
+	}
+
+	/**
+	 * Switch between one terminal per page and up to
+	 * {@link TerminalTileLayout#MAX_TILES} terminals tiled on each page,
+	 * keeping the current terminal in view.
+	 */
+	private void setSplitScreenMode(boolean enabled) {
+		if (enabled == splitScreenMode)
+			return;
+
+		TerminalView current = adapter.getCurrentTerminalView();
+		int bridgeIndex = (current != null && bound != null)
+				? bound.getBridges().indexOf(current.bridge) : -1;
+
+		splitScreenMode = enabled;
+		adapter.notifyDataSetChanged();
+
+		if (bridgeIndex != -1)
+			setDisplayedTerminal(bridgeIndex);
+	}
+
 	@Override
 	public boolean onPrepareOptionsMenu(Menu menu) {
 		super.onPrepareOptionsMenu(menu);
@@ -973,6 +1289,19 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 		portForward.setEnabled(sessionOpen && canForwardPorts);
 		urlscan.setEnabled(activeTerminal);
 		resize.setEnabled(sessionOpen);
+		sendFile.setEnabled(sessionOpen && NativeZmodem.isAvailable());
+		broadcast.setEnabled(sessionOpen);
+		broadcast.setChecked(activeTerminal && view.bridge.getBroadcastGroup() != null);
+		runOnAll.setEnabled(canRunOnAll());
+		record.setEnabled(activeTerminal);
+		record.setChecked(activeTerminal && view.bridge.isRecording());
+		playRecording.setEnabled(activeTerminal && view.bridge.getLastRecording() != null);
+		boolean promptMarks = activeTerminal && view.bridge.hasPromptMarks();
+		previousPrompt.setVisible(promptMarks);
+		nextPrompt.setVisible(promptMarks);
+		copyLastOutput.setVisible(promptMarks);
+		splitScreen.setChecked(splitScreenMode);
+		splitScreen.setEnabled(splitScreenMode || adapter.getBridgeCount() > 1);
 
 		return true;
 	}
@@ -1036,6 +1365,28 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 		}
 	}
 
+	@Override
+	protected void onActivityResult(int requestCode, int resultCode, Intent data) {
+		super.onActivityResult(requestCode, resultCode, data);
+
+		if (requestCode != REQUEST_UPLOAD || resultCode != RESULT_OK || data == null
+				|| data.getData() == null)
+			return;
+
+		TerminalView terminalView = adapter.getCurrentTerminalView();
+		if (terminalView == null) {
+			Log.w(TAG, "No terminal to send " + data.getData() + " to");
+			return;
+		}
+		terminalView.bridge.sendFile(data.getData());
+	}
+
+	private static void noteRequestedAt(TerminalBridge bridge, Intent intent) {
+		long requestedAt = intent.getLongExtra(EXTRA_REQUESTED_AT, -1);
+		if (bridge != null && requestedAt >= 0)
+			bridge.setRequestedAt(requestedAt);
+	}
+
 	/* (non-Javadoc)
 	 * @see android.app.Activity#onNewIntent(android.content.Intent)
 	 */
@@ -1067,7 +1418,7 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 				try {
 					Log.d(TAG, String.format("We couldnt find an existing bridge with URI=%s (nickname=%s)," +
 							"so creating one now", requested.toString(), requested.getFragment()));
-					bound.openConnection(requested);
+					noteRequestedAt(bound.openConnection(requested), intent);
 				} catch (Exception e) {
 					Log.e(TAG, "Problem while trying to create new requested bridge from URI", e);
 					// TODO: We should display an error dialog here.
@@ -1075,7 +1426,7 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 				}
 
 				adapter.notifyDataSetChanged();
-				requestedIndex = adapter.getCount();
+				requestedIndex = adapter.getBridgeCount() - 1;
 			} else {
 				final int flipIndex = bound.getBridges().indexOf(requestedBridge);
 				if (flipIndex > requestedIndex) {
@@ -1091,6 +1442,8 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 	public void onStop() {
 		super.onStop();
 
+		if (bound != null)
+			bound.unregisterOnHostStatusChangedListener(hostStatusListener);
 		unbindService(connection);
 	}
 
@@ -1227,14 +1580,21 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 	}
 
 	/**
-	 * Displays the child in the ViewPager at the requestedIndex and updates the prompts.
+	 * Displays the terminal of the bridge at requestedIndex and updates the prompts.
 	 *
-	 * @param requestedIndex the index of the terminal view to display
+	 * @param requestedIndex the index of the bridge whose terminal to display
 	 */
 	private void setDisplayedTerminal(int requestedIndex) {
-		pager.setCurrentItem(requestedIndex);
+		int position = adapter.getPositionOfBridge(requestedIndex);
+		pager.setCurrentItem(position);
+
+		TerminalBridge bridge = adapter.getBridge(requestedIndex);
+		TerminalTileLayout tiles = adapter.getTiles(position);
+		if (tiles != null && bridge != null)
+			tiles.setActiveTile(bridge);
+
 		// set activity title
-		setTitle(adapter.getPageTitle(requestedIndex));
+		setTitle(adapter.getPageTitle(position));
 		onTerminalChanged();
 	}
 
@@ -1252,8 +1612,20 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 	}
 
 	public class TerminalPagerAdapter extends PagerAdapter {
+		/** Tag prefix of the tile layout holding each page in split screen mode. */
+		private static final String TILES_TAG = "tiles:";
+
 		@Override
 		public int getCount() {
+			int bridges = getBridgeCount();
+			if (splitScreenMode) {
+				return (bridges + TerminalTileLayout.MAX_TILES - 1) / TerminalTileLayout.MAX_TILES;
+			} else {
+				return bridges;
+			}
+		}
+
+		public int getBridgeCount() {
 			if (bound != null) {
 				return bound.getBridges().size();
 			} else {
@@ -1263,10 +1635,40 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 
 		@Override
 		public Object instantiateItem(ViewGroup container, int position) {
-			if (bound == null || bound.getBridges().size() <= position) {
+			if (bound == null || getCount() <= position) {
 				Log.w(TAG, "Activity not bound when creating TerminalView.");
 			}
-			TerminalBridge bridge = bound.getBridges().get(position);
+
+			if (!splitScreenMode) {
+				View view = createTerminalItem(container, bound.getBridges().get(position));
+				container.addView(view);
+				return view;
+			}
+
+			TerminalTileLayout tiles = new TerminalTileLayout(container.getContext());
+			tiles.setTag(TILES_TAG + position);
+			tiles.setOnActiveTileChangedListener(new TerminalTileLayout.OnActiveTileChangedListener() {
+				@Override
+				public void onActiveTileChanged(TerminalView terminal) {
+					onTerminalChanged();
+				}
+			});
+
+			ArrayList<TerminalBridge> bridges = bound.getBridges();
+			int first = position * TerminalTileLayout.MAX_TILES;
+			int last = Math.min(first + TerminalTileLayout.MAX_TILES, bridges.size());
+			for (int i = first; i < last; i++) {
+				tiles.addView(createTerminalItem(tiles, bridges.get(i)));
+			}
+
+			container.addView(tiles);
+			return tiles;
+		}
+
+		/**
+		 * Inflate the view showing one bridge: its terminal and name overlay.
+		 */
+		private View createTerminalItem(ViewGroup container, TerminalBridge bridge) {
 			bridge.promptHelper.setHandler(promptHandler);
 
 			// inflate each terminal view
@@ -1285,7 +1687,6 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 			// Tag the view with its bridge so it can be retrieved later.
 			view.setTag(bridge);
 
-			container.addView(view);
 			terminalNameOverlay.startAnimation(fade_out_delayed);
 			return view;
 		}
@@ -1303,6 +1704,12 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 				return POSITION_NONE;
 			}
 
+			// Pages of tiles are rebuilt whenever the set of bridges changes,
+			// and every page is rebuilt when the mode changes.
+			if (splitScreenMode || object instanceof TerminalTileLayout) {
+				return POSITION_NONE;
+			}
+
 			View view = (View) object;
 			TerminalView terminal = view.findViewById(R.id.terminal_view);
 			HostBean host = terminal.bridge.host;
@@ -1319,16 +1726,48 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 			return itemIndex;
 		}
 
+		/**
+		 * @return the bridge shown at {@code position}; in split screen mode,
+		 *         the first bridge on that page
+		 */
 		public TerminalBridge getBridgeAtPosition(int position) {
+			if (splitScreenMode) {
+				position *= TerminalTileLayout.MAX_TILES;
+			}
+			return getBridge(position);
+		}
+
+		public TerminalBridge getBridge(int index) {
 			if (bound == null) {
 				return null;
 			}
 
 			ArrayList<TerminalBridge> bridges = bound.getBridges();
-			if (position < 0 || position >= bridges.size()) {
+			if (index < 0 || index >= bridges.size()) {
+				return null;
+			}
+			return bridges.get(index);
+		}
+
+		/**
+		 * @return the page showing the bridge at {@code index}
+		 */
+		public int getPositionOfBridge(int index) {
+			if (splitScreenMode) {
+				return index / TerminalTileLayout.MAX_TILES;
+			}
+			return index;
+		}
+
+		/**
+		 * @return the tiles on page {@code position}, or {@code null} when not
+		 *         in split screen mode
+		 */
+		public TerminalTileLayout getTiles(int position) {
+			if (!splitScreenMode) {
 				return null;
 			}
-			return bridges.get(position);
+			return pager.findViewWithTag(TILES_TAG + position);
 		}
 
 		@Override
@@ -1347,6 +1786,22 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 
 		@Override
 		public CharSequence getPageTitle(int position) {
+			if (splitScreenMode) {
+				StringBuilder title = new StringBuilder();
+				int first = position * TerminalTileLayout.MAX_TILES;
+				for (int i = first; i < first + TerminalTileLayout.MAX_TILES; i++) {
+					TerminalBridge bridge = getBridge(i);
+					if (bridge == null) {
+						break;
+					}
+					if (title.length() > 0) {
+						title.append(" | ");
+					}
+					title.append(bridge.host.getNickname());
+				}
+				return title.length() > 0 ? title : "???";
+			}
+
 			TerminalBridge bridge = getBridgeAtPosition(position);
 			if (bridge == null) {
 				return "???";
@@ -1355,6 +1810,11 @@ public class ConsoleActivity extends AppCompatActivity implements BridgeDisconne
 		}
 
 		public TerminalView getCurrentTerminalView() {
+			TerminalTileLayout tiles = getTiles(pager.getCurrentItem());
+			if (tiles != null) {
+				return tiles.getActiveTerminalView();
+			}
+
 			View currentView = pager.findViewWithTag(getBridgeAtPosition(pager.getCurrentItem()));
 			if (currentView == null) {
 				return null;
@@ -40,6 +40,7 @@ import android.view.MenuItem;
 import org.connectbot.bean.HostBean;
 import org.connectbot.service.TerminalBridge;
 import org.connectbot.service.TerminalManager;
+import org.connectbot.transport.SSH;
 import org.connectbot.util.HostDatabase;
 import org.connectbot.util.PubkeyDatabase;
 
@@ -115,13 +116,26 @@ public class EditHostActivity extends AppCompatActivity implements HostEditorFra
 			pubkeyValues.add(cs.toString());
 		}
 
+		// Any other SSH host can be used as a jump host; loops are refused when connecting.
+		ArrayList<String> jumpHostNames = new ArrayList<>();
+		ArrayList<String> jumpHostValues = new ArrayList<>();
+		jumpHostNames.add(getString(R.string.list_jumphost_none));
+		jumpHostValues.add(Long.toString(HostDatabase.JUMPHOSTID_NONE));
+		for (HostBean host : mHostDb.getHosts(false)) {
+			if (host.getId() == hostId || !SSH.getProtocolName().equals(host.getProtocol()))
+				continue;
+			jumpHostNames.add(host.getNickname());
+			jumpHostValues.add(Long.toString(host.getId()));
+		}
+
 		setContentView(R.layout.activity_edit_host);
 		FragmentManager fm = getSupportFragmentManager();
 		HostEditorFragment fragment =
 				(HostEditorFragment) fm.findFragmentById(R.id.fragment_container);
 
 		if (fragment == null) {
-			fragment = HostEditorFragment.newInstance(mHost, pubkeyNames, pubkeyValues);
+			fragment = HostEditorFragment.newInstance(mHost, pubkeyNames, pubkeyValues,
+					jumpHostNames, jumpHostValues);
 			getSupportFragmentManager().beginTransaction()
 					.add(R.id.fragment_container, fragment).commit();
 		}
@@ -32,6 +32,7 @@ import androidx.appcompat.widget.PopupMenu;
 import android.text.Editable;
 import android.text.TextWatcher;
 import android.view.LayoutInflater;
+import android.view.Menu;
 import android.view.MenuItem;
 import android.view.View;
 import android.view.ViewGroup;
@@ -55,6 +56,8 @@ public class HostEditorFragment extends Fragment {
 	private static final String ARG_IS_EXPANDED = "isExpanded";
 	private static final String ARG_PUBKEY_NAMES = "pubkeyNames";
 	private static final String ARG_PUBKEY_VALUES = "pubkeyValues";
+	private static final String ARG_JUMPHOST_NAMES = "jumpHostNames";
+	private static final String ARG_JUMPHOST_VALUES = "jumpHostValues";
 	private static final String ARG_QUICKCONNECT_STRING = "quickConnectString";
 
 	// Note: The "max" value for mFontSizeSeekBar is 32. If these font values change, this value
@@ -70,6 +73,10 @@ public class HostEditorFragment extends Fragment {
 	private ArrayList<String> mPubkeyNames;
 	private ArrayList<String> mPubkeyValues;
 
+	// The hosts this one can be tunneled through, including connecting directly.
+	private ArrayList<String> mJumpHostNames;
+	private ArrayList<String> mJumpHostValues;
+
 	// The listener for changes to this host.
 	private Listener mListener;
 
@@ -115,6 +122,8 @@ public class HostEditorFragment extends Fragment {
 	private SeekBar mFontSizeSeekBar;
 	private View mPubkeyItem;
 	private TextView mPubkeyText;
+	private View mJumpHostItem;
+	private TextView mJumpHostText;
 	private View mDelKeyItem;
 	private TextView mDelKeyText;
 	private View mEncodingItem;
@@ -129,7 +138,8 @@ public class HostEditorFragment extends Fragment {
 	private HostTextFieldWatcher mFontSizeTextChangeListener;
 
 	public static HostEditorFragment newInstance(
-			HostBean existingHost, ArrayList<String> pubkeyNames, ArrayList<String> pubkeyValues) {
+			HostBean existingHost, ArrayList<String> pubkeyNames, ArrayList<String> pubkeyValues,
+			ArrayList<String> jumpHostNames, ArrayList<String> jumpHostValues) {
 		HostEditorFragment fragment = new HostEditorFragment();
 		Bundle args = new Bundle();
 		if (existingHost != null) {
@@ -138,6 +148,8 @@ public class HostEditorFragment extends Fragment {
 		}
 		args.putStringArrayList(ARG_PUBKEY_NAMES, pubkeyNames);
 		args.putStringArrayList(ARG_PUBKEY_VALUES, pubkeyValues);
+		args.putStringArrayList(ARG_JUMPHOST_NAMES, jumpHostNames);
+		args.putStringArrayList(ARG_JUMPHOST_VALUES, jumpHostValues);
 		fragment.setArguments(args);
 		return fragment;
 	}
@@ -161,6 +173,8 @@ public class HostEditorFragment extends Fragment {
 
 		mPubkeyNames = bundle.getStringArrayList(ARG_PUBKEY_NAMES);
 		mPubkeyValues = bundle.getStringArrayList(ARG_PUBKEY_VALUES);
+		mJumpHostNames = bundle.getStringArrayList(ARG_JUMPHOST_NAMES);
+		mJumpHostValues = bundle.getStringArrayList(ARG_JUMPHOST_VALUES);
 
 		mIsUriEditorExpanded = bundle.getBoolean(ARG_IS_EXPANDED);
 	}
@@ -248,6 +262,7 @@ public class HostEditorFragment extends Fragment {
 		mPortField.addTextChangedListener(new HostTextFieldWatcher(HostDatabase.FIELD_HOST_PORT));
 
 		mNicknameItem = view.findViewById(R.id.nickname_item);
+		mJumpHostItem = view.findViewById(R.id.jumphost_item);
 
 		setTransportType(mHost.getProtocol(), /* setDefaultPortInModel */ false);
 
@@ -351,6 +366,36 @@ public class HostEditorFragment extends Fragment {
 			}
 		}
 
+		mJumpHostItem.setOnClickListener(new View.OnClickListener() {
+			@Override
+			public void onClick(View v) {
+				PopupMenu menu = new PopupMenu(getActivity(), v);
+				for (int i = 0; i < mJumpHostNames.size(); i++) {
+					menu.getMenu().add(Menu.NONE, i, Menu.NONE, mJumpHostNames.get(i));
+				}
+				menu.setOnMenuItemClickListener(new PopupMenu.OnMenuItemClickListener() {
+					@Override
+					public boolean onMenuItemClick(MenuItem item) {
+						// Nicknames need not be unique, so match on position.
+						int i = item.getItemId();
+						mHost.setJumpHostId(Long.parseLong(mJumpHostValues.get(i)));
+						mJumpHostText.setText(mJumpHostNames.get(i));
+						handleHostChange();
+						return true;
+					}
+				});
+				menu.show();
+			}
+		});
+
+		mJumpHostText = view.findViewById(R.id.jumphost_text);
+		for (int i = 0; i < mJumpHostValues.size(); i++) {
+			if (mHost.getJumpHostId() == Long.parseLong(mJumpHostValues.get(i))) {
+				mJumpHostText.setText(mJumpHostNames.get(i));
+				break;
+			}
+		}
+
 		mDelKeyItem = view.findViewById(R.id.delkey_item);
 		mDelKeyItem.setOnClickListener(new View.OnClickListener() {
 			@Override
@@ -506,18 +551,21 @@ public class HostEditorFragment extends Fragment {
 			mPortContainer.setVisibility(View.VISIBLE);
 			mExpandCollapseButton.setVisibility(View.VISIBLE);
 			mNicknameItem.setVisibility(View.VISIBLE);
+			mJumpHostItem.setVisibility(View.VISIBLE);
 		} else if (Telnet.getProtocolName().equals(protocol)) {
 			mUsernameContainer.setVisibility(View.GONE);
 			mHostnameContainer.setVisibility(View.VISIBLE);
 			mPortContainer.setVisibility(View.VISIBLE);
 			mExpandCollapseButton.setVisibility(View.VISIBLE);
 			mNicknameItem.setVisibility(View.VISIBLE);
+			mJumpHostItem.setVisibility(View.GONE);
 		} else {
 			// Local protocol has only one field, so no need to show the URI parts
 			// container.
 			setUriPartsContainerExpanded(false);
 			mExpandCollapseButton.setVisibility(View.GONE);
 			mNicknameItem.setVisibility(View.GONE);
+			mJumpHostItem.setVisibility(View.GONE);
 		}
 	}
 
@@ -604,6 +652,8 @@ public class HostEditorFragment extends Fragment {
 				ARG_QUICKCONNECT_STRING, mQuickConnectField.getText().toString());
 		savedInstanceState.putStringArrayList(ARG_PUBKEY_NAMES, mPubkeyNames);
 		savedInstanceState.putStringArrayList(ARG_PUBKEY_VALUES, mPubkeyValues);
+		savedInstanceState.putStringArrayList(ARG_JUMPHOST_NAMES, mJumpHostNames);
+		savedInstanceState.putStringArrayList(ARG_JUMPHOST_VALUES, mJumpHostValues);
 	}
 
 	/**
@@ -30,6 +30,7 @@ import android.net.Uri;
 import android.os.Build;
 import android.os.Bundle;
 import android.os.IBinder;
+import android.os.SystemClock;
 import android.preference.PreferenceManager;
 import androidx.annotation.StyleRes;
 import androidx.annotation.VisibleForTesting;
@@ -56,6 +57,7 @@ import org.connectbot.service.TerminalManager;
 import org.connectbot.transport.TransportFactory;
 import org.connectbot.util.HostDatabase;
 import org.connectbot.util.PreferenceConstants;
+import org.connectbot.util.StartupTrace;
 
 import java.util.List;
 
@@ -101,6 +103,8 @@ public class HostListActivity extends AppCompatListActivity implements OnHostSta
 
 			bound.registerOnHostStatusChangedListener(HostListActivity.this);
 
+			bound.preconnectLikelyHosts();
+
 			if (waitingForDisconnectAll) {
 				disconnectAll();
 			}
@@ -168,6 +172,8 @@ public class HostListActivity extends AppCompatListActivity implements OnHostSta
 	@Override
 	public void onCreate(Bundle icicle) {
 		super.onCreate(icicle);
+		StartupTrace.start();
+
 		setContentView(R.layout.act_hostlist);
 		setTitle(R.string.title_hosts_list);
 
@@ -356,6 +362,7 @@ public class HostListActivity extends AppCompatListActivity implements OnHostSta
 
 		Intent intent = new Intent(HostListActivity.this, ConsoleActivity.class);
 		intent.setData(uri);
+		intent.putExtra(ConsoleActivity.EXTRA_REQUESTED_AT, SystemClock.elapsedRealtime());
 		startActivity(intent);
 
 		return true;
@@ -373,6 +380,8 @@ public class HostListActivity extends AppCompatListActivity implements OnHostSta
 
 		hosts = hostdb.getHosts(sortedByColor);
 
+		StartupTrace.mark(StartupTrace.HOST_LIST_SHOWN);
+
 		// Don't lose hosts that are connected via shortcuts but not in the database.
 		if (bound != null) {
 			for (TerminalBridge bridge : bound.getBridges()) {
@@ -0,0 +1,332 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot;
+
+import java.io.File;
+import java.io.IOException;
+import java.util.Locale;
+
+import org.connectbot.service.SessionPlayer;
+import org.connectbot.views.PlaybackView;
+
+import android.os.Bundle;
+import android.os.Handler;
+import android.os.HandlerThread;
+import android.os.Looper;
+import android.os.SystemClock;
+import android.util.Log;
+import android.view.View;
+import android.widget.Button;
+import android.widget.SeekBar;
+import android.widget.TextView;
+import android.widget.Toast;
+import androidx.appcompat.app.AppCompatActivity;
+import de.mud.terminal.vt320;
+
+/**
+ * Plays back a session recording with a scrubber and a choice of speeds.
+ * The recording is read and fed to the terminal on a playback thread; the
+ * main thread only draws the screen and the controls.
+ *
+ * @author Kenny Root
+ */
+public class PlaybackActivity extends AppCompatActivity {
+	private static final String TAG = "CB.PlaybackActivity";
+
+	/** Intent extra with the path of the recording to play. */
+	public static final String EXTRA_RECORDING = "org.connectbot.extra.RECORDING";
+
+	private static final float[] SPEEDS = { 1f, 2f, 4f, 8f, 16f, 64f };
+
+	private static final long FRAME_MILLIS = 16;
+
+	private final Handler handler = new Handler();
+
+	private HandlerThread playbackThread;
+	private Handler playbackHandler;
+
+	/** Only used on the playback thread. */
+	private SessionPlayer player;
+	private long lastTick;
+
+	private PlaybackView terminalView;
+	private Button playButton;
+	private Button speedButton;
+	private SeekBar seekBar;
+	private TextView timeView;
+
+	private boolean opened = false;
+	private boolean resumed = false;
+	private boolean finished = false;
+	private boolean playing = true;
+	private int speedIndex = 0;
+
+	/** Whether the playback thread should keep advancing. */
+	private volatile boolean ticking = false;
+
+	private volatile int seekTarget;
+
+	private final Runnable tick = new Runnable() {
+		@Override
+		public void run() {
+			if (!ticking)
+				return;
+
+			long now = SystemClock.uptimeMillis();
+			try {
+				// everything since the last frame is applied before one redraw
+				player.advance(now - lastTick);
+			} catch (IOException e) {
+				Log.e(TAG, "Could not read session recording", e);
+				postProgress(true);
+				return;
+			}
+			lastTick = now;
+
+			if (player.isFinished()) {
+				postProgress(true);
+			} else {
+				postProgress(false);
+				playbackHandler.postDelayed(this, FRAME_MILLIS);
+			}
+		}
+	};
+
+	private final Runnable startTicking = new Runnable() {
+		@Override
+		public void run() {
+			lastTick = SystemClock.uptimeMillis();
+			tick.run();
+		}
+	};
+
+	private final Runnable seek = new Runnable() {
+		@Override
+		public void run() {
+			try {
+				player.seek(seekTarget);
+			} catch (IOException e) {
+				Log.e(TAG, "Could not seek in session recording", e);
+			}
+			postProgress(false);
+		}
+	};
+
+	@Override
+	protected void onCreate(Bundle savedInstanceState) {
+		super.onCreate(savedInstanceState);
+		setContentView(R.layout.act_playback);
+
+		terminalView = findViewById(R.id.playback_terminal);
+		playButton = findViewById(R.id.playback_play);
+		speedButton = findViewById(R.id.playback_speed);
+		seekBar = findViewById(R.id.playback_seek);
+		timeView = findViewById(R.id.playback_time);
+
+		final vt320 terminal = new vt320() {
+			@Override
+			public void write(byte[] b) {}
+			@Override
+			public void write(int b) {}
+			@Override
+			public void sendTelnetCommand(byte cmd) {}
+			@Override
+			public void setWindowSize(int c, int r) {}
+			@Override
+			public void debug(String s) {}
+		};
+		terminalView.setVDUBuffer(terminal);
+
+		playbackThread = new HandlerThread("Playback");
+		playbackThread.start();
+		playbackHandler = new Handler(playbackThread.getLooper());
+
+		final String path = getIntent().getStringExtra(EXTRA_RECORDING);
+		playbackHandler.post(new Runnable() {
+			@Override
+			public void run() {
+				try {
+					if (path == null)
+						throw new IOException("No recording given");
+					player = new SessionPlayer(new File(path), terminal);
+				} catch (IOException e) {
+					Log.e(TAG, "Could not open session recording " + path, e);
+					handler.post(new Runnable() {
+						@Override
+						public void run() {
+							Toast.makeText(PlaybackActivity.this, R.string.playback_open_failed,
+									Toast.LENGTH_LONG).show();
+							finish();
+						}
+					});
+					return;
+				}
+
+				final int duration = player.getDuration();
+				handler.post(new Runnable() {
+					@Override
+					public void run() {
+						onOpened(duration);
+					}
+				});
+			}
+		});
+
+		seekBar.setOnSeekBarChangeListener(new SeekBar.OnSeekBarChangeListener() {
+			@Override
+			public void onProgressChanged(SeekBar bar, int progress, boolean fromUser) {
+				if (!fromUser || !opened)
+					return;
+
+				// only the latest position matters while the user drags
+				seekTarget = progress;
+				playbackHandler.removeCallbacks(seek);
+				playbackHandler.post(seek);
+			}
+
+			@Override
+			public void onStartTrackingTouch(SeekBar bar) {
+			}
+
+			@Override
+			public void onStopTrackingTouch(SeekBar bar) {
+			}
+		});
+
+		playButton.setOnClickListener(new View.OnClickListener() {
+			@Override
+			public void onClick(View v) {
+				if (!opened)
+					return;
+
+				if (!playing && finished) {
+					seekTarget = 0;
+					playbackHandler.post(seek);
+				}
+				setPlaying(!playing);
+			}
+		});
+
+		speedButton.setOnClickListener(new View.OnClickListener() {
+			@Override
+			public void onClick(View v) {
+				speedIndex = (speedIndex + 1) % SPEEDS.length;
+				updateSpeed();
+			}
+		});
+
+		updateSpeed();
+		updateProgress(0, false);
+	}
+
+	private void onOpened(int duration) {
+		if (isFinishing())
+			return;
+
+		opened = true;
+		seekBar.setMax(duration);
+		updateSpeed();
+		if (resumed)
+			setPlaying(playing);
+	}
+
+	@Override
+	protected void onResume() {
+		super.onResume();
+		resumed = true;
+		if (opened && playing)
+			setPlaying(true);
+	}
+
+	@Override
+	protected void onPause() {
+		super.onPause();
+		resumed = false;
+		ticking = false;
+		playbackHandler.removeCallbacks(startTicking);
+		playbackHandler.removeCallbacks(tick);
+	}
+
+	@Override
+	protected void onDestroy() {
+		super.onDestroy();
+		ticking = false;
+		playbackHandler.removeCallbacksAndMessages(null);
+		playbackHandler.post(new Runnable() {
+			@Override
+			public void run() {
+				if (player != null) {
+					try {
+						player.close();
+					} catch (IOException e) {
+						Log.e(TAG, "Could not close session recording", e);
+					}
+				}
+				Looper.myLooper().quit();
+			}
+		});
+	}
+
+	private void setPlaying(boolean playing) {
+		this.playing = playing;
+		ticking = playing;
+		playbackHandler.removeCallbacks(startTicking);
+		playbackHandler.removeCallbacks(tick);
+		if (playing)
+			playbackHandler.post(startTicking);
+		playButton.setText(playing ? R.string.playback_pause : R.string.playback_play);
+	}
+
+	private void updateSpeed() {
+		final float speed = SPEEDS[speedIndex];
+		if (opened) {
+			playbackHandler.post(new Runnable() {
+				@Override
+				public void run() {
+					player.setSpeed(speed);
+				}
+			});
+		}
+		speedButton.setText(String.format(Locale.getDefault(), "%.0f\u00d7", speed));
+	}
+
+	/**
+	 * Show the player's position on the main thread. Called on the playback
+	 * thread.
+	 * @param stop whether playback has ended or failed
+	 */
+	private void postProgress(final boolean stop) {
+		final int time = player.getTime();
+		final boolean done = player.isFinished();
+		handler.post(new Runnable() {
+			@Override
+			public void run() {
+				updateProgress(time, done);
+				if (stop && playing)
+					setPlaying(false);
+			}
+		});
+	}
+
+	private void updateProgress(int time, boolean done) {
+		finished = done;
+		seekBar.setProgress(time);
+		int seconds = time / 1000;
+		timeView.setText(String.format(Locale.getDefault(), "%d:%02d:%02d",
+				seconds / 3600, (seconds / 60) % 60, seconds % 60));
+	}
+}
@@ -18,36 +18,34 @@
 package org.connectbot;
 
 import java.util.List;
+import java.util.Locale;
 import java.util.regex.Matcher;
 import java.util.regex.Pattern;
 
 import org.connectbot.bean.SelectionArea;
 import org.connectbot.service.FontSizeChangedListener;
 import org.connectbot.service.TerminalBridge;
-import org.connectbot.service.TerminalKeyListener;
+import org.connectbot.util.CursorRenderer;
 import org.connectbot.util.PreferenceConstants;
 import org.connectbot.util.TerminalTextViewOverlay;
 import org.connectbot.util.TerminalViewPager;
 
 import android.app.Activity;
+import android.content.ActivityNotFoundException;
 import android.content.ContentResolver;
 import android.content.Context;
+import android.content.DialogInterface;
 import android.content.Intent;
 import android.content.SharedPreferences;
 import android.content.pm.ResolveInfo;
 import android.database.Cursor;
-import android.graphics.Bitmap;
 import android.graphics.Canvas;
-import android.graphics.ColorMatrix;
-import android.graphics.ColorMatrixColorFilter;
-import android.graphics.Matrix;
 import android.graphics.Paint;
-import android.graphics.Path;
-import android.graphics.RectF;
 import android.net.Uri;
 import android.os.AsyncTask;
 import android.preference.PreferenceManager;
 import android.text.ClipboardManager;
+import android.util.Log;
 import android.view.GestureDetector;
 import android.view.KeyEvent;
 import android.view.MotionEvent;
@@ -72,6 +70,11 @@ import de.mud.terminal.vt320;
  * @author jsharkey
  */
 public class TerminalView extends FrameLayout implements FontSizeChangedListener {
+	private static final String TAG = "CB.TerminalView";
+
+	/** Schemes of hyperlinks that may be opened; any other link is refused. */
+	private static final String[] LINK_SCHEMES = { "http", "https", "mailto" };
+
 	private final Context context;
 	public final TerminalBridge bridge;
 
@@ -85,19 +88,7 @@ public class TerminalView extends FrameLayout implements FontSizeChangedListener
 	private final ClipboardManager clipboard;
 
 	private final Paint paint;
-	private final Paint cursorPaint;
-	private final Paint cursorStrokePaint;
-	private final Paint cursorInversionPaint;
-	private final Paint cursorMetaInversionPaint;
-
-	// Cursor paints to distinguish modes
-	private final Path ctrlCursor;
-	private final Path altCursor;
-	private final Path shiftCursor;
-	private final RectF tempSrc;
-	private final RectF tempDst;
-	private final Matrix scaleMatrix;
-	private static final Matrix.ScaleToFit scaleType = Matrix.ScaleToFit.FILL;
+	private final CursorRenderer cursorRenderer;
 
 	private Toast notification = null;
 	private String lastNotification = null;
@@ -112,8 +103,6 @@ public class TerminalView extends FrameLayout implements FontSizeChangedListener
 	private Matcher mCodeMatcher = null;
 	private AccessibilityEventSender mEventSender = null;
 
-	private final char[] singleDeadKey = new char[1];
-
 	private static final String BACKSPACE_CODE = "\\x08\\x1b\\[K";
 	private static final String CONTROL_CODE_PATTERN = "\\x1b\\[K[^m]+[m|:]";
 
@@ -143,57 +132,7 @@ public class TerminalView extends FrameLayout implements FontSizeChangedListener
 
 		paint = new Paint();
 
-		cursorPaint = new Paint();
-		cursorPaint.setColor(bridge.color[bridge.defaultFg]);
-		cursorPaint.setAntiAlias(true);
-
-		cursorInversionPaint = new Paint();
-		cursorInversionPaint.setColorFilter(new ColorMatrixColorFilter(new ColorMatrix(new float[] {
-				-1, 0, 0, 0, 255,
-				0, -1, 0, 0, 255,
-				0, 0, -1, 0, 255,
-				0, 0, 0, 1, 0
-		})));
-		cursorInversionPaint.setAntiAlias(true);
-
-		cursorMetaInversionPaint = new Paint();
-		cursorMetaInversionPaint.setColorFilter(
-				new ColorMatrixColorFilter(new ColorMatrix(new float[] {
-						-1f, 0, 0, 0, 255,
-						0, -1f, 0, 0, 255,
-						0, 0, -1f, 0, 255,
-						0, 0, 0, 0.5f, 0
-				})));
-		cursorMetaInversionPaint.setAntiAlias(true);
-
-		cursorStrokePaint = new Paint(cursorInversionPaint);
-		cursorStrokePaint.setStrokeWidth(0.1f);
-		cursorStrokePaint.setStyle(Paint.Style.STROKE);
-
-		/*
-		 * Set up our cursor indicators on a 1x1 Path object which we can later
-		 * transform to our character width and height
-		 */
-		// TODO make this into a resource somehow
-		shiftCursor = new Path();
-		shiftCursor.lineTo(0.5f, 0.33f);
-		shiftCursor.lineTo(1.0f, 0.0f);
-
-		altCursor = new Path();
-		altCursor.moveTo(0.0f, 1.0f);
-		altCursor.lineTo(0.5f, 0.66f);
-		altCursor.lineTo(1.0f, 1.0f);
-
-		ctrlCursor = new Path();
-		ctrlCursor.moveTo(0.0f, 0.25f);
-		ctrlCursor.lineTo(1.0f, 0.5f);
-		ctrlCursor.lineTo(0.0f, 0.75f);
-
-		// For creating the transform when the terminal resizes
-		tempSrc = new RectF();
-		tempSrc.set(0.0f, 0.0f, 1.0f, 1.0f);
-		tempDst = new RectF();
-		scaleMatrix = new Matrix();
+		cursorRenderer = new CursorRenderer(bridge.color[bridge.defaultFg]);
 
 		// connect our view up to the bridge
 		setOnKeyListener(bridge.getKeyHandler());
@@ -253,6 +192,8 @@ public class TerminalView extends FrameLayout implements FontSizeChangedListener
 					} else if (moved != 0) {
 						int base = bridge.buffer.getWindowBase();
 						bridge.buffer.setWindowBase(base + moved);
+						if (bridge.buffer.getWindowBase() == 0)
+							bridge.requestHistory();
 						totalY = 0;
 						return false;
 					}
@@ -263,15 +204,100 @@ public class TerminalView extends FrameLayout implements FontSizeChangedListener
 
 			@Override
 			public boolean onSingleTapConfirmed(MotionEvent e) {
+				String link = bridge.getLinkAt((int) (e.getX() / bridge.charWidth), getRowAt(e));
+				if (link != null) {
+					openLink(link);
+					return true;
+				}
+
 				viewPager.performClick();
 				return super.onSingleTapConfirmed(e);
 			}
+
+			/**
+			 * Copy the output of the command under the tap, when the shell
+			 * marks where commands and their output are.
+			 */
+			@Override
+			public boolean onDoubleTap(MotionEvent e) {
+				if (!bridge.hasPromptMarks())
+					return false;
+
+				String output = bridge.getCommandOutputAt(getRowAt(e));
+				if (output == null)
+					return false;
+
+				clipboard.setText(output);
+				Toast.makeText(context,
+						context.getResources().getQuantityString(R.plurals.console_copy_done,
+								output.length(), output.length()),
+						Toast.LENGTH_LONG).show();
+				return true;
+			}
 		});
 
 		// Enable accessibility features if a screen reader is active.
 		new AccessibilityStateTester().execute((Void) null);
 	}
 
+	/**
+	 * @return the screen row under {@code e}
+	 */
+	private int getRowAt(MotionEvent e) {
+		int scrollOffset;
+		synchronized (bridge.getFrameLock()) {
+			scrollOffset = bridge.getFrameScrollOffset();
+		}
+		// the frame is drawn shifted up by the scroll offset
+		return (int) ((e.getY() + scrollOffset) / bridge.charHeight);
+	}
+
+	/**
+	 * Open a hyperlink the remote host attached to some text, after showing
+	 * the real target: the text itself can say anything.
+	 */
+	private void openLink(final String link) {
+		final Uri uri = Uri.parse(link);
+		if (!isLinkAllowed(uri)) {
+			Log.w(TAG, "Refusing to open hyperlink " + link);
+			Toast.makeText(context, context.getString(R.string.console_link_refused, link),
+					Toast.LENGTH_LONG).show();
+			return;
+		}
+
+		new androidx.appcompat.app.AlertDialog.Builder(context, R.style.AlertDialogTheme)
+				.setTitle(R.string.console_open_link_title)
+				.setMessage(link)
+				.setPositiveButton(R.string.button_open, new DialogInterface.OnClickListener() {
+					@Override
+					public void onClick(DialogInterface dialog, int which) {
+						try {
+							context.startActivity(new Intent(Intent.ACTION_VIEW, uri));
+						} catch (ActivityNotFoundException e) {
+							Log.e(TAG, "No activity to open hyperlink " + link, e);
+						}
+					}
+				})
+				.setNegativeButton(android.R.string.cancel, null)
+				.create().show();
+	}
+
+	/**
+	 * @return true if {@code uri} uses one of the {@link #LINK_SCHEMES}
+	 */
+	static boolean isLinkAllowed(Uri uri) {
+		String scheme = uri.getScheme();
+		if (scheme == null)
+			return false;
+
+		scheme = scheme.toLowerCase(Locale.US);
+		for (String allowed : LINK_SCHEMES) {
+			if (allowed.equals(scheme))
+				return true;
+		}
+		return false;
+	}
+
 	private void setLayerTypeToSoftware() {
 		setLayerType(View.LAYER_TYPE_SOFTWARE, null);
 	}
@@ -392,102 +418,67 @@ public class TerminalView extends FrameLayout implements FontSizeChangedListener
 	}
 
 	private void scaleCursors() {
-		// Create a scale matrix to scale our 1x1 representation of the cursor
-		tempDst.set(0.0f, 0.0f, bridge.charWidth, bridge.charHeight);
-		scaleMatrix.setRectToRect(tempSrc, tempDst, scaleType);
+		cursorRenderer.setCharSize(bridge.charWidth, bridge.charHeight);
 	}
 
 	@Override
 	public void onDraw(Canvas canvas) {
-		if (bridge.bitmap != null) {
-			// draw the bitmap
-			bridge.onDraw();
-
-			// draw the bridge bitmap if it exists
-			canvas.drawBitmap(bridge.bitmap, 0, 0, paint);
-
-			// also draw cursor if visible
-			if (bridge.buffer.isCursorVisible()) {
-				int cursorColumn = bridge.buffer.getCursorColumn();
-				final int cursorRow = bridge.buffer.getCursorRow();
-
-				final int columns = bridge.buffer.getColumns();
-
-				if (cursorColumn == columns)
-					cursorColumn = columns - 1;
-
-				if (cursorColumn < 0 || cursorRow < 0)
-					return;
-
-				long currentAttribute = bridge.buffer.getAttributes(
-						cursorColumn, cursorRow);
-				boolean onWideCharacter = (currentAttribute & VDUBuffer.FULLWIDTH) != 0;
-
-				int x = cursorColumn * bridge.charWidth;
-				int y = (bridge.buffer.getCursorRow()
-						+ bridge.buffer.screenBase - bridge.buffer.windowBase)
-						* bridge.charHeight;
-
-				// Save the current clip and translation
-				canvas.save();
-
-				canvas.translate(x, y);
-				canvas.clipRect(0, 0,
-						bridge.charWidth * (onWideCharacter ? 2 : 1),
-						bridge.charHeight);
-
-				int metaState = bridge.getKeyHandler().getMetaState();
-				if (y + bridge.charHeight < bridge.bitmap.getHeight()) {
-					Bitmap underCursor = Bitmap.createBitmap(bridge.bitmap, x, y,
-							bridge.charWidth * (onWideCharacter ? 2 : 1), bridge.charHeight);
-					if (metaState == 0)
-						canvas.drawBitmap(underCursor, 0, 0, cursorInversionPaint);
-					else
-						canvas.drawBitmap(underCursor, 0, 0, cursorMetaInversionPaint);
-				} else {
-					canvas.drawPaint(cursorPaint);
-				}
-				final int deadKey = bridge.getKeyHandler().getDeadKey();
-				if (deadKey != 0) {
-					singleDeadKey[0] = (char) deadKey;
-					canvas.drawText(singleDeadKey, 0, 1, 0, 0, cursorStrokePaint);
-				}
+		long start = System.nanoTime();
 
-				// Make sure we scale our decorations to the correct size.
-				canvas.concat(scaleMatrix);
+		// keep the render thread from swapping the frame while we show it
+		synchronized (bridge.getFrameLock()) {
+			if (bridge.bitmap == null)
+				return;
 
-				if ((metaState & TerminalKeyListener.OUR_SHIFT_ON) != 0)
-					canvas.drawPath(shiftCursor, cursorStrokePaint);
-				else if ((metaState & TerminalKeyListener.OUR_SHIFT_LOCK) != 0)
-					canvas.drawPath(shiftCursor, cursorInversionPaint);
+			drawFrame(canvas);
+		}
 
-				if ((metaState & TerminalKeyListener.OUR_ALT_ON) != 0)
-					canvas.drawPath(altCursor, cursorStrokePaint);
-				else if ((metaState & TerminalKeyListener.OUR_ALT_LOCK) != 0)
-					canvas.drawPath(altCursor, cursorInversionPaint);
+		bridge.recordViewDraw(System.nanoTime() - start);
+	}
 
-				if ((metaState & TerminalKeyListener.OUR_CTRL_ON) != 0)
-					canvas.drawPath(ctrlCursor, cursorStrokePaint);
-				else if ((metaState & TerminalKeyListener.OUR_CTRL_LOCK) != 0)
-					canvas.drawPath(ctrlCursor, cursorInversionPaint);
+	/**
+	 * Blit the latest frame the render thread finished and put the cursor and
+	 * selection on top. Must be called with the bridge's frame lock held.
+	 */
+	private void drawFrame(Canvas canvas) {
+		canvas.drawBitmap(bridge.bitmap, 0, 0, paint);
 
-				// Restore previous clip region
-				canvas.restore();
-			}
+		// also draw cursor if visible
+		if (bridge.buffer.isCursorVisible()) {
+			int cursorColumn = bridge.buffer.getCursorColumn();
+			final int cursorRow = bridge.buffer.getCursorRow();
 
-			// draw any highlighted area
-			if (terminalTextViewOverlay == null && bridge.isSelectingForCopy()) {
-				SelectionArea area = bridge.getSelectionArea();
-				canvas.save();
-				canvas.clipRect(
-					area.getLeft() * bridge.charWidth,
-					area.getTop() * bridge.charHeight,
-					(area.getRight() + 1) * bridge.charWidth,
-					(area.getBottom() + 1) * bridge.charHeight
-				);
-				canvas.drawPaint(cursorPaint);
-				canvas.restore();
-			}
+			final int columns = bridge.buffer.getColumns();
+
+			if (cursorColumn == columns)
+				cursorColumn = columns - 1;
+
+			if (cursorColumn < 0 || cursorRow < 0)
+				return;
+
+			long currentAttribute = bridge.buffer.getAttributes(
+					cursorColumn, cursorRow);
+			boolean onWideCharacter = (currentAttribute & VDUBuffer.FULLWIDTH) != 0;
+
+			int x = cursorColumn * bridge.charWidth;
+			int y = (bridge.buffer.getCursorRow()
+					+ bridge.buffer.screenBase - bridge.buffer.windowBase)
+					* bridge.charHeight - bridge.getFrameScrollOffset();
+
+			cursorRenderer.draw(canvas, bridge.bitmap, x, y,
+					bridge.charWidth * (onWideCharacter ? 2 : 1), bridge.charHeight,
+					bridge.getKeyHandler().getMetaState(), bridge.getKeyHandler().getDeadKey());
+		}
+
+		// draw any highlighted area
+		if (terminalTextViewOverlay == null && bridge.isSelectingForCopy()) {
+			SelectionArea area = bridge.getSelectionArea();
+			cursorRenderer.drawSelection(canvas,
+				area.getLeft() * bridge.charWidth,
+				area.getTop() * bridge.charHeight,
+				(area.getRight() + 1) * bridge.charWidth,
+				(area.getBottom() + 1) * bridge.charHeight
+			);
 		}
 	}
 
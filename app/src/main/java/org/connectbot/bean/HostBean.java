@@ -56,6 +56,7 @@ public class HostBean extends AbstractBean {
 	private String encoding = HostDatabase.ENCODING_DEFAULT;
 	private boolean stayConnected = false;
 	private boolean quickDisconnect = false;
+	private long jumpHostId = HostDatabase.JUMPHOSTID_NONE;
 
 	public HostBean() {
 
@@ -198,6 +199,18 @@ public class HostBean extends AbstractBean {
 		return quickDisconnect;
 	}
 
+	/**
+	 * @param jumpHostId ID of the host to tunnel this connection through, or
+	 *        {@link HostDatabase#JUMPHOSTID_NONE} to connect directly
+	 */
+	public void setJumpHostId(long jumpHostId) {
+		this.jumpHostId = jumpHostId;
+	}
+
+	public long getJumpHostId() {
+		return jumpHostId;
+	}
+
 	@SuppressLint("DefaultLocale")
 	public String getDescription() {
 		String description = String.format("%s@%s", username, hostname);
@@ -230,6 +243,7 @@ public class HostBean extends AbstractBean {
 		values.put(HostDatabase.FIELD_HOST_ENCODING, encoding);
 		values.put(HostDatabase.FIELD_HOST_STAYCONNECTED, Boolean.toString(stayConnected));
 		values.put(HostDatabase.FIELD_HOST_QUICKDISCONNECT, Boolean.toString(quickDisconnect));
+		values.put(HostDatabase.FIELD_HOST_JUMPHOSTID, jumpHostId);
 
 		return values;
 	}
@@ -254,6 +268,7 @@ public class HostBean extends AbstractBean {
 		host.setEncoding(values.getAsString(HostDatabase.FIELD_HOST_ENCODING));
 		host.setStayConnected(values.getAsBoolean(HostDatabase.FIELD_HOST_STAYCONNECTED));
 		host.setQuickDisconnect(values.getAsBoolean(HostDatabase.FIELD_HOST_QUICKDISCONNECT));
+		host.setJumpHostId(values.getAsLong(HostDatabase.FIELD_HOST_JUMPHOSTID));
 		return host;
 	}
 
@@ -155,6 +155,12 @@ public class SelectionArea {
 				// only copy printable chars
 				char c = vb.getChar(x, y);
 
+				if (VDUBuffer.isClusterHandle(c)) {
+					buffer.append(vb.getCluster(c));
+					lastNonSpace = buffer.length() - 1;
+					continue;
+				}
+
 				if (!Character.isDefined(c) ||
 						(Character.isISOControl(c) && c != '\t'))
 					c = ' ';
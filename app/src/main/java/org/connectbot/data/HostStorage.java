@@ -60,6 +60,13 @@ public interface HostStorage {
 	 */
 	List<HostBean> getHosts(boolean sortedByColor);
 
+	/**
+	 * Returns the hosts connected to since {@code since}, most recently
+	 * connected first.
+	 * @param since time in seconds since the epoch, as stored by {@link #touchHost(HostBean)}
+	 */
+	List<HostBean> getRecentHosts(long since);
+
 	/**
 	 * Updates the last connected time for {@code host}.
 	 */
@@ -17,14 +17,18 @@
 
 package org.connectbot.service;
 
+import java.io.IOException;
+
 import org.connectbot.util.HostDatabase;
 import org.connectbot.util.PreferenceConstants;
 import org.connectbot.util.PubkeyDatabase;
 
 import android.app.backup.BackupAgentHelper;
+import android.app.backup.BackupDataOutput;
 import android.app.backup.FileBackupHelper;
 import android.app.backup.SharedPreferencesBackupHelper;
 import android.content.SharedPreferences;
+import android.os.ParcelFileDescriptor;
 import android.preference.PreferenceManager;
 import android.util.Log;
 
@@ -51,4 +55,14 @@ public class BackupAgent extends BackupAgentHelper {
 			addHelper(PubkeyDatabase.DB_NAME, pubkeys);
 		}
 	}
+
+	@Override
+	public void onBackup(ParcelFileDescriptor oldState, BackupDataOutput data,
+			ParcelFileDescriptor newState) throws IOException {
+		// The helpers copy only the database files, not their write-ahead logs.
+		HostDatabase.get(this).checkpoint();
+		PubkeyDatabase.get(this).checkpoint();
+
+		super.onBackup(oldState, data, newState);
+	}
 }
@@ -0,0 +1,196 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.io.IOException;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.CopyOnWriteArrayList;
+import java.util.concurrent.LinkedBlockingQueue;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import android.util.Log;
+
+/**
+ * A set of {@link TerminalBridge}s that receive the same user input. Input is
+ * encoded once by the bridge it was typed into and the resulting bytes are
+ * handed unchanged to every other member. Each member has its own writer
+ * thread and queue, so a slow host only delays itself; a member that falls
+ * too far behind is dropped from the group rather than stalling the others.
+ *
+ * @author Kenny Root
+ */
+public class BroadcastGroup {
+	private static final String TAG = "CB.BroadcastGroup";
+
+	/** Most input a single member may have queued before it is dropped. */
+	static final int MAX_PENDING_BYTES = 64 * 1024;
+
+	private static final byte[][] SINGLE_BYTES = new byte[256][];
+
+	static {
+		for (int i = 0; i < SINGLE_BYTES.length; i++)
+			SINGLE_BYTES[i] = new byte[] {(byte) i};
+	}
+
+	private final List<Member> members = new CopyOnWriteArrayList<>();
+
+	/**
+	 * @return a shared, never-modified one-byte array for {@code b}
+	 */
+	static byte[] singleByte(int b) {
+		return SINGLE_BYTES[b & 0xff];
+	}
+
+	/**
+	 * Add {@code bridge} to this group.
+	 * @return false if it was already a member
+	 */
+	public synchronized boolean add(TerminalBridge bridge) {
+		if (findMember(bridge) != null)
+			return false;
+
+		Member member = new Member(bridge);
+		members.add(member);
+		bridge.setBroadcastGroup(this);
+		member.start();
+		return true;
+	}
+
+	/**
+	 * Remove {@code bridge} from this group. Input already queued for it is
+	 * discarded.
+	 * @return false if it was not a member
+	 */
+	public synchronized boolean remove(TerminalBridge bridge) {
+		Member member = findMember(bridge);
+		if (member == null)
+			return false;
+
+		members.remove(member);
+		bridge.setBroadcastGroup(null);
+		member.stop();
+		return true;
+	}
+
+	public synchronized void clear() {
+		for (Member member : members) {
+			member.bridge.setBroadcastGroup(null);
+			member.stop();
+		}
+		members.clear();
+	}
+
+	public boolean contains(TerminalBridge bridge) {
+		return findMember(bridge) != null;
+	}
+
+	public List<TerminalBridge> getBridges() {
+		List<TerminalBridge> bridges = new ArrayList<>(members.size());
+		for (Member member : members)
+			bridges.add(member.bridge);
+		return bridges;
+	}
+
+	public int size() {
+		return members.size();
+	}
+
+	/**
+	 * Queue {@code data}, already written to {@code source}'s own host, for
+	 * every other member. The array is shared between members, so the caller
+	 * must not modify it afterwards. Members that have disconnected since they
+	 * joined are dropped here.
+	 */
+	void send(TerminalBridge source, byte[] data) {
+		for (Member member : members) {
+			if (member.bridge == source)
+				continue;
+
+			if (member.bridge.isDisconnected()) {
+				remove(member.bridge);
+				continue;
+			}
+
+			if (!member.offer(data)) {
+				Log.w(TAG, String.format("Dropping '%s' from broadcast; it is %d bytes behind",
+						member.bridge.host.getNickname(), member.pendingBytes.get()));
+				remove(member.bridge);
+			}
+		}
+	}
+
+	private Member findMember(TerminalBridge bridge) {
+		for (Member member : members) {
+			if (member.bridge == bridge)
+				return member;
+		}
+		return null;
+	}
+
+	private static class Member implements Runnable {
+		final TerminalBridge bridge;
+		final LinkedBlockingQueue<byte[]> queue = new LinkedBlockingQueue<>();
+		final AtomicInteger pendingBytes = new AtomicInteger();
+		private Thread writer;
+		private volatile boolean running;
+
+		Member(TerminalBridge bridge) {
+			this.bridge = bridge;
+		}
+
+		void start() {
+			running = true;
+			writer = new Thread(this);
+			writer.setName("BroadcastWriter");
+			writer.setDaemon(true);
+			writer.start();
+		}
+
+		void stop() {
+			running = false;
+			writer.interrupt();
+			queue.clear();
+		}
+
+		boolean offer(byte[] data) {
+			if (pendingBytes.addAndGet(data.length) > MAX_PENDING_BYTES) {
+				pendingBytes.addAndGet(-data.length);
+				return false;
+			}
+			queue.add(data);
+			return true;
+		}
+
+		@Override
+		public void run() {
+			try {
+				while (running) {
+					byte[] data = queue.take();
+					try {
+						bridge.writeBroadcastInput(data);
+					} catch (IOException e) {
+						Log.e(TAG, "Problem writing broadcast input", e);
+					}
+					pendingBytes.addAndGet(-data.length);
+				}
+			} catch (InterruptedException e) {
+				// stopped
+			}
+		}
+	}
+}
@@ -0,0 +1,39 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.io.OutputStream;
+
+/**
+ * Supplies the output sinks for each host in a batch started with
+ * {@link TerminalManager#execOnBridges}.
+ *
+ * @author Kenny Root
+ */
+public interface ExecOutputProvider {
+	/**
+	 * @param bridge host the command is running on
+	 * @return sink for the command's standard output on that host
+	 */
+	OutputStream getStdout(TerminalBridge bridge);
+
+	/**
+	 * @param bridge host the command is running on
+	 * @return sink for the command's standard error on that host
+	 */
+	OutputStream getStderr(TerminalBridge bridge);
+}
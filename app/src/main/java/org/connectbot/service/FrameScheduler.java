@@ -0,0 +1,261 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.ArrayList;
+import java.util.Iterator;
+import java.util.LinkedHashSet;
+import java.util.List;
+import java.util.concurrent.TimeUnit;
+
+import android.annotation.TargetApi;
+import android.os.Build;
+import android.os.Handler;
+import android.os.HandlerThread;
+import android.os.Looper;
+import android.os.Process;
+import android.util.Log;
+import android.view.Choreographer;
+
+/**
+ * One render loop for every visible terminal.
+ * <p>
+ * Bridges report damage with {@link #requestFrame}, from any thread. Once
+ * per display frame the scheduler repaints the damaged bridges into their
+ * back bitmaps on a dedicated render thread, oldest damage first, and the
+ * bridges swap them to the front and invalidate their views. The UI thread
+ * only has to blit the finished frame. When the repaints of one frame have
+ * used up {@link #FRAME_BUDGET_NANOS}, the remaining bridges wait for the
+ * next frame, so several busy terminals on screen together cannot fall
+ * behind the display. At least one bridge is painted per frame.
+ * <p>
+ * Frame times of the render thread and of the views drawing on the UI
+ * thread are collected in histograms and logged every
+ * {@link #LOG_INTERVAL_FRAMES} rendered frames.
+ *
+ * @author Kenny Root
+ */
+public class FrameScheduler {
+	/** Time the repaints of one frame may take, leaving room for the rest of the frame. */
+	static final long FRAME_BUDGET_NANOS = TimeUnit.MILLISECONDS.toNanos(8);
+
+	private static final long FALLBACK_FRAME_MILLIS = 16;
+
+	static final int LOG_INTERVAL_FRAMES = 1000;
+
+	private static final String TAG = "CB.FrameScheduler";
+
+	/**
+	 * Something the scheduler can paint; implemented by {@link TerminalBridge}.
+	 */
+	interface Target {
+		/**
+		 * Paint pending damage and invalidate the view. Called on the render
+		 * thread.
+		 */
+		void renderFrame();
+	}
+
+	/**
+	 * Where frame time budgets are measured from; replaced in tests.
+	 */
+	interface Clock {
+		long nanoTime();
+	}
+
+	private static final Clock SYSTEM_CLOCK = new Clock() {
+		@Override
+		public long nanoTime() {
+			return System.nanoTime();
+		}
+	};
+
+	private final Clock clock;
+
+	private final Object lock = new Object();
+
+	/** Damaged targets in the order they should be served. */
+	private final LinkedHashSet<Target> damaged = new LinkedHashSet<>();
+
+	private final List<Target> frame = new ArrayList<>();
+
+	private boolean frameScheduled = false;
+
+	private final HandlerThread thread;
+
+	private final Handler handler;
+
+	private final FrameTimeHistogram renderTimes = new FrameTimeHistogram("render");
+	private final FrameTimeHistogram viewTimes = new FrameTimeHistogram("view");
+
+	private final Runnable frameRunnable = new Runnable() {
+		@Override
+		public void run() {
+			doFrame();
+		}
+	};
+
+	private Object frameCallback;
+
+	private long lastFrameNanos;
+	private int deferredTargets;
+
+	public FrameScheduler() {
+		this(SYSTEM_CLOCK);
+	}
+
+	FrameScheduler(Clock clock) {
+		this.clock = clock;
+		thread = new HandlerThread("Render", Process.THREAD_PRIORITY_DISPLAY);
+		thread.start();
+		handler = new Handler(thread.getLooper());
+	}
+
+	public void requestFrame(Target target) {
+		synchronized (lock) {
+			damaged.add(target);
+			scheduleLocked();
+		}
+	}
+
+	/**
+	 * Forget any pending damage for {@code target}, e.g. when its view goes away.
+	 */
+	public void cancel(Target target) {
+		synchronized (lock) {
+			damaged.remove(target);
+		}
+	}
+
+	/**
+	 * @return how long the repaints of the last frame took, in nanoseconds
+	 */
+	public long getLastFrameNanos() {
+		return lastFrameNanos;
+	}
+
+	/**
+	 * @return how many damaged targets had to wait for a later frame last time
+	 */
+	public int getDeferredTargets() {
+		return deferredTargets;
+	}
+
+	/**
+	 * Note how long a view took to draw the frame it was given. Called on
+	 * the main thread.
+	 */
+	public void recordViewDraw(long nanos) {
+		viewTimes.record(nanos);
+	}
+
+	public FrameTimeHistogram getRenderTimes() {
+		return renderTimes;
+	}
+
+	public FrameTimeHistogram getViewTimes() {
+		return viewTimes;
+	}
+
+	/**
+	 * Stop the render thread. Pending damage is dropped.
+	 */
+	public void quit() {
+		synchronized (lock) {
+			damaged.clear();
+		}
+		thread.quit();
+	}
+
+	private void scheduleLocked() {
+		if (frameScheduled)
+			return;
+		frameScheduled = true;
+
+		if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.JELLY_BEAN) {
+			if (Looper.myLooper() == handler.getLooper())
+				postFrameCallback();
+			else
+				handler.post(new Runnable() {
+					@Override
+					public void run() {
+						postFrameCallback();
+					}
+				});
+		} else {
+			handler.postDelayed(frameRunnable, FALLBACK_FRAME_MILLIS);
+		}
+	}
+
+	@TargetApi(Build.VERSION_CODES.JELLY_BEAN)
+	private void postFrameCallback() {
+		if (frameCallback == null) {
+			frameCallback = new Choreographer.FrameCallback() {
+				@Override
+				public void doFrame(long frameTimeNanos) {
+					FrameScheduler.this.doFrame();
+				}
+			};
+		}
+		Choreographer.getInstance().postFrameCallback((Choreographer.FrameCallback) frameCallback);
+	}
+
+	/**
+	 * Called on the render thread once per display frame while there is damage.
+	 */
+	void doFrame() {
+		synchronized (lock) {
+			frameScheduled = false;
+			frame.addAll(damaged);
+			damaged.clear();
+		}
+
+		long start = clock.nanoTime();
+		int served = 0;
+		Iterator<Target> it = frame.iterator();
+		while (it.hasNext()) {
+			if (served > 0 && clock.nanoTime() - start >= FRAME_BUDGET_NANOS)
+				break;
+
+			Target target = it.next();
+			it.remove();
+			target.renderFrame();
+			served++;
+		}
+		lastFrameNanos = clock.nanoTime() - start;
+		deferredTargets = frame.size();
+
+		renderTimes.record(lastFrameNanos);
+		if (renderTimes.getCount() >= LOG_INTERVAL_FRAMES) {
+			Log.d(TAG, renderTimes.toString());
+			Log.d(TAG, viewTimes.toString());
+			renderTimes.reset();
+			viewTimes.reset();
+		}
+
+		if (!frame.isEmpty()) {
+			synchronized (lock) {
+				// Leftovers go first next time, ahead of newer damage.
+				frame.addAll(damaged);
+				damaged.clear();
+				damaged.addAll(frame);
+				scheduleLocked();
+			}
+			frame.clear();
+		}
+	}
+}
@@ -0,0 +1,91 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.Locale;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Counts how long frames take, in buckets that double in size up to a few
+ * display frames. Cheap enough to record every frame from any thread.
+ *
+ * @author Kenny Root
+ */
+public class FrameTimeHistogram {
+	/** Upper bounds of the buckets in milliseconds; a last, open bucket follows. */
+	static final int[] BOUNDS_MILLIS = {1, 2, 4, 8, 16, 33, 66};
+
+	private static final long[] BOUNDS_NANOS = new long[BOUNDS_MILLIS.length];
+	static {
+		for (int i = 0; i < BOUNDS_MILLIS.length; i++)
+			BOUNDS_NANOS[i] = TimeUnit.MILLISECONDS.toNanos(BOUNDS_MILLIS[i]);
+	}
+
+	private final String name;
+
+	private final long[] counts = new long[BOUNDS_MILLIS.length + 1];
+	private long count;
+	private long maxNanos;
+
+	public FrameTimeHistogram(String name) {
+		this.name = name;
+	}
+
+	public synchronized void record(long nanos) {
+		int bucket = 0;
+		while (bucket < BOUNDS_NANOS.length && nanos >= BOUNDS_NANOS[bucket])
+			bucket++;
+		counts[bucket]++;
+		count++;
+		if (nanos > maxNanos)
+			maxNanos = nanos;
+	}
+
+	/**
+	 * @return number of frames recorded since the last {@link #reset()}
+	 */
+	public synchronized long getCount() {
+		return count;
+	}
+
+	/**
+	 * @param bucket index into {@link #BOUNDS_MILLIS}, or its length for the
+	 *        frames slower than all bounds
+	 * @return number of frames that fell into that bucket
+	 */
+	public synchronized long getBucketCount(int bucket) {
+		return counts[bucket];
+	}
+
+	public synchronized void reset() {
+		for (int i = 0; i < counts.length; i++)
+			counts[i] = 0;
+		count = 0;
+		maxNanos = 0;
+	}
+
+	@Override
+	public synchronized String toString() {
+		StringBuilder sb = new StringBuilder(name).append(':');
+		for (int i = 0; i < BOUNDS_MILLIS.length; i++)
+			sb.append(" <").append(BOUNDS_MILLIS[i]).append("ms ").append(counts[i]);
+		sb.append(" >=").append(BOUNDS_MILLIS[BOUNDS_MILLIS.length - 1]).append("ms ")
+				.append(counts[BOUNDS_MILLIS.length]);
+		sb.append(String.format(Locale.US, " (max %.1f ms)", maxNanos / 1e6));
+		return sb.toString();
+	}
+}
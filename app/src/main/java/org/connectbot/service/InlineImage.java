@@ -0,0 +1,283 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.HashMap;
+import java.util.Map;
+
+import org.connectbot.util.NativeImageDecoder;
+
+import android.graphics.Bitmap;
+import android.graphics.BitmapFactory;
+import android.util.Log;
+import de.mud.terminal.vt320;
+
+/**
+ * Receives one inline image from the terminal emulator, decodes it and puts
+ * it on the screen. Sixel data is decoded in native code as it arrives. For
+ * iTerm2's {@code OSC 1337 ; File=} only the base64 layer is decoded
+ * natively; the image file inside is handed to {@link BitmapFactory}, which
+ * reads every format the platform knows.
+ * <p>
+ * Sixel pixels map one to one onto screen pixels, which is what programs
+ * expect after asking for the size of the window in pixels. iTerm2 images
+ * are sized by their {@code width} and {@code height} arguments and, like
+ * sixels, shrunk to fit next to the cursor when they are too wide.
+ *
+ * @author Kenny Root
+ */
+class InlineImage implements vt320.ImageReceiver {
+	private static final String TAG = "CB.InlineImage";
+
+	/** Largest file accepted through {@code OSC 1337 ; File=}. */
+	private static final int MAX_FILE_BYTES = 16 * 1024 * 1024;
+
+	/** How many screens high a sixel image may be before it is clipped. */
+	private static final int MAX_SCREENS = 2;
+
+	/** Characters are passed to native code in runs of at least this many. */
+	private static final int BATCH_SIZE = 1024;
+
+	private final vt320 buffer;
+	private final InlineImageCache cache;
+	private final int format;
+	private final int charWidth;
+	private final int charHeight;
+	private final int maxWidth;
+	private final Map<String, String> arguments;
+
+	private NativeImageDecoder decoder;
+	private final char[] pending = new char[BATCH_SIZE];
+	private int pendingLength;
+
+	/**
+	 * @param format {@link vt320#IMAGE_SIXEL} or {@link vt320#IMAGE_FILE}
+	 * @param params what {@link vt320#beginImage} was given
+	 */
+	InlineImage(vt320 buffer, InlineImageCache cache, int format, String params,
+			int charWidth, int charHeight) {
+		this.buffer = buffer;
+		this.cache = cache;
+		this.format = format;
+		this.charWidth = charWidth;
+		this.charHeight = charHeight;
+
+		// images start at the cursor and must not run off the right edge
+		maxWidth = Math.max(buffer.width - buffer.getCursorColumn(), 1) * charWidth;
+
+		if (format == vt320.IMAGE_SIXEL) {
+			arguments = null;
+			int maxHeight = MAX_SCREENS * buffer.height * charHeight;
+			decoder = new NativeImageDecoder(NativeImageDecoder.FORMAT_SIXEL, maxWidth,
+					maxHeight, 0);
+		} else {
+			arguments = parseArguments(params);
+			// files not marked inline would be downloads, which we do not offer
+			if ("1".equals(arguments.get("inline")))
+				decoder = new NativeImageDecoder(NativeImageDecoder.FORMAT_BASE64, 0, 0,
+						MAX_FILE_BYTES);
+		}
+	}
+
+	@Override
+	public void append(char[] data, int offset, int length) {
+		if (decoder == null)
+			return;
+
+		if (pendingLength + length > pending.length)
+			flush();
+		if (length >= pending.length) {
+			feed(data, offset, length);
+		} else {
+			System.arraycopy(data, offset, pending, pendingLength, length);
+			pendingLength += length;
+		}
+	}
+
+	@Override
+	public void finish() {
+		if (decoder == null)
+			return;
+
+		flush();
+		try {
+			if (decoder != null) {
+				if (format == vt320.IMAGE_SIXEL)
+					placeSixel();
+				else
+					placeFile();
+			}
+		} catch (OutOfMemoryError e) {
+			Log.e(TAG, "Not enough memory for inline image", e);
+		} finally {
+			abort();
+		}
+	}
+
+	@Override
+	public void abort() {
+		if (decoder != null) {
+			decoder.release();
+			decoder = null;
+		}
+	}
+
+	private void flush() {
+		if (pendingLength > 0) {
+			feed(pending, 0, pendingLength);
+			pendingLength = 0;
+		}
+	}
+
+	private void feed(char[] data, int offset, int length) {
+		if (decoder != null && !decoder.feed(data, offset, length)) {
+			Log.w(TAG, "Inline image is larger than " + MAX_FILE_BYTES + " bytes; dropping it");
+			abort();
+		}
+	}
+
+	private void placeSixel() {
+		int width = decoder.getWidth();
+		int height = decoder.getHeight();
+		int[] pixels = decoder.getPixels();
+		if (pixels == null)
+			return;
+
+		Bitmap bitmap = Bitmap.createBitmap(pixels, width, height, Bitmap.Config.ARGB_8888);
+		place(bitmap, width, height);
+	}
+
+	private void placeFile() {
+		byte[] data = decoder.getBytes();
+		decoder.release();
+		decoder = null;
+		if (data == null || data.length == 0)
+			return;
+
+		BitmapFactory.Options options = new BitmapFactory.Options();
+		options.inJustDecodeBounds = true;
+		BitmapFactory.decodeByteArray(data, 0, data.length, options);
+		int imageWidth = options.outWidth;
+		int imageHeight = options.outHeight;
+		if (imageWidth <= 0 || imageHeight <= 0) {
+			Log.w(TAG, "Could not decode inline image " + arguments.get("name"));
+			return;
+		}
+
+		int[] size = computeSize(arguments, imageWidth, imageHeight, charWidth, charHeight,
+				buffer.width * charWidth, buffer.height * charHeight, maxWidth);
+
+		// no need to decode more pixels than end up on the screen
+		options.inJustDecodeBounds = false;
+		options.inSampleSize = 1;
+		while (imageWidth / (options.inSampleSize * 2) >= size[0]
+				&& imageHeight / (options.inSampleSize * 2) >= size[1])
+			options.inSampleSize *= 2;
+
+		Bitmap bitmap = BitmapFactory.decodeByteArray(data, 0, data.length, options);
+		if (bitmap == null) {
+			Log.w(TAG, "Could not decode inline image " + arguments.get("name"));
+			return;
+		}
+		place(bitmap, size[0], size[1]);
+	}
+
+	/**
+	 * Cache {@code bitmap} and fill the cells it covers when drawn
+	 * {@code width} by {@code height} screen pixels large.
+	 */
+	private void place(Bitmap bitmap, int width, int height) {
+		int columns = (width + charWidth - 1) / charWidth;
+		int rows = (height + charHeight - 1) / charHeight;
+		float cellWidth = (float) bitmap.getWidth() * charWidth / width;
+		float cellHeight = (float) bitmap.getHeight() * charHeight / height;
+
+		int id = cache.put(bitmap, cellWidth, cellHeight);
+		if (cache.hasWrapped())
+			buffer.clearImage(id);
+		buffer.placeImage(id, columns, rows);
+	}
+
+	/**
+	 * Split the arguments of {@code File=}, such as
+	 * {@code name=Zm9v;size=3;inline=1}, into keys and values.
+	 */
+	static Map<String, String> parseArguments(String params) {
+		Map<String, String> arguments = new HashMap<>();
+		for (String argument : params.split(";")) {
+			int equals = argument.indexOf('=');
+			if (equals > 0)
+				arguments.put(argument.substring(0, equals), argument.substring(equals + 1));
+		}
+		return arguments;
+	}
+
+	/**
+	 * Turn a {@code width} or {@code height} argument into pixels: a number
+	 * of cells, {@code Npx}, {@code N%} of the screen, or {@code auto}.
+	 * @return the size in pixels, or -1 for the image's own size
+	 */
+	static int parseDimension(String value, int cellSize, int screenSize) {
+		if (value == null || value.equals("auto"))
+			return -1;
+
+		try {
+			if (value.endsWith("px"))
+				return Integer.parseInt(value.substring(0, value.length() - 2));
+			else if (value.endsWith("%"))
+				return (int) ((long) screenSize
+						* Integer.parseInt(value.substring(0, value.length() - 1)) / 100);
+			else
+				return (int) Math.min((long) Integer.parseInt(value) * cellSize, Integer.MAX_VALUE);
+		} catch (NumberFormatException e) {
+			return -1;
+		}
+	}
+
+	/**
+	 * Work out how large an iTerm2 image is drawn, in screen pixels.
+	 * @return width and height, shrunk to at most {@code maxWidth} wide
+	 */
+	static int[] computeSize(Map<String, String> arguments, int imageWidth, int imageHeight,
+			int charWidth, int charHeight, int screenWidth, int screenHeight, int maxWidth) {
+		int width = parseDimension(arguments.get("width"), charWidth, screenWidth);
+		int height = parseDimension(arguments.get("height"), charHeight, screenHeight);
+		boolean preserveAspectRatio = !"0".equals(arguments.get("preserveAspectRatio"));
+
+		if (width <= 0 && height <= 0) {
+			width = imageWidth;
+			height = imageHeight;
+		} else if (width <= 0) {
+			width = (int) ((long) imageWidth * height / imageHeight);
+		} else if (height <= 0) {
+			height = (int) ((long) imageHeight * width / imageWidth);
+		} else if (preserveAspectRatio) {
+			// fit inside the box the arguments describe
+			if ((long) width * imageHeight > (long) height * imageWidth)
+				width = (int) ((long) imageWidth * height / imageHeight);
+			else
+				height = (int) ((long) imageHeight * width / imageWidth);
+		}
+
+		if (width > maxWidth) {
+			if (preserveAspectRatio)
+				height = (int) ((long) height * maxWidth / width);
+			width = maxWidth;
+		}
+		return new int[] { Math.max(width, 1), Math.max(height, 1) };
+	}
+}
@@ -0,0 +1,118 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.Iterator;
+import java.util.LinkedHashMap;
+import java.util.Map;
+
+import android.graphics.Bitmap;
+import de.mud.terminal.VDUBuffer;
+
+/**
+ * Holds the inline images of one terminal, keyed by the id stored in the
+ * cells that show them. The least recently drawn images are dropped once
+ * the cache holds more than its budget of pixels; cells that still refer to
+ * them are drawn blank.
+ * <p>
+ * Evicted bitmaps are left to the garbage collector rather than recycled,
+ * because a row may still be drawing them on another thread.
+ *
+ * @author Kenny Root
+ */
+public class InlineImageCache {
+	public static class Entry {
+		public final Bitmap bitmap;
+		/** Size of one terminal cell in bitmap pixels. */
+		public final float cellWidth;
+		public final float cellHeight;
+
+		Entry(Bitmap bitmap, float cellWidth, float cellHeight) {
+			this.bitmap = bitmap;
+			this.cellWidth = cellWidth;
+			this.cellHeight = cellHeight;
+		}
+	}
+
+	private final Map<Integer, Entry> entries = new LinkedHashMap<>(16, 0.75f, true);
+
+	private final int maxBytes;
+	private int bytes;
+	private int nextId = 1;
+	/** Set once the ids have run out and started again from 1. */
+	private boolean wrapped;
+
+	public InlineImageCache(int maxBytes) {
+		this.maxBytes = maxBytes;
+	}
+
+	/**
+	 * Add an image, evicting older ones as needed. The newest image is
+	 * always kept, even if it alone is over the budget.
+	 * @param cellWidth width of one terminal cell in bitmap pixels
+	 * @param cellHeight height of one terminal cell in bitmap pixels
+	 * @return id to store in the cells with {@link VDUBuffer#imageAttributes}
+	 */
+	public synchronized int put(Bitmap bitmap, float cellWidth, float cellHeight) {
+		int id = nextId;
+		if (nextId == VDUBuffer.MAX_IMAGE_ID) {
+			nextId = 1;
+			wrapped = true;
+		} else {
+			nextId++;
+		}
+
+		Entry old = entries.remove(id);
+		if (old != null)
+			bytes -= old.bitmap.getByteCount();
+
+		Iterator<Entry> it = entries.values().iterator();
+		int size = bitmap.getByteCount();
+		while (bytes + size > maxBytes && it.hasNext()) {
+			bytes -= it.next().bitmap.getByteCount();
+			it.remove();
+		}
+
+		entries.put(id, new Entry(bitmap, cellWidth, cellHeight));
+		bytes += size;
+		return id;
+	}
+
+	/**
+	 * @return true once {@link #put} has started handing out ids again, so
+	 *         that cells may still refer to an earlier image with the same
+	 *         id; see {@link VDUBuffer#clearImage}
+	 */
+	public synchronized boolean hasWrapped() {
+		return wrapped;
+	}
+
+	/**
+	 * @return the image with the given id, or null if it has been evicted
+	 */
+	public synchronized Entry get(int id) {
+		return entries.get(id);
+	}
+
+	/**
+	 * Drop every image.
+	 */
+	public synchronized void clear() {
+		entries.clear();
+		bytes = 0;
+	}
+}
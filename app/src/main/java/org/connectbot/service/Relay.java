@@ -27,6 +27,7 @@ import java.nio.charset.CodingErrorAction;
 
 import org.apache.harmony.niochar.charset.additional.IBM437;
 import org.connectbot.transport.AbsTransport;
+import org.connectbot.util.NativeZmodem;
 
 import android.text.AndroidCharacter;
 import android.util.Log;
@@ -55,6 +56,16 @@ public class Relay implements Runnable {
 	private byte[] byteArray;
 	private char[] charArray;
 
+	/* for East Asian character widths */
+	private byte[] wideAttribute;
+
+	/* set while tmux runs in control mode on this connection */
+	private TmuxControlClient tmux;
+	/* how much of TmuxControlClient.START has been seen so far */
+	private int tmuxMatch;
+	/* how much of NativeZmodem.START has been seen so far */
+	private int zmodemMatch;
+
 	public Relay(TerminalBridge bridge, AbsTransport transport, vt320 buffer, String encoding) {
 		setCharset(encoding);
 		this.bridge = bridge;
@@ -95,14 +106,11 @@ public class Relay implements Runnable {
 		byteBuffer = ByteBuffer.allocate(BUFFER_SIZE);
 		charBuffer = CharBuffer.allocate(BUFFER_SIZE);
 
-		/* for East Asian character widths */
-		byte[] wideAttribute = new byte[BUFFER_SIZE];
+		wideAttribute = new byte[BUFFER_SIZE];
 
 		byteArray = byteBuffer.array();
 		charArray = charBuffer.array();
 
-		CoderResult result;
-
 		int bytesRead = 0;
 		byteBuffer.limit(0);
 		int bytesToRead;
@@ -116,29 +124,153 @@ public class Relay implements Runnable {
 
 				if (bytesRead > 0) {
 					byteBuffer.limit(byteBuffer.limit() + bytesRead);
+					received(offset);
+				}
+			}
+		} catch (IOException e) {
+			Log.e(TAG, "Problem while handling incoming data in relay thread", e);
+		}
 
-					synchronized (this) {
-						result = decoder.decode(byteBuffer, charBuffer, false);
-					}
+		if (tmux != null)
+			tmux.close();
+	}
 
-					if (result.isUnderflow() &&
-							byteBuffer.limit() == byteBuffer.capacity()) {
-						byteBuffer.compact();
-						byteBuffer.limit(byteBuffer.position());
-						byteBuffer.position(0);
-					}
+	/**
+	 * Handle the bytes in {@link #byteBuffer} from {@code start} on, which
+	 * have just been read. If rz or sz starts a ZMODEM session among them,
+	 * the rest of the stream goes to {@link ZmodemTransfer} until the
+	 * session ends.
+	 */
+	private void received(int start) throws IOException {
+		int end = byteBuffer.limit();
+		int zmodemEnd = findZmodemStart(start, end);
+		if (zmodemEnd < 0) {
+			decode();
+			return;
+		}
 
-					offset = charBuffer.position();
+		// The start of the marker may have been shown already if it came in
+		// an earlier read; the session still gets all of it.
+		byteBuffer.limit(Math.max(start, zmodemEnd - NativeZmodem.START.length));
+		decode();
+
+		ZmodemTransfer transfer = new ZmodemTransfer(bridge, transport, buffer);
+		byte[] leftover = transfer.run(byteArray, zmodemEnd, end - zmodemEnd);
+
+		int used = 0;
+		while (used < leftover.length) {
+			byteBuffer.compact();
+			int length = Math.min(byteBuffer.remaining(), leftover.length - used);
+			int resume = byteBuffer.position();
+			byteBuffer.put(leftover, used, length);
+			byteBuffer.flip();
+			used += length;
+			received(resume);
+		}
+	}
+
+	/**
+	 * @return the index just past {@link NativeZmodem#START} in
+	 *         {@link #byteArray} between {@code start} and {@code end}, or -1
+	 */
+	private int findZmodemStart(int start, int end) {
+		if (tmux != null || !NativeZmodem.isAvailable())
+			return -1;
+
+		byte[] marker = NativeZmodem.START;
+		for (int i = start; i < end; i++) {
+			if (byteArray[i] == marker[zmodemMatch]) {
+				zmodemMatch++;
+			} else if (byteArray[i] != marker[0]) {
+				zmodemMatch = 0;
+			} else if (zmodemMatch != 2) {
+				// a third '*' still leaves the last two as a start
+				zmodemMatch = 1;
+			}
+
+			if (zmodemMatch == marker.length) {
+				zmodemMatch = 0;
+				return i + 1;
+			}
+		}
+		return -1;
+	}
 
-					AndroidCharacter.getEastAsianWidths(charArray, 0, offset, wideAttribute);
-					buffer.putString(charArray, wideAttribute, 0, charBuffer.position());
-					bridge.propagateConsoleText(charArray, charBuffer.position());
-					charBuffer.clear();
-					bridge.redraw();
+	/**
+	 * Decode what is in {@link #byteBuffer} and hand it to the terminal.
+	 */
+	private void decode() {
+		CoderResult result;
+		synchronized (this) {
+			result = decoder.decode(byteBuffer, charBuffer, false);
+		}
+
+		if (result.isUnderflow() &&
+				byteBuffer.limit() == byteBuffer.capacity()) {
+			byteBuffer.compact();
+			byteBuffer.limit(byteBuffer.position());
+			byteBuffer.position(0);
+		}
+
+		int length = charBuffer.position();
+
+		AndroidCharacter.getEastAsianWidths(charArray, 0, length, wideAttribute);
+		process(length);
+		charBuffer.clear();
+		bridge.redraw();
+	}
+
+	/**
+	 * Hand decoded chars to the terminal, or to the tmux control client while
+	 * tmux runs in control mode.
+	 */
+	private void process(int length) {
+		int offset = 0;
+		while (offset < length) {
+			if (tmux != null) {
+				offset += tmux.feed(charArray, offset, length - offset);
+				if (tmux.isExited())
+					tmux = null;
+				continue;
+			}
+
+			int end = length;
+			int start = -1;
+			String marker = TmuxControlClient.START;
+			for (int i = offset; i < length; i++) {
+				if (charArray[i] == marker.charAt(tmuxMatch)) {
+					tmuxMatch++;
+				} else {
+					tmuxMatch = charArray[i] == marker.charAt(0) ? 1 : 0;
+				}
+
+				if (tmuxMatch == marker.length()) {
+					tmuxMatch = 0;
+					end = i + 1;
+					// the marker may have started in an earlier read
+					start = Math.max(offset, end - marker.length());
+					break;
 				}
 			}
-		} catch (IOException e) {
-			Log.e(TAG, "Problem while handling incoming data in relay thread", e);
+
+			write(offset, (start < 0 ? end : start) - offset);
+			offset = end;
+			if (start >= 0)
+				tmux = new TmuxControlClient(bridge);
+		}
+	}
+
+	private void write(int offset, int length) {
+		if (length <= 0)
+			return;
+
+		buffer.putString(charArray, wideAttribute, offset, length);
+		if (offset == 0) {
+			bridge.propagateConsoleText(charArray, length);
+		} else {
+			char[] text = new char[length];
+			System.arraycopy(charArray, offset, text, 0, length);
+			bridge.propagateConsoleText(text, length);
 		}
 	}
 }
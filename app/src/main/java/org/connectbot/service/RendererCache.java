@@ -0,0 +1,90 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.HashMap;
+import java.util.Iterator;
+import java.util.Map;
+
+import org.connectbot.util.NativeCellRenderer;
+
+import android.graphics.Paint;
+
+/**
+ * Shares native renderers, and so their glyph atlases, between bridges that
+ * draw with the same font metrics. Terminals tiled side by side usually do,
+ * so each glyph is rasterized once rather than once per terminal.
+ * <p>
+ * Renderers draw only on the {@link FrameScheduler}'s render thread, one
+ * row at a time; rows that {@link RowRenderPool} spreads over other cores
+ * are drawn with the canvas instead. That single thread is what makes
+ * sharing them safe, since a renderer keeps scratch state between rows.
+ * Bridges acquire and release renderers under their own lock, which the
+ * render thread also holds while it draws, so one is never released while
+ * drawing.
+ *
+ * @author Kenny Root
+ */
+public class RendererCache {
+	private static class Entry {
+		final NativeCellRenderer renderer;
+		int references;
+
+		Entry(NativeCellRenderer renderer) {
+			this.renderer = renderer;
+		}
+	}
+
+	private final Map<String, Entry> entries = new HashMap<>();
+
+	/**
+	 * @return a renderer for text drawn with {@code paint} in cells of the
+	 *         given size; hand it back with {@link #release} when done
+	 */
+	public synchronized NativeCellRenderer acquire(Paint paint, int charWidth, int charHeight,
+			int charTop) {
+		String key = paint.getTextSize() + "/" + charWidth + "x" + charHeight + "/" + charTop;
+		Entry entry = entries.get(key);
+		if (entry == null) {
+			entry = new Entry(new NativeCellRenderer(paint, charWidth, charHeight, charTop));
+			entries.put(key, entry);
+		}
+		entry.references++;
+		return entry.renderer;
+	}
+
+	public synchronized void release(NativeCellRenderer renderer) {
+		Iterator<Entry> it = entries.values().iterator();
+		while (it.hasNext()) {
+			Entry entry = it.next();
+			if (entry.renderer != renderer)
+				continue;
+
+			if (--entry.references == 0) {
+				entry.renderer.release();
+				it.remove();
+			}
+			return;
+		}
+	}
+
+	public synchronized void clear() {
+		for (Entry entry : entries.values())
+			entry.renderer.release();
+		entries.clear();
+	}
+}
@@ -0,0 +1,185 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import android.os.Handler;
+import android.os.Looper;
+import android.os.SystemClock;
+import android.util.Log;
+
+/**
+ * Passes terminal size changes on to the remote end, at most one per burst.
+ * <p>
+ * Rotation, the soft keyboard coming and going and font zoom each change the
+ * size several times in quick succession, and every size the remote end sees
+ * makes it redraw the whole screen. Requests are held until no new one has
+ * come in for {@link #SETTLE_MILLIS}, and then only the last is sent, unless
+ * it is the size the remote end already has.
+ * <p>
+ * Output arriving shortly after a resize was sent is counted as the redraw
+ * it caused, so the cost of each resize shows up in the log.
+ *
+ * @author Kenny Root
+ */
+public class ResizeCoordinator {
+	private static final String TAG = "CB.ResizeCoordinator";
+
+	/** How long the size must stay the same before it is sent. */
+	static final long SETTLE_MILLIS = 150;
+
+	/** Output within this long after a resize is counted as its redraw. */
+	static final long REDRAW_WINDOW_MILLIS = 1000;
+
+	/**
+	 * Where sizes go once they have settled; the bridge's transport.
+	 */
+	interface Sink {
+		void setDimensions(int columns, int rows, int width, int height);
+	}
+
+	private final Sink sink;
+	private final Handler handler = new Handler(Looper.getMainLooper());
+
+	private int pendingColumns, pendingRows, pendingWidth, pendingHeight;
+	private boolean pending = false;
+	private int pendingRequests;
+
+	private int sentColumns = -1, sentRows = -1;
+
+	private long sentAt = -1;
+	private long redrawChars;
+
+	private int sent;
+	private int suppressed;
+
+	private final Runnable sendRunnable = new Runnable() {
+		@Override
+		public void run() {
+			flush();
+		}
+	};
+
+	public ResizeCoordinator(Sink sink) {
+		this.sink = sink;
+	}
+
+	/**
+	 * The terminal changed size. The remote end hears about it once the size
+	 * settles.
+	 */
+	public synchronized void request(int columns, int rows, int width, int height) {
+		pendingColumns = columns;
+		pendingRows = rows;
+		pendingWidth = width;
+		pendingHeight = height;
+		pending = true;
+		pendingRequests++;
+
+		handler.removeCallbacks(sendRunnable);
+		handler.postDelayed(sendRunnable, SETTLE_MILLIS);
+	}
+
+	/**
+	 * Send the pending size now instead of waiting for it to settle.
+	 */
+	public void flush() {
+		int columns, rows, width, height, requests;
+		synchronized (this) {
+			handler.removeCallbacks(sendRunnable);
+			if (!pending)
+				return;
+			pending = false;
+
+			requests = pendingRequests;
+			pendingRequests = 0;
+			suppressed += requests - 1;
+
+			// Back to the size the remote end already has; it needs no redraw.
+			if (pendingColumns == sentColumns && pendingRows == sentRows) {
+				suppressed++;
+				return;
+			}
+
+			logRedraw();
+
+			columns = sentColumns = pendingColumns;
+			rows = sentRows = pendingRows;
+			width = pendingWidth;
+			height = pendingHeight;
+			sentAt = SystemClock.uptimeMillis();
+			redrawChars = 0;
+			sent++;
+		}
+
+		Log.d(TAG, String.format("Resizing to %dx%d after %d requests", columns, rows, requests));
+		sink.setDimensions(columns, rows, width, height);
+	}
+
+	/**
+	 * Drop the pending size, e.g. because the connection is going away.
+	 */
+	public synchronized void cancel() {
+		handler.removeCallbacks(sendRunnable);
+		pending = false;
+		pendingRequests = 0;
+	}
+
+	/**
+	 * Forget what the remote end was told, e.g. because a new connection
+	 * is starting that has not heard any size yet.
+	 */
+	public synchronized void reset() {
+		sentColumns = -1;
+		sentRows = -1;
+		sentAt = -1;
+	}
+
+	/**
+	 * Count output from the remote end toward the redraw of the last resize.
+	 */
+	public synchronized void onOutput(int chars) {
+		if (sentAt >= 0 && SystemClock.uptimeMillis() - sentAt <= REDRAW_WINDOW_MILLIS)
+			redrawChars += chars;
+	}
+
+	private void logRedraw() {
+		if (sentAt >= 0)
+			Log.d(TAG, String.format("Resize to %dx%d was followed by %d chars of output",
+					sentColumns, sentRows, redrawChars));
+	}
+
+	/**
+	 * @return output counted toward the redraw of the last resize
+	 */
+	public synchronized long getRedrawChars() {
+		return redrawChars;
+	}
+
+	/**
+	 * @return number of sizes passed on to the remote end
+	 */
+	public synchronized int getSentCount() {
+		return sent;
+	}
+
+	/**
+	 * @return number of size requests that were never passed on
+	 */
+	public synchronized int getSuppressedCount() {
+		return suppressed;
+	}
+}
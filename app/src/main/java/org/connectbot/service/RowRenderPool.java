@@ -0,0 +1,200 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.RejectedExecutionException;
+import java.util.concurrent.ThreadFactory;
+
+import android.graphics.Bitmap;
+import android.graphics.Canvas;
+import android.graphics.Paint;
+import android.os.Process;
+import android.util.Log;
+
+/**
+ * Draws a large batch of terminal rows on several cores at once.
+ * <p>
+ * The dirty rows are split into contiguous horizontal bands, one per
+ * thread. Every band draws with its own {@link Canvas} and {@link Paint}
+ * into its own rows of the shared bitmap, and the caller draws the first
+ * band itself. {@link #render} returns only once every band is done, so the
+ * bitmap is complete before the view blits it.
+ *
+ * @author Kenny Root
+ */
+public class RowRenderPool {
+	private static final String TAG = "CB.RowRenderPool";
+
+	/** Fewer dirty rows than this are not worth handing to other threads. */
+	static final int MIN_ROWS_PER_BAND = 8;
+
+	/** More threads than this fight over memory bandwidth instead of helping. */
+	private static final int MAX_THREADS = 4;
+
+	/**
+	 * Draws one row. Called concurrently for different rows.
+	 */
+	public interface RowPainter {
+		void paintRow(Canvas canvas, Paint paint, int row);
+	}
+
+	private final int threads;
+	private final ExecutorService workers;
+
+	private final Canvas[] canvases;
+	private final Paint[] paints;
+	private Bitmap boundBitmap;
+
+	public RowRenderPool(int threads) {
+		this.threads = Math.max(1, threads);
+
+		canvases = new Canvas[this.threads];
+		paints = new Paint[this.threads];
+		for (int i = 0; i < this.threads; i++) {
+			canvases[i] = new Canvas();
+			paints[i] = new Paint();
+		}
+
+		if (this.threads > 1) {
+			workers = Executors.newFixedThreadPool(this.threads - 1, new ThreadFactory() {
+				@Override
+				public Thread newThread(final Runnable r) {
+					Thread t = new Thread(new Runnable() {
+						@Override
+						public void run() {
+							Process.setThreadPriority(Process.THREAD_PRIORITY_DISPLAY);
+							r.run();
+						}
+					}, "RowRender");
+					t.setDaemon(true);
+					return t;
+				}
+			});
+		} else {
+			workers = null;
+		}
+	}
+
+	/**
+	 * @return a thread count suited to this device
+	 */
+	public static int getDefaultThreadCount() {
+		return Math.min(Runtime.getRuntime().availableProcessors(), MAX_THREADS);
+	}
+
+	public int getThreadCount() {
+		return threads;
+	}
+
+	/**
+	 * @return whether drawing {@code rowCount} rows should be split into bands
+	 */
+	public boolean shouldSplit(int rowCount) {
+		return threads > 1 && rowCount >= 2 * MIN_ROWS_PER_BAND;
+	}
+
+	/**
+	 * Draw {@code rows[0..count)} into {@code bitmap} and wait for all of them.
+	 * Bridges share the pool, so callers are served one at a time.
+	 *
+	 * @param template paint whose settings every band starts from
+	 */
+	public synchronized void render(Bitmap bitmap, Paint template, int[] rows, int count,
+			final RowPainter painter) {
+		int bands = Math.min(threads, count / MIN_ROWS_PER_BAND);
+		if (bands < 1)
+			bands = 1;
+
+		if (bitmap != boundBitmap) {
+			for (Canvas canvas : canvases)
+				canvas.setBitmap(bitmap);
+			boundBitmap = bitmap;
+		}
+
+		final CountDownLatch done = new CountDownLatch(bands - 1);
+		for (int band = 1; band < bands; band++) {
+			final Canvas canvas = canvases[band];
+			final Paint paint = paints[band];
+			final int[] bandRows = rows;
+			final int from = count * band / bands;
+			final int to = count * (band + 1) / bands;
+			paint.set(template);
+
+			Runnable task = new Runnable() {
+				@Override
+				public void run() {
+					try {
+						paintRows(canvas, paint, bandRows, from, to, painter);
+					} finally {
+						done.countDown();
+					}
+				}
+			};
+
+			try {
+				workers.execute(task);
+			} catch (RejectedExecutionException e) {
+				// Shutting down; draw it here instead.
+				task.run();
+			}
+		}
+
+		paints[0].set(template);
+		paintRows(canvases[0], paints[0], rows, 0, count / bands, painter);
+
+		boolean interrupted = false;
+		while (true) {
+			try {
+				done.await();
+				break;
+			} catch (InterruptedException e) {
+				interrupted = true;
+			}
+		}
+		if (interrupted)
+			Thread.currentThread().interrupt();
+	}
+
+	private static void paintRows(Canvas canvas, Paint paint, int[] rows, int from, int to,
+			RowPainter painter) {
+		try {
+			for (int i = from; i < to; i++)
+				painter.paintRow(canvas, paint, rows[i]);
+		} catch (RuntimeException e) {
+			Log.e(TAG, "Problem while drawing terminal rows", e);
+		}
+	}
+
+	/**
+	 * Drop the reference to the last bitmap drawn into, e.g. before it is
+	 * recycled.
+	 */
+	public synchronized void releaseBitmap() {
+		for (Canvas canvas : canvases)
+			canvas.setBitmap(null);
+		boundBitmap = null;
+	}
+
+	public void shutdown() {
+		if (workers != null)
+			workers.shutdown();
+		releaseBitmap();
+	}
+}
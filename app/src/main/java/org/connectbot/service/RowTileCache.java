@@ -0,0 +1,145 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.ArrayList;
+import java.util.Iterator;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+import android.graphics.Bitmap;
+import android.graphics.Bitmap.Config;
+
+/**
+ * Rendered scrollback rows, one bitmap per row, keyed by absolute line
+ * number (see {@link de.mud.terminal.VDUBuffer#linesDropped}). Rows in the
+ * scrollback do not change, so while the user scrolls through history the
+ * rows that are still visible are blitted from here instead of being drawn
+ * again. Everything is dropped when the version changes, e.g. when the
+ * buffer is resized or the palette changes. Least recently used tiles are
+ * painted over when the cache is full, so scrolling does not allocate.
+ * <p>
+ * Not thread-safe; used by the render thread with the bridge locked.
+ *
+ * @author Kenny Root
+ */
+public class RowTileCache {
+	private final LinkedHashMap<Long, Bitmap> tiles = new LinkedHashMap<>(16, 0.75f, true);
+
+	private final List<Bitmap> spare = new ArrayList<>();
+
+	private int tileWidth, tileHeight;
+	private int capacity;
+	private long version;
+
+	private int hits, misses;
+
+	/**
+	 * Set the size of each tile and how many to keep. Cached tiles are
+	 * dropped if the size changes.
+	 */
+	public void setTileSize(int width, int height, int capacity) {
+		if (width != tileWidth || height != tileHeight) {
+			release();
+			tileWidth = width;
+			tileHeight = height;
+		}
+		this.capacity = Math.max(capacity, 1);
+		while (tiles.size() > this.capacity)
+			evictEldest();
+		while (!spare.isEmpty() && tiles.size() + spare.size() > this.capacity)
+			spare.remove(spare.size() - 1).recycle();
+	}
+
+	/**
+	 * Forget all tiles unless {@code version} is the one they were drawn for.
+	 */
+	public void setVersion(long version) {
+		if (version != this.version) {
+			invalidate();
+			this.version = version;
+		}
+	}
+
+	/**
+	 * @return tile for absolute line {@code line}, or null if it has to be drawn
+	 */
+	public Bitmap get(long line) {
+		Bitmap tile = tiles.get(line);
+		if (tile != null)
+			hits++;
+		return tile;
+	}
+
+	/**
+	 * Hand out a tile to draw {@code line} into, reusing the least recently
+	 * used one if the cache is full. Its old contents are undefined.
+	 */
+	public Bitmap obtain(long line) {
+		misses++;
+
+		if (tiles.size() >= capacity)
+			evictEldest();
+
+		Bitmap tile;
+		if (spare.isEmpty())
+			tile = Bitmap.createBitmap(tileWidth, tileHeight, Config.ARGB_8888);
+		else
+			tile = spare.remove(spare.size() - 1);
+		tiles.put(line, tile);
+		return tile;
+	}
+
+	private void evictEldest() {
+		Iterator<Map.Entry<Long, Bitmap>> it = tiles.entrySet().iterator();
+		if (it.hasNext()) {
+			spare.add(it.next().getValue());
+			it.remove();
+		}
+	}
+
+	/**
+	 * Forget all tiles, keeping their bitmaps for reuse.
+	 */
+	public void invalidate() {
+		spare.addAll(tiles.values());
+		tiles.clear();
+	}
+
+	/**
+	 * Forget all tiles and recycle their bitmaps.
+	 */
+	public void release() {
+		invalidate();
+		for (Bitmap tile : spare)
+			tile.recycle();
+		spare.clear();
+	}
+
+	public int size() {
+		return tiles.size();
+	}
+
+	public int getHits() {
+		return hits;
+	}
+
+	public int getMisses() {
+		return misses;
+	}
+}
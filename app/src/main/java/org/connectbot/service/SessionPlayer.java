@@ -0,0 +1,256 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.io.ByteArrayInputStream;
+import java.io.Closeable;
+import java.io.DataInputStream;
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+
+import android.text.AndroidCharacter;
+import de.mud.terminal.vt320;
+
+/**
+ * Plays back a file written by {@link SessionRecorder} into a terminal.
+ * Opening the file only reads record headers to build an index of the
+ * keyframes. A seek restores the closest keyframe before the target and
+ * replays the output after it, so it costs at most
+ * {@link SessionRecorder#KEYFRAME_CHARS} of parsing however long the
+ * recording is. Playback at a multiple of real time applies all output up
+ * to the new position before the caller draws once, skipping the frames in
+ * between.
+ *
+ * @author Kenny Root
+ */
+public class SessionPlayer implements Closeable {
+	private static final int HEADER_SIZE = 8;
+	private static final int RECORD_HEADER_SIZE = 9;
+
+	private final RandomAccessFile file;
+	private final vt320 terminal;
+
+	private long[] keyframeOffsets = new long[16];
+	private int[] keyframeTimes = new int[16];
+	private int keyframeCount;
+	private int duration;
+
+	/** File offset of the next record to play and the playback position. */
+	private long position;
+	private int time;
+
+	private float speed = 1f;
+
+	private char[] text = new char[0];
+	private byte[] widths = new byte[0];
+
+	public SessionPlayer(File recording, vt320 terminal) throws IOException {
+		this.terminal = terminal;
+		file = new RandomAccessFile(recording, "r");
+
+		try {
+			if (file.readInt() != SessionRecorder.MAGIC
+					|| file.readInt() != SessionRecorder.VERSION)
+				throw new IOException("Not a session recording: " + recording);
+
+			buildIndex();
+		} catch (IOException e) {
+			file.close();
+			throw e;
+		}
+
+		restoreKeyframe(0);
+		playUntil(0);
+	}
+
+	private void buildIndex() throws IOException {
+		long length = file.length();
+		long offset = HEADER_SIZE;
+		while (offset + RECORD_HEADER_SIZE <= length) {
+			file.seek(offset);
+			byte type = file.readByte();
+			int recordTime = file.readInt();
+			int size = file.readInt();
+			if (offset + RECORD_HEADER_SIZE + size > length)
+				break; // cut short while recording
+
+			if (type == SessionRecorder.TYPE_KEYFRAME) {
+				if (keyframeCount == keyframeOffsets.length) {
+					long[] offsets = new long[keyframeCount * 2];
+					int[] times = new int[keyframeCount * 2];
+					System.arraycopy(keyframeOffsets, 0, offsets, 0, keyframeCount);
+					System.arraycopy(keyframeTimes, 0, times, 0, keyframeCount);
+					keyframeOffsets = offsets;
+					keyframeTimes = times;
+				}
+				keyframeOffsets[keyframeCount] = offset;
+				keyframeTimes[keyframeCount] = recordTime;
+				keyframeCount++;
+			}
+
+			duration = Math.max(duration, recordTime);
+			offset += RECORD_HEADER_SIZE + size;
+		}
+
+		if (keyframeCount == 0)
+			throw new IOException("Session recording has no keyframes");
+	}
+
+	/**
+	 * @return length of the recording in milliseconds
+	 */
+	public int getDuration() {
+		return duration;
+	}
+
+	/**
+	 * @return playback position in milliseconds
+	 */
+	public int getTime() {
+		return time;
+	}
+
+	public boolean isFinished() {
+		return time >= duration;
+	}
+
+	public void setSpeed(float speed) {
+		this.speed = speed;
+	}
+
+	public float getSpeed() {
+		return speed;
+	}
+
+	/**
+	 * Move playback to {@code millis} into the recording.
+	 */
+	public void seek(int millis) throws IOException {
+		millis = Math.max(0, Math.min(millis, duration));
+
+		// going forward, keep playing unless a keyframe is closer
+		int keyframe = findKeyframe(millis);
+		if (millis < time || keyframeTimes[keyframe] > time)
+			restoreKeyframe(keyframe);
+		playUntil(millis);
+	}
+
+	/**
+	 * Advance playback by {@code realMillis} of wall clock time at the
+	 * current speed.
+	 */
+	public void advance(long realMillis) throws IOException {
+		long target = time + (long) (realMillis * speed);
+		playUntil((int) Math.min(target, duration));
+	}
+
+	/**
+	 * @return index of the last keyframe at or before {@code millis}
+	 */
+	int findKeyframe(int millis) {
+		int lo = 0, hi = keyframeCount - 1, found = 0;
+		while (lo <= hi) {
+			int mid = (lo + hi) >>> 1;
+			if (keyframeTimes[mid] <= millis) {
+				found = mid;
+				lo = mid + 1;
+			} else {
+				hi = mid - 1;
+			}
+		}
+		return found;
+	}
+
+	private void restoreKeyframe(int keyframe) throws IOException {
+		file.seek(keyframeOffsets[keyframe]);
+		file.readByte();
+		int recordTime = file.readInt();
+		byte[] state = new byte[file.readInt()];
+		file.readFully(state);
+		restoreState(state);
+
+		position = file.getFilePointer();
+		time = recordTime;
+	}
+
+	private void restoreState(byte[] state) throws IOException {
+		synchronized (terminal) {
+			terminal.restoreScreenState(new DataInputStream(new ByteArrayInputStream(state)));
+		}
+	}
+
+	private void playUntil(int millis) throws IOException {
+		long length = file.length();
+		while (position + RECORD_HEADER_SIZE <= length) {
+			file.seek(position);
+			byte type = file.readByte();
+			int recordTime = file.readInt();
+			int size = file.readInt();
+			if (recordTime > millis || position + RECORD_HEADER_SIZE + size > length)
+				break;
+
+			if (type == SessionRecorder.TYPE_DATA) {
+				byte[] bytes = new byte[size];
+				file.readFully(bytes);
+				play(new String(bytes, SessionRecorder.UTF8));
+			} else if (type == SessionRecorder.TYPE_KEYFRAME && isResize()) {
+				// the output does not show a resize, only the keyframe after it
+				file.seek(position + RECORD_HEADER_SIZE);
+				byte[] state = new byte[size];
+				file.readFully(state);
+				restoreState(state);
+			}
+			// other keyframes only repeat what the output already built
+
+			position += RECORD_HEADER_SIZE + size;
+		}
+		time = millis;
+	}
+
+	/**
+	 * Reads the screen size at the start of the keyframe the file is
+	 * positioned in.
+	 * @return true if it differs from the terminal's size
+	 */
+	private boolean isResize() throws IOException {
+		int columns = file.readInt();
+		int rows = file.readInt();
+		synchronized (terminal) {
+			return columns != terminal.getColumns() || rows != terminal.getRows();
+		}
+	}
+
+	private void play(String output) {
+		int length = output.length();
+		if (text.length < length) {
+			text = new char[length];
+			widths = new byte[length];
+		}
+		output.getChars(0, length, text, 0);
+		AndroidCharacter.getEastAsianWidths(text, 0, length, widths);
+
+		synchronized (terminal) {
+			terminal.putString(text, widths, 0, length);
+		}
+	}
+
+	@Override
+	public void close() throws IOException {
+		file.close();
+	}
+}
@@ -0,0 +1,191 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.io.BufferedOutputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.DataOutputStream;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.nio.charset.Charset;
+
+import android.os.SystemClock;
+import android.util.Log;
+import de.mud.terminal.vt320;
+
+/**
+ * Records what a session printed so it can be played back later with
+ * {@link SessionPlayer}. The file holds the decoded output as a series of
+ * timestamped data records. Every so often a keyframe record with the whole
+ * screen state is written between them, so a player can start from the
+ * closest keyframe instead of replaying from the start.
+ *
+ * <pre>
+ * header:   MAGIC, VERSION
+ * data:     'D', millis since start, byte count, UTF-8 text
+ * keyframe: 'K', millis since start, byte count, vt320 screen state
+ * </pre>
+ *
+ * @author Kenny Root
+ */
+public class SessionRecorder {
+	private static final String TAG = "CB.SessionRecorder";
+
+	static final int MAGIC = 0x43425245; // "CBRE"
+	static final int VERSION = 2;
+
+	static final byte TYPE_DATA = 'D';
+	static final byte TYPE_KEYFRAME = 'K';
+
+	/** Output between keyframes, which bounds the replay needed for a seek. */
+	static final int KEYFRAME_CHARS = 64 * 1024;
+
+	/** Longest time between keyframes while there is output. */
+	static final long KEYFRAME_MILLIS = 60 * 1000;
+
+	static final Charset UTF8 = Charset.forName("UTF-8");
+
+	private final File file;
+	private final vt320 buffer;
+	private final DataOutputStream out;
+	private final long startTime;
+	private final int keyframeChars;
+
+	private int charsSinceKeyframe;
+	private long lastKeyframeTime;
+	private boolean keyframeRequested = true;
+	private char pendingHighSurrogate;
+	private boolean closed;
+
+	public SessionRecorder(File file, vt320 buffer) throws IOException {
+		this(file, buffer, KEYFRAME_CHARS);
+	}
+
+	SessionRecorder(File file, vt320 buffer, int keyframeChars) throws IOException {
+		this.file = file;
+		this.buffer = buffer;
+		this.keyframeChars = keyframeChars;
+		out = new DataOutputStream(new BufferedOutputStream(new FileOutputStream(file)));
+		out.writeInt(MAGIC);
+		out.writeInt(VERSION);
+
+		startTime = now();
+
+		synchronized (buffer) {
+			writeKeyframeIfIdle();
+		}
+	}
+
+	public File getFile() {
+		return file;
+	}
+
+	long now() {
+		return SystemClock.elapsedRealtime();
+	}
+
+	/**
+	 * Record output after it has been given to the emulator. Called on the
+	 * relay thread.
+	 */
+	public synchronized void onOutput(char[] text, int length) {
+		if (closed || length <= 0)
+			return;
+
+		// keep a surrogate pair split between reads together so it encodes
+		StringBuilder chunk = new StringBuilder(length + 1);
+		if (pendingHighSurrogate != 0)
+			chunk.append(pendingHighSurrogate);
+		pendingHighSurrogate = 0;
+		if (Character.isHighSurrogate(text[length - 1])) {
+			pendingHighSurrogate = text[length - 1];
+			length--;
+		}
+		chunk.append(text, 0, length);
+
+		try {
+			byte[] bytes = chunk.toString().getBytes(UTF8);
+			out.writeByte(TYPE_DATA);
+			out.writeInt((int) (now() - startTime));
+			out.writeInt(bytes.length);
+			out.write(bytes);
+
+			charsSinceKeyframe += length;
+			if (charsSinceKeyframe >= keyframeChars
+					|| now() - lastKeyframeTime >= KEYFRAME_MILLIS)
+				keyframeRequested = true;
+
+			if (keyframeRequested) {
+				synchronized (buffer) {
+					writeKeyframeIfIdle();
+				}
+			}
+		} catch (IOException e) {
+			Log.e(TAG, "Could not write to session recording", e);
+		}
+	}
+
+	/**
+	 * The screen changed in a way the recorded output does not show, such as
+	 * a resize; store a keyframe at the next chance.
+	 */
+	public synchronized void requestKeyframe() {
+		if (closed)
+			return;
+
+		keyframeRequested = true;
+		synchronized (buffer) {
+			try {
+				writeKeyframeIfIdle();
+			} catch (IOException e) {
+				Log.e(TAG, "Could not write to session recording", e);
+			}
+		}
+	}
+
+	/**
+	 * A keyframe can only be restored if it was taken between escape
+	 * sequences, so otherwise wait for the next output.
+	 */
+	private void writeKeyframeIfIdle() throws IOException {
+		if (!keyframeRequested || !buffer.isIdle())
+			return;
+
+		ByteArrayOutputStream state = new ByteArrayOutputStream();
+		buffer.saveScreenState(new DataOutputStream(state));
+
+		long time = now();
+		out.writeByte(TYPE_KEYFRAME);
+		out.writeInt((int) (time - startTime));
+		out.writeInt(state.size());
+		state.writeTo(out);
+
+		keyframeRequested = false;
+		charsSinceKeyframe = 0;
+		lastKeyframeTime = time;
+	}
+
+	public synchronized void close() {
+		closed = true;
+		try {
+			out.close();
+		} catch (IOException e) {
+			Log.e(TAG, "Could not close session recording", e);
+		}
+	}
+}
@@ -17,10 +17,15 @@
 
 package org.connectbot.service;
 
+import java.io.File;
 import java.io.IOException;
+import java.io.OutputStream;
 import java.nio.charset.Charset;
 import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Date;
 import java.util.List;
+import java.util.Locale;
 import java.util.regex.Matcher;
 import java.util.regex.Pattern;
 
@@ -32,6 +37,9 @@ import org.connectbot.bean.SelectionArea;
 import org.connectbot.transport.AbsTransport;
 import org.connectbot.transport.TransportFactory;
 import org.connectbot.util.HostDatabase;
+import org.connectbot.util.NativeCellRenderer;
+import org.connectbot.util.NativeImageDecoder;
+import org.connectbot.util.StartupTrace;
 
 import android.content.Context;
 import android.graphics.Bitmap;
@@ -41,11 +49,14 @@ import android.graphics.Color;
 import android.graphics.Paint;
 import android.graphics.Paint.FontMetrics;
 import android.graphics.Typeface;
+import android.net.Uri;
 import android.os.Handler;
 import android.os.Looper;
+import android.os.SystemClock;
 import android.provider.Settings;
 import android.text.ClipboardManager;
 import android.util.Log;
+import de.mud.terminal.PromptIndex;
 import de.mud.terminal.VDUBuffer;
 import de.mud.terminal.VDUDisplay;
 import de.mud.terminal.vt320;
@@ -61,11 +72,13 @@ import de.mud.terminal.vt320;
  * prompting.
  */
 @SuppressWarnings("deprecation") // for ClipboardManager
-public class TerminalBridge implements VDUDisplay {
+public class TerminalBridge implements VDUDisplay, FrameScheduler.Target {
 	public final static String TAG = "CB.TerminalBridge";
 
 	private final static int DEFAULT_FONT_SIZE_DP = 10;
 	private final static int FONT_SIZE_STEP = 2;
+	/** Memory the inline images of one terminal may hold on to. */
+	private final static int MAX_IMAGE_BYTES = 32 * 1024 * 1024;
 	private float displayDensity;
 	private float systemFontScale;
 
@@ -84,15 +97,42 @@ public class TerminalBridge implements VDUDisplay {
 
 	private Relay relay;
 
+	/** When the user asked for this connection, in {@link SystemClock#elapsedRealtime()} time. */
+	private volatile long requestedAt = -1;
+
 	private final String emulation;
 	private final int scrollback;
 
+	/** Last completed frame; only touch it while holding {@link #getFrameLock()}. */
 	public Bitmap bitmap = null;
 	public VDUBuffer buffer = null;
 
 	private TerminalView parent = null;
+
+	/** Frame being rasterized on the render thread; {@link #canvas} draws into it. */
+	private Bitmap backBitmap = null;
 	private final Canvas canvas = new Canvas();
 
+	private final Object frameLock = new Object();
+
+	/** Rows changed by the last frame, which the back bitmap has not seen yet. */
+	private boolean[] staleRows;
+	/** Number of coming frames that must repaint everything, one per bitmap. */
+	private int staleFrames = 0;
+
+	/** Scrollback rows already drawn, reused while scrolling through history. */
+	private final RowTileCache tiles = new RowTileCache();
+	private final Canvas tileCanvas = new Canvas();
+	private volatile int paletteVersion = 0;
+
+	/** Pixels the view is scrolled past the top of {@link VDUBuffer#windowBase}. */
+	private volatile int scrollOffset = 0;
+	/** Absolute line and offset the last frame was drawn at. */
+	private long renderedTop = -1;
+	private int renderedOffset = 0;
+	/** Offset of the frame in {@link #bitmap}. */
+	private int frameScrollOffset = 0;
+
 	private boolean disconnected = false;
 	private boolean awaitingClose = false;
 
@@ -121,10 +161,53 @@ public class TerminalBridge implements VDUDisplay {
 	 */
 	private boolean fullRedraw = false;
 
+	private int[] dirtyRows;
+	private final RowRenderPool.RowPainter rowPainter = new RowRenderPool.RowPainter() {
+		@Override
+		public void paintRow(Canvas canvas, Paint paint, int row) {
+			drawRow(canvas, paint, row);
+		}
+	};
+
+	private NativeCellRenderer nativeRenderer;
+	private int[] nativeFg;
+	private int[] nativeBg;
+	private byte[] nativeFlags;
+
+	/** Inline images shown in {@link VDUBuffer#IMAGE_CELL} cells. */
+	private final InlineImageCache images = new InlineImageCache(MAX_IMAGE_BYTES);
+
 	public PromptHelper promptHelper;
 
 	private BridgeDisconnectedListener disconnectListener = null;
 
+	private volatile BroadcastGroup broadcastGroup = null;
+
+	/**
+	 * Thread currently encoding a key through {@link vt320#keyPressed} or
+	 * {@link vt320#keyTyped}. Bytes vt320 writes from that thread are user
+	 * input; anything else (e.g. status replies) is for this host only.
+	 */
+	private volatile Thread keyEncodingThread = null;
+
+	private volatile SessionRecorder recorder = null;
+	private File lastRecording = null;
+
+	/** Files waiting to go out with the next ZMODEM upload. */
+	private final List<Uri> pendingUploads = new ArrayList<>();
+
+	/** Whether font size changes are saved back to the host database. */
+	private final boolean persistHost;
+
+	private final ResizeCoordinator resizer = new ResizeCoordinator(new ResizeCoordinator.Sink() {
+		@Override
+		public void setDimensions(int columns, int rows, int width, int height) {
+			AbsTransport current = transport;
+			if (current != null)
+				current.setDimensions(columns, rows, width, height);
+		}
+	});
+
 	/**
 	 * Create a new terminal bridge suitable for unit testing.
 	 */
@@ -144,6 +227,7 @@ public class TerminalBridge implements VDUDisplay {
 
 		emulation = null;
 		manager = null;
+		persistHost = false;
 
 		displayDensity = 1f;
 
@@ -158,6 +242,8 @@ public class TerminalBridge implements VDUDisplay {
 
 		transport = null;
 
+		promptHelper = new PromptHelper(this);
+
 		keyListener = new TerminalKeyListener(null, this, buffer, null);
 	}
 
@@ -167,8 +253,17 @@ public class TerminalBridge implements VDUDisplay {
 	 * and password authentication.
 	 */
 	public TerminalBridge(final TerminalManager manager, final HostBean host) {
+		this(manager, host, true);
+	}
+
+	/**
+	 * Create a terminal bridge for a host that only exists while it is
+	 * connected, such as a tmux pane, and so is never saved.
+	 */
+	TerminalBridge(final TerminalManager manager, final HostBean host, boolean persistHost) {
 		this.manager = manager;
 		this.host = host;
+		this.persistHost = persistHost;
 
 		emulation = manager.getEmulation();
 		scrollback = manager.getScrollback();
@@ -205,8 +300,12 @@ public class TerminalBridge implements VDUDisplay {
 			@Override
 			public void write(byte[] b) {
 				try {
-					if (b != null && transport != null)
-						transport.write(b);
+					if (b != null && transport != null) {
+						if (keyEncodingThread == Thread.currentThread())
+							sendInput(b);
+						else
+							transport.write(b);
+					}
 				} catch (IOException e) {
 					Log.e(TAG, "Problem writing outgoing data in vt320() thread", e);
 				}
@@ -215,13 +314,37 @@ public class TerminalBridge implements VDUDisplay {
 			@Override
 			public void write(int b) {
 				try {
-					if (transport != null)
-						transport.write(b);
+					if (transport != null) {
+						if (keyEncodingThread == Thread.currentThread())
+							sendInput(b);
+						else
+							transport.write(b);
+					}
 				} catch (IOException e) {
 					Log.e(TAG, "Problem writing outgoing data in vt320() thread", e);
 				}
 			}
 
+			@Override
+			public void keyPressed(int keyCode, char keyChar, int modifiers) {
+				keyEncodingThread = Thread.currentThread();
+				try {
+					super.keyPressed(keyCode, keyChar, modifiers);
+				} finally {
+					keyEncodingThread = null;
+				}
+			}
+
+			@Override
+			public void keyTyped(int keyCode, char keyChar, int modifiers) {
+				keyEncodingThread = Thread.currentThread();
+				try {
+					super.keyTyped(keyCode, keyChar, modifiers);
+				} finally {
+					keyEncodingThread = null;
+				}
+			}
+
 			// We don't use telnet sequences.
 			@Override
 			public void sendTelnetCommand(byte cmd) {
@@ -239,6 +362,13 @@ public class TerminalBridge implements VDUDisplay {
 				else
 					manager.sendActivityNotification(host);
 			}
+
+			@Override
+			protected ImageReceiver beginImage(int format, String params) {
+				if (!NativeImageDecoder.isAvailable() || charWidth <= 0 || charHeight <= 0)
+					return null;
+				return new InlineImage(this, images, format, params, charWidth, charHeight);
+			}
 		};
 
 		// Don't keep any scrollback if a session is not being opened.
@@ -263,12 +393,29 @@ public class TerminalBridge implements VDUDisplay {
 	 * Spawn thread to open connection and start login process.
 	 */
 	protected void startConnection() {
-		transport = TransportFactory.getTransport(host.getProtocol());
+		AbsTransport transport = TransportFactory.getTransport(host.getProtocol());
 		if (transport == null) {
 			Log.i(TAG, "No transport found for " + host.getProtocol());
 			return;
 		}
 
+		startConnection(transport);
+	}
+
+	/**
+	 * Spawn thread to open connection over the given transport.
+	 */
+	void startConnection(final AbsTransport transport) {
+		this.transport = transport;
+		requestedAt = SystemClock.elapsedRealtime();
+
+		// A new connection has not been told any size yet.
+		resizer.reset();
+		if (bitmap != null) {
+			resizer.request(columns, rows, bitmap.getWidth(), bitmap.getHeight());
+			resizer.flush();
+		}
+
 		transport.setBridge(this);
 		transport.setManager(manager);
 		transport.setHost(host);
@@ -279,7 +426,7 @@ public class TerminalBridge implements VDUDisplay {
 		transport.setEmulation(emulation);
 
 		if (transport.canForwardPorts()) {
-			for (PortForwardBean portForward : manager.hostdb.getPortForwardsForHost(host))
+			for (PortForwardBean portForward : manager.getHostStorage().getPortForwardsForHost(host))
 				transport.addPortForward(portForward);
 		}
 
@@ -370,11 +517,20 @@ public class TerminalBridge implements VDUDisplay {
 		}
 	}
 
+	/**
+	 * Inject a specific string into this terminal. Used for pasting clipboard,
+	 * so it is also sent to the rest of the broadcast group.
+	 */
+	public void injectString(final String string) {
+		injectString(string, true);
+	}
+
 	/**
 	 * Inject a specific string into this terminal. Used for post-login strings
 	 * and pasting clipboard.
+	 * @param broadcast whether the rest of the broadcast group should get it too
 	 */
-	public void injectString(final String string) {
+	private void injectString(final String string, final boolean broadcast) {
 		if (string == null || string.length() == 0)
 			return;
 
@@ -382,7 +538,11 @@ public class TerminalBridge implements VDUDisplay {
 			@Override
 			public void run() {
 				try {
-					transport.write(string.getBytes(host.getEncoding()));
+					byte[] encoded = string.getBytes(host.getEncoding());
+					if (broadcast)
+						sendInput(encoded);
+					else
+						transport.write(encoded);
 				} catch (Exception e) {
 					Log.e(TAG, "Couldn't inject string to remote host: ", e);
 				}
@@ -392,6 +552,38 @@ public class TerminalBridge implements VDUDisplay {
 		injectStringThread.start();
 	}
 
+	/**
+	 * @return whether {@link #exec} can run a command on this host right now
+	 */
+	public boolean canExec() {
+		AbsTransport t = transport;
+		return t != null && t.isConnected() && t.canExec();
+	}
+
+	/**
+	 * Run a command on this host outside of the terminal session. See
+	 * {@link AbsTransport#exec(String, OutputStream, OutputStream, long)}.
+	 * @return exit status of the command
+	 * @throws IOException if the host can't run commands or the command failed
+	 */
+	public int exec(String command, OutputStream stdout, OutputStream stderr, long timeoutMillis)
+			throws IOException {
+		AbsTransport t = transport;
+		if (t == null || !t.isConnected() || !t.canExec())
+			throw new IOException("Host is not able to run commands");
+
+		return t.exec(command, stdout, stderr, timeoutMillis);
+	}
+
+	/**
+	 * Note that the user asked for this connection at {@code elapsedRealtime},
+	 * for example when they tapped the host, rather than when it was started.
+	 * The time from then until the session is ready is logged.
+	 */
+	public void setRequestedAt(long elapsedRealtime) {
+		requestedAt = elapsedRealtime;
+	}
+
 	/**
 	 * Internal method to request actual PTY terminal once we've finished
 	 * authentication. If called before authenticated, it will just fail.
@@ -399,6 +591,15 @@ public class TerminalBridge implements VDUDisplay {
 	public void onConnected() {
 		disconnected = false;
 
+		StartupTrace.mark(StartupTrace.FIRST_CONNECT);
+
+		long requested = requestedAt;
+		if (requested >= 0) {
+			Log.i(TAG, String.format(Locale.US, "Tap to prompt for %s: %d ms",
+					host.getNickname(), SystemClock.elapsedRealtime() - requested));
+			requestedAt = -1;
+		}
+
 		((vt320) buffer).reset();
 
 		// We no longer need our local output.
@@ -426,7 +627,54 @@ public class TerminalBridge implements VDUDisplay {
 		setFontSize(fontSizeDp);
 
 		// finally send any post-login string, if requested
-		injectString(host.getPostLogin());
+		injectString(host.getPostLogin(), false);
+	}
+
+	/**
+	 * Send user input to this host and, if this bridge is in a
+	 * {@link BroadcastGroup}, to every other host in the group. The same array
+	 * is shared with the group, so it must not be modified afterwards.
+	 */
+	public void sendInput(byte[] data) throws IOException {
+		transport.write(data);
+
+		BroadcastGroup group = broadcastGroup;
+		if (group != null)
+			group.send(this, data);
+	}
+
+	/**
+	 * Send a single byte of user input. See {@link #sendInput(byte[])}.
+	 */
+	public void sendInput(int b) throws IOException {
+		transport.write(b);
+
+		BroadcastGroup group = broadcastGroup;
+		if (group != null)
+			group.send(this, BroadcastGroup.singleByte(b));
+	}
+
+	/**
+	 * Write input that was typed into another member of our broadcast group.
+	 */
+	void writeBroadcastInput(byte[] data) throws IOException {
+		AbsTransport t = transport;
+		if (disconnected || t == null || !t.isSessionOpen())
+			return;
+
+		t.write(data);
+		t.flush();
+	}
+
+	void setBroadcastGroup(BroadcastGroup group) {
+		broadcastGroup = group;
+	}
+
+	/**
+	 * @return the broadcast group this bridge belongs to, or {@code null}
+	 */
+	public BroadcastGroup getBroadcastGroup() {
+		return broadcastGroup;
 	}
 
 	/**
@@ -438,10 +686,51 @@ public class TerminalBridge implements VDUDisplay {
 		return false;
 	}
 
+	/**
+	 * Ask the transport for history older than the local scrollback, if it
+	 * keeps any.
+	 */
+	public void requestHistory() {
+		if (transport != null)
+			transport.requestHistory();
+	}
+
+	/**
+	 * Size the buffer to match a terminal the remote end has laid out itself,
+	 * such as a tmux pane sharing its window with others. The view keeps its
+	 * own size; the next layout change hands it back.
+	 */
+	void setRemoteSize(int columns, int rows) {
+		synchronized (buffer) {
+			if (buffer.getColumns() == columns && buffer.getRows() == rows)
+				return;
+			buffer.setScreenSize(columns, rows, false);
+		}
+
+		fullRedraw = true;
+		redraw();
+	}
+
 	public void setOnDisconnectedListener(BridgeDisconnectedListener disconnectListener) {
 		this.disconnectListener = disconnectListener;
 	}
 
+	/**
+	 * Called by the transport's keepalive monitor when the remote end has
+	 * stopped answering. Tears the connection down right away so that
+	 * reconnection can start instead of waiting for TCP to give up.
+	 */
+	public void onConnectionStalled(long silentMillis) {
+		Log.i(TAG, String.format("Connection to %s stalled; nothing heard for %d ms",
+				host.getNickname(), silentMillis));
+		final String line = manager.res.getString(R.string.terminal_connection_stalled,
+				(int) (silentMillis / 1000));
+		synchronized (buffer) {
+			((vt320) buffer).putString("\r\n" + line);
+		}
+		dispatchDisconnect(false);
+	}
+
 	/**
 	 * Force disconnection of this terminal bridge.
 	 */
@@ -454,9 +743,17 @@ public class TerminalBridge implements VDUDisplay {
 			disconnected = true;
 		}
 
+		BroadcastGroup group = broadcastGroup;
+		if (group != null)
+			group.remove(this);
+
 		// Cancel any pending prompts.
 		promptHelper.cancelPrompt();
 
+		resizer.cancel();
+
+		stopRecording();
+
 		// disconnection request hangs if we havent really connected to a host yet
 		// temporary fix is to just spawn disconnection into a thread
 		Thread disconnectThread = new Thread(new Runnable() {
@@ -530,21 +827,26 @@ public class TerminalBridge implements VDUDisplay {
 
 		final int fontSizePx = (int) (sizeDp * displayDensity *	systemFontScale + 0.5f);
 
-		defaultPaint.setTextSize(fontSizePx);
-		fontSizeDp = sizeDp;
+		// the render thread draws with this paint and these metrics
+		synchronized (this) {
+			defaultPaint.setTextSize(fontSizePx);
+			fontSizeDp = sizeDp;
 
-		// read new metrics to get exact pixel dimensions
-		FontMetrics fm = defaultPaint.getFontMetrics();
-		charTop = (int) Math.ceil(fm.top);
+			// read new metrics to get exact pixel dimensions
+			FontMetrics fm = defaultPaint.getFontMetrics();
+			charTop = (int) Math.ceil(fm.top);
 
-		float[] widths = new float[1];
-		defaultPaint.getTextWidths("X", widths);
-		charWidth = (int) Math.ceil(widths[0]);
-		charHeight = (int) Math.ceil(fm.descent - fm.top);
+			float[] widths = new float[1];
+			defaultPaint.getTextWidths("X", widths);
+			charWidth = (int) Math.ceil(widths[0]);
+			charHeight = (int) Math.ceil(fm.descent - fm.top);
 
-		// refresh any bitmap with new font size
-		if (parent != null) {
-			parentChanged(parent);
+			releaseNativeRenderer();
+
+			// refresh any bitmap with new font size
+			if (parent != null) {
+				parentChanged(parent);
+			}
 		}
 
 		for (FontSizeChangedListener ofscl : fontSizeChangedListeners) {
@@ -552,7 +854,8 @@ public class TerminalBridge implements VDUDisplay {
 		}
 
 		host.setFontSize((int) sizeDp);
-		manager.hostdb.saveHost(host);
+		if (persistHost)
+			manager.getHostStorage().saveHost(host);
 
 		forcedSize = false;
 	}
@@ -626,27 +929,17 @@ public class TerminalBridge implements VDUDisplay {
 		if (bitmap != null)
 			newBitmap = (bitmap.getWidth() != width || bitmap.getHeight() != height);
 
-		if (newBitmap) {
-			discardBitmap();
-			bitmap = Bitmap.createBitmap(width, height, Config.ARGB_8888);
-			canvas.setBitmap(bitmap);
-		}
-
-		// clear out any old buffer information
-		defaultPaint.setColor(Color.BLACK);
-		canvas.drawPaint(defaultPaint);
-
-		// Stroke the border of the terminal if the size is being forced;
-		if (forcedSize) {
-			int borderX = (columns * charWidth) + 1;
-			int borderY = (rows * charHeight) + 1;
+		synchronized (frameLock) {
+			if (newBitmap) {
+				discardBitmap();
+				bitmap = Bitmap.createBitmap(width, height, Config.ARGB_8888);
+				backBitmap = Bitmap.createBitmap(width, height, Config.ARGB_8888);
+			}
 
-			defaultPaint.setColor(Color.GRAY);
-			defaultPaint.setStrokeWidth(0.0f);
-			if (width >= borderX)
-				canvas.drawLine(borderX, 0, borderX, borderY + 1, defaultPaint);
-			if (height >= borderY)
-				canvas.drawLine(0, borderY, borderX + 1, borderY, defaultPaint);
+			// clear out any old buffer information in both frames
+			clearBitmap(bitmap, width, height);
+			clearBitmap(backBitmap, width, height);
+			canvas.setBitmap(backBitmap);
 		}
 
 		try {
@@ -655,8 +948,17 @@ public class TerminalBridge implements VDUDisplay {
 				buffer.setScreenSize(columns, rows, true);
 			}
 
-			if (transport != null)
-				transport.setDimensions(columns, rows, width, height);
+			SessionRecorder recorder = this.recorder;
+			if (recorder != null)
+				recorder.requestKeyframe();
+
+			// Until the session is open, nothing redraws and the size is
+			// needed for the PTY request; afterwards, wait for it to settle.
+			if (transport != null) {
+				resizer.request(columns, rows, width, height);
+				if (!isSessionOpen())
+					resizer.flush();
+			}
 		} catch (Exception e) {
 			Log.e(TAG, "Problem while trying to resize screen or PTY", e);
 		}
@@ -680,19 +982,84 @@ public class TerminalBridge implements VDUDisplay {
 		Log.i(TAG, String.format("parentChanged() now width=%d, height=%d", columns, rows));
 	}
 
+	private void clearBitmap(Bitmap target, int width, int height) {
+		canvas.setBitmap(target);
+		defaultPaint.setColor(Color.BLACK);
+		canvas.drawPaint(defaultPaint);
+
+		// Stroke the border of the terminal if the size is being forced;
+		if (forcedSize) {
+			int borderX = (columns * charWidth) + 1;
+			int borderY = (rows * charHeight) + 1;
+
+			defaultPaint.setColor(Color.GRAY);
+			defaultPaint.setStrokeWidth(0.0f);
+			if (width >= borderX)
+				canvas.drawLine(borderX, 0, borderX, borderY + 1, defaultPaint);
+			if (height >= borderY)
+				canvas.drawLine(0, borderY, borderX + 1, borderY, defaultPaint);
+		}
+	}
+
 	/**
 	 * Somehow our parent {@link TerminalView} was destroyed. Now we don't need
 	 * to redraw anywhere, and we can recycle our internal bitmap.
 	 */
 	public synchronized void parentDestroyed() {
+		if (manager != null)
+			manager.getFrameScheduler().cancel(this);
 		parent = null;
-		discardBitmap();
+		synchronized (frameLock) {
+			discardBitmap();
+		}
+		releaseNativeRenderer();
 	}
 
 	private void discardBitmap() {
+		if (bitmap != null && manager != null)
+			manager.getRowRenderPool().releaseBitmap();
+		canvas.setBitmap(null);
 		if (bitmap != null)
 			bitmap.recycle();
 		bitmap = null;
+		if (backBitmap != null)
+			backBitmap.recycle();
+		backBitmap = null;
+		tiles.release();
+		tileCanvas.setBitmap(null);
+	}
+
+	/**
+	 * @return pixels the frame in {@link #bitmap} is shifted up by, while the
+	 *         view rests between two lines of scrollback; read it with the
+	 *         frame lock held
+	 */
+	public int getFrameScrollOffset() {
+		return frameScrollOffset;
+	}
+
+	/**
+	 * Scroll the view {@code pixels} further down than the line at
+	 * {@link VDUBuffer#windowBase}, for smooth scrolling through history.
+	 */
+	public void setScrollOffset(int pixels) {
+		if (pixels < 0 || charHeight <= 0)
+			pixels = 0;
+		else if (pixels >= charHeight)
+			pixels = charHeight - 1;
+
+		if (pixels != scrollOffset) {
+			scrollOffset = pixels;
+			redraw();
+		}
+	}
+
+	/**
+	 * @return lock to hold while drawing {@link #bitmap}, so the render
+	 *         thread cannot swap it out from under the view
+	 */
+	public Object getFrameLock() {
+		return frameLock;
 	}
 
 	@Override
@@ -706,124 +1073,408 @@ public class TerminalBridge implements VDUDisplay {
 	}
 
 	public void propagateConsoleText(char[] rawText, int length) {
+		resizer.onOutput(length);
+
+		SessionRecorder recorder = this.recorder;
+		if (recorder != null)
+			recorder.onOutput(rawText, length);
+
 		if (parent != null) {
 			parent.propagateConsoleText(rawText, length);
 		}
 	}
 
-	public void onDraw() {
-		int fg, bg;
+	/**
+	 * Rasterize pending changes into the back bitmap. Besides the rows the
+	 * buffer marks as dirty, this repaints the rows the previous frame changed
+	 * in the other bitmap, so both frames stay complete.
+	 */
+	private void onDraw() {
 		synchronized (buffer) {
-			boolean entireDirty = buffer.update[0] || fullRedraw;
-			boolean isWideCharacter = false;
+			if (fullRedraw)
+				tiles.invalidate();
+			tiles.setVersion(((long) paletteVersion << 32) | (buffer.historyVersion & 0xffffffffL));
+
+			// Scrolling through history: compose the frame from row tiles.
+			boolean inHistory = buffer.windowBase < buffer.screenBase;
+			int offset = inHistory ? scrollOffset : 0;
+			long top = buffer.linesDropped + buffer.windowBase;
+			if (inHistory && (offset != 0 || top != renderedTop || offset != renderedOffset)) {
+				composeFromTiles(offset);
+				Arrays.fill(buffer.update, false);
+				renderedTop = top;
+				renderedOffset = offset;
+				staleFrames = 2;
+				fullRedraw = false;
+				return;
+			}
+
+			boolean damaged = buffer.update[0] || fullRedraw
+					|| top != renderedTop || offset != renderedOffset;
+			boolean entireDirty = damaged || staleFrames > 0;
+			renderedTop = top;
+			renderedOffset = offset;
+
+			NativeCellRenderer renderer = getNativeRenderer();
+
+			if (dirtyRows == null || dirtyRows.length < buffer.height)
+				dirtyRows = new int[buffer.height];
+			if (staleRows == null || staleRows.length != buffer.height) {
+				staleRows = new boolean[buffer.height];
+				entireDirty = damaged = true;
+			}
+			int dirtyCount = 0;
 
 			// walk through all lines in the buffer
 			for (int l = 0; l < buffer.height; l++) {
+				boolean changed = damaged || buffer.update[l + 1];
 
 				// check if this line is dirty and needs to be repainted
 				// also check for entire-buffer dirty flags
-				if (!entireDirty && !buffer.update[l + 1]) continue;
+				boolean repaint = changed || entireDirty || staleRows[l];
+				staleRows[l] = changed;
+				if (!repaint) continue;
 
 				// reset dirty flag for this line
 				buffer.update[l + 1] = false;
 
-				// walk through all characters in this line
-				for (int c = 0; c < buffer.width; c++) {
-					int addr = 0;
-					long currAttr = buffer.charAttributes[buffer.windowBase + l][c];
-
-					{
-						int fgcolor = defaultFg;
-						int bgcolor = defaultBg;
-
-						// check if foreground color attribute is set
-						if ((currAttr & VDUBuffer.COLOR_FG) != 0)
-							fgcolor = (int) ((currAttr & VDUBuffer.COLOR_FG) >> VDUBuffer.COLOR_FG_SHIFT) - 1;
+				if (renderer != null && renderNativeRow(renderer, l))
+					continue;
 
-						if (fgcolor < 8 && (currAttr & VDUBuffer.BOLD) != 0)
-							fg = color[fgcolor + 8];
-						else if (fgcolor < 256)
-							fg = color[fgcolor];
-						else
-							fg = 0xff000000 | (fgcolor - 256);
+				dirtyRows[dirtyCount++] = l;
+			}
 
-						// check if background color attribute is set
-						if ((currAttr & VDUBuffer.COLOR_BG) != 0)
-							bgcolor = (int) ((currAttr & VDUBuffer.COLOR_BG) >> VDUBuffer.COLOR_BG_SHIFT) - 1;
+			// Big repaints are split into bands drawn on several cores.
+			RowRenderPool pool = manager != null ? manager.getRowRenderPool() : null;
+			if (pool != null && pool.shouldSplit(dirtyCount)) {
+				pool.render(backBitmap, defaultPaint, dirtyRows, dirtyCount, rowPainter);
+			} else {
+				for (int i = 0; i < dirtyCount; i++)
+					drawRow(canvas, defaultPaint, dirtyRows[i]);
+			}
 
-						if (bgcolor < 256)
-							bg = color[bgcolor];
-						else
-							bg = 0xff000000 | (bgcolor - 256);
-					}
+			// reset entire-buffer flags
+			buffer.update[0] = false;
+			staleFrames = Math.max(staleFrames - 1, damaged ? 1 : 0);
+		}
+		fullRedraw = false;
+	}
 
-					// support character inversion by swapping background and foreground color
-					if ((currAttr & VDUBuffer.INVERT) != 0) {
-						int swapc = bg;
-						bg = fg;
-						fg = swapc;
-					}
+	/**
+	 * Fill the back bitmap with the rows from {@link VDUBuffer#windowBase} on,
+	 * shifted up by {@code offset} pixels. Scrollback rows come from the tile
+	 * cache and are only drawn on a miss; rows of the live screen are drawn
+	 * directly. Must be called with the buffer locked.
+	 */
+	private void composeFromTiles(int offset) {
+		int width = buffer.width * charWidth;
+		tiles.setTileSize(width, charHeight, 2 * buffer.height + 2);
+
+		canvas.save();
+		canvas.clipRect(0, 0, width, buffer.height * charHeight);
+
+		// one more row peeks in at the bottom while between lines
+		int count = offset > 0 ? buffer.height + 1 : buffer.height;
+		for (int l = 0; l < count; l++) {
+			int row = buffer.windowBase + l;
+			if (row >= buffer.bufSize)
+				break;
+
+			if (row < buffer.screenBase) {
+				long line = buffer.linesDropped + row;
+				Bitmap tile = tiles.get(line);
+				if (tile == null) {
+					tile = tiles.obtain(line);
+					tileCanvas.setBitmap(tile);
+					drawBufferRow(tileCanvas, defaultPaint, row, 0);
+				}
+				canvas.drawBitmap(tile, 0, l * charHeight - offset, null);
+			} else {
+				canvas.save();
+				canvas.translate(0, -offset);
+				drawBufferRow(canvas, defaultPaint, row, l);
+				canvas.restore();
+			}
+		}
 
-					// set underlined attributes if requested
-					defaultPaint.setUnderlineText((currAttr & VDUBuffer.UNDERLINE) != 0);
+		canvas.restore();
+	}
 
-					isWideCharacter = (currAttr & VDUBuffer.FULLWIDTH) != 0;
+	/**
+	 * Paint screen line {@code l} with the canvas path. Only touches pixels
+	 * inside that line, so different lines may be drawn concurrently as long
+	 * as each thread has its own {@code canvas} and {@code paint}. Must be
+	 * called with the buffer locked.
+	 */
+	private void drawRow(Canvas canvas, Paint paint, int l) {
+		drawBufferRow(canvas, paint, buffer.windowBase + l, l);
+	}
 
-					if (isWideCharacter)
-						addr++;
-					else {
-						// determine the amount of continuous characters with the same settings and print them all at once
-						while (c + addr < buffer.width
-								&& buffer.charAttributes[buffer.windowBase + l][c + addr] == currAttr) {
-							addr++;
-						}
-					}
+	/**
+	 * Paint buffer row {@code row} where screen line {@code l} goes.
+	 */
+	private void drawBufferRow(Canvas canvas, Paint paint, int row, int l) {
+		// walk through all characters in this line
+		for (int c = 0; c < buffer.width; c++) {
+			if (buffer.charArray[row][c] == VDUBuffer.IMAGE_CELL) {
+				c += drawImageRun(canvas, paint, row, c, l) - 1;
+				continue;
+			}
 
-					// Save the current clip region
-					canvas.save();
-
-					// clear this dirty area with background color
-					defaultPaint.setColor(bg);
-					if (isWideCharacter) {
-						canvas.clipRect(c * charWidth,
-								l * charHeight,
-								(c + 2) * charWidth,
-								(l + 1) * charHeight);
-					} else {
-						canvas.clipRect(c * charWidth,
-								l * charHeight,
-								(c + addr) * charWidth,
-								(l + 1) * charHeight);
-					}
-					canvas.drawPaint(defaultPaint);
+			int addr = 0;
+			long currAttr = buffer.charAttributes[row][c];
 
-					// write the text string starting at 'c' for 'addr' number of characters
-					defaultPaint.setColor(fg);
-					if ((currAttr & VDUBuffer.INVISIBLE) == 0)
-						canvas.drawText(buffer.charArray[buffer.windowBase + l], c,
-							addr, c * charWidth, (l * charHeight) - charTop,
-							defaultPaint);
+			int fg = getForegroundColor(currAttr);
+			int bg = getBackgroundColor(currAttr);
 
-					// Restore the previous clip region
-					canvas.restore();
+			// support character inversion by swapping background and foreground color
+			if ((currAttr & VDUBuffer.INVERT) != 0) {
+				int swapc = bg;
+				bg = fg;
+				fg = swapc;
+			}
 
-					// advance to the next text block with different characteristics
-					c += addr - 1;
-					if (isWideCharacter)
-						c++;
+			// set underlined attributes if requested; hyperlinks are always underlined
+			paint.setUnderlineText((currAttr & (VDUBuffer.UNDERLINE | VDUBuffer.LINK)) != 0);
+
+			boolean isWideCharacter = (currAttr & VDUBuffer.FULLWIDTH) != 0;
+			char[] chars = buffer.charArray[row];
+
+			// emoji and other clusters are kept out of line, so draw each alone
+			boolean isCluster = VDUBuffer.isClusterHandle(chars[c]);
+
+			if (isCluster) {
+				addr = isWideCharacter ? 2 : 1;
+			} else if (isWideCharacter) {
+				// each wide character takes its own cell and a padding cell,
+				// so take as many whole pairs with the same settings as we can
+				addr = 2;
+				while (c + addr + 1 < buffer.width
+						&& buffer.charAttributes[row][c + addr] == currAttr
+						&& buffer.charAttributes[row][c + addr + 1] == currAttr
+						&& !VDUBuffer.isClusterHandle(chars[c + addr])
+						&& chars[c + addr] != VDUBuffer.IMAGE_CELL) {
+					addr += 2;
+				}
+			} else {
+				// determine the amount of continuous characters with the same settings and print them all at once
+				while (c + addr < buffer.width
+						&& buffer.charAttributes[row][c + addr] == currAttr
+						&& !VDUBuffer.isClusterHandle(chars[c + addr])
+						&& chars[c + addr] != VDUBuffer.IMAGE_CELL) {
+					addr++;
 				}
 			}
 
-			// reset entire-buffer flags
-			buffer.update[0] = false;
+			// Save the current clip region
+			canvas.save();
+
+			// clear this dirty area with background color
+			paint.setColor(bg);
+			canvas.clipRect(c * charWidth,
+					l * charHeight,
+					(c + addr) * charWidth,
+					(l + 1) * charHeight);
+			canvas.drawPaint(paint);
+
+			// write the text string starting at 'c' for 'addr' number of characters
+			paint.setColor(fg);
+			if ((currAttr & VDUBuffer.INVISIBLE) == 0) {
+				if (isCluster)
+					canvas.drawText(buffer.getCluster(chars[c]), c * charWidth,
+						(l * charHeight) - charTop, paint);
+				else if (!isWideCharacter)
+					canvas.drawText(chars, c,
+						addr, c * charWidth, (l * charHeight) - charTop,
+						paint);
+				else if (addr == 2)
+					canvas.drawText(chars, c,
+						1, c * charWidth, (l * charHeight) - charTop,
+						paint);
+				else
+					WideCharRun.draw(canvas, paint, chars, c,
+						addr, c * charWidth, (l * charHeight) - charTop, charWidth);
+			}
+
+			// Restore the previous clip region
+			canvas.restore();
+
+			// advance to the next text block with different characteristics
+			c += addr - 1;
 		}
-		fullRedraw = false;
+	}
+
+	/**
+	 * Paint the image cells from column {@code c} on that show neighbouring
+	 * tiles of the same image, scaling the image to the current cell size.
+	 * @return the number of cells painted
+	 */
+	private int drawImageRun(Canvas canvas, Paint paint, int row, int c, int l) {
+		char[] chars = buffer.charArray[row];
+		long[] attrs = buffer.charAttributes[row];
+		int id = VDUBuffer.getImageId(attrs[c]);
+		int column = VDUBuffer.getImageColumn(attrs[c]);
+		int tileRow = VDUBuffer.getImageRow(attrs[c]);
+
+		int count = 1;
+		while (c + count < buffer.width && chars[c + count] == VDUBuffer.IMAGE_CELL
+				&& attrs[c + count] == VDUBuffer.imageAttributes(id, column + count, tileRow))
+			count++;
+
+		canvas.save();
+		canvas.clipRect(c * charWidth, l * charHeight,
+				(c + count) * charWidth, (l + 1) * charHeight);
+		paint.setColor(color[defaultBg]);
+		canvas.drawPaint(paint);
+
+		InlineImageCache.Entry image = images.get(id);
+		if (image != null) {
+			canvas.translate((c - column) * charWidth, (l - tileRow) * charHeight);
+			canvas.scale(charWidth / image.cellWidth, charHeight / image.cellHeight);
+			canvas.drawBitmap(image.bitmap, 0, 0, paint);
+		}
+		canvas.restore();
+
+		return count;
+	}
+
+	private int getForegroundColor(long attr) {
+		int fgcolor = defaultFg;
+
+		// check if foreground color attribute is set
+		if ((attr & VDUBuffer.COLOR_FG) != 0)
+			fgcolor = (int) ((attr & VDUBuffer.COLOR_FG) >> VDUBuffer.COLOR_FG_SHIFT) - 1;
+
+		if (fgcolor < 8 && (attr & VDUBuffer.BOLD) != 0)
+			return color[fgcolor + 8];
+		else if (fgcolor < 256)
+			return color[fgcolor];
+		else
+			return 0xff000000 | (fgcolor - 256);
+	}
+
+	private int getBackgroundColor(long attr) {
+		int bgcolor = defaultBg;
+
+		// check if background color attribute is set
+		if ((attr & VDUBuffer.COLOR_BG) != 0)
+			bgcolor = (int) ((attr & VDUBuffer.COLOR_BG) >> VDUBuffer.COLOR_BG_SHIFT) - 1;
+
+		if (bgcolor < 256)
+			return color[bgcolor];
+		else
+			return 0xff000000 | (bgcolor - 256);
+	}
+
+	/**
+	 * @return the native renderer for the current font size, or {@code null}
+	 *         if it is turned off or unavailable
+	 */
+	private NativeCellRenderer getNativeRenderer() {
+		if (manager == null || !manager.isNativeRendererEnabled()) {
+			releaseNativeRenderer();
+			return null;
+		}
+
+		if (nativeRenderer == null && charWidth > 0 && NativeCellRenderer.isAvailable())
+			nativeRenderer = manager.getRendererCache().acquire(defaultPaint, charWidth,
+					charHeight, charTop);
+
+		return nativeRenderer;
+	}
+
+	private void releaseNativeRenderer() {
+		if (nativeRenderer != null) {
+			manager.getRendererCache().release(nativeRenderer);
+			nativeRenderer = null;
+		}
+	}
+
+	/**
+	 * Draw line {@code l} of the screen with the native renderer. Must be
+	 * called with the buffer locked.
+	 *
+	 * @return false if the line still needs to be drawn with the canvas
+	 */
+	private boolean renderNativeRow(NativeCellRenderer renderer, int l) {
+		final int width = buffer.width;
+		if (nativeFlags == null || nativeFlags.length < width) {
+			nativeFg = new int[width];
+			nativeBg = new int[width];
+			nativeFlags = new byte[width];
+		}
+
+		long[] attrs = buffer.charAttributes[buffer.windowBase + l];
+		char[] chars = buffer.charArray[buffer.windowBase + l];
+		for (int c = 0; c < width; c++) {
+			// the glyph atlas only holds single code units, and no images
+			if (VDUBuffer.isClusterHandle(chars[c]) || chars[c] == VDUBuffer.IMAGE_CELL)
+				return false;
+
+			long attr = attrs[c];
+			nativeFg[c] = getForegroundColor(attr);
+			nativeBg[c] = getBackgroundColor(attr);
+
+			byte flags = 0;
+			if ((attr & (VDUBuffer.UNDERLINE | VDUBuffer.LINK)) != 0)
+				flags |= NativeCellRenderer.FLAG_UNDERLINE;
+			if ((attr & VDUBuffer.INVERT) != 0)
+				flags |= NativeCellRenderer.FLAG_INVERSE;
+			if ((attr & VDUBuffer.INVISIBLE) != 0)
+				flags |= NativeCellRenderer.FLAG_INVISIBLE;
+			if ((attr & VDUBuffer.FULLWIDTH) != 0)
+				flags |= NativeCellRenderer.FLAG_WIDE;
+			nativeFlags[c] = flags;
+		}
+
+		return renderer.renderRow(backBitmap, l, chars,
+				nativeFg, nativeBg, nativeFlags, width);
 	}
 
 	@Override
 	public void redraw() {
-		if (parent != null)
-			parent.postInvalidate();
+		if (parent == null)
+			return;
+
+		if (manager != null)
+			manager.getFrameScheduler().requestFrame(this);
+		else
+			renderFrame();
+	}
+
+	/**
+	 * Paint pending changes into the back bitmap, make it the front one and
+	 * have the view show it. Called by the {@link FrameScheduler} on its
+	 * render thread.
+	 */
+	@Override
+	public void renderFrame() {
+		TerminalView view;
+		synchronized (this) {
+			view = parent;
+			if (view == null || backBitmap == null)
+				return;
+
+			onDraw();
+
+			synchronized (frameLock) {
+				Bitmap front = backBitmap;
+				backBitmap = bitmap;
+				bitmap = front;
+				frameScrollOffset = renderedOffset;
+				canvas.setBitmap(backBitmap);
+			}
+		}
+		view.postInvalidate();
+	}
+
+	/**
+	 * Report how long the view took to show a frame, for the frame-time
+	 * statistics of the main thread.
+	 */
+	public void recordViewDraw(long nanos) {
+		if (manager != null)
+			manager.getFrameScheduler().recordViewDraw(nanos);
 	}
 
 	// We don't have a scroll bar.
@@ -992,17 +1643,20 @@ public class TerminalBridge implements VDUDisplay {
 	@Override
 	public void setColor(int index, int red, int green, int blue) {
 		// Don't allow the system colors to be overwritten for now. May violate specs.
-		if (index < color.length && index >= 16)
+		if (index < color.length && index >= 16) {
 			color[index] = 0xff000000 | red << 16 | green << 8 | blue;
+			paletteVersion++;
+		}
 	}
 
 	@Override
 	public final void resetColors() {
-		int[] defaults = manager.colordb.getDefaultColorsForScheme(HostDatabase.DEFAULT_COLOR_SCHEME);
+		int[] defaults = manager.getColorStorage().getDefaultColorsForScheme(HostDatabase.DEFAULT_COLOR_SCHEME);
 		defaultFg = defaults[0];
 		defaultBg = defaults[1];
 
-		color = manager.colordb.getColorsForScheme(HostDatabase.DEFAULT_COLOR_SCHEME);
+		color = manager.getColorStorage().getColorsForScheme(HostDatabase.DEFAULT_COLOR_SCHEME);
+		paletteVersion++;
 	}
 
 	private static class PatternHolder {
@@ -1039,24 +1693,218 @@ public class TerminalBridge implements VDUDisplay {
 		private static final Pattern urlPattern;
 	}
 
+	/**
+	 * Start recording everything this session prints into a new file in
+	 * {@code directory}.
+	 *
+	 * @return false if the recording could not be started
+	 */
+	public boolean startRecording(File directory) {
+		if (recorder != null)
+			return true;
+
+		if (!directory.isDirectory() && !directory.mkdirs())
+			return false;
+
+		String name = String.format(Locale.US, "%s-%tY%<tm%<td-%<tH%<tM%<tS.cbrec",
+				host.getNickname().replaceAll("[^-_.A-Za-z0-9]", "_"), new Date());
+		try {
+			recorder = new SessionRecorder(new File(directory, name), (vt320) buffer);
+			return true;
+		} catch (IOException e) {
+			Log.e(TAG, "Could not start recording session", e);
+			return false;
+		}
+	}
+
+	/**
+	 * Stop recording, if this session is being recorded.
+	 */
+	public void stopRecording() {
+		SessionRecorder recorder = this.recorder;
+		if (recorder == null)
+			return;
+
+		this.recorder = null;
+		recorder.close();
+		lastRecording = recorder.getFile();
+	}
+
+	public boolean isRecording() {
+		return recorder != null;
+	}
+
+	/**
+	 * @return the file of the last finished recording, or {@code null}
+	 */
+	public File getLastRecording() {
+		return lastRecording;
+	}
+
+	/**
+	 * Queue {@code uri} for upload and start rz on the remote host, which
+	 * the relay answers with a ZMODEM session that sends it.
+	 */
+	public void sendFile(Uri uri) {
+		synchronized (pendingUploads) {
+			pendingUploads.add(uri);
+		}
+		injectString("rz\r", false);
+	}
+
+	/**
+	 * @return the next file queued by {@link #sendFile(Uri)}, or {@code null}
+	 */
+	Uri pollUpload() {
+		synchronized (pendingUploads) {
+			return pendingUploads.isEmpty() ? null : pendingUploads.remove(0);
+		}
+	}
+
+	/**
+	 * @return true if the shell has reported where its prompts are
+	 */
+	public boolean hasPromptMarks() {
+		synchronized (buffer) {
+			return !buffer.prompts.isEmpty();
+		}
+	}
+
+	/**
+	 * Scroll so the closest prompt above the top of the screen is the first
+	 * line shown.
+	 *
+	 * @return false if there is no such prompt
+	 */
+	public boolean scrollToPreviousPrompt() {
+		synchronized (buffer) {
+			int row = buffer.prompts.getPreviousPrompt(buffer.getWindowBase());
+			if (row == PromptIndex.NONE)
+				return false;
+
+			buffer.setWindowBase(row);
+			return true;
+		}
+	}
+
+	/**
+	 * Scroll so the closest prompt below the top of the screen is the first
+	 * line shown, or to the bottom when there are no more.
+	 *
+	 * @return false if there is no such prompt
+	 */
+	public boolean scrollToNextPrompt() {
+		synchronized (buffer) {
+			int row = buffer.prompts.getNextPrompt(buffer.getWindowBase());
+			if (row == PromptIndex.NONE) {
+				buffer.setWindowBase(buffer.screenBase);
+				return false;
+			}
+
+			buffer.setWindowBase(row);
+			return true;
+		}
+	}
+
+	/**
+	 * @return the output of the most recent command that has finished, or
+	 *         {@code null} if the shell has not marked any
+	 */
+	public String getLastCommandOutput() {
+		synchronized (buffer) {
+			return getBufferText(buffer.prompts.getLastOutputRange());
+		}
+	}
+
+	/**
+	 * @return the output of the command shown at screen row {@code row}, or
+	 *         {@code null} if the shell has not marked it
+	 */
+	public String getCommandOutputAt(int row) {
+		synchronized (buffer) {
+			return getBufferText(buffer.prompts.getOutputRange(buffer.getWindowBase() + row));
+		}
+	}
+
+	/**
+	 * @param range first buffer row and the row after the last one
+	 */
+	private String getBufferText(int[] range) {
+		if (range == null)
+			return null;
+
+		StringBuilder text = new StringBuilder();
+		synchronized (buffer) {
+			int stop = Math.min(range[1], buffer.getBufferSize());
+			for (int l = range[0]; l < stop; l++) {
+				int lineStart = text.length();
+				// scrollback may still be laid out for an earlier width
+				int width = buffer.charArray[l].length;
+				for (int c = 0; c < width; c++) {
+					text.append(buffer.getCellText(c, l));
+					// the cell after a wide character only pads it out
+					if ((buffer.charAttributes[l][c] & VDUBuffer.FULLWIDTH) != 0)
+						c++;
+				}
+
+				// a wrapped line goes on in the next row
+				if (buffer.isWrapped(l) && l + 1 < stop)
+					continue;
+
+				int trimmed = text.length();
+				while (trimmed > lineStart && text.charAt(trimmed - 1) == ' ')
+					trimmed--;
+				text.setLength(trimmed);
+				text.append('\n');
+			}
+		}
+		return text.toString();
+	}
+
 	/**
 	 * @return
 	 */
 	public List<String> scanForURLs() {
 		List<String> urls = new ArrayList<>();
 
-		char[] visibleBuffer = new char[buffer.height * buffer.width];
-		for (int l = 0; l < buffer.height; l++)
-			System.arraycopy(buffer.charArray[buffer.windowBase + l], 0,
-					visibleBuffer, l * buffer.width, buffer.width);
+		// only rows that autowrap continued are joined, so a URL that happens
+		// to end at the right edge does not run on into the next line
+		StringBuilder visibleBuffer = new StringBuilder(buffer.height * (buffer.width + 1));
+		for (int l = 0; l < buffer.height; l++) {
+			int row = buffer.windowBase + l;
+			visibleBuffer.append(buffer.charArray[row], 0, buffer.width);
+			if (!buffer.isWrapped(row))
+				visibleBuffer.append('\n');
+		}
 
-		Matcher urlMatcher = PatternHolder.urlPattern.matcher(new String(visibleBuffer));
-		while (urlMatcher.find())
-			urls.add(urlMatcher.group());
+		// explicit hyperlinks come first since their text may not look like a URL
+		for (int l = 0; l < buffer.height; l++) {
+			long[] attrs = buffer.charAttributes[buffer.windowBase + l];
+			for (int c = 0; c < buffer.width; c++) {
+				String link = buffer.getLink(VDUBuffer.getLinkId(attrs[c]));
+				if (link != null && !urls.contains(link))
+					urls.add(link);
+			}
+		}
+
+		Matcher urlMatcher = PatternHolder.urlPattern.matcher(visibleBuffer);
+		while (urlMatcher.find()) {
+			String url = urlMatcher.group();
+			if (!urls.contains(url))
+				urls.add(url);
+		}
 
 		return urls;
 	}
 
+	/**
+	 * @return the target of the hyperlink at the given screen position, or
+	 *         {@code null} if there is none
+	 */
+	public String getLinkAt(int column, int row) {
+		return buffer.getLinkAt(column, buffer.windowBase + row);
+	}
+
 	/**
 	 * @return
 	 */
@@ -152,24 +152,24 @@ public class TerminalKeyListener implements OnKeyListener, OnSharedPreferenceCha
 					if (keyCode == KeyEvent.KEYCODE_ALT_RIGHT
 							&& (ourMetaState & OUR_SLASH) != 0) {
 						ourMetaState &= ~OUR_TRANSIENT;
-						bridge.transport.write('/');
+						bridge.sendInput('/');
 						return true;
 					} else if (keyCode == KeyEvent.KEYCODE_SHIFT_RIGHT
 							&& (ourMetaState & OUR_TAB) != 0) {
 						ourMetaState &= ~OUR_TRANSIENT;
-						bridge.transport.write(0x09);
+						bridge.sendInput(0x09);
 						return true;
 					}
 				} else if (leftModifiersAreSlashAndTab) {
 					if (keyCode == KeyEvent.KEYCODE_ALT_LEFT
 							&& (ourMetaState & OUR_SLASH) != 0) {
 						ourMetaState &= ~OUR_TRANSIENT;
-						bridge.transport.write('/');
+						bridge.sendInput('/');
 						return true;
 					} else if (keyCode == KeyEvent.KEYCODE_SHIFT_LEFT
 							&& (ourMetaState & OUR_TAB) != 0) {
 						ourMetaState &= ~OUR_TRANSIENT;
-						bridge.transport.write(0x09);
+						bridge.sendInput(0x09);
 						return true;
 					}
 				}
@@ -193,7 +193,7 @@ public class TerminalKeyListener implements OnKeyListener, OnSharedPreferenceCha
 			if (keyCode == KeyEvent.KEYCODE_UNKNOWN &&
 					event.getAction() == KeyEvent.ACTION_MULTIPLE) {
 				byte[] input = event.getCharacters().getBytes(encoding);
-				bridge.transport.write(input);
+				bridge.sendInput(input);
 				return true;
 			}
 
@@ -363,10 +363,10 @@ public class TerminalKeyListener implements OnKeyListener, OnSharedPreferenceCha
 				if ((derivedMetaState & KeyEvent.META_ALT_ON) != 0)
 					sendEscape();
 				if (uchar < 0x80)
-					bridge.transport.write(uchar);
+					bridge.sendInput(uchar);
 				else
 					// TODO write encoding routine that doesn't allocate each time
-					bridge.transport.write(new String(Character.toChars(uchar))
+					bridge.sendInput(new String(Character.toChars(uchar))
 							.getBytes(encoding));
 				return true;
 			}
@@ -377,7 +377,7 @@ public class TerminalKeyListener implements OnKeyListener, OnSharedPreferenceCha
 				sendEscape();
 				return true;
 			case KeyEvent.KEYCODE_TAB:
-				bridge.transport.write(0x09);
+				bridge.sendInput(0x09);
 				return true;
 			case KeyEvent.KEYCODE_CAMERA:
 
@@ -386,15 +386,15 @@ public class TerminalKeyListener implements OnKeyListener, OnSharedPreferenceCha
 						PreferenceConstants.CAMERA,
 						PreferenceConstants.CAMERA_CTRLA_SPACE);
 				if (PreferenceConstants.CAMERA_CTRLA_SPACE.equals(camera)) {
-					bridge.transport.write(0x01);
-					bridge.transport.write(' ');
+					bridge.sendInput(0x01);
+					bridge.sendInput(' ');
 				} else if (PreferenceConstants.CAMERA_CTRLA.equals(camera)) {
-					bridge.transport.write(0x01);
+					bridge.sendInput(0x01);
 				} else if (PreferenceConstants.CAMERA_ESC.equals(camera)) {
 					((vt320) buffer).keyTyped(vt320.KEY_ESCAPE, ' ', 0);
 				} else if (PreferenceConstants.CAMERA_ESC_A.equals(camera)) {
 					((vt320) buffer).keyTyped(vt320.KEY_ESCAPE, ' ', 0);
-					bridge.transport.write('a');
+					bridge.sendInput('a');
 				}
 
 				break;
@@ -515,7 +515,7 @@ public class TerminalKeyListener implements OnKeyListener, OnSharedPreferenceCha
 
 	public void sendTab() {
 		try {
-			bridge.transport.write(0x09);
+			bridge.sendInput(0x09);
 		} catch (IOException e) {
 			Log.e(TAG, "Problem while trying to send TAB press.", e);
 			try {
@@ -18,29 +18,44 @@
 package org.connectbot.service;
 
 import java.io.IOException;
+import java.io.InterruptedIOException;
 import java.lang.ref.WeakReference;
 import java.security.KeyPair;
 import java.util.ArrayList;
 import java.util.Arrays;
+import java.util.Collection;
 import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
 import java.util.Map.Entry;
 import java.util.Timer;
 import java.util.TimerTask;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.ThreadFactory;
 
 import org.connectbot.R;
 import org.connectbot.bean.HostBean;
 import org.connectbot.bean.PubkeyBean;
 import org.connectbot.data.ColorStorage;
 import org.connectbot.data.HostStorage;
+import org.connectbot.transport.AbsTransport;
+import org.connectbot.transport.JumpHostPool;
+import org.connectbot.transport.PreConnector;
+import org.connectbot.transport.TmuxPane;
 import org.connectbot.transport.TransportFactory;
+import org.connectbot.util.DatabaseWriter;
 import org.connectbot.util.HostDatabase;
 import org.connectbot.util.PreferenceConstants;
 import org.connectbot.util.ProviderLoader;
 import org.connectbot.util.ProviderLoaderListener;
 import org.connectbot.util.PubkeyDatabase;
 import org.connectbot.util.PubkeyUtils;
+import org.connectbot.util.StartupTrace;
 
 import android.app.Service;
 import android.content.Context;
@@ -81,13 +96,40 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 
 	private final ArrayList<OnHostStatusChangedListener> hostStatusChangedListeners = new ArrayList<>();
 
-	public Map<String, KeyHolder> loadedKeypairs = new HashMap<>();
+	private final BroadcastGroup broadcastGroup = new BroadcastGroup();
+
+	public Map<String, KeyHolder> loadedKeypairs = new ConcurrentHashMap<>();
 
 	public Resources res;
 
-	public HostStorage hostdb;
-	public ColorStorage colordb;
-	public PubkeyDatabase pubkeydb;
+	/**
+	 * Runs the slow parts of service startup and media player changes so they
+	 * stay off the main thread. Tasks run in submission order.
+	 */
+	private ExecutorService backgroundExecutor;
+
+	private Future<HostDatabase> hostdbFuture;
+	private Future<PubkeyDatabase> pubkeydbFuture;
+	private Future<?> startupKeysFuture;
+
+	/** Runs batches of commands started with {@link #execOnBridges}. */
+	private ExecutorService execExecutor;
+
+	/** Interrupts commands from {@link #execOnBridges} that run past their deadline. */
+	private Timer execTimer;
+
+	/** Shared by all bridges to draw large repaints on several cores. */
+	private RowRenderPool rowRenderPool;
+
+	private final FrameScheduler frameScheduler = new FrameScheduler();
+
+	private final RendererCache rendererCache = new RendererCache();
+
+	/** Connections to jump hosts, shared by the bridges tunneled through them. */
+	private final JumpHostPool jumpHostPool = new JumpHostPool(this);
+
+	/** Connections opened ahead of time to the hosts likely to be opened next. */
+	private final PreConnector preConnector = new PreConnector(this);
 
 	protected SharedPreferences prefs;
 
@@ -95,7 +137,7 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 
 	private ConnectivityReceiver connectivityManager;
 
-	private MediaPlayer mediaPlayer;
+	private volatile MediaPlayer mediaPlayer;
 
 	private Timer pubkeyTimer;
 
@@ -108,9 +150,11 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 
 	private boolean wantBellVibration;
 
+	private volatile boolean wantNativeRenderer;
+
 	private boolean resizeAllowed = true;
 
-	private boolean savingKeys;
+	private volatile boolean savingKeys;
 
 	protected List<WeakReference<TerminalBridge>> mPendingReconnect = new ArrayList<>();
 
@@ -119,6 +163,7 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 	@Override
 	public void onCreate() {
 		Log.i(TAG, "Starting service");
+		StartupTrace.start();
 
 		prefs = PreferenceManager.getDefaultSharedPreferences(this);
 		prefs.registerOnSharedPreferenceChangeListener(this);
@@ -127,28 +172,70 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 
 		pubkeyTimer = new Timer("pubkeyTimer", true);
 
-		hostdb = HostDatabase.get(this);
-		colordb = HostDatabase.get(this);
-		pubkeydb = PubkeyDatabase.get(this);
-
-		// load all marked pubkeys into memory
 		updateSavingKeys();
-		List<PubkeyBean> pubkeys = pubkeydb.getAllStartPubkeys();
 
-		for (PubkeyBean pubkey : pubkeys) {
-			try {
-				KeyPair pair = PubkeyUtils.convertToKeyPair(pubkey, null);
-				addKey(pubkey, pair);
-			} catch (Exception e) {
-				Log.d(TAG, String.format("Problem adding key '%s' to in-memory cache", pubkey.getNickname()), e);
+		backgroundExecutor = Executors.newSingleThreadExecutor(new ThreadFactory() {
+			@Override
+			public Thread newThread(Runnable r) {
+				Thread t = new Thread(r, "TerminalManagerStartup");
+				t.setDaemon(true);
+				return t;
 			}
-		}
+		});
+
+		// Everything that touches the disk is staged on the background
+		// executor. Consumers wait only on the stage they need through
+		// getHostStorage(), getPubkeyDatabase() and awaitStartupKeys().
+		hostdbFuture = backgroundExecutor.submit(new Callable<HostDatabase>() {
+			@Override
+			public HostDatabase call() {
+				StartupTrace.beginSection("HostDatabase.open");
+				try {
+					return HostDatabase.get(TerminalManager.this);
+				} finally {
+					StartupTrace.endSection();
+				}
+			}
+		});
+
+		pubkeydbFuture = backgroundExecutor.submit(new Callable<PubkeyDatabase>() {
+			@Override
+			public PubkeyDatabase call() {
+				StartupTrace.beginSection("PubkeyDatabase.open");
+				try {
+					return PubkeyDatabase.get(TerminalManager.this);
+				} finally {
+					StartupTrace.endSection();
+					StartupTrace.mark(StartupTrace.DATABASES_READY);
+				}
+			}
+		});
+
+		// load all marked pubkeys into memory
+		startupKeysFuture = backgroundExecutor.submit(new Runnable() {
+			@Override
+			public void run() {
+				StartupTrace.beginSection("TerminalManager.loadStartPubkeys");
+				try {
+					loadStartPubkeys();
+				} finally {
+					StartupTrace.endSection();
+					StartupTrace.mark(StartupTrace.KEYS_READY);
+				}
+			}
+		});
 
 		vibrator = (Vibrator) getSystemService(Context.VIBRATOR_SERVICE);
 		wantKeyVibration = prefs.getBoolean(PreferenceConstants.BUMPY_ARROWS, true);
 
 		wantBellVibration = prefs.getBoolean(PreferenceConstants.BELL_VIBRATE, true);
-		enableMediaPlayer();
+		wantNativeRenderer = prefs.getBoolean(PreferenceConstants.NATIVE_RENDERER, false);
+		backgroundExecutor.execute(new Runnable() {
+			@Override
+			public void run() {
+				enableMediaPlayer();
+			}
+		});
 
 		hardKeyboardHidden = (res.getConfiguration().hardKeyboardHidden ==
 			Configuration.HARDKEYBOARDHIDDEN_YES);
@@ -164,14 +251,105 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 		savingKeys = prefs.getBoolean(PreferenceConstants.MEMKEYS, true);
 	}
 
+	/**
+	 * Decode every key marked for loading at startup into the in-memory cache.
+	 * Runs on {@link #backgroundExecutor}.
+	 */
+	private void loadStartPubkeys() {
+		List<PubkeyBean> pubkeys = getPubkeyDatabase().getAllStartPubkeys();
+
+		for (PubkeyBean pubkey : pubkeys) {
+			try {
+				KeyPair pair = PubkeyUtils.convertToKeyPair(pubkey, null);
+				addKey(pubkey, pair);
+			} catch (Exception e) {
+				Log.d(TAG, String.format("Problem adding key '%s' to in-memory cache", pubkey.getNickname()), e);
+			}
+		}
+	}
+
+	/**
+	 * @return host storage, waiting for it to be opened if startup has not
+	 *         reached that point yet
+	 */
+	public HostStorage getHostStorage() {
+		return awaitStartupStage(hostdbFuture);
+	}
+
+	/**
+	 * @return color storage, waiting for it to be opened if startup has not
+	 *         reached that point yet
+	 */
+	public ColorStorage getColorStorage() {
+		return awaitStartupStage(hostdbFuture);
+	}
+
+	/**
+	 * @return pubkey database, waiting for it to be opened if startup has not
+	 *         reached that point yet
+	 */
+	public PubkeyDatabase getPubkeyDatabase() {
+		return awaitStartupStage(pubkeydbFuture);
+	}
+
+	public JumpHostPool getJumpHostPool() {
+		return jumpHostPool;
+	}
+
+	public PreConnector getPreConnector() {
+		return preConnector;
+	}
+
+	/**
+	 * Start connecting to the hosts the user is likely to open next, if
+	 * they asked for that. Called whenever the host list is shown.
+	 */
+	public void preconnectLikelyHosts() {
+		if (prefs.getBoolean(PreferenceConstants.PRECONNECT, false))
+			preConnector.warmUp();
+	}
+
+	/**
+	 * Block until the keys marked for loading at startup are in
+	 * {@link #loadedKeypairs}. Should not be called from the main thread.
+	 */
+	public void awaitStartupKeys() {
+		awaitStartupStage(startupKeysFuture);
+	}
+
+	private static <T> T awaitStartupStage(Future<T> stage) {
+		boolean interrupted = false;
+		try {
+			while (true) {
+				try {
+					return stage.get();
+				} catch (InterruptedException e) {
+					interrupted = true;
+				}
+			}
+		} catch (ExecutionException e) {
+			throw new IllegalStateException("TerminalManager startup failed", e.getCause());
+		} finally {
+			if (interrupted)
+				Thread.currentThread().interrupt();
+		}
+	}
+
 	@Override
 	public void onDestroy() {
 		Log.i(TAG, "Destroying service");
 
+		// nothing may be handed to the executors shut down below anymore
+		prefs.unregisterOnSharedPreferenceChangeListener(this);
+
 		disconnectAll(true, false);
+		jumpHostPool.closeAll();
+		preConnector.closeAll();
+
+		// nothing queued for the databases may be lost with the process
+		DatabaseWriter.get().flush();
 
-		hostdb = null;
-		pubkeydb = null;
+		broadcastGroup.clear();
 
 		synchronized (this) {
 			if (idleTimer != null)
@@ -184,7 +362,25 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 
 		ConnectionNotifier.getInstance().hideRunningNotification(this);
 
-		disableMediaPlayer();
+		backgroundExecutor.execute(new Runnable() {
+			@Override
+			public void run() {
+				disableMediaPlayer();
+			}
+		});
+		backgroundExecutor.shutdown();
+		frameScheduler.quit();
+
+		synchronized (this) {
+			if (execExecutor != null)
+				execExecutor.shutdownNow();
+			if (execTimer != null)
+				execTimer.cancel();
+			if (rowRenderPool != null)
+				rowRenderPool.shutdown();
+		}
+
+		rendererCache.clear();
 	}
 
 	/**
@@ -249,6 +445,135 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 		return bridge;
 	}
 
+	/**
+	 * Open a terminal for one tmux pane driven through the control client
+	 * running on {@code gateway}. The pane only lives as long as the tmux
+	 * session, so its host is never saved.
+	 */
+	TerminalBridge openTmuxPane(TerminalBridge gateway, AbsTransport transport, String nickname) {
+		HostBean parent = gateway.host;
+		HostBean host = new HostBean(nickname, TmuxPane.getProtocolName(),
+				parent.getUsername(), parent.getHostname(), parent.getPort());
+		host.setColor(parent.getColor());
+		host.setEncoding(parent.getEncoding());
+		host.setDelKey(parent.getDelKey());
+		host.setFontSize(parent.getFontSize());
+		host.setQuickDisconnect(true);
+
+		TerminalBridge bridge = new TerminalBridge(this, host, false);
+		bridge.setOnDisconnectedListener(this);
+		bridge.startConnection(transport);
+
+		synchronized (bridges) {
+			bridges.add(bridge);
+			WeakReference<TerminalBridge> wr = new WeakReference<>(bridge);
+			mHostBridgeMap.put(bridge.host, wr);
+			mNicknameBridgeMap.put(bridge.host.getNickname(), wr);
+		}
+
+		notifyHostStatusChanged();
+
+		return bridge;
+	}
+
+	/**
+	 * Run {@code command} on each of {@code targets} at the same time, outside of
+	 * their terminal sessions. Each host gets its own channel and its own sinks
+	 * from {@code outputs}, so a slow host or sink does not hold up the others.
+	 * @param timeoutMillis how long the command may run on each host, or 0 for no limit;
+	 *        the transport is asked to stop at the deadline, and the thread running
+	 *        the command is interrupted then in case it does not
+	 * @return one future per target, in order, yielding the command's exit status;
+	 *         a host that ran out of time fails with an {@link InterruptedIOException}
+	 */
+	public List<Future<Integer>> execOnBridges(Collection<TerminalBridge> targets,
+			final String command, final ExecOutputProvider outputs, final long timeoutMillis) {
+		synchronized (this) {
+			if (execExecutor == null) {
+				execExecutor = Executors.newCachedThreadPool(new ThreadFactory() {
+					@Override
+					public Thread newThread(Runnable r) {
+						Thread t = new Thread(r, "Exec");
+						t.setDaemon(true);
+						return t;
+					}
+				});
+			}
+			if (execTimer == null && timeoutMillis > 0)
+				execTimer = new Timer("ExecDeadline", true);
+		}
+
+		List<Future<Integer>> results = new ArrayList<>(targets.size());
+		for (final TerminalBridge bridge : targets) {
+			results.add(execExecutor.submit(new Callable<Integer>() {
+				@Override
+				public Integer call() throws IOException {
+					if (timeoutMillis <= 0)
+						return bridge.exec(command, outputs.getStdout(bridge),
+								outputs.getStderr(bridge), 0);
+
+					ExecDeadline deadline = new ExecDeadline(Thread.currentThread());
+					execTimer.schedule(deadline, timeoutMillis);
+					try {
+						return bridge.exec(command, outputs.getStdout(bridge),
+								outputs.getStderr(bridge), timeoutMillis);
+					} catch (IOException e) {
+						if (deadline.finish())
+							throw timedOut(e);
+						throw e;
+					} finally {
+						deadline.finish();
+						// a deadline that fired just as the command ended
+						Thread.interrupted();
+					}
+				}
+
+				private InterruptedIOException timedOut(IOException cause) {
+					if (cause instanceof InterruptedIOException)
+						return (InterruptedIOException) cause;
+
+					InterruptedIOException e = new InterruptedIOException(
+							"Command timed out after " + timeoutMillis + " ms");
+					e.initCause(cause);
+					return e;
+				}
+			}));
+		}
+		return results;
+	}
+
+	/**
+	 * Interrupts the thread running one command of {@link #execOnBridges}
+	 * once its time is up, unless the command has finished by then.
+	 */
+	private static class ExecDeadline extends TimerTask {
+		private final Thread worker;
+		private boolean finished;
+		private boolean fired;
+
+		ExecDeadline(Thread worker) {
+			this.worker = worker;
+		}
+
+		@Override
+		public synchronized void run() {
+			if (finished)
+				return;
+			fired = true;
+			worker.interrupt();
+		}
+
+		/**
+		 * Stop the deadline from firing later.
+		 * @return true if it has already fired
+		 */
+		synchronized boolean finish() {
+			finished = true;
+			cancel();
+			return fired;
+		}
+	}
+
 	public String getEmulation() {
 		return prefs.getString(PreferenceConstants.EMULATION, "xterm-256color");
 	}
@@ -267,7 +592,7 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 	 * format specified by an individual transport.
 	 */
 	public TerminalBridge openConnection(Uri uri) throws Exception {
-		HostBean host = TransportFactory.findHost(hostdb, uri);
+		HostBean host = TransportFactory.findHost(getHostStorage(), uri);
 
 		if (host == null)
 			host = TransportFactory.getTransport(uri.getScheme()).createHost(uri);
@@ -280,7 +605,7 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 	 * to {@link HostDatabase}.
 	 */
 	private void touchHost(HostBean host) {
-		hostdb.touchHost(host);
+		getHostStorage().touchHost(host);
 	}
 
 	/**
@@ -331,6 +656,8 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 			mHostBridgeMap.remove(bridge.host);
 			mNicknameBridgeMap.remove(bridge.host.getNickname());
 
+			broadcastGroup.remove(bridge);
+
 			if (bridge.isUsingNetwork()) {
 				connectivityManager.decRef();
 			}
@@ -471,6 +798,13 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 		return bridges;
 	}
 
+	/**
+	 * @return the group of bridges that input is currently broadcast to
+	 */
+	public BroadcastGroup getBroadcastGroup() {
+		return broadcastGroup;
+	}
+
 	@Override
 	public void onProviderLoaderSuccess() {
 		Log.d(TAG, "Installed crypto provider successfully");
@@ -556,38 +890,48 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 			vibrator.vibrate(VIBRATE_DURATION);
 	}
 
+	/**
+	 * Prepares the bell sound. Must run on {@link #backgroundExecutor}.
+	 */
 	private void enableMediaPlayer() {
-		mediaPlayer = new MediaPlayer();
+		MediaPlayer player = new MediaPlayer();
 
 		float volume = prefs.getFloat(PreferenceConstants.BELL_VOLUME,
 				PreferenceConstants.DEFAULT_BELL_VOLUME);
 
-		mediaPlayer.setAudioStreamType(AudioManager.STREAM_NOTIFICATION);
+		player.setAudioStreamType(AudioManager.STREAM_NOTIFICATION);
 
 		AssetFileDescriptor file = res.openRawResourceFd(R.raw.bell);
 		try {
-			mediaPlayer.setLooping(false);
-			mediaPlayer.setDataSource(file.getFileDescriptor(), file
+			player.setLooping(false);
+			player.setDataSource(file.getFileDescriptor(), file
 					.getStartOffset(), file.getLength());
 			file.close();
-			mediaPlayer.setVolume(volume, volume);
-			mediaPlayer.prepare();
+			player.setVolume(volume, volume);
+			player.prepare();
 		} catch (IOException e) {
 			Log.e(TAG, "Error setting up bell media player", e);
 		}
+
+		mediaPlayer = player;
 	}
 
+	/**
+	 * Releases the bell sound. Must run on {@link #backgroundExecutor}.
+	 */
 	private void disableMediaPlayer() {
-		if (mediaPlayer != null) {
-			mediaPlayer.release();
+		MediaPlayer player = mediaPlayer;
+		if (player != null) {
 			mediaPlayer = null;
+			player.release();
 		}
 	}
 
 	public void playBeep() {
-		if (mediaPlayer != null) {
-			mediaPlayer.seekTo(0);
-			mediaPlayer.start();
+		MediaPlayer player = mediaPlayer;
+		if (player != null) {
+			player.seekTo(0);
+			player.start();
 		}
 
 		if (wantBellVibration)
@@ -615,18 +959,24 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 	public void onSharedPreferenceChanged(SharedPreferences sharedPreferences,
 			String key) {
 		if (PreferenceConstants.BELL.equals(key)) {
-			boolean wantAudible = sharedPreferences.getBoolean(
+			final boolean wantAudible = sharedPreferences.getBoolean(
 					PreferenceConstants.BELL, true);
-			if (wantAudible && mediaPlayer == null)
-				enableMediaPlayer();
-			else if (!wantAudible && mediaPlayer != null)
-				disableMediaPlayer();
+			backgroundExecutor.execute(new Runnable() {
+				@Override
+				public void run() {
+					if (wantAudible && mediaPlayer == null)
+						enableMediaPlayer();
+					else if (!wantAudible && mediaPlayer != null)
+						disableMediaPlayer();
+				}
+			});
 		} else if (PreferenceConstants.BELL_VOLUME.equals(key)) {
-			if (mediaPlayer != null) {
+			MediaPlayer player = mediaPlayer;
+			if (player != null) {
 				float volume = sharedPreferences.getFloat(
 						PreferenceConstants.BELL_VOLUME,
 						PreferenceConstants.DEFAULT_BELL_VOLUME);
-				mediaPlayer.setVolume(volume, volume);
+				player.setVolume(volume, volume);
 			}
 		} else if (PreferenceConstants.BELL_VIBRATE.equals(key)) {
 			wantBellVibration = sharedPreferences.getBoolean(
@@ -639,6 +989,12 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 			connectivityManager.setWantWifiLock(lockingWifi);
 		} else if (PreferenceConstants.MEMKEYS.equals(key)) {
 			updateSavingKeys();
+		} else if (PreferenceConstants.NATIVE_RENDERER.equals(key)) {
+			wantNativeRenderer = sharedPreferences.getBoolean(
+					PreferenceConstants.NATIVE_RENDERER, false);
+		} else if (PreferenceConstants.PRECONNECT.equals(key)) {
+			if (!sharedPreferences.getBoolean(PreferenceConstants.PRECONNECT, false))
+				preConnector.closeAll();
 		}
 	}
 
@@ -654,6 +1010,33 @@ public class TerminalManager extends Service implements BridgeDisconnectedListen
 		return resizeAllowed;
 	}
 
+	/**
+	 * @return the render loop that repaints every visible terminal
+	 */
+	public FrameScheduler getFrameScheduler() {
+		return frameScheduler;
+	}
+
+	/**
+	 * @return glyph atlases shared between bridges with the same font
+	 */
+	public RendererCache getRendererCache() {
+		return rendererCache;
+	}
+
+	public synchronized RowRenderPool getRowRenderPool() {
+		if (rowRenderPool == null)
+			rowRenderPool = new RowRenderPool(RowRenderPool.getDefaultThreadCount());
+		return rowRenderPool;
+	}
+
+	/**
+	 * @return whether terminals should be drawn with {@link org.connectbot.util.NativeCellRenderer}
+	 */
+	public boolean isNativeRendererEnabled() {
+		return wantNativeRenderer;
+	}
+
 	public static class KeyHolder {
 		public PubkeyBean bean;
 		public KeyPair pair;
@@ -0,0 +1,598 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.io.IOException;
+import java.nio.charset.Charset;
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.Iterator;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+
+import org.connectbot.R;
+import org.connectbot.transport.TmuxPane;
+
+import android.os.Handler;
+import android.os.Looper;
+import android.util.Log;
+import androidx.annotation.VisibleForTesting;
+import de.mud.terminal.VDUBuffer;
+import de.mud.terminal.VDUDisplay;
+import de.mud.terminal.vt320;
+
+/**
+ * Client for tmux control mode ({@code tmux -CC}) running on a terminal's
+ * connection. Each tmux pane gets its own {@link TerminalBridge} over a
+ * {@link TmuxPane} transport: pane output is taken straight from the
+ * {@code %output} notifications instead of tmux redrawing a whole screen, so
+ * switching panes costs nothing on the wire and every pane keeps its own
+ * scrollback. History from before the pane was attached is only fetched
+ * once the user scrolls up to it.
+ *
+ * @author Kenny Root
+ */
+public class TmuxControlClient {
+	private static final String TAG = "CB.TmuxControl";
+
+	/** What tmux writes before the first notification in control mode. */
+	public static final String START = "\033P1000p";
+
+	private static final Charset UTF8 = Charset.forName("UTF-8");
+
+	private static final String PANE_FORMAT =
+			"#{pane_id} #{pane_width} #{pane_height} #{window_name}";
+
+	/** Bytes of input per send-keys command, to keep command lines short. */
+	private static final int SEND_KEYS_CHUNK = 256;
+
+	/** Handles the output of a command sent to tmux. */
+	interface Response {
+		void onResponse(List<String> lines, boolean error);
+	}
+
+	private static final Response IGNORE = new Response() {
+		@Override
+		public void onResponse(List<String> lines, boolean error) {
+			if (error && !lines.isEmpty())
+				Log.d(TAG, "tmux command failed: " + lines.get(0));
+		}
+	};
+
+	private static final class Pane {
+		final String id;
+		final TmuxPane transport;
+		int columns, rows;
+
+		/* output is dropped until the captured screen has been queued */
+		boolean seeding = true;
+		boolean historyRequested = false;
+
+		/* screenBase once the captured screen was written, to tell how much
+		 * of the local scrollback has arrived as output since */
+		int seedBase;
+
+		Pane(String id, TmuxPane transport) {
+			this.id = id;
+			this.transport = transport;
+		}
+	}
+
+	private final TerminalBridge gateway;
+	private final Handler handler;
+
+	private final StringBuilder line = new StringBuilder();
+
+	/* responses still expected, in the order the commands were sent */
+	private final ArrayDeque<Response> pending = new ArrayDeque<>();
+
+	/* command output being collected between %begin and %end */
+	private List<String> block;
+	private String blockGuard;
+	private boolean blockIsOurs;
+
+	private final Map<String, Pane> panes = new HashMap<>();
+
+	private boolean listing = false;
+	private boolean listAgain = false;
+
+	private int clientColumns = -1;
+	private int clientRows = -1;
+
+	private boolean exited = false;
+
+	public TmuxControlClient(TerminalBridge gateway) {
+		this.gateway = gateway;
+		handler = new Handler(Looper.getMainLooper());
+
+		notice(R.string.terminal_tmux_attached);
+		listPanes();
+	}
+
+	/**
+	 * Handle output of the connection while control mode is active.
+	 * @return how many chars were used; anything after is ordinary terminal
+	 *         output again because control mode has ended
+	 */
+	public int feed(char[] chars, int offset, int length) {
+		int end = offset + length;
+		for (int i = offset; i < end; i++) {
+			char c = chars[i];
+			if (c != '\n') {
+				line.append(c);
+				continue;
+			}
+
+			int len = line.length();
+			if (len > 0 && line.charAt(len - 1) == '\r')
+				line.setLength(len - 1);
+			String text = line.toString();
+			line.setLength(0);
+
+			handleLine(text);
+			if (exited)
+				return i + 1 - offset;
+		}
+		return length;
+	}
+
+	public boolean isExited() {
+		return exited;
+	}
+
+	/**
+	 * @return the transport of the pane tmux calls {@code paneId}, or
+	 *         {@code null} if there is no such pane
+	 */
+	@VisibleForTesting
+	TmuxPane getPane(String paneId) {
+		synchronized (panes) {
+			Pane pane = panes.get(paneId);
+			return pane != null ? pane.transport : null;
+		}
+	}
+
+	private void handleLine(String text) {
+		if (block != null) {
+			if (text.equals("%end" + blockGuard)) {
+				finishBlock(false);
+			} else if (text.equals("%error" + blockGuard)) {
+				finishBlock(true);
+			} else {
+				block.add(text);
+			}
+			return;
+		}
+
+		if (text.startsWith("%output ")) {
+			int space = text.indexOf(' ', 8);
+			if (space > 0)
+				output(text.substring(8, space), text, space + 1);
+		} else if (text.startsWith("%extended-output ")) {
+			int space = text.indexOf(' ', 17);
+			int data = text.indexOf(" : ", 17);
+			if (space > 0 && data > 0)
+				output(text.substring(17, space), text, data + 3);
+		} else if (text.startsWith("%begin ")) {
+			blockGuard = text.substring(6);
+			blockIsOurs = blockGuard.endsWith(" 1");
+			block = new ArrayList<>();
+		} else if (text.startsWith("%layout-change ")
+				|| text.startsWith("%window-add ")
+				|| text.startsWith("%window-close ")
+				|| text.startsWith("%session-changed ")) {
+			listPanes();
+		} else if (text.equals("%exit") || text.startsWith("%exit ")) {
+			close();
+		}
+		// everything else is of no interest here
+	}
+
+	private void finishBlock(boolean error) {
+		List<String> lines = block;
+		block = null;
+
+		// Blocks not flagged as ours answer commands tmux ran by itself.
+		if (!blockIsOurs)
+			return;
+
+		Response response;
+		synchronized (pending) {
+			response = pending.poll();
+		}
+		if (response != null)
+			response.onResponse(lines, error);
+	}
+
+	private void output(String paneId, String text, int start) {
+		Pane pane;
+		synchronized (panes) {
+			pane = panes.get(paneId);
+			if (pane == null || pane.seeding)
+				return;
+		}
+		pane.transport.receive(unescape(text, start));
+	}
+
+	/**
+	 * Turn the escaped text of an {@code %output} notification back into the
+	 * bytes the pane wrote. tmux writes control characters and backslashes as
+	 * three octal digits; everything else arrives as text.
+	 */
+	static byte[] unescape(String text, int start) {
+		int length = text.length();
+		byte[] out = new byte[(length - start) * 3];
+		int n = 0;
+		for (int i = start; i < length; i++) {
+			char c = text.charAt(i);
+			if (c == '\\' && i + 3 < length && isOctal(text, i + 1)) {
+				out[n++] = (byte) ((text.charAt(i + 1) - '0') << 6
+						| (text.charAt(i + 2) - '0') << 3
+						| (text.charAt(i + 3) - '0'));
+				i += 3;
+			} else if (c < 0x80) {
+				out[n++] = (byte) c;
+			} else if (c < 0x800) {
+				out[n++] = (byte) (0xc0 | c >> 6);
+				out[n++] = (byte) (0x80 | c & 0x3f);
+			} else if (Character.isHighSurrogate(c) && i + 1 < length
+					&& Character.isLowSurrogate(text.charAt(i + 1))) {
+				int cp = Character.toCodePoint(c, text.charAt(++i));
+				out[n++] = (byte) (0xf0 | cp >> 18);
+				out[n++] = (byte) (0x80 | cp >> 12 & 0x3f);
+				out[n++] = (byte) (0x80 | cp >> 6 & 0x3f);
+				out[n++] = (byte) (0x80 | cp & 0x3f);
+			} else {
+				out[n++] = (byte) (0xe0 | c >> 12);
+				out[n++] = (byte) (0x80 | c >> 6 & 0x3f);
+				out[n++] = (byte) (0x80 | c & 0x3f);
+			}
+		}
+		return Arrays.copyOf(out, n);
+	}
+
+	private static boolean isOctal(String text, int start) {
+		for (int i = start; i < start + 3; i++) {
+			char c = text.charAt(i);
+			if (c < '0' || c > '7')
+				return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Send a command line to tmux. One handler is needed for each command
+	 * on the line, in order.
+	 */
+	private void send(String command, Response... responses) {
+		byte[] data = (command + "\n").getBytes(UTF8);
+		synchronized (pending) {
+			if (exited || gateway.transport == null)
+				return;
+
+			Collections.addAll(pending, responses);
+			try {
+				gateway.transport.write(data);
+			} catch (IOException e) {
+				Log.e(TAG, "Couldn't send command to tmux", e);
+			}
+		}
+	}
+
+	private void listPanes() {
+		synchronized (panes) {
+			if (listing) {
+				listAgain = true;
+				return;
+			}
+			listing = true;
+		}
+
+		send("list-panes -s -F '" + PANE_FORMAT + "'", new Response() {
+			@Override
+			public void onResponse(List<String> lines, boolean error) {
+				boolean again;
+				synchronized (panes) {
+					listing = false;
+					again = listAgain;
+					listAgain = false;
+				}
+
+				if (!error)
+					updatePanes(lines);
+				if (again)
+					listPanes();
+			}
+		});
+	}
+
+	private void updatePanes(List<String> lines) {
+		Set<String> seen = new HashSet<>();
+		for (String text : lines) {
+			String[] fields = text.split(" ", 4);
+			if (fields.length < 3)
+				continue;
+
+			String id = fields[0];
+			int columns, rows;
+			try {
+				columns = Integer.parseInt(fields[1]);
+				rows = Integer.parseInt(fields[2]);
+			} catch (NumberFormatException e) {
+				continue;
+			}
+			seen.add(id);
+
+			Pane pane;
+			boolean created = false;
+			synchronized (panes) {
+				pane = panes.get(id);
+				if (pane == null) {
+					pane = new Pane(id, new TmuxPane(this, id));
+					panes.put(id, pane);
+					created = true;
+				}
+			}
+
+			if (created || pane.columns != columns || pane.rows != rows)
+				resizePane(pane, columns, rows);
+			if (created)
+				openPane(pane, fields.length > 3 ? fields[3] : "");
+		}
+
+		synchronized (panes) {
+			Iterator<Pane> it = panes.values().iterator();
+			while (it.hasNext()) {
+				Pane pane = it.next();
+				if (!seen.contains(pane.id)) {
+					it.remove();
+					pane.transport.remoteClosed();
+				}
+			}
+		}
+	}
+
+	private void resizePane(final Pane pane, final int columns, final int rows) {
+		pane.columns = columns;
+		pane.rows = rows;
+		pane.transport.post(new Runnable() {
+			@Override
+			public void run() {
+				pane.transport.getBridge().setRemoteSize(columns, rows);
+			}
+		});
+	}
+
+	private void openPane(final Pane pane, String windowName) {
+		// Both commands run back to back, so no output slips in between.
+		final int[] cursor = new int[2];
+		send("display-message -p -t " + pane.id + " '#{cursor_x} #{cursor_y}' ; "
+				+ "capture-pane -p -e -t " + pane.id,
+				new Response() {
+					@Override
+					public void onResponse(List<String> lines, boolean error) {
+						if (error || lines.isEmpty())
+							return;
+						String[] fields = lines.get(0).split(" ");
+						if (fields.length < 2)
+							return;
+						try {
+							cursor[0] = Integer.parseInt(fields[0]);
+							cursor[1] = Integer.parseInt(fields[1]);
+						} catch (NumberFormatException e) {
+							Log.d(TAG, "Unexpected cursor position " + lines.get(0));
+						}
+					}
+				},
+				new Response() {
+					@Override
+					public void onResponse(List<String> lines, boolean error) {
+						seed(pane, error ? Collections.<String>emptyList() : lines,
+								cursor[0], cursor[1]);
+					}
+				});
+
+		final TerminalManager manager = gateway.manager;
+		if (manager == null)
+			return;
+
+		final String nickname = String.format("%s: %s %s",
+				gateway.host.getNickname(), windowName, pane.id);
+		handler.post(new Runnable() {
+			@Override
+			public void run() {
+				manager.openTmuxPane(gateway, pane.transport, nickname);
+			}
+		});
+	}
+
+	/**
+	 * Start the pane's terminal from what tmux has on the screen right now.
+	 */
+	private void seed(final Pane pane, List<String> lines, int x, int y) {
+		StringBuilder screen = new StringBuilder("\033[H\033[2J");
+		for (int i = 0; i < lines.size(); i++) {
+			if (i > 0)
+				screen.append("\r\n");
+			screen.append(lines.get(i));
+		}
+		screen.append("\033[0m\033[").append(y + 1).append(';').append(x + 1).append('H');
+
+		synchronized (panes) {
+			pane.transport.receive(screen.toString().getBytes(UTF8));
+			pane.seeding = false;
+		}
+
+		pane.transport.post(new Runnable() {
+			@Override
+			public void run() {
+				pane.seedBase = pane.transport.getBridge().buffer.screenBase;
+			}
+		});
+	}
+
+	/**
+	 * Fetch the history tmux kept for a pane from before it was attached,
+	 * as much of it as fits into the local scrollback.
+	 */
+	public void requestHistory(String paneId) {
+		final Pane pane;
+		synchronized (panes) {
+			pane = panes.get(paneId);
+			if (pane == null || pane.seeding || pane.historyRequested)
+				return;
+			pane.historyRequested = true;
+		}
+
+		VDUBuffer buffer = pane.transport.getBridge().buffer;
+		int room = buffer.getMaxBufferSize() - buffer.getBufferSize();
+		if (room <= 0)
+			return;
+
+		// Also ask for the lines that came in as output since, as more may
+		// scroll by before the answer arrives; they get dropped then.
+		int scrolled = Math.max(0, buffer.screenBase - pane.seedBase);
+		send("capture-pane -p -e -t " + pane.id + " -S -" + (room + scrolled) + " -E -1",
+				new Response() {
+					@Override
+					public void onResponse(final List<String> lines, boolean error) {
+						if (error)
+							return;
+						pane.transport.post(new Runnable() {
+							@Override
+							public void run() {
+								insertHistory(pane, lines);
+							}
+						});
+					}
+				});
+	}
+
+	/**
+	 * Put fetched history above a pane's scrollback. Runs on the pane's relay
+	 * thread, so the buffer is in step with the output tmux had sent when it
+	 * answered.
+	 */
+	private void insertHistory(Pane pane, List<String> lines) {
+		TerminalBridge bridge = pane.transport.getBridge();
+		VDUBuffer buffer = bridge.buffer;
+
+		int count = lines.size() - Math.max(0, buffer.screenBase - pane.seedBase);
+		if (count <= 0)
+			return;
+
+		vt320 history = new vt320() {
+			@Override
+			public void write(byte[] b) {}
+			@Override
+			public void write(int b) {}
+			@Override
+			public void sendTelnetCommand(byte cmd) {}
+			@Override
+			public void setWindowSize(int c, int r) {}
+			@Override
+			public void debug(String s) {}
+		};
+		history.setDisplay(new VDUDisplay() {
+			@Override
+			public void redraw() {}
+			@Override
+			public void updateScrollBar() {}
+			@Override
+			public void setVDUBuffer(VDUBuffer buffer) {}
+			@Override
+			public VDUBuffer getVDUBuffer() { return null; }
+			@Override
+			public void setColor(int index, int red, int green, int blue) {}
+			@Override
+			public void resetColors() {}
+		});
+		history.setScreenSize(buffer.getColumns(), count, false);
+		for (int i = 0; i < count; i++) {
+			if (i > 0)
+				history.putString("\r\n");
+			history.putString(lines.get(i));
+		}
+
+		int added = buffer.insertHistory(history, history.screenBase, count);
+		pane.seedBase += added;
+		bridge.redraw();
+	}
+
+	/**
+	 * Type {@code data} into a pane.
+	 */
+	public void sendKeys(String paneId, byte[] data, int offset, int length) {
+		StringBuilder command = new StringBuilder();
+		for (int start = offset; start < offset + length; start += SEND_KEYS_CHUNK) {
+			command.setLength(0);
+			command.append("send-keys -t ").append(paneId).append(" -H");
+			int end = Math.min(offset + length, start + SEND_KEYS_CHUNK);
+			for (int i = start; i < end; i++)
+				command.append(' ').append(Integer.toHexString(data[i] & 0xff));
+			send(command.toString(), IGNORE);
+		}
+	}
+
+	public void killPane(String paneId) {
+		send("kill-pane -t " + paneId, IGNORE);
+	}
+
+	/**
+	 * Tell tmux how big the terminals showing its panes are.
+	 */
+	public void setClientSize(int columns, int rows) {
+		synchronized (pending) {
+			if (columns == clientColumns && rows == clientRows)
+				return;
+			clientColumns = columns;
+			clientRows = rows;
+		}
+		send("refresh-client -C " + columns + "," + rows, IGNORE);
+	}
+
+	/**
+	 * Control mode has ended, either by tmux or because the connection went
+	 * away. Every pane terminal closes with it.
+	 */
+	public void close() {
+		synchronized (pending) {
+			if (exited)
+				return;
+			exited = true;
+			pending.clear();
+		}
+
+		synchronized (panes) {
+			for (Pane pane : panes.values())
+				pane.transport.remoteClosed();
+			panes.clear();
+		}
+
+		notice(R.string.terminal_tmux_detached);
+	}
+
+	private void notice(int resId) {
+		if (gateway.manager != null)
+			((vt320) gateway.buffer).putString("\r\n" + gateway.manager.res.getString(resId) + "\r\n");
+	}
+}
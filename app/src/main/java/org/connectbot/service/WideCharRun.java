@@ -0,0 +1,85 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.connectbot.service;
+
+import android.graphics.Canvas;
+import android.graphics.Paint;
+
+/**
+ * Draws a run of full width (CJK) cells with a single text call. The
+ * buffer stores each wide character in its first cell followed by a
+ * padding cell, so the glyphs are gathered out of every other cell and
+ * placed two cells apart; the font's own advance for them is usually not
+ * exactly twice the cell width, so they cannot be drawn as one string.
+ *
+ * @author Kenny Root
+ */
+final class WideCharRun {
+	/** Scratch space per drawing thread since rows are painted in parallel. */
+	private static final ThreadLocal<WideCharRun> sScratch = new ThreadLocal<WideCharRun>() {
+		@Override
+		protected WideCharRun initialValue() {
+			return new WideCharRun();
+		}
+	};
+
+	char[] glyphs = new char[0];
+	float[] positions = new float[0];
+
+	/**
+	 * Collect the glyphs of {@code cells} cells starting at {@code start}
+	 * into {@link #glyphs} and their origins into {@link #positions}.
+	 *
+	 * @return the number of glyphs collected
+	 */
+	int gather(char[] line, int start, int cells, float x, float y, int charWidth) {
+		int count = (cells + 1) / 2;
+		if (glyphs.length < count) {
+			glyphs = new char[count];
+			positions = new float[count * 2];
+		}
+
+		for (int i = 0; i < count; i++) {
+			glyphs[i] = line[start + i * 2];
+			positions[i * 2] = x + i * 2 * charWidth;
+			positions[i * 2 + 1] = y;
+		}
+		return count;
+	}
+
+	/**
+	 * Draw the wide characters in {@code cells} cells of {@code line}
+	 * starting at {@code start}, with the first glyph's origin at
+	 * ({@code x}, {@code y}).
+	 */
+	@SuppressWarnings("deprecation")
+	static void draw(Canvas canvas, Paint paint, char[] line, int start, int cells,
+			float x, float y, int charWidth) {
+		WideCharRun run = sScratch.get();
+		int count = run.gather(line, start, cells, x, y, charWidth);
+
+		if (paint.isUnderlineText()) {
+			// drawPosText does not draw text decorations, so lay out each
+			// glyph by itself to keep the underline.
+			for (int i = 0; i < count; i++)
+				canvas.drawText(run.glyphs, i, 1, run.positions[i * 2], y, paint);
+		} else {
+			canvas.drawPosText(run.glyphs, 0, count, run.positions, paint);
+		}
+	}
+}
@@ -0,0 +1,290 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.io.BufferedOutputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileNotFoundException;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
+import java.util.Arrays;
+
+import org.connectbot.R;
+import org.connectbot.transport.AbsTransport;
+import org.connectbot.util.NativeZmodem;
+
+import android.database.Cursor;
+import android.net.Uri;
+import android.os.Environment;
+import android.os.ParcelFileDescriptor;
+import android.provider.OpenableColumns;
+import android.util.Log;
+import de.mud.terminal.vt320;
+
+/**
+ * Runs one ZMODEM session on the relay thread after {@link Relay} has seen
+ * rz or sz start on the remote host. Raw bytes go straight between the
+ * transport and {@link NativeZmodem} without passing through the charset
+ * decoder or the terminal emulator. Received files are saved to the app's
+ * downloads directory; files to send come from
+ * {@link TerminalBridge#sendFile(Uri)}.
+ *
+ * @author Kenny Root
+ */
+class ZmodemTransfer implements NativeZmodem.Host {
+	private static final String TAG = "CB.ZmodemTransfer";
+
+	private static final int BUFFER_SIZE = 16384;
+
+	private final TerminalBridge bridge;
+	private final AbsTransport transport;
+	private final vt320 buffer;
+
+	private File receiving;
+	private OutputStream receivingOut;
+	private long receivedBytes;
+
+	private String sendingName;
+	private ParcelFileDescriptor sendingFd;
+	private FileChannel sendingChannel;
+
+	ZmodemTransfer(TerminalBridge bridge, AbsTransport transport, vt320 buffer) {
+		this.bridge = bridge;
+		this.transport = transport;
+		this.buffer = buffer;
+	}
+
+	/**
+	 * Run the session to its end.
+	 *
+	 * @param input what followed {@link NativeZmodem#START} in the read that
+	 *              contained it
+	 * @return what the remote end sent after the session, for the terminal
+	 * @throws IOException when the connection fails
+	 */
+	byte[] run(byte[] input, int offset, int length) throws IOException {
+		NativeZmodem session = new NativeZmodem(this);
+		try {
+			session.feed(NativeZmodem.START, 0, NativeZmodem.START.length);
+
+			byte[] data = input;
+			byte[] readBuffer = new byte[BUFFER_SIZE];
+			while (true) {
+				int used = session.feed(data, offset, length);
+				while (!session.isFinished() && session.pump()) {
+					// keep the window full
+				}
+
+				if (session.isFinished()) {
+					if (!session.isSucceeded())
+						notice(R.string.terminal_zmodem_cancelled);
+					return Arrays.copyOfRange(data, offset + used, offset + length);
+				}
+
+				data = readBuffer;
+				offset = 0;
+				length = Math.max(0, transport.read(readBuffer, 0, readBuffer.length));
+			}
+		} finally {
+			session.destroy();
+			// Only left open if the connection failed mid-file.
+			closeReceived(false);
+			closeSent(false);
+		}
+	}
+
+	@Override
+	public void write(byte[] data) throws IOException {
+		transport.write(data);
+		transport.flush();
+	}
+
+	@Override
+	public boolean openReceived(String name, long size) {
+		File directory = bridge.manager.getExternalFilesDir(Environment.DIRECTORY_DOWNLOADS);
+		if (directory == null || (!directory.isDirectory() && !directory.mkdirs())) {
+			notice(R.string.terminal_zmodem_no_storage);
+			return false;
+		}
+
+		File file = uniqueFile(directory, safeName(name));
+		try {
+			receivingOut = new BufferedOutputStream(new FileOutputStream(file), BUFFER_SIZE);
+		} catch (FileNotFoundException e) {
+			Log.e(TAG, "Could not create " + file, e);
+			notice(R.string.terminal_zmodem_failed, name);
+			return false;
+		}
+
+		receiving = file;
+		receivedBytes = 0;
+		notice(R.string.terminal_zmodem_receiving, file.getName());
+		return true;
+	}
+
+	@Override
+	public boolean writeReceived(byte[] data, int length) {
+		try {
+			receivingOut.write(data, 0, length);
+			receivedBytes += length;
+			return true;
+		} catch (IOException e) {
+			Log.e(TAG, "Could not write to " + receiving, e);
+			return false;
+		}
+	}
+
+	@Override
+	public void closeReceived(boolean complete) {
+		if (receivingOut == null)
+			return;
+
+		try {
+			receivingOut.close();
+		} catch (IOException e) {
+			Log.e(TAG, "Could not close " + receiving, e);
+			complete = false;
+		}
+
+		if (complete) {
+			notice(R.string.terminal_zmodem_received, receiving.getPath(), receivedBytes);
+		} else {
+			// Don't leave half a file behind looking like the real thing.
+			receiving.delete();
+			notice(R.string.terminal_zmodem_failed, receiving.getName());
+		}
+		receivingOut = null;
+		receiving = null;
+	}
+
+	@Override
+	public String nextToSend() {
+		Uri uri;
+		while ((uri = bridge.pollUpload()) != null) {
+			try {
+				sendingFd = bridge.manager.getContentResolver().openFileDescriptor(uri, "r");
+			} catch (FileNotFoundException e) {
+				Log.e(TAG, "Could not open " + uri, e);
+			} catch (SecurityException e) {
+				Log.e(TAG, "Not allowed to open " + uri, e);
+			}
+
+			String name = safeName(displayName(uri));
+			if (sendingFd == null) {
+				notice(R.string.terminal_zmodem_failed, name);
+				continue;
+			}
+
+			sendingChannel = new FileInputStream(sendingFd.getFileDescriptor()).getChannel();
+			sendingName = name;
+			notice(R.string.terminal_zmodem_sending, name);
+			return name;
+		}
+		return null;
+	}
+
+	@Override
+	public long sizeToSend() {
+		return sendingFd == null ? -1 : sendingFd.getStatSize();
+	}
+
+	@Override
+	public int readToSend(long offset, byte[] data, int length) {
+		try {
+			// Positional reads, since the receiver may ask to resume anywhere.
+			int read = sendingChannel.read(ByteBuffer.wrap(data, 0, length), offset);
+			return read < 0 ? 0 : read;
+		} catch (IOException e) {
+			Log.e(TAG, "Could not read " + sendingName, e);
+			return -1;
+		}
+	}
+
+	@Override
+	public void closeSent(boolean complete) {
+		if (sendingFd == null)
+			return;
+
+		try {
+			sendingChannel.close();
+			sendingFd.close();
+		} catch (IOException e) {
+			Log.e(TAG, "Could not close " + sendingName, e);
+		}
+
+		notice(complete ? R.string.terminal_zmodem_sent : R.string.terminal_zmodem_failed,
+				sendingName);
+		sendingFd = null;
+		sendingChannel = null;
+		sendingName = null;
+	}
+
+	private String displayName(Uri uri) {
+		Cursor cursor = null;
+		try {
+			cursor = bridge.manager.getContentResolver().query(uri,
+					new String[] { OpenableColumns.DISPLAY_NAME }, null, null, null);
+			if (cursor != null && cursor.moveToFirst() && cursor.getString(0) != null)
+				return cursor.getString(0);
+		} catch (SecurityException e) {
+			Log.w(TAG, "Not allowed to query " + uri, e);
+		} finally {
+			if (cursor != null)
+				cursor.close();
+		}
+		return uri.getLastPathSegment();
+	}
+
+	private void notice(int resId, Object... args) {
+		buffer.putString("\r\n" + bridge.manager.res.getString(resId, args) + "\r\n");
+		bridge.redraw();
+	}
+
+	/**
+	 * Reduce a file name from the remote end to a harmless base name.
+	 */
+	static String safeName(String name) {
+		if (name == null)
+			return "file";
+
+		String base = name.substring(name.lastIndexOf('/') + 1)
+				.replaceAll("[^-_.+ A-Za-z0-9]", "_");
+		int start = 0;
+		while (start < base.length() && base.charAt(start) == '.')
+			start++;
+		base = base.substring(start).trim();
+		return base.length() == 0 ? "file" : base;
+	}
+
+	/**
+	 * @return {@code name} in {@code directory}, or the first of
+	 *         name-1.ext, name-2.ext, ... that does not exist yet
+	 */
+	static File uniqueFile(File directory, String name) {
+		File file = new File(directory, name);
+		int dot = name.lastIndexOf('.');
+		String stem = dot > 0 ? name.substring(0, dot) : name;
+		String extension = dot > 0 ? name.substring(dot) : "";
+		for (int i = 1; file.exists(); i++)
+			file = new File(directory, stem + "-" + i + extension);
+		return file;
+	}
+}
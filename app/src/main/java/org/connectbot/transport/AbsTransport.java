@@ -18,6 +18,8 @@
 package org.connectbot.transport;
 
 import java.io.IOException;
+import java.io.InterruptedIOException;
+import java.io.OutputStream;
 import java.util.List;
 import java.util.Map;
 
@@ -211,6 +213,42 @@ public abstract class AbsTransport {
 		return null;
 	}
 
+	/**
+	 * The user has scrolled to the top of the local scrollback. Transports that
+	 * keep history on the remote end can use this to fetch more of it.
+	 */
+	public void requestHistory() {
+		// do nothing
+	}
+
+	/**
+	 * Whether or not this transport can run commands outside of the terminal session.
+	 * @return true on ability to use {@link #exec(String, OutputStream, OutputStream, long)}
+	 */
+	public boolean canExec() {
+		return false;
+	}
+
+	/**
+	 * Runs {@code command} without a PTY and without passing its output through the
+	 * terminal emulator. Output is written to the given sinks as it arrives; the
+	 * transport does not read more from the remote side until a sink write returns,
+	 * so a slow sink pushes back on the command instead of buffering without bound.
+	 * Blocks until the command has finished or {@code timeoutMillis} has passed,
+	 * in which case the command is cancelled.
+	 * @param command command line to run
+	 * @param stdout sink for the command's standard output
+	 * @param stderr sink for the command's standard error
+	 * @param timeoutMillis how long the command may run, or 0 for no limit
+	 * @return exit status of the command, or -1 if it was not reported
+	 * @throws InterruptedIOException when the command ran out of time and was cancelled
+	 * @throws IOException when the command could not be run or a sink failed
+	 */
+	public int exec(String command, OutputStream stdout, OutputStream stderr, long timeoutMillis)
+			throws IOException {
+		throw new UnsupportedOperationException("exec is not supported by this transport");
+	}
+
 	public abstract boolean isConnected();
 	public abstract boolean isSessionOpen();
 
@@ -0,0 +1,181 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.transport;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Decides when bulk channels (port forwards) may send on an SSH connection
+ * that they share with an interactive shell session.
+ * <p>
+ * The interactive session always goes first: after every keystroke written
+ * to the session, bulk channels hold off for {@link #INTERACTIVE_HOLD_MILLIS}
+ * so the keystroke and its echo are not queued behind forward traffic. Bulk
+ * channels are served by deficit round-robin in chunks of at most
+ * {@link #QUANTUM} bytes, so one busy forward cannot starve another.
+ *
+ * @author Kenny Root
+ */
+public class ChannelScheduler {
+	/** How long bulk channels yield after interactive input. */
+	static final long INTERACTIVE_HOLD_MILLIS = 40;
+
+	/** Bytes each bulk channel may send per round. */
+	static final int QUANTUM = 8192;
+
+	/**
+	 * Where the scheduler gets the time and how it waits for it to pass.
+	 */
+	interface Clock {
+		long nanoTime();
+
+		/**
+		 * Wait on {@code lock}, which the caller holds, for at most {@code nanos}.
+		 */
+		void waitNanos(Object lock, long nanos) throws InterruptedException;
+	}
+
+	static final Clock SYSTEM_CLOCK = new Clock() {
+		@Override
+		public long nanoTime() {
+			return System.nanoTime();
+		}
+
+		@Override
+		public void waitNanos(Object lock, long nanos) throws InterruptedException {
+			long millis = TimeUnit.NANOSECONDS.toMillis(nanos);
+			lock.wait(millis, (int) (nanos - TimeUnit.MILLISECONDS.toNanos(millis)));
+		}
+	};
+
+	private final Clock clock;
+
+	private final Object lock = new Object();
+
+	private final List<BulkChannel> channels = new ArrayList<>();
+
+	private long interactiveUntilNanos;
+
+	/**
+	 * One bulk channel's share of the connection.
+	 */
+	public static final class BulkChannel {
+		private int deficit = QUANTUM;
+		private boolean waiting;
+
+		private BulkChannel() {
+		}
+	}
+
+	public ChannelScheduler() {
+		this(SYSTEM_CLOCK);
+	}
+
+	ChannelScheduler(Clock clock) {
+		this.clock = clock;
+	}
+
+	public BulkChannel register() {
+		BulkChannel channel = new BulkChannel();
+		synchronized (lock) {
+			channels.add(channel);
+		}
+		return channel;
+	}
+
+	public void unregister(BulkChannel channel) {
+		synchronized (lock) {
+			channels.remove(channel);
+			lock.notifyAll();
+		}
+	}
+
+	/**
+	 * Called before interactive session data is written to the connection.
+	 */
+	public void onInteractiveWrite() {
+		synchronized (lock) {
+			interactiveUntilNanos = clock.nanoTime()
+					+ TimeUnit.MILLISECONDS.toNanos(INTERACTIVE_HOLD_MILLIS);
+		}
+	}
+
+	/**
+	 * Wait until {@code channel} may send, then reserve part of {@code wanted}.
+	 * @return the number of bytes the caller may write now, between 1 and
+	 *         {@code min(wanted, QUANTUM)}
+	 */
+	public int acquire(BulkChannel channel, int wanted) throws InterruptedException {
+		synchronized (lock) {
+			channel.waiting = true;
+			try {
+				while (true) {
+					long now = clock.nanoTime();
+
+					long holdNanos = interactiveUntilNanos - now;
+					if (holdNanos > 0) {
+						waitNanos(holdNanos);
+						continue;
+					}
+
+					if (channel.deficit <= 0) {
+						if (!roundFinished()) {
+							lock.wait();
+							continue;
+						}
+						startNextRound();
+					}
+
+					int allowed = Math.min(Math.min(wanted, channel.deficit), QUANTUM);
+					channel.deficit -= allowed;
+					if (channel.deficit <= 0)
+						lock.notifyAll();
+
+					return allowed;
+				}
+			} finally {
+				channel.waiting = false;
+				// channels whose quantum is used up may be waiting for this one
+				if (channel.deficit > 0)
+					lock.notifyAll();
+			}
+		}
+	}
+
+	/**
+	 * @return true when every channel that wants to send has used up its quantum
+	 */
+	private boolean roundFinished() {
+		for (BulkChannel c : channels) {
+			if (c.waiting && c.deficit > 0)
+				return false;
+		}
+		return true;
+	}
+
+	private void startNextRound() {
+		for (BulkChannel c : channels)
+			c.deficit = Math.min(c.deficit + QUANTUM, QUANTUM);
+		lock.notifyAll();
+	}
+
+	private void waitNanos(long nanos) throws InterruptedException {
+		clock.waitNanos(lock, nanos);
+	}
+}
@@ -0,0 +1,278 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.transport;
+
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.net.Socket;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+
+import org.connectbot.bean.HostBean;
+import org.connectbot.data.HostStorage;
+import org.connectbot.service.TerminalBridge;
+import org.connectbot.service.TerminalManager;
+import org.connectbot.util.HostDatabase;
+
+import android.util.Log;
+import androidx.annotation.VisibleForTesting;
+
+import com.trilead.ssh2.Connection;
+import com.trilead.ssh2.LocalStreamForwarder;
+import com.trilead.ssh2.ProxyData;
+
+/**
+ * Shares one authenticated connection to each jump host among all the SSH
+ * connections tunneled through it, so opening several hosts behind the same
+ * bastion costs a single handshake with the bastion. Each tunneled
+ * connection holds a reference for as long as it is open, and the jump host
+ * connection is closed when the last one goes away.
+ *
+ * @author Kenny Root
+ */
+public class JumpHostPool {
+	private static final String TAG = "CB.JumpHostPool";
+
+	/** Longest chain of jump hosts that will be followed. */
+	static final int MAX_CHAIN_LENGTH = 8;
+
+	private final TerminalManager manager;
+
+	private final Map<Long, Entry> entries = new HashMap<>();
+
+	private static class Entry {
+		int references = 0;
+
+		/** Only replaced while holding the lock on this entry. */
+		volatile SSH transport;
+	}
+
+	public JumpHostPool(TerminalManager manager) {
+		this.manager = manager;
+	}
+
+	/**
+	 * Checks that following jump hosts from {@code host} ends at a host that
+	 * connects directly, without loops or missing hosts along the way.
+	 * @return true if {@code host} can be connected to
+	 */
+	static boolean isChainValid(HostStorage storage, HostBean host) {
+		Set<Long> seen = new HashSet<>();
+		seen.add(host.getId());
+
+		long jumpHostId = host.getJumpHostId();
+		while (jumpHostId != HostDatabase.JUMPHOSTID_NONE) {
+			if (!seen.add(jumpHostId) || seen.size() > MAX_CHAIN_LENGTH + 1)
+				return false;
+
+			HostBean jumpHost = storage.findHostById(jumpHostId);
+			if (jumpHost == null || !SSH.getProtocolName().equals(jumpHost.getProtocol()))
+				return false;
+
+			jumpHostId = jumpHost.getJumpHostId();
+		}
+
+		return true;
+	}
+
+	/**
+	 * Returns an authenticated connection to {@code jumpHost}, connecting to
+	 * it first if nothing is using it yet. Connections asking for the same
+	 * jump host at the same time wait for a single handshake. Messages and
+	 * prompts for the jump host are shown on {@code bridge}. Every non-null
+	 * result must be balanced by a call to {@link #release(HostBean)}.
+	 * @return the connection, or {@code null} if it could not be made
+	 */
+	Connection acquire(HostBean jumpHost, TerminalBridge bridge) {
+		Entry entry;
+		synchronized (entries) {
+			entry = entries.get(jumpHost.getId());
+			if (entry == null) {
+				entry = new Entry();
+				entries.put(jumpHost.getId(), entry);
+			}
+			entry.references++;
+		}
+
+		Connection connection = null;
+		synchronized (entry) {
+			SSH transport = entry.transport;
+			if (transport == null || !transport.isConnected() || !transport.isAuthenticated()) {
+				if (transport != null)
+					transport.close();
+
+				Log.d(TAG, "Connecting to jump host " + jumpHost.getNickname());
+				transport = createTransport(jumpHost, bridge);
+				entry.transport = transport;
+				transport.connect();
+			}
+
+			if (transport.isConnected() && transport.isAuthenticated())
+				connection = transport.getConnection();
+		}
+
+		if (connection == null)
+			release(jumpHost);
+
+		return connection;
+	}
+
+	/**
+	 * Creates the transport for a new connection to {@code jumpHost}.
+	 */
+	@VisibleForTesting
+	SSH createTransport(HostBean jumpHost, TerminalBridge bridge) {
+		return SSH.forJumpHost(jumpHost, bridge, manager);
+	}
+
+	/**
+	 * Gives up a reference taken by {@link #acquire(HostBean, TerminalBridge)}.
+	 */
+	void release(HostBean jumpHost) {
+		SSH transport;
+		synchronized (entries) {
+			Entry entry = entries.get(jumpHost.getId());
+			if (entry == null || --entry.references > 0)
+				return;
+
+			entries.remove(jumpHost.getId());
+			transport = entry.transport;
+		}
+
+		if (transport != null) {
+			Log.d(TAG, "Closing unused jump host " + jumpHost.getNickname());
+			transport.close();
+		}
+	}
+
+	/**
+	 * Closes every jump host connection, whether or not it is still in use.
+	 */
+	public void closeAll() {
+		List<Entry> toClose;
+		synchronized (entries) {
+			toClose = new ArrayList<>(entries.values());
+			entries.clear();
+		}
+
+		for (Entry entry : toClose) {
+			SSH transport = entry.transport;
+			if (transport != null)
+				transport.close();
+		}
+	}
+
+	/**
+	 * Opens the transport for a tunneled connection as a direct-tcpip channel
+	 * on the jump host connection.
+	 */
+	static class Tunnel implements ProxyData {
+		private final Connection jumpConnection;
+
+		Tunnel(Connection jumpConnection) {
+			this.jumpConnection = jumpConnection;
+		}
+
+		@Override
+		public Socket openConnection(String hostname, int port, int connectTimeout) throws IOException {
+			return new ChannelSocket(jumpConnection.createLocalStreamForwarder(hostname, port));
+		}
+	}
+
+	/**
+	 * Presents a forwarded channel as the socket the SSH transport reads
+	 * from and writes to. Socket options have no meaning for a channel and
+	 * are ignored.
+	 */
+	private static class ChannelSocket extends Socket {
+		private final LocalStreamForwarder channel;
+
+		private volatile boolean closed = false;
+
+		ChannelSocket(LocalStreamForwarder channel) {
+			this.channel = channel;
+		}
+
+		@Override
+		public InputStream getInputStream() throws IOException {
+			return channel.getInputStream();
+		}
+
+		@Override
+		public OutputStream getOutputStream() throws IOException {
+			return channel.getOutputStream();
+		}
+
+		@Override
+		public boolean isConnected() {
+			return true;
+		}
+
+		@Override
+		public boolean isClosed() {
+			return closed;
+		}
+
+		@Override
+		public synchronized void close() throws IOException {
+			if (closed)
+				return;
+			closed = true;
+			channel.close();
+		}
+
+		@Override
+		public void shutdownInput() {
+		}
+
+		@Override
+		public void shutdownOutput() {
+		}
+
+		@Override
+		public void setTcpNoDelay(boolean on) {
+		}
+
+		@Override
+		public boolean getTcpNoDelay() {
+			return true;
+		}
+
+		@Override
+		public void setKeepAlive(boolean on) {
+		}
+
+		@Override
+		public boolean getKeepAlive() {
+			return false;
+		}
+
+		@Override
+		public synchronized void setSoTimeout(int timeout) {
+		}
+
+		@Override
+		public synchronized int getSoTimeout() {
+			return 0;
+		}
+	}
+}
@@ -0,0 +1,450 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.transport;
+
+import java.io.IOException;
+import java.net.InetSocketAddress;
+import java.net.Socket;
+import java.util.Map;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.RejectedExecutionException;
+import java.util.concurrent.ThreadFactory;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.TimeoutException;
+
+import android.os.Build;
+import android.os.ParcelFileDescriptor;
+import android.system.ErrnoException;
+import android.system.Os;
+import android.system.OsConstants;
+import android.util.Log;
+
+import com.trilead.ssh2.ProxyData;
+
+/**
+ * Notices a connection that has silently died (NAT mapping expired, radio
+ * went to sleep) long before TCP gives up on it.
+ * <p>
+ * While the link is idle, a keepalive {@link Probe} is sent every
+ * {@link #getInterval()} milliseconds. Probes that get an answer feed a
+ * smoothed round-trip estimate, and a probe that is not answered within a
+ * few round-trips is reported to the {@link StallListener}. Typing on an
+ * idle link sends a probe straight away, so a dead link is found as soon
+ * as the user tries to use it.
+ * <p>
+ * Some protocols have no keepalive that gets an answer. Their probes are
+ * only written, and it is the socket's user timeout (see
+ * {@link #configureSocket}) that turns a probe the peer never acknowledged
+ * into an error; the transport passes that on with {@link #onSendTimedOut()}.
+ * <p>
+ * The interval adapts to the NAT in the path: it creeps up while probes
+ * keep succeeding, and drops below the idle time at which a stall was
+ * seen. The learned interval is remembered per host for the next
+ * connection.
+ *
+ * @author Kenny Root
+ */
+public class KeepaliveMonitor {
+	private static final String TAG = "CB.KeepaliveMonitor";
+
+	static final long DEFAULT_INTERVAL = 45 * 1000;
+	static final long MIN_INTERVAL = 10 * 1000;
+	static final long MAX_INTERVAL = 5 * 60 * 1000;
+
+	static final long MIN_STALL_TIMEOUT = 5 * 1000;
+	static final long MAX_STALL_TIMEOUT = 15 * 1000;
+
+	/** Socket-level timeout for unacknowledged data, in milliseconds. */
+	static final int TCP_USER_TIMEOUT_MILLIS = 10 * 1000;
+
+	/** Linux TCP_USER_TIMEOUT; not exposed through OsConstants. */
+	private static final int TCP_USER_TIMEOUT = 18;
+
+	private static final Map<String, Long> learnedIntervals = new ConcurrentHashMap<>();
+
+	/**
+	 * Sends one keepalive to the peer.
+	 */
+	public interface Probe {
+		/**
+		 * Blocks until the peer has answered, if the protocol lets it.
+		 * @return true if the call waited for an answer, false if the
+		 *         probe was only written
+		 */
+		boolean probe() throws IOException;
+	}
+
+	public interface StallListener {
+		/**
+		 * Called once, from the monitor thread, when the peer has stopped
+		 * answering.
+		 * @param silentMillis how long ago the peer was last heard from
+		 */
+		void onStall(long silentMillis);
+	}
+
+	private final String key;
+	private final Probe probe;
+	private final StallListener listener;
+
+	private final long minInterval;
+	private final long minStallTimeout;
+	private final long maxStallTimeout;
+
+	private final Object lock = new Object();
+
+	private final ExecutorService probeExecutor;
+
+	private Thread thread;
+	private boolean running;
+	private boolean probeRequested;
+
+	private long interval;
+	private long natTimeoutCeiling = Long.MAX_VALUE;
+
+	/** Last time the peer was heard from or a probe went out. */
+	private long lastActivity;
+
+	/** How long the link had been quiet when the last probe went out. */
+	private long lastProbeIdle;
+
+	/** Smoothed round-trip time and its variance, per RFC 6298. */
+	private long srtt = -1;
+	private long rttvar;
+
+	/**
+	 * @param key identifies the host so that the learned interval outlives
+	 *            this connection
+	 */
+	public KeepaliveMonitor(String key, Probe probe, StallListener listener) {
+		this(key, probe, listener, MIN_INTERVAL, DEFAULT_INTERVAL, MIN_STALL_TIMEOUT);
+	}
+
+	KeepaliveMonitor(String key, Probe probe, StallListener listener,
+			long minInterval, long initialInterval, long minStallTimeout) {
+		this.key = key;
+		this.probe = probe;
+		this.listener = listener;
+		this.minInterval = minInterval;
+		this.minStallTimeout = minStallTimeout;
+		this.maxStallTimeout = minStallTimeout * MAX_STALL_TIMEOUT / MIN_STALL_TIMEOUT;
+
+		Long learned = learnedIntervals.get(key);
+		interval = learned != null ? learned : initialInterval;
+
+		probeExecutor = Executors.newSingleThreadExecutor(new ThreadFactory() {
+			@Override
+			public Thread newThread(Runnable r) {
+				Thread t = new Thread(r, "KeepaliveProbe");
+				t.setDaemon(true);
+				return t;
+			}
+		});
+	}
+
+	public void start() {
+		synchronized (lock) {
+			if (running)
+				return;
+
+			running = true;
+			lastActivity = now();
+
+			thread = new Thread(new Runnable() {
+				@Override
+				public void run() {
+					monitor();
+				}
+			});
+			thread.setName("Keepalive");
+			thread.setDaemon(true);
+			thread.start();
+		}
+	}
+
+	public void stop() {
+		synchronized (lock) {
+			running = false;
+			lock.notifyAll();
+		}
+		probeExecutor.shutdownNow();
+	}
+
+	/**
+	 * Called by the transport whenever anything arrives from the peer.
+	 */
+	public void onDataReceived() {
+		synchronized (lock) {
+			lastActivity = now();
+			lastProbeIdle = 0;
+		}
+	}
+
+	/**
+	 * Called by the transport when the socket gave up on data the peer never
+	 * acknowledged, see {@link #isUserTimeout}. For probes that are only
+	 * written this is how a stall shows up, so it is reported like an
+	 * unanswered probe unless monitoring has already ended.
+	 */
+	public void onSendTimedOut() {
+		long silent;
+		synchronized (lock) {
+			if (!running)
+				return;
+			running = false;
+			lock.notifyAll();
+			onStallLocked(lastProbeIdle);
+			silent = now() - lastActivity;
+		}
+		probeExecutor.shutdownNow();
+
+		Log.d(TAG, "Data sent to " + key + " was never acknowledged");
+		listener.onStall(silent);
+	}
+
+	/**
+	 * Called by the transport when the user sends data. If the link has been
+	 * quiet for a while, check it right away rather than waiting for the
+	 * next keepalive.
+	 */
+	public void onDataSent() {
+		synchronized (lock) {
+			if (now() - lastActivity > getStallTimeoutLocked()) {
+				probeRequested = true;
+				lock.notifyAll();
+			}
+		}
+	}
+
+	public long getInterval() {
+		synchronized (lock) {
+			return interval;
+		}
+	}
+
+	/**
+	 * @return smoothed round-trip time in milliseconds, or -1 before the
+	 *         first answered probe
+	 */
+	public long getRoundTripTime() {
+		synchronized (lock) {
+			return srtt;
+		}
+	}
+
+	long getStallTimeout() {
+		synchronized (lock) {
+			return getStallTimeoutLocked();
+		}
+	}
+
+	private long getStallTimeoutLocked() {
+		if (srtt < 0)
+			return maxStallTimeout;
+
+		return Math.min(Math.max(minStallTimeout, 2 * (srtt + 4 * rttvar)), maxStallTimeout);
+	}
+
+	private void monitor() {
+		try {
+			while (true) {
+				long idle;
+				synchronized (lock) {
+					while (true) {
+						if (!running)
+							return;
+
+						idle = now() - lastActivity;
+						if (probeRequested || idle >= interval)
+							break;
+
+						lock.wait(interval - idle);
+					}
+					probeRequested = false;
+				}
+
+				if (!sendProbe(idle))
+					return;
+			}
+		} catch (InterruptedException e) {
+			// Stopped.
+		}
+	}
+
+	/**
+	 * @return false if the connection stalled and monitoring should end
+	 */
+	private boolean sendProbe(long idle) throws InterruptedException {
+		long timeout = getStallTimeout();
+		long sent = now();
+
+		Future<Boolean> result;
+		try {
+			result = probeExecutor.submit(new Callable<Boolean>() {
+				@Override
+				public Boolean call() throws IOException {
+					return probe.probe();
+				}
+			});
+		} catch (RejectedExecutionException e) {
+			return false;
+		}
+
+		try {
+			boolean answered = result.get(timeout, TimeUnit.MILLISECONDS);
+			onProbeSucceeded(idle, answered ? now() - sent : -1);
+			return true;
+		} catch (TimeoutException e) {
+			result.cancel(true);
+			Log.d(TAG, String.format("Keepalive to %s unanswered after %d ms", key, timeout));
+		} catch (ExecutionException e) {
+			Log.d(TAG, "Keepalive to " + key + " failed", e.getCause());
+		}
+
+		long silent;
+		synchronized (lock) {
+			if (!running)
+				return false;
+			running = false;
+			onStallLocked(idle);
+			silent = now() - lastActivity;
+		}
+
+		listener.onStall(silent);
+		return false;
+	}
+
+	private void onProbeSucceeded(long idle, long rtt) {
+		synchronized (lock) {
+			lastActivity = now();
+			lastProbeIdle = idle;
+
+			if (rtt >= 0) {
+				if (srtt < 0) {
+					srtt = rtt;
+					rttvar = rtt / 2;
+				} else {
+					rttvar = (3 * rttvar + Math.abs(srtt - rtt)) / 4;
+					srtt = (7 * srtt + rtt) / 8;
+				}
+			}
+
+			// The NAT mapping survived this much idle time, so probe a
+			// little less often, staying clear of any known timeout.
+			if (idle >= interval) {
+				long next = Math.min(interval * 5 / 4, MAX_INTERVAL);
+				if (natTimeoutCeiling != Long.MAX_VALUE)
+					next = Math.min(next, natTimeoutCeiling * 3 / 4);
+				setIntervalLocked(next);
+			}
+		}
+	}
+
+	private void onStallLocked(long idle) {
+		// The path went dead somewhere within this much idle time. If the
+		// next connection is quiet for as long again, probe before then.
+		if (idle >= minInterval) {
+			natTimeoutCeiling = Math.min(natTimeoutCeiling, idle);
+			setIntervalLocked(idle / 2);
+		}
+	}
+
+	private static long now() {
+		return TimeUnit.NANOSECONDS.toMillis(System.nanoTime());
+	}
+
+	private void setIntervalLocked(long next) {
+		interval = Math.max(minInterval, next);
+		learnedIntervals.put(key, interval);
+	}
+
+	/**
+	 * @return true if {@code e} is the error a socket set up with
+	 *         {@link #configureSocket} reports once the peer has not
+	 *         acknowledged data for {@link #TCP_USER_TIMEOUT_MILLIS}
+	 */
+	public static boolean isUserTimeout(IOException e) {
+		if (Build.VERSION.SDK_INT < Build.VERSION_CODES.LOLLIPOP)
+			return false;
+
+		for (Throwable t = e; t != null; t = t.getCause()) {
+			if (t instanceof ErrnoException && ((ErrnoException) t).errno == OsConstants.ETIMEDOUT)
+				return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Make writes on {@code socket} fail if the peer has not acknowledged
+	 * them within {@link #TCP_USER_TIMEOUT_MILLIS}, instead of the many
+	 * minutes TCP retransmission would otherwise take. Also turns on TCP
+	 * keepalives. Best effort; older platforms only get the latter.
+	 */
+	public static void configureSocket(Socket socket) {
+		try {
+			socket.setKeepAlive(true);
+		} catch (IOException e) {
+			Log.d(TAG, "Could not enable TCP keepalive", e);
+		}
+
+		if (Build.VERSION.SDK_INT < Build.VERSION_CODES.LOLLIPOP)
+			return;
+
+		ParcelFileDescriptor pfd = null;
+		try {
+			pfd = ParcelFileDescriptor.fromSocket(socket);
+			Os.setsockoptInt(pfd.getFileDescriptor(), OsConstants.IPPROTO_TCP,
+					TCP_USER_TIMEOUT, TCP_USER_TIMEOUT_MILLIS);
+		} catch (ErrnoException e) {
+			Log.d(TAG, "Could not set TCP user timeout", e);
+		} finally {
+			if (pfd != null) {
+				try {
+					pfd.close();
+				} catch (IOException e) {
+					// Only our duplicate of the descriptor is closed.
+				}
+			}
+		}
+	}
+
+	/**
+	 * Opens the plain TCP connection for an SSH {@link com.trilead.ssh2.Connection}
+	 * with {@link #configureSocket} applied. sshlib never hands out the socket
+	 * it makes by itself, so this is the only way to set it up.
+	 */
+	public static class DirectConnection implements ProxyData {
+		@Override
+		public Socket openConnection(String hostname, int port, int connectTimeout) throws IOException {
+			Socket socket = new Socket();
+			try {
+				socket.connect(new InetSocketAddress(hostname, port), connectTimeout);
+				socket.setTcpNoDelay(true);
+			} catch (IOException e) {
+				socket.close();
+				throw e;
+			}
+			configureSocket(socket);
+			return socket;
+		}
+	}
+}
@@ -21,6 +21,9 @@ import java.io.FileDescriptor;
 import java.io.FileInputStream;
 import java.io.FileOutputStream;
 import java.io.IOException;
+import java.io.InputStream;
+import java.io.InterruptedIOException;
+import java.io.OutputStream;
 import java.util.Map;
 
 import org.connectbot.R;
@@ -43,6 +46,9 @@ public class Local extends AbsTransport {
 	private static final String PROTOCOL = "local";
 
 	private static final String DEFAULT_URI = "local:#Local";
+
+	private static final String SHELL = "/system/bin/sh";
+	private static final int EXEC_BUFFER_SIZE = 32768;
 	private final Killer killer;
 
 	private FileDescriptor shellFd;
@@ -86,7 +92,7 @@ public class Local extends AbsTransport {
 		int[] pids = new int[1];
 
 		try {
-			shellFd = Exec.createSubprocess("/system/bin/sh", "-", null, pids);
+			shellFd = Exec.createSubprocess(SHELL, "-", null, pids);
 		} catch (Exception e) {
 			bridge.outputLine(manager.res.getString(R.string.local_shell_unavailable));
 			Log.e(TAG, "Cannot start local shell", e);
@@ -174,6 +180,112 @@ public class Local extends AbsTransport {
 			os.write(c);
 	}
 
+	@Override
+	public boolean canExec() {
+		return true;
+	}
+
+	/**
+	 * Runs {@code command} with {@code sh -c} connected to pipes rather than a PTY.
+	 * Standard error is drained on a second thread so neither pipe can fill up and
+	 * stall the command while the other is being read. A command that runs out
+	 * of time is killed, which closes its pipes and ends both pumps.
+	 */
+	@Override
+	public int exec(String command, OutputStream out, final OutputStream err,
+			final long timeoutMillis) throws IOException {
+		final int[] pids = new int[1];
+
+		FileDescriptor[] fds = Exec.createPipedSubprocess(SHELL, "-c", command, pids);
+		if (fds == null)
+			throw new IOException("Cannot start local command");
+
+		final boolean[] timedOut = new boolean[1];
+		Thread watchdog = null;
+		if (timeoutMillis > 0) {
+			watchdog = new Thread(new Runnable() {
+				@Override
+				public void run() {
+					try {
+						Thread.sleep(timeoutMillis);
+					} catch (InterruptedException e) {
+						return;
+					}
+					timedOut[0] = true;
+					killer.killProcess(pids[0]);
+				}
+			});
+			watchdog.setName("LocalExecWatchdog");
+			watchdog.setDaemon(true);
+			watchdog.start();
+		}
+
+		new FileOutputStream(fds[0]).close();
+
+		final FileInputStream execStderr = new FileInputStream(fds[2]);
+		final IOException[] stderrFailure = new IOException[1];
+		Thread stderrPump = new Thread(new Runnable() {
+			@Override
+			public void run() {
+				try {
+					pump(execStderr, err);
+				} catch (IOException e) {
+					stderrFailure[0] = e;
+				}
+			}
+		});
+		stderrPump.setName("LocalExecStderr");
+		stderrPump.setDaemon(true);
+		stderrPump.start();
+
+		IOException stdoutFailure = null;
+		try {
+			pump(new FileInputStream(fds[1]), out);
+		} catch (IOException e) {
+			// The command would block on a full pipe otherwise.
+			killer.killProcess(pids[0]);
+			stdoutFailure = e;
+		}
+
+		try {
+			stderrPump.join();
+			// The watchdog must be gone before waitFor lets the pid be reused.
+			if (watchdog != null) {
+				watchdog.interrupt();
+				watchdog.join();
+			}
+		} catch (InterruptedException e) {
+			Thread.currentThread().interrupt();
+		}
+
+		int exitStatus = Exec.waitFor(pids[0]);
+
+		if (timedOut[0])
+			throw new InterruptedIOException("Command timed out after " + timeoutMillis + " ms");
+
+		if (stdoutFailure != null)
+			throw stdoutFailure;
+
+		if (stderrFailure[0] != null)
+			throw stderrFailure[0];
+
+		return exitStatus;
+	}
+
+	private static void pump(InputStream in, OutputStream out) throws IOException {
+		byte[] buf = new byte[EXEC_BUFFER_SIZE];
+		try {
+			int n;
+			while ((n = in.read(buf)) >= 0) {
+				if (n > 0)
+					out.write(buf, 0, n);
+			}
+			out.flush();
+		} finally {
+			in.close();
+		}
+	}
+
 	public static Uri getUri(String input) {
 		Uri uri = Uri.parse(DEFAULT_URI);
 
@@ -0,0 +1,337 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.transport;
+
+import java.io.IOException;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Locale;
+import java.util.Map;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.Future;
+import java.util.concurrent.ScheduledExecutorService;
+import java.util.concurrent.ScheduledFuture;
+import java.util.concurrent.ScheduledThreadPoolExecutor;
+import java.util.concurrent.ThreadFactory;
+import java.util.concurrent.TimeUnit;
+
+import org.connectbot.bean.HostBean;
+import org.connectbot.data.HostStorage;
+import org.connectbot.service.TerminalManager;
+import org.connectbot.util.HostDatabase;
+
+import android.util.Log;
+
+import com.trilead.ssh2.Connection;
+import com.trilead.ssh2.ConnectionMonitor;
+import com.trilead.ssh2.ExtendedServerHostKeyVerifier;
+import com.trilead.ssh2.KnownHosts;
+
+/**
+ * Opens connections to the hosts the user is most likely to tap next, so
+ * that most of the work of connecting is done before they do. For each of
+ * the most recently used SSH hosts this resolves the name, opens the TCP
+ * connection and completes key exchange, then waits. Authentication is
+ * left to {@link SSH}, which takes the connection over with
+ * {@link #take(HostBean)} when the host is opened.
+ * <p>
+ * Only hosts whose key is already known are pre-connected, since nobody is
+ * there to answer a prompt. Connections that are not used within
+ * {@link #IDLE_TIMEOUT_MILLIS} are closed.
+ *
+ * @author Kenny Root
+ */
+public class PreConnector {
+	private static final String TAG = "CB.PreConnector";
+
+	/** How many hosts are connected to ahead of time. */
+	static final int MAX_HOSTS = 3;
+
+	/** Hosts not used for this long are not worth a connection. */
+	static final long RECENT_SECONDS = 14 * 24 * 60 * 60;
+
+	/** Kept under the two minutes servers usually allow before authentication. */
+	static final long IDLE_TIMEOUT_MILLIS = 60 * 1000;
+
+	private static final int CONNECT_TIMEOUT_MILLIS = 10 * 1000;
+	private static final int KEX_TIMEOUT_MILLIS = 15 * 1000;
+
+	private final TerminalManager manager;
+
+	/** Connections opened or being opened, by host ID. */
+	private final Map<Long, Warm> warm = new HashMap<>();
+
+	private ScheduledExecutorService executor;
+
+	private static class Warm {
+		Future<Connection> connection;
+		ScheduledFuture<?> expiry;
+
+		/** Set once connected, guarded by this entry. */
+		Connection ready;
+
+		/** Set when nobody wants the connection any more, guarded by this entry. */
+		boolean abandoned;
+	}
+
+	public PreConnector(TerminalManager manager) {
+		this.manager = manager;
+	}
+
+	/**
+	 * Picks the hosts worth connecting to ahead of time from {@code recent},
+	 * which is ordered most recently used first.
+	 */
+	static List<HostBean> pickHosts(List<HostBean> recent, int max) {
+		List<HostBean> picked = new ArrayList<>();
+		for (HostBean host : recent) {
+			if (picked.size() >= max)
+				break;
+
+			// Jump hosts may need prompts, and other protocols have nothing to warm up.
+			if (!SSH.getProtocolName().equals(host.getProtocol())
+					|| host.getJumpHostId() != HostDatabase.JUMPHOSTID_NONE)
+				continue;
+
+			picked.add(host);
+		}
+		return picked;
+	}
+
+	/**
+	 * Starts connecting to the most likely hosts in the background. Hosts
+	 * that are already connected or being pre-connected are skipped, so this
+	 * may be called every time the host list is shown.
+	 */
+	public void warmUp() {
+		getExecutor().execute(new Runnable() {
+			@Override
+			public void run() {
+				long since = System.currentTimeMillis() / 1000 - RECENT_SECONDS;
+				List<HostBean> hosts = pickHosts(
+						manager.getHostStorage().getRecentHosts(since), MAX_HOSTS);
+
+				for (HostBean host : hosts) {
+					if (manager.getConnectedBridge(host) == null)
+						start(host);
+				}
+			}
+		});
+	}
+
+	private void start(final HostBean host) {
+		final Warm entry = new Warm();
+		synchronized (warm) {
+			if (warm.containsKey(host.getId()))
+				return;
+			warm.put(host.getId(), entry);
+
+			ScheduledExecutorService executor = getExecutor();
+			entry.connection = executor.submit(new Callable<Connection>() {
+				@Override
+				public Connection call() throws IOException {
+					return connect(host, entry);
+				}
+			});
+			entry.expiry = executor.schedule(new Runnable() {
+				@Override
+				public void run() {
+					if (remove(host.getId(), entry)) {
+						Log.d(TAG, "Closing unused connection to " + host.getNickname());
+						close(entry);
+					}
+				}
+			}, IDLE_TIMEOUT_MILLIS, TimeUnit.MILLISECONDS);
+		}
+	}
+
+	private Connection connect(HostBean host, final Warm entry) throws IOException {
+		final long hostId = host.getId();
+		long start = System.nanoTime();
+
+		Connection connection = new Connection(host.getHostname(), host.getPort());
+		connection.setProxyData(new KeepaliveMonitor.DirectConnection());
+		connection.setCompression(host.getCompression());
+		connection.addConnectionMonitor(new ConnectionMonitor() {
+			@Override
+			public void connectionLost(Throwable reason) {
+				remove(hostId, entry);
+			}
+		});
+
+		try {
+			connection.connect(new KnownHostsVerifier(manager.getHostStorage()),
+					CONNECT_TIMEOUT_MILLIS, KEX_TIMEOUT_MILLIS);
+		} catch (IOException e) {
+			Log.d(TAG, "Could not pre-connect to " + host.getNickname(), e);
+			remove(hostId, entry);
+			connection.close();
+			throw e;
+		}
+
+		synchronized (entry) {
+			if (entry.abandoned) {
+				connection.close();
+				throw new IOException("Pre-connection was no longer wanted");
+			}
+			entry.ready = connection;
+		}
+
+		Log.d(TAG, String.format(Locale.US, "Pre-connected to %s in %d ms",
+				host.getNickname(), (System.nanoTime() - start) / 1000000));
+		return connection;
+	}
+
+	/**
+	 * Hands over the pre-connected connection to {@code host}, waiting for
+	 * it if it is still being opened. The caller owns the connection and
+	 * still has to authenticate.
+	 * @return the connection, or {@code null} if there is none
+	 */
+	Connection take(HostBean host) {
+		Warm entry;
+		synchronized (warm) {
+			entry = warm.remove(host.getId());
+		}
+
+		if (entry == null)
+			return null;
+
+		entry.expiry.cancel(false);
+		return await(entry);
+	}
+
+	/**
+	 * Closes all pre-connected connections.
+	 */
+	public void closeAll() {
+		List<Warm> toClose;
+		synchronized (warm) {
+			toClose = new ArrayList<>(warm.values());
+			warm.clear();
+		}
+
+		for (Warm entry : toClose) {
+			entry.expiry.cancel(false);
+			close(entry);
+		}
+
+		synchronized (warm) {
+			if (executor != null) {
+				executor.shutdownNow();
+				executor = null;
+			}
+		}
+	}
+
+	private boolean remove(long hostId, Warm entry) {
+		synchronized (warm) {
+			if (warm.get(hostId) != entry)
+				return false;
+			warm.remove(hostId);
+			return true;
+		}
+	}
+
+	/**
+	 * Closes the connection of {@code entry}, or has it closed as soon as it
+	 * is made if it is still being opened.
+	 */
+	private static void close(Warm entry) {
+		Connection connection;
+		synchronized (entry) {
+			entry.abandoned = true;
+			connection = entry.ready;
+		}
+
+		if (connection != null)
+			connection.close();
+	}
+
+	private static Connection await(Warm entry) {
+		boolean interrupted = false;
+		try {
+			while (true) {
+				try {
+					return entry.connection.get();
+				} catch (InterruptedException e) {
+					interrupted = true;
+				}
+			}
+		} catch (ExecutionException e) {
+			return null;
+		} finally {
+			if (interrupted)
+				Thread.currentThread().interrupt();
+		}
+	}
+
+	private ScheduledExecutorService getExecutor() {
+		synchronized (warm) {
+			if (executor == null) {
+				executor = new ScheduledThreadPoolExecutor(MAX_HOSTS,
+						new ThreadFactory() {
+							@Override
+							public Thread newThread(Runnable r) {
+								Thread t = new Thread(r, "PreConnect");
+								t.setDaemon(true);
+								return t;
+							}
+						});
+			}
+			return executor;
+		}
+	}
+
+	/**
+	 * Accepts only host keys that are already known, since there is no
+	 * terminal to ask the user about a new or changed one. Such hosts are
+	 * simply connected to the usual way when opened.
+	 */
+	private static class KnownHostsVerifier extends ExtendedServerHostKeyVerifier {
+		private final HostStorage storage;
+
+		KnownHostsVerifier(HostStorage storage) {
+			this.storage = storage;
+		}
+
+		@Override
+		public boolean verifyServerHostKey(String hostname, int port,
+				String serverHostKeyAlgorithm, byte[] serverHostKey) throws IOException {
+			String matchName = String.format(Locale.US, "%s:%d", hostname, port);
+			return storage.getKnownHosts().verifyHostkey(matchName, serverHostKeyAlgorithm,
+					serverHostKey) == KnownHosts.HOSTKEY_IS_OK;
+		}
+
+		@Override
+		public List<String> getKnownKeyAlgorithmsForHost(String host, int port) {
+			return storage.getHostKeyAlgorithmsForHost(host, port);
+		}
+
+		@Override
+		public void removeServerHostKey(String host, int port, String algorithm, byte[] hostKey) {
+			storage.removeKnownHost(host, port, algorithm, hostKey);
+		}
+
+		@Override
+		public void addServerHostKey(String host, int port, String algorithm, byte[] hostKey) {
+			storage.saveKnownHost(host, port, algorithm, hostKey);
+		}
+	}
+}
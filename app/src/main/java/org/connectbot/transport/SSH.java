@@ -19,6 +19,7 @@ package org.connectbot.transport;
 
 import java.io.IOException;
 import java.io.InputStream;
+import java.io.InterruptedIOException;
 import java.io.OutputStream;
 import java.net.InetAddress;
 import java.net.InetSocketAddress;
@@ -59,6 +60,7 @@ import org.connectbot.util.PubkeyUtils;
 
 import android.content.Context;
 import android.net.Uri;
+import android.os.SystemClock;
 import android.util.Log;
 
 import com.trilead.ssh2.AuthAgentCallback;
@@ -70,7 +72,6 @@ import com.trilead.ssh2.DynamicPortForwarder;
 import com.trilead.ssh2.ExtendedServerHostKeyVerifier;
 import com.trilead.ssh2.InteractiveCallback;
 import com.trilead.ssh2.KnownHosts;
-import com.trilead.ssh2.LocalPortForwarder;
 import com.trilead.ssh2.Session;
 import com.trilead.ssh2.crypto.PEMDecoder;
 import com.trilead.ssh2.signature.DSASHA1Verify;
@@ -101,6 +102,18 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 		super(host, bridge, manager);
 	}
 
+	/**
+	 * Creates a transport that connects and authenticates to {@code jumpHost}
+	 * without opening a session, for {@link JumpHostPool} to share. Messages
+	 * and prompts go to {@code bridge}, the terminal that needed the jump host.
+	 */
+	static SSH forJumpHost(HostBean jumpHost, TerminalBridge bridge, TerminalManager manager) {
+		SSH ssh = new SSH(jumpHost, bridge, manager);
+		ssh.jumpHostOnly = true;
+		ssh.setCompression(jumpHost.getCompression());
+		return ssh;
+	}
+
 	private static final String PROTOCOL = "ssh";
 	private static final String TAG = "CB.SSH";
 	private static final int DEFAULT_PORT = 22;
@@ -134,8 +147,16 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 		| ChannelCondition.CLOSED
 		| ChannelCondition.EOF;
 
+	private static final int EXEC_BUFFER_SIZE = 32768;
+	private static final long EXIT_STATUS_TIMEOUT = 5000;
+
 	private List<PortForwardBean> portForwards = new ArrayList<>();
 
+	/** Gives the shell session priority over local port forwards. */
+	private final ChannelScheduler channelScheduler = new ChannelScheduler();
+
+	private volatile KeepaliveMonitor keepalive;
+
 	private int columns;
 	private int rows;
 
@@ -145,13 +166,19 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 	private String useAuthAgent = HostDatabase.AUTHAGENT_NO;
 	private String agentLockPassphrase;
 
+	/** Whether this only connects to a jump host for other connections to tunnel through. */
+	private boolean jumpHostOnly = false;
+
+	/** The jump host this connection is tunneled through, if any. */
+	private HostBean jumpHost;
+
 	public class HostKeyVerifier extends ExtendedServerHostKeyVerifier {
 		@Override
 		public boolean verifyServerHostKey(String hostname, int port,
 				String serverHostKeyAlgorithm, byte[] serverHostKey) throws IOException {
 
 			// read in all known hosts from hostdb
-			KnownHosts hosts = manager.hostdb.getKnownHosts();
+			KnownHosts hosts = manager.getHostStorage().getKnownHosts();
 			Boolean result;
 
 			String matchName = String.format(Locale.US, "%s:%d", hostname, port);
@@ -186,7 +213,7 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 				}
 				if (result) {
 					// save this key in known database
-					manager.hostdb.saveKnownHost(hostname, port, serverHostKeyAlgorithm, serverHostKey);
+					manager.getHostStorage().saveKnownHost(hostname, port, serverHostKeyAlgorithm, serverHostKey);
 				}
 				return result;
 
@@ -211,7 +238,7 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 				result = bridge.promptHelper.requestBooleanPrompt(null, manager.res.getString(R.string.prompt_continue_connecting));
 				if (result != null && result) {
 					// save this key in known database
-					manager.hostdb.saveKnownHost(hostname, port, serverHostKeyAlgorithm, serverHostKey);
+					manager.getHostStorage().saveKnownHost(hostname, port, serverHostKeyAlgorithm, serverHostKey);
 					return true;
 				} else {
 					return false;
@@ -225,17 +252,17 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 
 		@Override
 		public List<String> getKnownKeyAlgorithmsForHost(String host, int port) {
-			return manager.hostdb.getHostKeyAlgorithmsForHost(host, port);
+			return manager.getHostStorage().getHostKeyAlgorithmsForHost(host, port);
 		}
 
 		@Override
 		public void removeServerHostKey(String host, int port, String algorithm, byte[] hostKey) {
-			manager.hostdb.removeKnownHost(host, port, algorithm, hostKey);
+			manager.getHostStorage().removeKnownHost(host, port, algorithm, hostKey);
 		}
 
 		@Override
 		public void addServerHostKey(String host, int port, String algorithm, byte[] hostKey) {
-			manager.hostdb.saveKnownHost(host, port, algorithm, hostKey);
+			manager.getHostStorage().saveKnownHost(host, port, algorithm, hostKey);
 		}
 	}
 
@@ -261,6 +288,10 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 				// if explicit pubkey defined for this host, then prompt for password as needed
 				// otherwise just try all in-memory keys held in terminalmanager
 
+				// the startup keys are decoded in the background; wait for them here
+				// rather than holding up the whole service
+				manager.awaitStartupKeys();
+
 				if (pubkeyId == HostDatabase.PUBKEYID_ANY) {
 					// try each of the in-memory keys
 					bridge.outputLine(manager.res
@@ -279,7 +310,7 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 				} else {
 					bridge.outputLine(manager.res.getString(R.string.terminal_auth_pubkey_specific));
 					// use a specific key for this host, as requested
-					PubkeyBean pubkey = manager.pubkeydb.findPubkeyById(pubkeyId);
+					PubkeyBean pubkey = manager.getPubkeyDatabase().findPubkeyById(pubkeyId);
 
 					if (pubkey == null)
 						bridge.outputLine(manager.res.getString(R.string.terminal_auth_pubkey_invalid));
@@ -400,6 +431,11 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 	private void finishConnection() {
 		authenticated = true;
 
+		if (jumpHostOnly)
+			return;
+
+		startKeepalive();
+
 		for (PortForwardBean portForward : portForwards) {
 			try {
 				enablePortForward(portForward);
@@ -437,15 +473,86 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 
 	}
 
+	/**
+	 * Watch the connection with keepalive@openssh-style global requests so
+	 * a dead link is noticed within seconds.
+	 */
+	private void startKeepalive() {
+		final Connection conn = connection;
+		keepalive = new KeepaliveMonitor(host.getHostname() + ":" + host.getPort(),
+				new KeepaliveMonitor.Probe() {
+					@Override
+					public boolean probe() throws IOException {
+						conn.ping();
+						return true;
+					}
+				},
+				new KeepaliveMonitor.StallListener() {
+					@Override
+					public void onStall(long silentMillis) {
+						bridge.onConnectionStalled(silentMillis);
+					}
+				});
+		keepalive.start();
+	}
+
+	/**
+	 * Route {@link #connection} through a channel on the shared connection to
+	 * this host's jump host, connecting to the jump host first if needed.
+	 * @return false if the jump host could not be reached
+	 */
+	private boolean tunnelThroughJumpHost() {
+		HostBean jump = manager.getHostStorage().findHostById(host.getJumpHostId());
+
+		// The whole chain is checked once, by the connection the user opened.
+		if (jump == null || (!jumpHostOnly && !JumpHostPool.isChainValid(manager.getHostStorage(), host))) {
+			bridge.outputLine(manager.res.getString(R.string.terminal_jump_host_invalid));
+			return false;
+		}
+
+		bridge.outputLine(manager.res.getString(R.string.terminal_jump_host, jump.getNickname()));
+
+		Connection jumpConnection = manager.getJumpHostPool().acquire(jump, bridge);
+		if (jumpConnection == null) {
+			bridge.outputLine(manager.res.getString(R.string.terminal_jump_host_failed, jump.getNickname()));
+			return false;
+		}
+
+		synchronized (this) {
+			jumpHost = jump;
+		}
+		connection.setProxyData(new JumpHostPool.Tunnel(jumpConnection));
+		return true;
+	}
+
 	@Override
 	public void connect() {
-		connection = new Connection(host.getHostname(), host.getPort());
-		connection.addConnectionMonitor(this);
+		// A connection opened ahead of time has already done key exchange.
+		Connection preconnected = null;
+		if (!jumpHostOnly && host.getJumpHostId() == HostDatabase.JUMPHOSTID_NONE)
+			preconnected = manager.getPreConnector().take(host);
+
+		if (preconnected != null) {
+			connection = preconnected;
+			connection.addConnectionMonitor(this);
+			bridge.outputLine(manager.res.getString(R.string.terminal_preconnected));
+		} else {
+			connection = new Connection(host.getHostname(), host.getPort());
+			connection.addConnectionMonitor(this);
+
+			if (host.getJumpHostId() == HostDatabase.JUMPHOSTID_NONE) {
+				connection.setProxyData(new KeepaliveMonitor.DirectConnection());
+			} else if (!tunnelThroughJumpHost()) {
+				close();
+				onDisconnect();
+				return;
+			}
 
-		try {
-			connection.setCompression(compression);
-		} catch (IOException e) {
-			Log.e(TAG, "Could not enable compression!", e);
+			try {
+				connection.setCompression(compression);
+			} catch (IOException e) {
+				Log.e(TAG, "Could not enable compression!", e);
+			}
 		}
 
 		try {
@@ -460,7 +567,9 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 			Logger.enabled = true;
 			Logger.logger = logger;
 			*/
-			ConnectionInfo connectionInfo = connection.connect(new HostKeyVerifier());
+			ConnectionInfo connectionInfo = preconnected != null
+					? connection.getConnectionInfo()
+					: connection.connect(new HostKeyVerifier());
 			connected = true;
 
 			bridge.outputLine(manager.res.getString(R.string.terminal_kex_algorithm,
@@ -516,6 +625,21 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 	public void close() {
 		connected = false;
 
+		if (keepalive != null) {
+			keepalive.stop();
+			keepalive = null;
+		}
+
+		// Our local forwards own their listening sockets, so the connection
+		// closing won't take them down.
+		for (PortForwardBean portForward : portForwards) {
+			if (portForward.getIdentifier() instanceof ShapedLocalPortForwarder) {
+				((ShapedLocalPortForwarder) portForward.getIdentifier()).close();
+				portForward.setIdentifier(null);
+				portForward.setEnabled(false);
+			}
+		}
+
 		if (session != null) {
 			session.close();
 			session = null;
@@ -525,9 +649,23 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 			connection.close();
 			connection = null;
 		}
+
+		HostBean jump;
+		synchronized (this) {
+			jump = jumpHost;
+			jumpHost = null;
+		}
+		if (jump != null)
+			manager.getJumpHostPool().release(jump);
 	}
 
 	private void onDisconnect() {
+		// A jump host going away is noticed by the connections through it.
+		if (jumpHostOnly) {
+			connected = false;
+			return;
+		}
+
 		bridge.dispatchDisconnect(false);
 	}
 
@@ -548,6 +686,10 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 
 		if ((newConditions & ChannelCondition.STDOUT_DATA) != 0) {
 			bytesRead = stdout.read(buffer, start, len);
+
+			KeepaliveMonitor monitor = keepalive;
+			if (bytesRead > 0 && monitor != null)
+				monitor.onDataReceived();
 		}
 
 		if ((newConditions & ChannelCondition.STDERR_DATA) != 0) {
@@ -568,14 +710,93 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 
 	@Override
 	public void write(byte[] buffer) throws IOException {
-		if (stdin != null)
+		if (stdin != null) {
+			channelScheduler.onInteractiveWrite();
 			stdin.write(buffer);
+
+			KeepaliveMonitor monitor = keepalive;
+			if (monitor != null)
+				monitor.onDataSent();
+		}
 	}
 
 	@Override
 	public void write(int c) throws IOException {
-		if (stdin != null)
+		if (stdin != null) {
+			channelScheduler.onInteractiveWrite();
 			stdin.write(c);
+
+			KeepaliveMonitor monitor = keepalive;
+			if (monitor != null)
+				monitor.onDataSent();
+		}
+	}
+
+	@Override
+	public boolean canExec() {
+		return true;
+	}
+
+	/**
+	 * Runs {@code command} on its own exec channel of the existing connection.
+	 * No PTY is requested, so the output is exactly what the command wrote.
+	 * Closing the channel is how a command that runs out of time is cancelled.
+	 */
+	@Override
+	public int exec(String command, OutputStream out, OutputStream err, long timeoutMillis)
+			throws IOException {
+		Connection conn = connection;
+		if (!authenticated || conn == null)
+			throw new IOException("Not connected");
+
+		Session execSession = conn.openSession();
+		try {
+			execSession.execCommand(command);
+			execSession.getStdin().close();
+
+			InputStream execStdout = execSession.getStdout();
+			InputStream execStderr = execSession.getStderr();
+			byte[] buf = new byte[EXEC_BUFFER_SIZE];
+			long deadline = timeoutMillis > 0 ? SystemClock.elapsedRealtime() + timeoutMillis : 0;
+
+			while (true) {
+				long wait = 0;
+				if (deadline != 0) {
+					wait = deadline - SystemClock.elapsedRealtime();
+					if (wait <= 0)
+						throw new InterruptedIOException("Command timed out after " + timeoutMillis + " ms");
+				}
+
+				int newConditions = execSession.waitForCondition(conditions, wait);
+				if ((newConditions & ChannelCondition.TIMEOUT) != 0)
+					throw new InterruptedIOException("Command timed out after " + timeoutMillis + " ms");
+
+				if ((newConditions & ChannelCondition.STDOUT_DATA) != 0) {
+					int n = execStdout.read(buf);
+					if (n > 0)
+						out.write(buf, 0, n);
+				}
+
+				if ((newConditions & ChannelCondition.STDERR_DATA) != 0) {
+					int n = execStderr.read(buf);
+					if (n > 0)
+						err.write(buf, 0, n);
+				}
+
+				if ((newConditions & (ChannelCondition.STDOUT_DATA | ChannelCondition.STDERR_DATA)) == 0
+						&& (newConditions & (ChannelCondition.EOF | ChannelCondition.CLOSED)) != 0)
+					break;
+			}
+
+			out.flush();
+			err.flush();
+
+			execSession.waitForCondition(ChannelCondition.EXIT_STATUS, EXIT_STATUS_TIMEOUT);
+			Integer exitStatus = execSession.getExitStatus();
+			return exitStatus == null ? -1 : exitStatus;
+		} finally {
+			execSession.close();
+		}
 	}
 
 	@Override
@@ -607,6 +828,14 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 		return connected;
 	}
 
+	boolean isAuthenticated() {
+		return authenticated;
+	}
+
+	Connection getConnection() {
+		return connection;
+	}
+
 	@Override
 	public void connectionLost(Throwable reason) {
 		onDisconnect();
@@ -646,9 +875,9 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 			return false;
 
 		if (HostDatabase.PORTFORWARD_LOCAL.equals(portForward.getType())) {
-			LocalPortForwarder lpf = null;
+			ShapedLocalPortForwarder lpf = null;
 			try {
-				lpf = connection.createLocalPortForwarder(
+				lpf = new ShapedLocalPortForwarder(connection, channelScheduler,
 						new InetSocketAddress(InetAddress.getLocalHost(), portForward.getSourcePort()),
 						portForward.getDestAddr(), portForward.getDestPort());
 			} catch (Exception e) {
@@ -656,11 +885,6 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 				return false;
 			}
 
-			if (lpf == null) {
-				Log.e(TAG, "returned LocalPortForwarder object is null");
-				return false;
-			}
-
 			portForward.setIdentifier(lpf);
 			portForward.setEnabled(true);
 			return true;
@@ -706,8 +930,8 @@ public class SSH extends AbsTransport implements ConnectionMonitor, InteractiveC
 			return false;
 
 		if (HostDatabase.PORTFORWARD_LOCAL.equals(portForward.getType())) {
-			LocalPortForwarder lpf = null;
-			lpf = (LocalPortForwarder) portForward.getIdentifier();
+			ShapedLocalPortForwarder lpf = null;
+			lpf = (ShapedLocalPortForwarder) portForward.getIdentifier();
 
 			if (!portForward.isEnabled() || lpf == null) {
 				Log.d(TAG, String.format("Could not disable %s; it appears to be not enabled or have no handler", portForward.getNickname()));
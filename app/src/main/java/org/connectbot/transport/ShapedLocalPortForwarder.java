@@ -0,0 +1,210 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.transport;
+
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.net.InetSocketAddress;
+import java.net.ServerSocket;
+import java.net.Socket;
+import java.util.ArrayList;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Set;
+
+import android.util.Log;
+
+import com.trilead.ssh2.Connection;
+import com.trilead.ssh2.LocalStreamForwarder;
+
+/**
+ * Local port forward whose outbound data is paced by a {@link ChannelScheduler},
+ * so that traffic through the forward does not delay the interactive session
+ * sharing the same connection.
+ *
+ * @author Kenny Root
+ */
+class ShapedLocalPortForwarder implements Runnable {
+	private static final String TAG = "CB.ShapedLocalForward";
+
+	private static final int BUFFER_SIZE = 32768;
+
+	private final Connection connection;
+	private final ChannelScheduler scheduler;
+	private final String destHost;
+	private final int destPort;
+
+	private final ServerSocket serverSocket;
+
+	private final Set<ForwardedConnection> active = new HashSet<>();
+
+	private volatile boolean closed = false;
+
+	ShapedLocalPortForwarder(Connection connection, ChannelScheduler scheduler,
+			InetSocketAddress listenAddress, String destHost, int destPort) throws IOException {
+		this.connection = connection;
+		this.scheduler = scheduler;
+		this.destHost = destHost;
+		this.destPort = destPort;
+
+		serverSocket = new ServerSocket();
+		serverSocket.setReuseAddress(true);
+		serverSocket.bind(listenAddress);
+
+		Thread acceptThread = new Thread(this);
+		acceptThread.setName("LocalForwardAccept");
+		acceptThread.setDaemon(true);
+		acceptThread.start();
+	}
+
+	@Override
+	public void run() {
+		try {
+			while (!closed) {
+				Socket socket = serverSocket.accept();
+				ForwardedConnection fc = new ForwardedConnection(socket);
+				synchronized (active) {
+					if (closed) {
+						fc.close();
+						break;
+					}
+					active.add(fc);
+				}
+				fc.start();
+			}
+		} catch (IOException e) {
+			if (!closed)
+				Log.e(TAG, "Local port forward stopped accepting", e);
+		}
+	}
+
+	public void close() {
+		closed = true;
+
+		try {
+			serverSocket.close();
+		} catch (IOException e) {
+			Log.d(TAG, "Problem closing listening socket", e);
+		}
+
+		List<ForwardedConnection> toClose;
+		synchronized (active) {
+			toClose = new ArrayList<>(active);
+			active.clear();
+		}
+
+		for (ForwardedConnection fc : toClose)
+			fc.close();
+	}
+
+	private class ForwardedConnection implements Runnable {
+		private final Socket socket;
+		private volatile LocalStreamForwarder channel;
+
+		ForwardedConnection(Socket socket) {
+			this.socket = socket;
+		}
+
+		void start() {
+			Thread t = new Thread(this);
+			t.setName("LocalForwardUp");
+			t.setDaemon(true);
+			t.start();
+		}
+
+		/**
+		 * Opens the channel, starts the downstream copy, and then copies local
+		 * data upstream one scheduled chunk at a time.
+		 */
+		@Override
+		public void run() {
+			ChannelScheduler.BulkChannel share = scheduler.register();
+			try {
+				channel = connection.createLocalStreamForwarder(destHost, destPort);
+
+				final InputStream fromRemote = channel.getInputStream();
+				final OutputStream toLocal = socket.getOutputStream();
+				Thread down = new Thread(new Runnable() {
+					@Override
+					public void run() {
+						copyDown(fromRemote, toLocal);
+					}
+				});
+				down.setName("LocalForwardDown");
+				down.setDaemon(true);
+				down.start();
+
+				InputStream fromLocal = socket.getInputStream();
+				OutputStream toRemote = channel.getOutputStream();
+				byte[] buf = new byte[BUFFER_SIZE];
+				int n;
+				while ((n = fromLocal.read(buf)) >= 0) {
+					int off = 0;
+					while (off < n) {
+						int allowed = scheduler.acquire(share, n - off);
+						toRemote.write(buf, off, allowed);
+						off += allowed;
+					}
+				}
+			} catch (IOException e) {
+				if (!closed)
+					Log.d(TAG, "Forwarded connection closed", e);
+			} catch (InterruptedException e) {
+				Thread.currentThread().interrupt();
+			} finally {
+				scheduler.unregister(share);
+				close();
+			}
+		}
+
+		private void copyDown(InputStream in, OutputStream out) {
+			byte[] buf = new byte[BUFFER_SIZE];
+			try {
+				int n;
+				while ((n = in.read(buf)) >= 0) {
+					out.write(buf, 0, n);
+				}
+			} catch (IOException e) {
+				// connection is going away
+			} finally {
+				close();
+			}
+		}
+
+		void close() {
+			try {
+				socket.close();
+			} catch (IOException e) {
+				// ignore
+			}
+
+			LocalStreamForwarder c = channel;
+			if (c != null) {
+				try {
+					c.close();
+				} catch (IOException e) {
+					// ignore
+				}
+			}
+
+			synchronized (active) {
+				active.remove(this);
+			}
+		}
+	}
+}
@@ -56,6 +56,9 @@ public class Telnet extends AbsTransport {
 
 	private static final int DEFAULT_PORT = 23;
 
+	/** IAC NOP; the server does not answer it. */
+	private static final byte NOP = (byte) 241;
+
 	private TelnetProtocolHandler handler;
 	private Socket socket;
 
@@ -66,6 +69,8 @@ public class Telnet extends AbsTransport {
 
 	private boolean connected = false;
 
+	private volatile KeepaliveMonitor keepalive;
+
 	static final Pattern hostmask;
 	static {
 		hostmask = Pattern.compile("^([0-9a-z.-]+)(:(\\d+))?$", Pattern.CASE_INSENSITIVE);
@@ -139,18 +144,60 @@ public class Telnet extends AbsTransport {
 		throw new SocketTimeoutException("Could not connect; socket timed out");
 	}
 
+	/**
+	 * Telnet has no request that gets a reply, so the keepalive is a NOP
+	 * that is only written. It still gives TCP unacknowledged data to time
+	 * out on: if the peer has gone away, the socket's user timeout fails the
+	 * connection, which {@link #onSocketError} reports as a stall.
+	 */
+	private void startKeepalive() {
+		keepalive = new KeepaliveMonitor(host.getHostname() + ":" + host.getPort(),
+				new KeepaliveMonitor.Probe() {
+					@Override
+					public boolean probe() throws IOException {
+						handler.sendTelnetControl(NOP);
+						return false;
+					}
+				},
+				new KeepaliveMonitor.StallListener() {
+					@Override
+					public void onStall(long silentMillis) {
+						bridge.onConnectionStalled(silentMillis);
+					}
+				});
+		keepalive.start();
+	}
+
+	/**
+	 * Tell the keepalive monitor when the socket gave up on unacknowledged
+	 * data, so the user learns the link stalled rather than just that it
+	 * closed.
+	 * @return true if the error was reported as a stall
+	 */
+	private boolean onSocketError(IOException e) {
+		KeepaliveMonitor monitor = keepalive;
+		if (monitor == null || !KeepaliveMonitor.isUserTimeout(e))
+			return false;
+
+		monitor.onSendTimedOut();
+		return true;
+	}
+
 	@Override
 	public void connect() {
 		try {
 			socket = new Socket();
 
 			tryAllAddresses(socket, host.getHostname(), host.getPort());
+			KeepaliveMonitor.configureSocket(socket);
 
 			connected = true;
 
 			is = socket.getInputStream();
 			os = socket.getOutputStream();
 
+			startKeepalive();
+
 			bridge.onConnected();
 		} catch (UnknownHostException e) {
 			Log.d(TAG, "IO Exception connecting to host", e);
@@ -162,6 +209,11 @@ public class Telnet extends AbsTransport {
 	@Override
 	public void close() {
 		connected = false;
+
+		if (keepalive != null) {
+			keepalive.stop();
+			keepalive = null;
+		}
 		if (socket != null)
 			try {
 				socket.close();
@@ -208,12 +260,21 @@ public class Telnet extends AbsTransport {
 				if (n > 0)
 					return n;
 			} while (n == 0);
-			n = is.read(buffer, start, len);
+			try {
+				n = is.read(buffer, start, len);
+			} catch (IOException e) {
+				onSocketError(e);
+				throw e;
+			}
 			if (n < 0) {
 				bridge.dispatchDisconnect(false);
 				throw new IOException("Remote end closed connection.");
 			}
 
+			KeepaliveMonitor monitor = keepalive;
+			if (monitor != null)
+				monitor.onDataReceived();
+
 			handler.inputfeed(buffer, start, n);
 			n = handler.negotiate(buffer, start);
 		}
@@ -225,8 +286,13 @@ public class Telnet extends AbsTransport {
 		try {
 			if (os != null)
 				os.write(buffer);
+
+			KeepaliveMonitor monitor = keepalive;
+			if (monitor != null)
+				monitor.onDataSent();
 		} catch (SocketException e) {
-			bridge.dispatchDisconnect(false);
+			if (!onSocketError(e))
+				bridge.dispatchDisconnect(false);
 		}
 	}
 
@@ -235,8 +301,13 @@ public class Telnet extends AbsTransport {
 		try {
 			if (os != null)
 				os.write(c);
+
+			KeepaliveMonitor monitor = keepalive;
+			if (monitor != null)
+				monitor.onDataSent();
 		} catch (SocketException e) {
-			bridge.dispatchDisconnect(false);
+			if (!onSocketError(e))
+				bridge.dispatchDisconnect(false);
 		}
 	}
 
@@ -0,0 +1,226 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.transport;
+
+import java.io.IOException;
+import java.io.InterruptedIOException;
+import java.util.ArrayDeque;
+import java.util.Map;
+
+import org.connectbot.bean.HostBean;
+import org.connectbot.service.TerminalBridge;
+import org.connectbot.service.TmuxControlClient;
+
+import android.content.Context;
+import android.net.Uri;
+
+/**
+ * One pane of a tmux session attached in control mode. Output arrives from
+ * the {@link TmuxControlClient} reading the session's SSH channel, and input
+ * goes back through it as tmux commands; nothing here touches the network
+ * directly.
+ *
+ * @author Kenny Root
+ */
+public class TmuxPane extends AbsTransport {
+	private static final String PROTOCOL = "tmux";
+
+	private final TmuxControlClient client;
+	private final String paneId;
+
+	/* chunks of pane output, and tasks to run in order with it */
+	private final ArrayDeque<Object> queue = new ArrayDeque<>();
+	private byte[] chunk;
+	private int chunkOffset;
+
+	private boolean closed = false;
+
+	public TmuxPane(TmuxControlClient client, String paneId) {
+		this.client = client;
+		this.paneId = paneId;
+	}
+
+	public static String getProtocolName() {
+		return PROTOCOL;
+	}
+
+	public String getPaneId() {
+		return paneId;
+	}
+
+	public TerminalBridge getBridge() {
+		return bridge;
+	}
+
+	/**
+	 * Queue output from tmux for the terminal to read.
+	 */
+	public void receive(byte[] data) {
+		synchronized (queue) {
+			queue.add(data);
+			queue.notify();
+		}
+	}
+
+	/**
+	 * Run {@code task} on the terminal's relay thread once everything received
+	 * so far has been written to its buffer.
+	 */
+	public void post(Runnable task) {
+		synchronized (queue) {
+			queue.add(task);
+			queue.notify();
+		}
+	}
+
+	/**
+	 * tmux closed the pane or the control client went away.
+	 */
+	public void remoteClosed() {
+		synchronized (queue) {
+			closed = true;
+			queue.notify();
+		}
+	}
+
+	@Override
+	public void connect() {
+		bridge.onConnected();
+	}
+
+	@Override
+	public int read(byte[] buffer, int offset, int length) throws IOException {
+		Runnable task = null;
+
+		synchronized (queue) {
+			while (chunk == null && task == null) {
+				Object next = queue.poll();
+				if (next instanceof Runnable) {
+					task = (Runnable) next;
+				} else if (next != null) {
+					chunk = (byte[]) next;
+					chunkOffset = 0;
+				} else if (closed) {
+					break;
+				} else {
+					try {
+						queue.wait();
+					} catch (InterruptedException e) {
+						throw new InterruptedIOException();
+					}
+				}
+			}
+
+			if (chunk != null) {
+				int n = Math.min(length, chunk.length - chunkOffset);
+				System.arraycopy(chunk, chunkOffset, buffer, offset, n);
+				chunkOffset += n;
+				if (chunkOffset == chunk.length)
+					chunk = null;
+				return n;
+			}
+		}
+
+		if (task != null) {
+			task.run();
+			return 0;
+		}
+
+		bridge.dispatchDisconnect(false);
+		throw new IOException("tmux pane " + paneId + " closed");
+	}
+
+	@Override
+	public void write(byte[] buffer) throws IOException {
+		client.sendKeys(paneId, buffer, 0, buffer.length);
+	}
+
+	@Override
+	public void write(int c) throws IOException {
+		client.sendKeys(paneId, new byte[] {(byte) c}, 0, 1);
+	}
+
+	@Override
+	public void flush() throws IOException {
+	}
+
+	@Override
+	public void close() {
+		boolean wasOpen;
+		synchronized (queue) {
+			wasOpen = !closed;
+			closed = true;
+			queue.notify();
+		}
+
+		// Closing the terminal here closes the pane over there.
+		if (wasOpen)
+			client.killPane(paneId);
+	}
+
+	@Override
+	public void setDimensions(int columns, int rows, int width, int height) {
+		client.setClientSize(columns, rows);
+	}
+
+	@Override
+	public void requestHistory() {
+		client.requestHistory(paneId);
+	}
+
+	@Override
+	public boolean isConnected() {
+		synchronized (queue) {
+			return !closed;
+		}
+	}
+
+	@Override
+	public boolean isSessionOpen() {
+		return isConnected();
+	}
+
+	@Override
+	public int getDefaultPort() {
+		return 0;
+	}
+
+	@Override
+	public String getDefaultNickname(String username, String hostname, int port) {
+		return null;
+	}
+
+	@Override
+	public void getSelectionArgs(Uri uri, Map<String, String> selection) {
+		// panes are never looked up in the host database
+	}
+
+	@Override
+	public HostBean createHost(Uri uri) {
+		return null;
+	}
+
+	public static String getFormatHint(Context context) {
+		return "";
+	}
+
+	@Override
+	public boolean usesNetwork() {
+		// the session's own connection already accounts for the network
+		return false;
+	}
+}
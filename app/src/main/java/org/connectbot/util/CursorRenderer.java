@@ -0,0 +1,185 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import org.connectbot.service.TerminalKeyListener;
+
+import android.graphics.Bitmap;
+import android.graphics.Canvas;
+import android.graphics.ColorMatrix;
+import android.graphics.ColorMatrixColorFilter;
+import android.graphics.Matrix;
+import android.graphics.Paint;
+import android.graphics.Path;
+import android.graphics.Rect;
+import android.graphics.RectF;
+
+/**
+ * Draws the cursor, its modifier key indicators and the copy selection on
+ * top of a terminal's bitmap. This runs for every frame the cursor is
+ * visible, so nothing here allocates: the inverted cell is drawn straight
+ * from the terminal bitmap through a color filter rather than copied out
+ * first.
+ *
+ * @author Kenny Root
+ */
+public class CursorRenderer {
+	private static final Matrix.ScaleToFit scaleType = Matrix.ScaleToFit.FILL;
+
+	private final Paint cursorPaint;
+	private final Paint cursorStrokePaint;
+	private final Paint cursorInversionPaint;
+	private final Paint cursorMetaInversionPaint;
+
+	// Cursor paints to distinguish modes
+	private final Path ctrlCursor;
+	private final Path altCursor;
+	private final Path shiftCursor;
+	private final RectF tempSrc;
+	private final RectF tempDst;
+	private final Matrix scaleMatrix;
+
+	// the cell under the cursor in the terminal bitmap, and where it goes
+	private final Rect cellSrc = new Rect();
+	private final Rect cellDst = new Rect();
+
+	private final char[] singleDeadKey = new char[1];
+
+	public CursorRenderer(int color) {
+		cursorPaint = new Paint();
+		cursorPaint.setColor(color);
+		cursorPaint.setAntiAlias(true);
+
+		cursorInversionPaint = new Paint();
+		cursorInversionPaint.setColorFilter(new ColorMatrixColorFilter(new ColorMatrix(new float[] {
+				-1, 0, 0, 0, 255,
+				0, -1, 0, 0, 255,
+				0, 0, -1, 0, 255,
+				0, 0, 0, 1, 0
+		})));
+		cursorInversionPaint.setAntiAlias(true);
+
+		cursorMetaInversionPaint = new Paint();
+		cursorMetaInversionPaint.setColorFilter(
+				new ColorMatrixColorFilter(new ColorMatrix(new float[] {
+						-1f, 0, 0, 0, 255,
+						0, -1f, 0, 0, 255,
+						0, 0, -1f, 0, 255,
+						0, 0, 0, 0.5f, 0
+				})));
+		cursorMetaInversionPaint.setAntiAlias(true);
+
+		cursorStrokePaint = new Paint(cursorInversionPaint);
+		cursorStrokePaint.setStrokeWidth(0.1f);
+		cursorStrokePaint.setStyle(Paint.Style.STROKE);
+
+		/*
+		 * Set up our cursor indicators on a 1x1 Path object which we can later
+		 * transform to our character width and height
+		 */
+		// TODO make this into a resource somehow
+		shiftCursor = new Path();
+		shiftCursor.lineTo(0.5f, 0.33f);
+		shiftCursor.lineTo(1.0f, 0.0f);
+
+		altCursor = new Path();
+		altCursor.moveTo(0.0f, 1.0f);
+		altCursor.lineTo(0.5f, 0.66f);
+		altCursor.lineTo(1.0f, 1.0f);
+
+		ctrlCursor = new Path();
+		ctrlCursor.moveTo(0.0f, 0.25f);
+		ctrlCursor.lineTo(1.0f, 0.5f);
+		ctrlCursor.lineTo(0.0f, 0.75f);
+
+		// For creating the transform when the terminal resizes
+		tempSrc = new RectF();
+		tempSrc.set(0.0f, 0.0f, 1.0f, 1.0f);
+		tempDst = new RectF();
+		scaleMatrix = new Matrix();
+	}
+
+	/**
+	 * Scale the modifier indicators to a new character size.
+	 */
+	public void setCharSize(int charWidth, int charHeight) {
+		// Create a scale matrix to scale our 1x1 representation of the cursor
+		tempDst.set(0.0f, 0.0f, charWidth, charHeight);
+		scaleMatrix.setRectToRect(tempSrc, tempDst, scaleType);
+	}
+
+	/**
+	 * Draw the cursor over the cell at {@code x}, {@code y} of
+	 * {@code screen}, which has already been drawn to {@code canvas} at its
+	 * origin.
+	 * @param width width of the cell, two characters for a wide one
+	 * @param metaState modifier state from {@link TerminalKeyListener#getMetaState()}
+	 * @param deadKey pending dead key, or 0
+	 */
+	public void draw(Canvas canvas, Bitmap screen, int x, int y, int width, int height,
+			int metaState, int deadKey) {
+		// Save the current clip and translation
+		canvas.save();
+
+		canvas.translate(x, y);
+		canvas.clipRect(0, 0, width, height);
+
+		if (y + height < screen.getHeight()) {
+			cellSrc.set(x, y, x + width, y + height);
+			cellDst.set(0, 0, width, height);
+			canvas.drawBitmap(screen, cellSrc, cellDst,
+					metaState == 0 ? cursorInversionPaint : cursorMetaInversionPaint);
+		} else {
+			canvas.drawPaint(cursorPaint);
+		}
+		if (deadKey != 0) {
+			singleDeadKey[0] = (char) deadKey;
+			canvas.drawText(singleDeadKey, 0, 1, 0, 0, cursorStrokePaint);
+		}
+
+		// Make sure we scale our decorations to the correct size.
+		canvas.concat(scaleMatrix);
+
+		if ((metaState & TerminalKeyListener.OUR_SHIFT_ON) != 0)
+			canvas.drawPath(shiftCursor, cursorStrokePaint);
+		else if ((metaState & TerminalKeyListener.OUR_SHIFT_LOCK) != 0)
+			canvas.drawPath(shiftCursor, cursorInversionPaint);
+
+		if ((metaState & TerminalKeyListener.OUR_ALT_ON) != 0)
+			canvas.drawPath(altCursor, cursorStrokePaint);
+		else if ((metaState & TerminalKeyListener.OUR_ALT_LOCK) != 0)
+			canvas.drawPath(altCursor, cursorInversionPaint);
+
+		if ((metaState & TerminalKeyListener.OUR_CTRL_ON) != 0)
+			canvas.drawPath(ctrlCursor, cursorStrokePaint);
+		else if ((metaState & TerminalKeyListener.OUR_CTRL_LOCK) != 0)
+			canvas.drawPath(ctrlCursor, cursorInversionPaint);
+
+		// Restore previous clip region
+		canvas.restore();
+	}
+
+	/**
+	 * Highlight the selected area, given in pixels.
+	 */
+	public void drawSelection(Canvas canvas, int left, int top, int right, int bottom) {
+		canvas.save();
+		canvas.clipRect(left, top, right, bottom);
+		canvas.drawPaint(cursorPaint);
+		canvas.restore();
+	}
+}
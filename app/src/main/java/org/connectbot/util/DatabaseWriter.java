@@ -0,0 +1,204 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import java.util.ArrayList;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+import android.database.sqlite.SQLiteDatabase;
+import android.database.sqlite.SQLiteException;
+import android.os.Handler;
+import android.os.HandlerThread;
+import android.os.Process;
+import android.util.Log;
+
+/**
+ * Writes database updates that nobody waits for on a background thread,
+ * shared by {@link HostDatabase} and {@link PubkeyDatabase}.
+ * <p>
+ * Each write is queued under a key naming the row it changes. A later write
+ * with the same key replaces the queued one, so a burst of updates, such as
+ * zooming through several font sizes, only reaches SQLite once. Writes are
+ * collected for {@link #BATCH_DELAY_MILLIS} and then committed in one
+ * transaction per database, in the order they were queued.
+ * <p>
+ * Anything that reads the databases or changes them synchronously calls
+ * {@link #flush()} first, so queued writes are never lost or reordered from
+ * the point of view of the app.
+ *
+ * @author Kenny Root
+ */
+public final class DatabaseWriter {
+	private static final String TAG = "CB.DatabaseWriter";
+
+	/** How long writes are collected before they are committed. */
+	static final long BATCH_DELAY_MILLIS = 250;
+
+	/**
+	 * One queued change. Runs on the writer thread, or on a thread calling
+	 * {@link #flush()}, inside a transaction on {@code db}.
+	 */
+	public interface Write {
+		void apply(SQLiteDatabase db);
+	}
+
+	private static class Pending {
+		final SQLiteDatabase db;
+		final Write write;
+
+		Pending(SQLiteDatabase db, Write write) {
+			this.db = db;
+			this.write = write;
+		}
+	}
+
+	private static final Object sInstanceLock = new Object();
+
+	private static DatabaseWriter sInstance;
+
+	private final Object lock = new Object();
+
+	private LinkedHashMap<String, Pending> pending = new LinkedHashMap<>();
+
+	/** Whether a batch is being written right now. */
+	private boolean writing = false;
+
+	private boolean scheduled = false;
+
+	private Handler handler;
+
+	private final Runnable drain = new Runnable() {
+		@Override
+		public void run() {
+			synchronized (lock) {
+				scheduled = false;
+			}
+			flush();
+		}
+	};
+
+	public static DatabaseWriter get() {
+		synchronized (sInstanceLock) {
+			if (sInstance == null)
+				sInstance = new DatabaseWriter();
+			return sInstance;
+		}
+	}
+
+	private DatabaseWriter() {
+	}
+
+	/**
+	 * Queue {@code write} for {@code db}, replacing any queued write with the
+	 * same {@code key}. The write moves to the end of the queue, behind
+	 * everything queued before it.
+	 * @param key the table and row the write changes, and which columns if
+	 *        it does not write the whole row
+	 */
+	public void enqueue(SQLiteDatabase db, String key, Write write) {
+		synchronized (lock) {
+			pending.remove(key);
+			pending.put(key, new Pending(db, write));
+
+			if (!scheduled) {
+				scheduled = true;
+				if (handler == null) {
+					HandlerThread thread = new HandlerThread("DatabaseWriter",
+							Process.THREAD_PRIORITY_BACKGROUND);
+					thread.start();
+					handler = new Handler(thread.getLooper());
+				}
+				handler.postDelayed(drain, BATCH_DELAY_MILLIS);
+			}
+		}
+	}
+
+	/**
+	 * @return number of writes waiting in the queue
+	 */
+	public int getPendingCount() {
+		synchronized (lock) {
+			return pending.size();
+		}
+	}
+
+	/**
+	 * Commit everything queued so far before returning. Runs the writes on
+	 * the calling thread unless the writer thread already has them.
+	 */
+	public void flush() {
+		Map<String, Pending> batch;
+		synchronized (lock) {
+			while (writing) {
+				try {
+					lock.wait();
+				} catch (InterruptedException e) {
+					Thread.currentThread().interrupt();
+					return;
+				}
+			}
+
+			if (pending.isEmpty())
+				return;
+
+			batch = pending;
+			pending = new LinkedHashMap<>();
+			writing = true;
+		}
+
+		try {
+			write(batch);
+		} finally {
+			synchronized (lock) {
+				writing = false;
+				lock.notifyAll();
+			}
+		}
+	}
+
+	private static void write(Map<String, Pending> batch) {
+		// one transaction per database, each keeping the order of its writes
+		Map<SQLiteDatabase, List<Write>> byDatabase = new LinkedHashMap<>();
+		for (Pending p : batch.values()) {
+			List<Write> writes = byDatabase.get(p.db);
+			if (writes == null) {
+				writes = new ArrayList<>();
+				byDatabase.put(p.db, writes);
+			}
+			writes.add(p.write);
+		}
+
+		for (Map.Entry<SQLiteDatabase, List<Write>> entry : byDatabase.entrySet()) {
+			SQLiteDatabase db = entry.getKey();
+			db.beginTransaction();
+			try {
+				for (Write write : entry.getValue()) {
+					try {
+						write.apply(db);
+					} catch (SQLiteException e) {
+						Log.e(TAG, "Could not write to " + db.getPath(), e);
+					}
+				}
+				db.setTransactionSuccessful();
+			} finally {
+				db.endTransaction();
+			}
+		}
+	}
+}
@@ -52,7 +52,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 	public final static String TAG = "CB.HostDatabase";
 
 	public final static String DB_NAME = "hosts";
-	public final static int DB_VERSION = 25;
+	public final static int DB_VERSION = 26;
 
 	public final static String TABLE_HOSTS = "hosts";
 	public final static String FIELD_HOST_NICKNAME = "nickname";
@@ -73,6 +73,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 	public final static String FIELD_HOST_ENCODING = "encoding";
 	public final static String FIELD_HOST_STAYCONNECTED = "stayconnected";
 	public final static String FIELD_HOST_QUICKDISCONNECT = "quickdisconnect";
+	public final static String FIELD_HOST_JUMPHOSTID = "jumphostid";
 
 	public final static String TABLE_KNOWNHOSTS = "knownhosts";
 	public final static String FIELD_KNOWNHOSTS_HOSTID = "hostid";
@@ -121,10 +122,13 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 	public final static long PUBKEYID_NEVER = -2;
 	public final static long PUBKEYID_ANY = -1;
 
+	public final static long JUMPHOSTID_NONE = -1;
+
 	public static final int DEFAULT_COLOR_SCHEME = 0;
 
 	// Table creation strings
-	public static final String TABLE_HOSTS_COLUMNS = "_id INTEGER PRIMARY KEY, "
+	/** Columns of the hosts table as of version 25, used to rebuild it during that upgrade. */
+	private static final String TABLE_HOSTS_COLUMNS_V25 = "_id INTEGER PRIMARY KEY, "
 			+ FIELD_HOST_NICKNAME + " TEXT, "
 			+ FIELD_HOST_PROTOCOL + " TEXT DEFAULT 'ssh', "
 			+ FIELD_HOST_USERNAME + " TEXT, "
@@ -144,6 +148,9 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 			+ FIELD_HOST_STAYCONNECTED + " TEXT DEFAULT '" + false + "', "
 			+ FIELD_HOST_QUICKDISCONNECT + " TEXT DEFAULT '" + false + "'";
 
+	public static final String TABLE_HOSTS_COLUMNS = TABLE_HOSTS_COLUMNS_V25 + ", "
+			+ FIELD_HOST_JUMPHOSTID + " INTEGER DEFAULT " + JUMPHOSTID_NONE;
+
 	public static final String CREATE_TABLE_HOSTS = "CREATE TABLE " + TABLE_HOSTS
 			+ " (" + TABLE_HOSTS_COLUMNS + ")";
 
@@ -181,6 +188,8 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 
 	private final SQLiteDatabase mDb;
 
+	private final DatabaseWriter mWriter = DatabaseWriter.get();
+
 	public static HostDatabase get(Context context) {
 		synchronized (sInstanceLock) {
 			if (sInstance != null) {
@@ -200,7 +209,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 		super(context, dbName, null, DB_VERSION);
 
 		this.displayDensity = context.getResources().getDisplayMetrics().density;
-		mDb = getWritableDatabase();
+		mDb = openDatabase();
 	}
 
 	@Override
@@ -250,6 +259,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 	@Override
 	@VisibleForTesting
 	public void resetDatabase() {
+		mWriter.flush();
 		try {
 			mDb.beginTransaction();
 
@@ -373,7 +383,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 					+ " FROM " + TABLE_HOSTS);
 			// Work around SQLite not supporting dropping columns
 			db.execSQL("DROP TABLE IF EXISTS " + TABLE_HOSTS + "_upgrade");
-			db.execSQL("CREATE TABLE " + TABLE_HOSTS + "_upgrade (" + TABLE_HOSTS_COLUMNS + ")");
+			db.execSQL("CREATE TABLE " + TABLE_HOSTS + "_upgrade (" + TABLE_HOSTS_COLUMNS_V25 + ")");
 			db.execSQL("INSERT INTO " + TABLE_HOSTS + "_upgrade SELECT _id, "
 					+ FIELD_HOST_NICKNAME + ", "
 					+ FIELD_HOST_PROTOCOL + ", "
@@ -396,6 +406,10 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 					+ " FROM " + TABLE_HOSTS);
 			db.execSQL("DROP TABLE " + TABLE_HOSTS);
 			db.execSQL("ALTER TABLE " + TABLE_HOSTS + "_upgrade RENAME TO " + TABLE_HOSTS);
+			// fall through
+		case 25:
+			db.execSQL("ALTER TABLE " + TABLE_HOSTS
+					+ " ADD COLUMN " + FIELD_HOST_JUMPHOSTID + " INTEGER DEFAULT " + JUMPHOSTID_NONE);
 		}
 	}
 
@@ -411,13 +425,22 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 		ContentValues values = new ContentValues();
 		values.put(FIELD_HOST_LASTCONNECT, now);
 
-		mDb.beginTransaction();
-		try {
-			mDb.update(TABLE_HOSTS, values, "_id = ?", new String[] {String.valueOf(host.getId())});
-			mDb.setTransactionSuccessful();
-		} finally {
-			mDb.endTransaction();
-		}
+		updateLater(TABLE_HOSTS + "/" + host.getId() + "/" + FIELD_HOST_LASTCONNECT,
+				TABLE_HOSTS, values, "_id = ?", new String[] {String.valueOf(host.getId())});
+	}
+
+	/**
+	 * Queue an update with {@link DatabaseWriter}.
+	 * @param key the row and columns being changed
+	 */
+	private void updateLater(String key, final String table, final ContentValues values,
+			final String whereClause, final String[] whereArgs) {
+		mWriter.enqueue(mDb, key, new DatabaseWriter.Write() {
+			@Override
+			public void apply(SQLiteDatabase db) {
+				db.update(table, values, whereClause, whereArgs);
+			}
+		});
 	}
 
 	/**
@@ -427,13 +450,17 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 	public HostBean saveHost(HostBean host) {
 		long id = host.getId();
 
+		if (id != -1) {
+			updateLater(TABLE_HOSTS + "/" + id, TABLE_HOSTS, host.getValues(), "_id = ?",
+					new String[] {String.valueOf(id)});
+			return host;
+		}
+
+		// the caller needs the new id, so inserts cannot wait
+		mWriter.flush();
 		mDb.beginTransaction();
 		try {
-			if (id == -1) {
-				id = mDb.insert(TABLE_HOSTS, null, host.getValues());
-			} else {
-				mDb.update(TABLE_HOSTS, host.getValues(), "_id = ?", new String[] {String.valueOf(id)});
-			}
+			id = mDb.insert(TABLE_HOSTS, null, host.getValues());
 			mDb.setTransactionSuccessful();
 		} finally {
 			mDb.endTransaction();
@@ -454,10 +481,17 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 		}
 
 		String[] hostIdArg = new String[] {String.valueOf(host.getId())};
+		mWriter.flush();
 		mDb.beginTransaction();
 		try {
 			mDb.delete(TABLE_KNOWNHOSTS, FIELD_KNOWNHOSTS_HOSTID + " = ?", hostIdArg);
 			mDb.delete(TABLE_HOSTS, "_id = ?", hostIdArg);
+
+			// Hosts that jumped through this one now connect directly.
+			ContentValues values = new ContentValues();
+			values.put(FIELD_HOST_JUMPHOSTID, JUMPHOSTID_NONE);
+			mDb.update(TABLE_HOSTS, values, FIELD_HOST_JUMPHOSTID + " = ?", hostIdArg);
+
 			mDb.setTransactionSuccessful();
 		} finally {
 			mDb.endTransaction();
@@ -473,6 +507,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 		String sortField = sortColors ? FIELD_HOST_COLOR : FIELD_HOST_NICKNAME;
 		List<HostBean> hosts;
 
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_HOSTS, null, null, null, null, null, sortField + " ASC");
 
 		hosts = createHostBeans(c);
@@ -482,6 +517,21 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 		return hosts;
 	}
 
+	@Override
+	public List<HostBean> getRecentHosts(long since) {
+		List<HostBean> hosts;
+
+		mWriter.flush();
+		Cursor c = mDb.query(TABLE_HOSTS, null, FIELD_HOST_LASTCONNECT + " >= ?",
+				new String[] {String.valueOf(since)}, null, null, FIELD_HOST_LASTCONNECT + " DESC");
+
+		hosts = createHostBeans(c);
+
+		c.close();
+
+		return hosts;
+	}
+
 	/**
 	 * @param c cursor to read from
 	 */
@@ -506,7 +556,8 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 			COL_COMPRESSION = c.getColumnIndexOrThrow(FIELD_HOST_COMPRESSION),
 			COL_ENCODING = c.getColumnIndexOrThrow(FIELD_HOST_ENCODING),
 			COL_STAYCONNECTED = c.getColumnIndexOrThrow(FIELD_HOST_STAYCONNECTED),
-			COL_QUICKDISCONNECT = c.getColumnIndexOrThrow(FIELD_HOST_QUICKDISCONNECT);
+			COL_QUICKDISCONNECT = c.getColumnIndexOrThrow(FIELD_HOST_QUICKDISCONNECT),
+			COL_JUMPHOSTID = c.getColumnIndexOrThrow(FIELD_HOST_JUMPHOSTID);
 
 		while (c.moveToNext()) {
 			HostBean host = new HostBean();
@@ -530,6 +581,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 			host.setEncoding(c.getString(COL_ENCODING));
 			host.setStayConnected(Boolean.parseBoolean(c.getString(COL_STAYCONNECTED)));
 			host.setQuickDisconnect(Boolean.parseBoolean(c.getString(COL_QUICKDISCONNECT)));
+			host.setJumpHostId(c.getLong(COL_JUMPHOSTID));
 
 			hosts.add(host);
 		}
@@ -583,6 +635,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 		String[] selectionValues = new String[selectionValuesList.size()];
 		selectionValuesList.toArray(selectionValues);
 
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_HOSTS, null,
 				selectionBuilder.toString(),
 				selectionValues,
@@ -597,6 +650,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 	 */
 	@Override
 	public HostBean findHostById(long hostId) {
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_HOSTS, null,
 				"_id = ?", new String[] {String.valueOf(hostId)},
 				null, null, null);
@@ -624,22 +678,22 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 			return;
 		}
 
-		ContentValues values = new ContentValues();
+		final ContentValues values = new ContentValues();
 		values.put(FIELD_KNOWNHOSTS_HOSTKEYALGO, hostkeyalgo);
 		values.put(FIELD_KNOWNHOSTS_HOSTKEY, hostkey);
 		values.put(FIELD_KNOWNHOSTS_HOSTID, hostBean.getId());
 
-		mDb.beginTransaction();
-		try {
-			mDb.delete(TABLE_KNOWNHOSTS, FIELD_KNOWNHOSTS_HOSTID + " = ? AND "
-							+ FIELD_KNOWNHOSTS_HOSTKEYALGO + " = ?",
-					new String[] {String.valueOf(hostBean.getId()), hostkeyalgo});
-			mDb.insert(TABLE_KNOWNHOSTS, null, values);
-			mDb.setTransactionSuccessful();
-		} finally {
-			mDb.endTransaction();
-		}
-		Log.d(TAG, String.format("Finished saving hostkey information for '%s:%d' algo %s",
+		final String[] whereArgs = new String[] {String.valueOf(hostBean.getId()), hostkeyalgo};
+		mWriter.enqueue(mDb, TABLE_KNOWNHOSTS + "/" + hostBean.getId() + "/" + hostkeyalgo,
+				new DatabaseWriter.Write() {
+			@Override
+			public void apply(SQLiteDatabase db) {
+				db.delete(TABLE_KNOWNHOSTS, FIELD_KNOWNHOSTS_HOSTID + " = ? AND "
+						+ FIELD_KNOWNHOSTS_HOSTKEYALGO + " = ?", whereArgs);
+				db.insert(TABLE_KNOWNHOSTS, null, values);
+			}
+		});
+		Log.d(TAG, String.format("Queued hostkey information for '%s:%d' algo %s",
 				hostname, port, hostkeyalgo));
 	}
 
@@ -655,6 +709,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 	public KnownHosts getKnownHosts() {
 		KnownHosts known = new KnownHosts();
 
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_HOSTS + " LEFT OUTER JOIN " + TABLE_KNOWNHOSTS
 						+ " ON " + TABLE_HOSTS + "._id = "
 						+ TABLE_KNOWNHOSTS + "." + FIELD_KNOWNHOSTS_HOSTID,
@@ -704,6 +759,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 
 		ArrayList<String> knownAlgorithms = new ArrayList<>();
 
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_KNOWNHOSTS, new String[] {FIELD_KNOWNHOSTS_HOSTKEYALGO},
 				FIELD_KNOWNHOSTS_HOSTID + " = ?",
 				new String[] {String.valueOf(hostBean.getId())}, null, null, null);
@@ -734,6 +790,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 		ContentValues values = new ContentValues();
 		values.put(FIELD_HOST_PUBKEYID, PUBKEYID_ANY);
 
+		mWriter.flush();
 		mDb.beginTransaction();
 		try {
 			mDb.update(TABLE_HOSTS, values, FIELD_HOST_PUBKEYID + " = ?", new String[] {String.valueOf(pubkeyId)});
@@ -761,6 +818,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 			return portForwards;
 		}
 
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_PORTFORWARDS, new String[] {
 						"_id", FIELD_PORTFORWARD_NICKNAME, FIELD_PORTFORWARD_TYPE, FIELD_PORTFORWARD_SOURCEPORT,
 						FIELD_PORTFORWARD_DESTADDR, FIELD_PORTFORWARD_DESTPORT},
@@ -785,24 +843,27 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 	}
 
 	/**
-	 * Update the parameters of a port forward in the database.
+	 * Update the parameters of a port forward in the database. New port
+	 * forwards are inserted right away to get their id; changes to existing
+	 * ones are queued.
 	 * @param pfb {@link PortForwardBean} to save
 	 * @return true on success
 	 */
 	public boolean savePortForward(PortForwardBean pfb) {
+		if (pfb.getId() >= 0) {
+			updateLater(TABLE_PORTFORWARDS + "/" + pfb.getId(), TABLE_PORTFORWARDS,
+					pfb.getValues(), "_id = ?", new String[] {String.valueOf(pfb.getId())});
+			return true;
+		}
+
+		mWriter.flush();
 		mDb.beginTransaction();
 		try {
-			if (pfb.getId() < 0) {
-				long addedId = mDb.insert(TABLE_PORTFORWARDS, null, pfb.getValues());
-				if (addedId == -1) {
-					return false;
-				}
-				pfb.setId(addedId);
-			} else {
-				if (mDb.update(TABLE_PORTFORWARDS, pfb.getValues(), "_id = ?", new String[] {String.valueOf(pfb.getId())}) <= 0) {
-					return false;
-				}
+			long addedId = mDb.insert(TABLE_PORTFORWARDS, null, pfb.getValues());
+			if (addedId == -1) {
+				return false;
 			}
+			pfb.setId(addedId);
 
 			mDb.setTransactionSuccessful();
 			return true;
@@ -820,6 +881,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 			return;
 		}
 
+		mWriter.flush();
 		mDb.beginTransaction();
 		try {
 			mDb.delete(TABLE_PORTFORWARDS, "_id = ?", new String[] {String.valueOf(pfb.getId())});
@@ -833,6 +895,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 	public int[] getColorsForScheme(int scheme) {
 		int[] colors = Colors.defaults.clone();
 
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_COLORS, new String[] {
 						FIELD_COLOR_NUMBER, FIELD_COLOR_VALUE},
 				FIELD_COLOR_SCHEME + " = ?",
@@ -848,38 +911,31 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 		return colors;
 	}
 
-	public void setColorForScheme(int scheme, int number, int value) {
+	public void setColorForScheme(final int scheme, final int number, final int value) {
 
 		final String[] whereArgs = new String[] { String.valueOf(scheme), String.valueOf(number) };
 
-		if (value == Colors.defaults[number]) {
-			mDb.beginTransaction();
-			try {
-				mDb.delete(TABLE_COLORS,
-						WHERE_SCHEME_AND_COLOR, whereArgs);
-				mDb.setTransactionSuccessful();
-			} finally {
-				mDb.endTransaction();
-			}
-		} else {
-			final ContentValues values = new ContentValues();
-			values.put(FIELD_COLOR_VALUE, value);
+		mWriter.enqueue(mDb, TABLE_COLORS + "/" + scheme + "/" + number, new DatabaseWriter.Write() {
+			@Override
+			public void apply(SQLiteDatabase db) {
+				if (value == Colors.defaults[number]) {
+					db.delete(TABLE_COLORS, WHERE_SCHEME_AND_COLOR, whereArgs);
+					return;
+				}
 
-			mDb.beginTransaction();
-			try {
-				final int rowsAffected = mDb.update(TABLE_COLORS, values,
+				ContentValues values = new ContentValues();
+				values.put(FIELD_COLOR_VALUE, value);
+
+				int rowsAffected = db.update(TABLE_COLORS, values,
 						WHERE_SCHEME_AND_COLOR, whereArgs);
 
 				if (rowsAffected == 0) {
 					values.put(FIELD_COLOR_SCHEME, scheme);
 					values.put(FIELD_COLOR_NUMBER, number);
-					mDb.insert(TABLE_COLORS, null, values);
+					db.insert(TABLE_COLORS, null, values);
 				}
-				mDb.setTransactionSuccessful();
-			} finally {
-				mDb.endTransaction();
 			}
-		}
+		});
 	}
 
 	@Override
@@ -891,6 +947,7 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 	public int[] getDefaultColorsForScheme(int scheme) {
 		int[] colors = new int[] { DEFAULT_FG_COLOR, DEFAULT_BG_COLOR };
 
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_COLOR_DEFAULTS,
 				new String[] {FIELD_COLOR_FG, FIELD_COLOR_BG},
 				FIELD_COLOR_SCHEME + " = ?",
@@ -912,30 +969,29 @@ public class HostDatabase extends RobustSQLiteOpenHelper implements HostStorage,
 	}
 
 	@Override
-	public void setDefaultColorsForScheme(int scheme, int fg, int bg) {
+	public void setDefaultColorsForScheme(final int scheme, int fg, int bg) {
 
-		String schemeWhere;
-		String[] whereArgs;
+		final String schemeWhere;
+		final String[] whereArgs;
 
 		schemeWhere = FIELD_COLOR_SCHEME + " = ?";
 		whereArgs = new String[] { String.valueOf(scheme) };
 
-		ContentValues values = new ContentValues();
+		final ContentValues values = new ContentValues();
 		values.put(FIELD_COLOR_FG, fg);
 		values.put(FIELD_COLOR_BG, bg);
 
-		mDb.beginTransaction();
-		try {
-			int rowsAffected = mDb.update(TABLE_COLOR_DEFAULTS, values,
-					schemeWhere, whereArgs);
+		mWriter.enqueue(mDb, TABLE_COLOR_DEFAULTS + "/" + scheme, new DatabaseWriter.Write() {
+			@Override
+			public void apply(SQLiteDatabase db) {
+				int rowsAffected = db.update(TABLE_COLOR_DEFAULTS, values,
+						schemeWhere, whereArgs);
 
-			if (rowsAffected == 0) {
-				values.put(FIELD_COLOR_SCHEME, scheme);
-				mDb.insert(TABLE_COLOR_DEFAULTS, null, values);
+				if (rowsAffected == 0) {
+					values.put(FIELD_COLOR_SCHEME, scheme);
+					db.insert(TABLE_COLOR_DEFAULTS, null, values);
+				}
 			}
-			mDb.setTransactionSuccessful();
-		} finally {
-			mDb.endTransaction();
-		}
+		});
 	}
 }
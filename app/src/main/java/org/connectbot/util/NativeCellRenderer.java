@@ -0,0 +1,162 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import java.nio.ByteBuffer;
+
+import android.graphics.Bitmap;
+import android.graphics.Canvas;
+import android.graphics.Color;
+import android.graphics.Paint;
+import android.util.Log;
+
+/**
+ * Draws terminal rows straight into a bitmap's pixels from native code
+ * instead of issuing {@link Canvas} calls for every run of cells.
+ * <p>
+ * Each character is rasterized once with the terminal's {@link Paint} into
+ * a glyph atlas, starting with printable ASCII and adding other characters
+ * the first time they are drawn. A new renderer is needed whenever the font
+ * size changes.
+ *
+ * @author Kenny Root
+ */
+public class NativeCellRenderer {
+	private static final String TAG = "CB.NativeCellRenderer";
+
+	/** Flags for {@link #renderRow}, matching CellFlags in cell_renderer.h. */
+	public static final byte FLAG_UNDERLINE = 1;
+	public static final byte FLAG_INVERSE = 1 << 1;
+	public static final byte FLAG_INVISIBLE = 1 << 2;
+	public static final byte FLAG_WIDE = 1 << 3;
+
+	private static final int RENDER_FAILED = -2;
+
+	private static final boolean available;
+
+	static {
+		boolean loaded;
+		try {
+			System.loadLibrary("connectbot_render");
+			loaded = true;
+		} catch (UnsatisfiedLinkError e) {
+			Log.w(TAG, "Native renderer is not available", e);
+			loaded = false;
+		}
+		available = loaded;
+	}
+
+	private final Paint glyphPaint;
+	private final int charWidth;
+	private final int charHeight;
+	private final int charTop;
+
+	private final Bitmap glyphBitmap;
+	private final Canvas glyphCanvas;
+	private final byte[] glyphCoverage;
+
+	private long handle;
+
+	public static boolean isAvailable() {
+		return available;
+	}
+
+	/**
+	 * @param paint the paint the terminal text is drawn with; it is copied
+	 * @param charTop the font's top metric, which is negative
+	 */
+	public NativeCellRenderer(Paint paint, int charWidth, int charHeight, int charTop) {
+		this.charWidth = charWidth;
+		this.charHeight = charHeight;
+		this.charTop = charTop;
+
+		glyphPaint = new Paint(paint);
+		glyphPaint.setUnderlineText(false);
+		glyphPaint.setColor(Color.WHITE);
+
+		glyphBitmap = Bitmap.createBitmap(2 * charWidth, charHeight, Bitmap.Config.ALPHA_8);
+		glyphCanvas = new Canvas(glyphBitmap);
+		glyphCoverage = new byte[glyphBitmap.getRowBytes() * charHeight];
+
+		// The underline sits just below the baseline, as Paint draws it.
+		int underlineRow = Math.min(-charTop + 1, charHeight - 1);
+		handle = nativeCreate(charWidth, charHeight, underlineRow);
+
+		for (char c = ' '; c <= '~'; c++)
+			addGlyph(c, false);
+	}
+
+	/**
+	 * Draw one row of cells. All arrays must hold at least {@code columns}
+	 * entries. Colors are ordinary {@link Color} ints; inversion is applied
+	 * here according to {@link #FLAG_INVERSE}.
+	 *
+	 * @return false if the row could not be drawn and the caller should fall
+	 *         back to drawing it with a {@link Canvas}
+	 */
+	public boolean renderRow(Bitmap bitmap, int row, char[] chars, int[] fg, int[] bg,
+			byte[] flags, int columns) {
+		if (handle == 0)
+			return false;
+
+		// Each missing glyph is added once; if the atlas turns it down, or the
+		// same column comes back missing, the row is left to the Canvas path.
+		int retried = -1;
+		while (true) {
+			int result = nativeRenderRow(handle, bitmap, row, chars, fg, bg, flags, columns);
+			if (result == -1)
+				return true;
+			else if (result == RENDER_FAILED || result == retried)
+				return false;
+
+			if (!addGlyph(chars[result], (flags[result] & FLAG_WIDE) != 0 && result + 1 < columns))
+				return false;
+			retried = result;
+		}
+	}
+
+	/**
+	 * Free the native atlas. The renderer cannot be used afterwards.
+	 */
+	public void release() {
+		if (handle != 0) {
+			nativeDestroy(handle);
+			handle = 0;
+		}
+		glyphBitmap.recycle();
+	}
+
+	/**
+	 * @return false if the native atlas rejected the glyph
+	 */
+	private boolean addGlyph(char c, boolean wide) {
+		glyphBitmap.eraseColor(Color.TRANSPARENT);
+		glyphCanvas.drawText(new char[] { c }, 0, 1, 0, -charTop, glyphPaint);
+		glyphBitmap.copyPixelsToBuffer(ByteBuffer.wrap(glyphCoverage));
+		return nativeAddGlyph(handle, c, wide, glyphCoverage, glyphBitmap.getRowBytes());
+	}
+
+	private static native long nativeCreate(int cellWidth, int cellHeight, int underlineRow);
+
+	private static native void nativeDestroy(long handle);
+
+	private static native boolean nativeAddGlyph(long handle, char c, boolean wide,
+			byte[] coverage, int stride);
+
+	private static native int nativeRenderRow(long handle, Bitmap bitmap, int row,
+			char[] chars, int[] fg, int[] bg, byte[] flags, int columns);
+}
@@ -0,0 +1,96 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import java.math.BigInteger;
+import java.security.spec.ECField;
+import java.security.spec.ECFieldFp;
+import java.security.spec.ECParameterSpec;
+import java.security.spec.ECPoint;
+import java.util.Arrays;
+
+import android.util.Log;
+
+/**
+ * Multiplies the generator of the NIST P-256, P-384 and P-521 curves by a
+ * scalar in native code, in constant time, for deriving EC public keys from
+ * private ones. The Java fallback is
+ * {@link org.keyczar.jce.EcCore#multiplyPointA}, which is much slower and
+ * branches on the bits of the key.
+ *
+ * @author Kenny Root
+ */
+public final class NativeEc {
+	private static final String TAG = "CB.NativeEc";
+
+	private static final boolean available;
+
+	static {
+		boolean loaded;
+		try {
+			System.loadLibrary("connectbot_crypto");
+			loaded = true;
+		} catch (UnsatisfiedLinkError e) {
+			Log.w(TAG, "Native EC arithmetic is not available", e);
+			loaded = false;
+		}
+		available = loaded;
+	}
+
+	private NativeEc() {
+	}
+
+	public static boolean isAvailable() {
+		return available;
+	}
+
+	/**
+	 * Compute {@code s} times the generator of {@code params}.
+	 *
+	 * @return the point, or null if the native code is not available, the
+	 *         curve is not one it knows or {@code s} is out of range; the
+	 *         caller should fall back to the Java implementation then
+	 */
+	public static ECPoint multiplyGenerator(ECParameterSpec params, BigInteger s) {
+		if (!available)
+			return null;
+
+		ECField field = params.getCurve().getField();
+		if (!(field instanceof ECFieldFp))
+			return null;
+
+		ECPoint generator = params.getGenerator();
+		byte[] scalar = s.toByteArray();
+		byte[] point;
+		try {
+			point = nativeMultiplyBase(((ECFieldFp) field).getP().toByteArray(),
+					generator.getAffineX().toByteArray(),
+					generator.getAffineY().toByteArray(), scalar);
+		} finally {
+			Arrays.fill(scalar, (byte) 0);
+		}
+		if (point == null)
+			return null;
+
+		int length = point.length / 2;
+		return new ECPoint(new BigInteger(1, Arrays.copyOfRange(point, 0, length)),
+				new BigInteger(1, Arrays.copyOfRange(point, length, point.length)));
+	}
+
+	private static native byte[] nativeMultiplyBase(byte[] p, byte[] gx, byte[] gy,
+			byte[] scalar);
+}
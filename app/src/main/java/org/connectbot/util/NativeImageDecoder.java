@@ -0,0 +1,124 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import android.util.Log;
+
+/**
+ * Decodes the payload of an inline image escape sequence in native code as
+ * it arrives, so that the terminal never has to hold the encoded text. Sixel
+ * images are turned into pixels; base64 payloads, as used by iTerm2's
+ * {@code OSC 1337 ; File=}, into the bytes of the file they carry.
+ *
+ * @author Kenny Root
+ */
+public final class NativeImageDecoder {
+	private static final String TAG = "CB.NativeImageDecoder";
+
+	/* must match org_connectbot_util_NativeImageDecoder.cpp */
+	public static final int FORMAT_SIXEL = 0;
+	public static final int FORMAT_BASE64 = 1;
+
+	private static final boolean available;
+
+	static {
+		boolean loaded;
+		try {
+			System.loadLibrary("connectbot_render");
+			loaded = true;
+		} catch (UnsatisfiedLinkError e) {
+			Log.w(TAG, "Native image decoder is not available", e);
+			loaded = false;
+		}
+		available = loaded;
+	}
+
+	private long handle;
+
+	public static boolean isAvailable() {
+		return available;
+	}
+
+	/**
+	 * @param format {@link #FORMAT_SIXEL} or {@link #FORMAT_BASE64}
+	 * @param maxWidth sixel drawing beyond this many pixels is clipped
+	 * @param maxHeight sixel drawing beyond this many pixels is clipped
+	 * @param maxBytes base64 payloads that decode to more are rejected
+	 */
+	public NativeImageDecoder(int format, int maxWidth, int maxHeight, int maxBytes) {
+		handle = nativeCreate(format, maxWidth, maxHeight, maxBytes);
+		if (handle == 0)
+			throw new IllegalArgumentException("Unknown image format " + format);
+	}
+
+	/**
+	 * Decode the next {@code length} characters of the payload.
+	 * @return false once a base64 payload has grown too large
+	 */
+	public boolean feed(char[] data, int offset, int length) {
+		if (handle == 0)
+			return false;
+		return nativeFeed(handle, data, offset, length);
+	}
+
+	/** @return width of the sixel image so far */
+	public int getWidth() {
+		return handle == 0 ? 0 : nativeGetWidth(handle);
+	}
+
+	/** @return height of the sixel image so far */
+	public int getHeight() {
+		return handle == 0 ? 0 : nativeGetHeight(handle);
+	}
+
+	/**
+	 * @return the sixel image as {@link #getWidth()} by {@link #getHeight()}
+	 *         ARGB pixels, or null if nothing was drawn
+	 */
+	public int[] getPixels() {
+		return handle == 0 ? null : nativeGetPixels(handle);
+	}
+
+	/** @return the bytes a base64 payload decoded to */
+	public byte[] getBytes() {
+		return handle == 0 ? null : nativeGetBytes(handle);
+	}
+
+	/**
+	 * Free the native decoder. It cannot be used afterwards.
+	 */
+	public void release() {
+		if (handle != 0) {
+			nativeDestroy(handle);
+			handle = 0;
+		}
+	}
+
+	private static native long nativeCreate(int format, int maxWidth, int maxHeight, int maxBytes);
+
+	private static native void nativeDestroy(long handle);
+
+	private static native boolean nativeFeed(long handle, char[] data, int offset, int length);
+
+	private static native int nativeGetWidth(long handle);
+
+	private static native int nativeGetHeight(long handle);
+
+	private static native int[] nativeGetPixels(long handle);
+
+	private static native byte[] nativeGetBytes(long handle);
+}
@@ -0,0 +1,168 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import java.io.IOException;
+
+import android.util.Log;
+
+/**
+ * A ZMODEM session in native code, for sending and receiving files with rz
+ * and sz over an interactive terminal session. The session does no I/O of
+ * its own: feed it what the remote end sends, pump it while sending, and it
+ * calls back into its {@link Host} for everything else. Callbacks happen on
+ * the thread that calls into the session. If writing to the remote end
+ * throws, the session ends and the exception is rethrown to that caller;
+ * local file errors are reported by return value instead and cancel the
+ * session on both ends.
+ *
+ * @author Kenny Root
+ */
+public final class NativeZmodem {
+	private static final String TAG = "CB.NativeZmodem";
+
+	/**
+	 * What rz and sz send first: ZPAD ZPAD ZDLE ZHEX and the first digit
+	 * of a ZRQINIT or ZRINIT header.
+	 */
+	public static final byte[] START = { '*', '*', 0x18, 'B', '0' };
+
+	/* must match org_connectbot_util_NativeZmodem.cpp */
+	private static final int STATE_FINISHED = 1;
+	private static final int STATE_SUCCEEDED = 2;
+	private static final int STATE_SENDING = 4;
+
+	private static final boolean available;
+
+	static {
+		boolean loaded;
+		try {
+			System.loadLibrary("connectbot_zmodem");
+			loaded = true;
+		} catch (UnsatisfiedLinkError e) {
+			Log.w(TAG, "Native ZMODEM is not available", e);
+			loaded = false;
+		}
+		available = loaded;
+	}
+
+	/**
+	 * The files and the connection a session works with.
+	 */
+	public interface Host {
+		/** Send {@code data} to the remote end. */
+		void write(byte[] data) throws IOException;
+
+		/**
+		 * The remote end offers a file.
+		 * @param size size in bytes, or -1 if it was not given
+		 * @return false to skip the file
+		 */
+		boolean openReceived(String name, long size);
+
+		/** Append the first {@code length} bytes of {@code data} to the file. */
+		boolean writeReceived(byte[] data, int length);
+
+		void closeReceived(boolean complete);
+
+		/** @return name of the next file to offer, or null when done */
+		String nextToSend();
+
+		/** @return size of the file {@link #nextToSend()} returned, or -1 */
+		long sizeToSend();
+
+		/**
+		 * Read up to {@code length} bytes of the current file from
+		 * {@code offset} into {@code data}.
+		 * @return bytes read, 0 at the end of the file or -1 on error
+		 */
+		int readToSend(long offset, byte[] data, int length);
+
+		void closeSent(boolean complete);
+	}
+
+	private long handle;
+
+	public NativeZmodem(Host host) {
+		if (!available)
+			throw new IllegalStateException("Native ZMODEM is not available");
+		handle = nativeCreate(host);
+	}
+
+	public static boolean isAvailable() {
+		return available;
+	}
+
+	/**
+	 * Hand bytes from the remote end to the session.
+	 * @return how many were used; once the session has finished, the rest
+	 *         belong to the terminal again
+	 */
+	public int feed(byte[] data, int offset, int length) throws IOException {
+		return nativeFeed(handle, data, offset, length);
+	}
+
+	/**
+	 * Send file data as far as the transfer window allows.
+	 * @return false when nothing more can be sent until the remote end
+	 *         answers
+	 */
+	public boolean pump() throws IOException {
+		return nativePump(handle);
+	}
+
+	/**
+	 * Abort the session on both ends.
+	 */
+	public void cancel() throws IOException {
+		nativeCancel(handle);
+	}
+
+	public boolean isFinished() {
+		return (nativeGetState(handle) & STATE_FINISHED) != 0;
+	}
+
+	public boolean isSucceeded() {
+		return (nativeGetState(handle) & STATE_SUCCEEDED) != 0;
+	}
+
+	/**
+	 * @return true if the remote end is receiving, false if it is sending
+	 *         or has not said yet
+	 */
+	public boolean isSending() {
+		return (nativeGetState(handle) & STATE_SENDING) != 0;
+	}
+
+	/**
+	 * Free the native session. Does not tell the remote end anything.
+	 */
+	public void destroy() {
+		if (handle != 0) {
+			nativeDestroy(handle);
+			handle = 0;
+		}
+	}
+
+	private static native long nativeCreate(Host host);
+	private static native int nativeFeed(long handle, byte[] data, int offset, int length)
+			throws IOException;
+	private static native boolean nativePump(long handle) throws IOException;
+	private static native void nativeCancel(long handle) throws IOException;
+	private static native int nativeGetState(long handle);
+	private static native void nativeDestroy(long handle);
+}
@@ -65,8 +65,12 @@ public final class PreferenceConstants {
 
 	public static final String KEEP_ALIVE = "keepalive";
 
+	public static final String NATIVE_RENDERER = "nativeRenderer";
+
 	public static final String WIFI_LOCK = "wifilock";
 
+	public static final String PRECONNECT = "preconnect";
+
 	public static final String BUMPY_ARROWS = "bumpyarrows";
 
 	public static final String SORT_BY_COLOR = "sortByColor";
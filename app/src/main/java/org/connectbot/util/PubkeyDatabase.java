@@ -69,6 +69,8 @@ public class PubkeyDatabase extends RobustSQLiteOpenHelper {
 
 	private final SQLiteDatabase mDb;
 
+	private final DatabaseWriter mWriter = DatabaseWriter.get();
+
 	public static PubkeyDatabase get(Context context) {
 		synchronized (sInstanceLock) {
 			if (sInstance != null) {
@@ -85,7 +87,7 @@ public class PubkeyDatabase extends RobustSQLiteOpenHelper {
 		super(context, DB_NAME, null, DB_VERSION);
 
 		this.context = context;
-		mDb = getWritableDatabase();
+		mDb = openDatabase();
 	}
 
 	@Override
@@ -126,6 +128,7 @@ public class PubkeyDatabase extends RobustSQLiteOpenHelper {
 		HostDatabase hostdb = HostDatabase.get(context);
 		hostdb.stopUsingPubkey(pubkey.getId());
 
+		mWriter.flush();
 		mDb.beginTransaction();
 		try {
 			mDb.delete(TABLE_PUBKEYS, "_id = ?", new String[] {Long.toString(pubkey.getId())});
@@ -146,6 +149,7 @@ public class PubkeyDatabase extends RobustSQLiteOpenHelper {
 	private List<PubkeyBean> getPubkeys(String selection, String[] selectionArgs) {
 		List<PubkeyBean> pubkeys = new ArrayList<>();
 
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_PUBKEYS, null, selection, selectionArgs, null, null, null);
 
 		if (c != null) {
@@ -186,6 +190,7 @@ public class PubkeyDatabase extends RobustSQLiteOpenHelper {
 	 * @return object representing the pubkey
 	 */
 	public PubkeyBean findPubkeyById(long pubkeyId) {
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_PUBKEYS, null,
 				"_id = ?", new String[] { String.valueOf(pubkeyId) },
 				null, null, null);
@@ -225,6 +230,7 @@ public class PubkeyDatabase extends RobustSQLiteOpenHelper {
 	public List<CharSequence> allValues(String column) {
 		List<CharSequence> list = new ArrayList<>();
 
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_PUBKEYS, new String[] { "_id", column },
 				null, null, null, null, "_id ASC");
 
@@ -243,6 +249,7 @@ public class PubkeyDatabase extends RobustSQLiteOpenHelper {
 	public String getNickname(long id) {
 		String nickname = null;
 
+		mWriter.flush();
 		Cursor c = mDb.query(TABLE_PUBKEYS, new String[] { "_id",
 				FIELD_PUBKEY_NICKNAME }, "_id = ?",
 				new String[] { Long.toString(id) }, null, null, null);
@@ -258,27 +265,34 @@ public class PubkeyDatabase extends RobustSQLiteOpenHelper {
 	}
 
 	/**
+	 * Save a new pubkey right away, or queue the changes to an existing one.
 	 * @param pubkey
 	 */
 	public PubkeyBean savePubkey(PubkeyBean pubkey) {
-		boolean success = false;
-
-		ContentValues values = pubkey.getValues();
+		if (pubkey.getId() > 0) {
+			final ContentValues values = pubkey.getValues();
+			final ContentValues row = pubkey.getValues();
+			row.put("_id", pubkey.getId());
+			final String[] whereArgs = new String[] {String.valueOf(pubkey.getId())};
+
+			mWriter.enqueue(mDb, TABLE_PUBKEYS + "/" + pubkey.getId(), new DatabaseWriter.Write() {
+				@Override
+				public void apply(SQLiteDatabase db) {
+					// put the row back under the same id if it went missing
+					if (db.update(TABLE_PUBKEYS, values, "_id = ?", whereArgs) <= 0)
+						db.insert(TABLE_PUBKEYS, null, row);
+				}
+			});
+			return pubkey;
+		}
 
+		mWriter.flush();
 		mDb.beginTransaction();
 		try {
-			if (pubkey.getId() > 0) {
-				values.remove("_id");
-				if (mDb.update(TABLE_PUBKEYS, values, "_id = ?", new String[] {String.valueOf(pubkey.getId())}) > 0)
-					success = true;
-			}
-
-			if (!success) {
-				long id = mDb.insert(TABLE_PUBKEYS, null, pubkey.getValues());
-				if (id != -1) {
-					// TODO add some error handling here?
-					pubkey.setId(id);
-				}
+			long id = mDb.insert(TABLE_PUBKEYS, null, pubkey.getValues());
+			if (id != -1) {
+				// TODO add some error handling here?
+				pubkey.setId(id);
 			}
 
 			mDb.setTransactionSuccessful();
@@ -291,6 +305,7 @@ public class PubkeyDatabase extends RobustSQLiteOpenHelper {
 
 	@VisibleForTesting
 	public void resetDatabase() {
+		mWriter.flush();
 		try {
 			mDb.beginTransaction();
 
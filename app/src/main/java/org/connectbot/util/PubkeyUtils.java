@@ -284,11 +284,14 @@ public class PubkeyUtils {
 			ECPrivateKey ecPriv = (ECPrivateKey) priv;
 			ECParameterSpec params = ecPriv.getParams();
 
-			// Calculate public key Y
-			ECPoint generator = params.getGenerator();
-			BigInteger[] wCoords = EcCore.multiplyPointA(new BigInteger[] { generator.getAffineX(),
-					generator.getAffineY() }, ecPriv.getS(), params);
-			ECPoint w = new ECPoint(wCoords[0], wCoords[1]);
+			// Calculate public key W, natively where possible
+			ECPoint w = NativeEc.multiplyGenerator(params, ecPriv.getS());
+			if (w == null) {
+				ECPoint generator = params.getGenerator();
+				BigInteger[] wCoords = EcCore.multiplyPointA(new BigInteger[] { generator.getAffineX(),
+						generator.getAffineY() }, ecPriv.getS(), params);
+				w = new ECPoint(wCoords[0], wCoords[1]);
+			}
 
 			return kf.generatePublic(new ECPublicKeySpec(w, params));
 		} else {
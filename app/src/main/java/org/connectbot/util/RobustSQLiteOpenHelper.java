@@ -40,6 +40,29 @@ public abstract class RobustSQLiteOpenHelper extends SQLiteOpenHelper {
 		super(context, name, factory, version);
 	}
 
+	/**
+	 * Open the database for writing in write-ahead log mode, which lets
+	 * readers carry on while {@link DatabaseWriter} commits and makes each
+	 * commit cheaper.
+	 */
+	protected SQLiteDatabase openDatabase() {
+		SQLiteDatabase db = getWritableDatabase();
+		db.enableWriteAheadLogging();
+		return db;
+	}
+
+	/**
+	 * Commit queued writes and copy the write-ahead log back into the
+	 * database file, so that the file alone holds everything, e.g. before
+	 * it is backed up.
+	 */
+	public void checkpoint() {
+		DatabaseWriter.get().flush();
+		Cursor c = getWritableDatabase().rawQuery("PRAGMA wal_checkpoint(FULL)", null);
+		c.moveToFirst();
+		c.close();
+	}
+
 	protected static void addTableName(String tableName) {
 		mTableNames.add(tableName);
 	}
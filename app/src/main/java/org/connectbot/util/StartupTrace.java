@@ -0,0 +1,112 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.connectbot.util;
+
+import java.util.HashMap;
+import java.util.Map;
+
+import android.os.SystemClock;
+import android.util.Log;
+import androidx.annotation.VisibleForTesting;
+import androidx.core.os.TraceCompat;
+
+/**
+ * Records how long the cold start of the app takes to reach a few
+ * user-visible milestones. Each milestone is logged once per process
+ * relative to the first call to {@link #start()}, and the expensive stages
+ * are wrapped in systrace sections so they show up in a trace capture.
+ *
+ * @author Kenny Root
+ */
+public final class StartupTrace {
+	private static final String TAG = "CB.StartupTrace";
+
+	public static final String DATABASES_READY = "databases-ready";
+	public static final String KEYS_READY = "keys-ready";
+	public static final String HOST_LIST_SHOWN = "host-list";
+	public static final String FIRST_CONNECT = "first-connect";
+
+	private static final Object sLock = new Object();
+
+	private static long sStartTime = -1;
+
+	private static final Map<String, Long> sMilestones = new HashMap<>();
+
+	private StartupTrace() {
+	}
+
+	/**
+	 * Marks the start of the process. Only the first call has any effect.
+	 */
+	public static void start() {
+		synchronized (sLock) {
+			if (sStartTime < 0) {
+				sStartTime = SystemClock.elapsedRealtime();
+			}
+		}
+	}
+
+	/**
+	 * Forget the start time and every milestone so that the next
+	 * {@link #start()} begins a new measurement.
+	 */
+	@VisibleForTesting
+	public static void reset() {
+		synchronized (sLock) {
+			sStartTime = -1;
+			sMilestones.clear();
+		}
+	}
+
+	/**
+	 * Record that {@code milestone} was reached. Later calls for the same
+	 * milestone are ignored.
+	 */
+	public static void mark(String milestone) {
+		long elapsed;
+		synchronized (sLock) {
+			if (sStartTime < 0 || sMilestones.containsKey(milestone)) {
+				return;
+			}
+
+			elapsed = SystemClock.elapsedRealtime() - sStartTime;
+			sMilestones.put(milestone, elapsed);
+		}
+
+		Log.i(TAG, String.format("Time to %s: %d ms", milestone, elapsed));
+	}
+
+	/**
+	 * @return milliseconds from start to {@code milestone}, or -1 if it has
+	 *         not been reached yet
+	 */
+	public static long getElapsed(String milestone) {
+		synchronized (sLock) {
+			Long elapsed = sMilestones.get(milestone);
+			return elapsed == null ? -1 : elapsed;
+		}
+	}
+
+	public static void beginSection(String sectionName) {
+		TraceCompat.beginSection(sectionName);
+	}
+
+	public static void endSection() {
+		TraceCompat.endSection();
+	}
+}
@@ -17,6 +17,8 @@
 
 package org.connectbot.util;
 
+import java.util.BitSet;
+
 import org.connectbot.R;
 import org.connectbot.TerminalView;
 import org.connectbot.service.TerminalBridge;
@@ -52,6 +54,9 @@ public class TerminalTextViewOverlay extends androidx.appcompat.widget.AppCompat
 	private ClipboardManager clipboard;
 
 	private int oldBufferHeight = 0;
+
+	/* offsets of the line breaks that autowrap made rather than the output */
+	private final BitSet softBreaks = new BitSet();
 	private int oldScrollY = -1;
 
 	public TerminalTextViewOverlay(Context context, TerminalView terminalView) {
@@ -68,22 +73,34 @@ public class TerminalTextViewOverlay extends androidx.appcompat.widget.AppCompat
 
 	public void refreshTextFromBuffer() {
 		VDUBuffer vb = terminalView.bridge.getVDUBuffer();
+		// all of the scrollback is shown, so it has to match the width
+		vb.reflowHistory();
 		int numRows = vb.getBufferSize();
 		int numCols = vb.getColumns();
 		oldBufferHeight = numRows;
 
 		StringBuilder buffer = new StringBuilder();
 		int previousTotalLength = 0;
+		softBreaks.clear();
 
 		for (int r = 0; r < numRows && vb.charArray[r] != null; r++) {
 			for (int c = 0; c < numCols; c++) {
-				buffer.append(vb.charArray[r][c]);
+				char ch = vb.charArray[r][c];
+				if (VDUBuffer.isClusterHandle(ch))
+					buffer.append(vb.getCluster(ch));
+				else
+					buffer.append(ch);
 			}
 
 			// Truncate all the new whitespace without removing the old data.
-			while (buffer.length() > previousTotalLength &&
-					Character.isWhitespace(buffer.charAt(buffer.length() - 1))) {
-				buffer.setLength(buffer.length() - 1);
+			// Blanks at the end of a wrapped line are part of the text.
+			if (vb.isWrapped(r)) {
+				softBreaks.set(buffer.length());
+			} else {
+				while (buffer.length() > previousTotalLength &&
+						Character.isWhitespace(buffer.charAt(buffer.length() - 1))) {
+					buffer.setLength(buffer.length() - 1);
+				}
 			}
 
 			// Make sure each line ends with a carriage return and then remember the buffer
@@ -159,17 +176,29 @@ public class TerminalTextViewOverlay extends androidx.appcompat.widget.AppCompat
 	@Override
 	protected void onSelectionChanged(int selStart, int selEnd) {
 		if (selStart >= 0 && selEnd >= 0 && selStart <= selEnd) {
-			currentSelection = getText().toString().substring(selStart, selEnd);
+			// a line wrapped by the terminal is copied as the one line it was
+			CharSequence text = getText();
+			StringBuilder selection = new StringBuilder(selEnd - selStart);
+			for (int i = selStart; i < selEnd; i++) {
+				if (!softBreaks.get(i))
+					selection.append(text.charAt(i));
+			}
+			currentSelection = selection.toString();
 		}
 		super.onSelectionChanged(selStart, selEnd);
 	}
 
 	@Override
 	public void scrollTo(int x, int y) {
-		int lineMultiple = (y * 2 + 1) / (getLineHeight() * 2);
+		int lineHeight = getLineHeight();
+		int lineMultiple = Math.max(y, 0) / lineHeight;
 
+		// show the part of a line we are past, so flings move smoothly
 		TerminalBridge bridge = terminalView.bridge;
+		bridge.setScrollOffset(Math.max(y, 0) - lineMultiple * lineHeight);
 		bridge.buffer.setWindowBase(lineMultiple);
+		if (lineMultiple == 0)
+			bridge.requestHistory();
 
 		super.scrollTo(0, y);
 	}
@@ -0,0 +1,176 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import org.connectbot.R;
+import org.connectbot.TerminalView;
+
+import android.content.Context;
+import android.graphics.Canvas;
+import android.graphics.Color;
+import android.graphics.Paint;
+import android.view.View;
+import android.view.ViewGroup;
+import androidx.core.content.ContextCompat;
+
+/**
+ * Lays several terminals out side by side so they can be watched at once:
+ * one fills the screen, two are split along the longer side, and three or
+ * four share a 2x2 grid. The tile that last had focus is the active one and
+ * gets keyboard input, menus and prompts; it is outlined.
+ *
+ * @author Kenny Root
+ */
+public class TerminalTileLayout extends ViewGroup {
+	public static final int MAX_TILES = 4;
+
+	/**
+	 * Notified when a different tile becomes active.
+	 */
+	public interface OnActiveTileChangedListener {
+		void onActiveTileChanged(TerminalView terminal);
+	}
+
+	private final int dividerWidth;
+	private final Paint dividerPaint;
+	private final Paint activePaint;
+
+	private View activeTile;
+	private OnActiveTileChangedListener listener;
+
+	public TerminalTileLayout(Context context) {
+		super(context);
+		setWillNotDraw(false);
+
+		dividerWidth = Math.max(1, Math.round(getResources().getDisplayMetrics().density));
+
+		dividerPaint = new Paint();
+		dividerPaint.setColor(Color.DKGRAY);
+
+		activePaint = new Paint();
+		activePaint.setColor(ContextCompat.getColor(context, R.color.accent));
+		activePaint.setStyle(Paint.Style.STROKE);
+		activePaint.setStrokeWidth(dividerWidth);
+	}
+
+	public void setOnActiveTileChangedListener(OnActiveTileChangedListener listener) {
+		this.listener = listener;
+	}
+
+	/**
+	 * @return the terminal in the active tile, or in the first tile if none
+	 *         has been focused yet
+	 */
+	public TerminalView getActiveTerminalView() {
+		View tile = activeTile;
+		if (tile == null || tile.getParent() != this) {
+			if (getChildCount() == 0)
+				return null;
+			tile = getChildAt(0);
+		}
+		return tile.findViewById(R.id.terminal_view);
+	}
+
+	/**
+	 * Make the tile holding {@code tag} active.
+	 */
+	public void setActiveTile(Object tag) {
+		View tile = findViewWithTag(tag);
+		if (tile != null)
+			tile.findViewById(R.id.terminal_view).requestFocus();
+	}
+
+	@Override
+	public void requestChildFocus(View child, View focused) {
+		super.requestChildFocus(child, focused);
+
+		if (child != activeTile) {
+			activeTile = child;
+			invalidate();
+			if (listener != null)
+				listener.onActiveTileChanged(getActiveTerminalView());
+		}
+	}
+
+	@Override
+	protected void onMeasure(int widthMeasureSpec, int heightMeasureSpec) {
+		int width = MeasureSpec.getSize(widthMeasureSpec);
+		int height = MeasureSpec.getSize(heightMeasureSpec);
+		setMeasuredDimension(width, height);
+
+		int count = getChildCount();
+		for (int i = 0; i < count; i++) {
+			int[] cell = getCell(i, count, width, height);
+			getChildAt(i).measure(
+					MeasureSpec.makeMeasureSpec(cell[2] - cell[0], MeasureSpec.EXACTLY),
+					MeasureSpec.makeMeasureSpec(cell[3] - cell[1], MeasureSpec.EXACTLY));
+		}
+	}
+
+	@Override
+	protected void onLayout(boolean changed, int l, int t, int r, int b) {
+		int count = getChildCount();
+		for (int i = 0; i < count; i++) {
+			int[] cell = getCell(i, count, r - l, b - t);
+			getChildAt(i).layout(cell[0], cell[1], cell[2], cell[3]);
+		}
+	}
+
+	/**
+	 * @return left, top, right and bottom of tile {@code index} out of
+	 *         {@code count}, leaving a divider between tiles
+	 */
+	private int[] getCell(int index, int count, int width, int height) {
+		int columns, rows;
+		if (count <= 1) {
+			columns = rows = 1;
+		} else if (count == 2) {
+			columns = width >= height ? 2 : 1;
+			rows = 3 - columns;
+		} else {
+			columns = rows = 2;
+		}
+
+		int column = index % columns;
+		int row = index / columns;
+		int cellWidth = (width - (columns - 1) * dividerWidth) / columns;
+		int cellHeight = (height - (rows - 1) * dividerWidth) / rows;
+
+		int left = column * (cellWidth + dividerWidth);
+		int top = row * (cellHeight + dividerWidth);
+		return new int[] { left, top, left + cellWidth, top + cellHeight };
+	}
+
+	@Override
+	protected void dispatchDraw(Canvas canvas) {
+		// Whatever the tiles don't cover is divider.
+		if (getChildCount() > 1)
+			canvas.drawPaint(dividerPaint);
+
+		super.dispatchDraw(canvas);
+
+		if (getChildCount() > 1) {
+			TerminalView active = getActiveTerminalView();
+			View tile = active != null ? (View) active.getParent() : null;
+			if (tile != null) {
+				float inset = dividerWidth / 2f;
+				canvas.drawRect(tile.getLeft() + inset, tile.getTop() + inset,
+						tile.getRight() - inset, tile.getBottom() - inset, activePaint);
+			}
+		}
+	}
+}
@@ -0,0 +1,188 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.views;
+
+import org.connectbot.util.Colors;
+import org.connectbot.util.HostDatabase;
+
+import android.content.Context;
+import android.graphics.Canvas;
+import android.graphics.Paint;
+import android.graphics.Typeface;
+import android.util.AttributeSet;
+import android.view.View;
+import de.mud.terminal.VDUBuffer;
+import de.mud.terminal.VDUDisplay;
+
+/**
+ * Shows the screen of a terminal that is being fed from a recording. The
+ * font is sized so the whole recorded width fits the view.
+ *
+ * @author Kenny Root
+ */
+public class PlaybackView extends View implements VDUDisplay {
+	private final Paint paint = new Paint();
+	private final int[] color = Colors.defaults.clone();
+
+	private VDUBuffer buffer;
+
+	private int measuredColumns = -1;
+	private int measuredWidth = -1;
+	private float charWidth, charHeight, charTop;
+
+	public PlaybackView(Context context) {
+		this(context, null);
+	}
+
+	public PlaybackView(Context context, AttributeSet attrs) {
+		super(context, attrs);
+		paint.setAntiAlias(true);
+		paint.setTypeface(Typeface.MONOSPACE);
+	}
+
+	@Override
+	public void setVDUBuffer(VDUBuffer buffer) {
+		this.buffer = buffer;
+		buffer.setDisplay(this);
+		postInvalidate();
+	}
+
+	@Override
+	public VDUBuffer getVDUBuffer() {
+		return buffer;
+	}
+
+	@Override
+	public void redraw() {
+		postInvalidate();
+	}
+
+	@Override
+	public void updateScrollBar() {
+	}
+
+	@Override
+	public void setColor(int index, int red, int green, int blue) {
+		if (index >= 0 && index < color.length)
+			color[index] = 0xff000000 | red << 16 | green << 8 | blue;
+	}
+
+	@Override
+	public void resetColors() {
+		System.arraycopy(Colors.defaults, 0, color, 0, color.length);
+	}
+
+	private void measure(int columns) {
+		if (columns == measuredColumns && getWidth() == measuredWidth)
+			return;
+
+		paint.setTextSize(10f);
+		float width = paint.measureText("X");
+		paint.setTextSize(10f * getWidth() / (width * columns));
+
+		Paint.FontMetrics fm = paint.getFontMetrics();
+		charWidth = paint.measureText("X");
+		charHeight = (float) Math.ceil(fm.descent - fm.top);
+		charTop = (float) Math.ceil(fm.top);
+
+		measuredColumns = columns;
+		measuredWidth = getWidth();
+	}
+
+	@Override
+	protected void onDraw(Canvas canvas) {
+		canvas.drawColor(color[HostDatabase.DEFAULT_BG_COLOR]);
+		if (buffer == null || getWidth() == 0)
+			return;
+
+		synchronized (buffer) {
+			measure(buffer.width);
+
+			for (int l = 0; l < buffer.height; l++) {
+				char[] chars = buffer.charArray[buffer.screenBase + l];
+				long[] attrs = buffer.charAttributes[buffer.screenBase + l];
+				float y = l * charHeight - charTop;
+
+				for (int c = 0; c < buffer.width; ) {
+					long attr = attrs[c];
+					boolean wide = (attr & VDUBuffer.FULLWIDTH) != 0;
+					int run = 1;
+					if (wide || VDUBuffer.isClusterHandle(chars[c])) {
+						// one character and its padding cell, if any
+						run = wide ? 2 : 1;
+					} else {
+						while (c + run < buffer.width && attrs[c + run] == attr
+								&& !VDUBuffer.isClusterHandle(chars[c + run]))
+							run++;
+					}
+					run = Math.min(run, buffer.width - c);
+
+					int fg = getColor(attr, true);
+					int bg = getColor(attr, false);
+					if ((attr & VDUBuffer.INVERT) != 0) {
+						int swap = fg;
+						fg = bg;
+						bg = swap;
+					}
+
+					paint.setColor(bg);
+					canvas.drawRect(c * charWidth, l * charHeight,
+							(c + run) * charWidth, (l + 1) * charHeight, paint);
+
+					if ((attr & VDUBuffer.INVISIBLE) == 0) {
+						paint.setColor(fg);
+						paint.setUnderlineText((attr & (VDUBuffer.UNDERLINE | VDUBuffer.LINK)) != 0);
+						if (VDUBuffer.isClusterHandle(chars[c]))
+							canvas.drawText(buffer.getCluster(chars[c]), c * charWidth, y, paint);
+						else
+							canvas.drawText(chars, c, wide ? 1 : run, c * charWidth, y, paint);
+					}
+
+					c += run;
+				}
+			}
+
+			if (buffer.isCursorVisible()) {
+				int column = Math.min(buffer.getCursorColumn(), buffer.width - 1);
+				int row = buffer.getCursorRow();
+				paint.setColor(0x80ffffff);
+				canvas.drawRect(column * charWidth, row * charHeight,
+						(column + 1) * charWidth, (row + 1) * charHeight, paint);
+			}
+		}
+	}
+
+	private int getColor(long attr, boolean foreground) {
+		int index;
+		if (foreground) {
+			index = HostDatabase.DEFAULT_FG_COLOR;
+			if ((attr & VDUBuffer.COLOR_FG) != 0)
+				index = (int) ((attr & VDUBuffer.COLOR_FG) >> VDUBuffer.COLOR_FG_SHIFT) - 1;
+			if (index < 8 && (attr & VDUBuffer.BOLD) != 0)
+				index += 8;
+		} else {
+			index = HostDatabase.DEFAULT_BG_COLOR;
+			if ((attr & VDUBuffer.COLOR_BG) != 0)
+				index = (int) ((attr & VDUBuffer.COLOR_BG) >> VDUBuffer.COLOR_BG_SHIFT) - 1;
+		}
+
+		if (index < color.length)
+			return color[index];
+		else
+			return 0xff000000 | (index - 256);
+	}
+}
@@ -0,0 +1,78 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Measures how many cells per second the native renderer composites into an
+// in-memory frame. Not run by ctest; build the cell_renderer_benchmark
+// target and run it directly.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#include "cell_renderer.h"
+#include "font5x7.h"
+
+using connectbot::CellRenderer;
+using connectbot::testing::LoadFont;
+using connectbot::testing::kFontCellHeight;
+using connectbot::testing::kFontCellWidth;
+using connectbot::testing::kFontUnderlineRow;
+
+int main(int argc, char** argv) {
+  const int columns = 120;
+  const int rows = 40;
+  const int frames = argc > 1 ? atoi(argv[1]) : 2000;
+
+  CellRenderer renderer(kFontCellWidth, kFontCellHeight, kFontUnderlineRow);
+  LoadFont(&renderer);
+
+  const size_t stride = columns * kFontCellWidth;
+  std::vector<uint32_t> pixels(stride * rows * kFontCellHeight);
+  std::vector<std::vector<uint16_t> > chars(rows, std::vector<uint16_t>(columns));
+  std::vector<uint32_t> fg(columns), bg(columns);
+  std::vector<uint8_t> flags(columns);
+
+  // Dense text in a few colors, like a compiler log.
+  for (int r = 0; r < rows; r++) {
+    for (int c = 0; c < columns; c++) {
+      chars[r][c] = static_cast<uint16_t>('!' + (r * 7 + c * 13) % 94);
+    }
+  }
+  for (int c = 0; c < columns; c++) {
+    fg[c] = c % 3 == 0 ? 0xff55ff55 : 0xffcccccc;
+    bg[c] = 0xff000000;
+    flags[c] = c % 17 == 0 ? connectbot::kCellInverse : 0;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int f = 0; f < frames; f++) {
+    for (int r = 0; r < rows; r++) {
+      renderer.RenderRow(pixels.data(), stride, r, columns, chars[r].data(),
+                         fg.data(), bg.data(), flags.data());
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  double cells = static_cast<double>(frames) * rows * columns;
+  printf("%d frames of %dx%d cells (%dx%d px each) in %.3f s: %.1f Mcells/s\n",
+         frames, columns, rows, kFontCellWidth, kFontCellHeight,
+         elapsed.count(), cells / elapsed.count() / 1e6);
+  // Use the output so the rendering cannot be optimized away.
+  return pixels[0] == 0x12345678 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,241 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Host tests for the native cell renderer. Build with the host CMake
+// configuration of app/CMakeLists.txt and run through ctest.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "cell_renderer.h"
+#include "font5x7.h"
+
+using connectbot::ArgbToPixel;
+using connectbot::CellRenderer;
+using connectbot::testing::FontGlyph;
+using connectbot::testing::LoadFont;
+using connectbot::testing::kFontCellHeight;
+using connectbot::testing::kFontCellWidth;
+using connectbot::testing::kFontUnderlineRow;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT_EQ(expected, actual)                                         \
+  do {                                                                      \
+    long long e = (expected), a = (actual);                                 \
+    if (e != a) {                                                           \
+      fprintf(stderr, "%s:%d: expected %s == %s (0x%llx), got 0x%llx\n",   \
+              __FILE__, __LINE__, #actual, #expected, e, a);                \
+      failures++;                                                           \
+    }                                                                       \
+  } while (0)
+
+const uint32_t kRed = 0xffff0000;
+const uint32_t kBlue = 0xff0000ff;
+const uint32_t kWhite = 0xffffffff;
+const uint32_t kBlack = 0xff000000;
+
+// An in-memory RGBA frame with a few rows of text cells.
+struct Frame {
+  Frame(int columns, int rows)
+      : columns(columns),
+        stride(columns * kFontCellWidth + 3),  // Padded like a real bitmap.
+        pixels(stride * rows * kFontCellHeight, 0xdeadbeef),
+        chars(columns, ' '),
+        fg(columns, kWhite),
+        bg(columns, kBlack),
+        flags(columns, 0) {}
+
+  void SetText(const char* text) {
+    for (int i = 0; text[i] != '\0' && i < columns; i++) {
+      chars[i] = text[i];
+    }
+  }
+
+  int Render(const CellRenderer& renderer, int row) {
+    return renderer.RenderRow(pixels.data(), stride, row, columns,
+                              chars.data(), fg.data(), bg.data(),
+                              flags.data());
+  }
+
+  uint32_t At(int row, int col, int x, int y) const {
+    return pixels[(row * kFontCellHeight + y) * stride
+                  + col * kFontCellWidth + x];
+  }
+
+  int columns;
+  size_t stride;
+  std::vector<uint32_t> pixels;
+  std::vector<uint16_t> chars;
+  std::vector<uint32_t> fg;
+  std::vector<uint32_t> bg;
+  std::vector<uint8_t> flags;
+};
+
+void TestPixelOrder() {
+  // Android stores ARGB_8888 as R, G, B, A bytes in memory.
+  uint32_t pixel = ArgbToPixel(0x80112233);
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&pixel);
+  EXPECT_EQ(0x11, bytes[0]);
+  EXPECT_EQ(0x22, bytes[1]);
+  EXPECT_EQ(0x33, bytes[2]);
+  EXPECT_EQ(0x80, bytes[3]);
+}
+
+void TestGlyphsMatchFont() {
+  CellRenderer renderer(kFontCellWidth, kFontCellHeight, kFontUnderlineRow);
+  LoadFont(&renderer);
+
+  Frame frame(4, 2);
+  frame.SetText("Hi !");
+  frame.fg[1] = kRed;
+  EXPECT_EQ(-1, frame.Render(renderer, 1));
+
+  const char* text = "Hi !";
+  for (int col = 0; col < 4; col++) {
+    std::vector<uint8_t> glyph = FontGlyph(text[col]);
+    uint32_t fg = ArgbToPixel(frame.fg[col]);
+    uint32_t bg = ArgbToPixel(kBlack);
+    for (int y = 0; y < kFontCellHeight; y++) {
+      for (int x = 0; x < kFontCellWidth; x++) {
+        EXPECT_EQ(glyph[y * kFontCellWidth + x] ? fg : bg,
+                  frame.At(1, col, x, y));
+      }
+    }
+  }
+
+  // Row 0 and the stride padding are left alone.
+  EXPECT_EQ(0xdeadbeef, frame.At(0, 0, 0, 0));
+  EXPECT_EQ(0xdeadbeef, frame.pixels[frame.stride - 1]);
+}
+
+void TestInverseAndUnderline() {
+  CellRenderer renderer(kFontCellWidth, kFontCellHeight, kFontUnderlineRow);
+  LoadFont(&renderer);
+
+  Frame frame(2, 1);
+  frame.SetText("  ");
+  frame.fg[0] = kRed;
+  frame.bg[0] = kBlue;
+  frame.flags[0] = connectbot::kCellInverse;
+  frame.fg[1] = kRed;
+  frame.bg[1] = kBlue;
+  frame.flags[1] = connectbot::kCellUnderline;
+  EXPECT_EQ(-1, frame.Render(renderer, 0));
+
+  EXPECT_EQ(ArgbToPixel(kRed), frame.At(0, 0, 0, 0));
+  EXPECT_EQ(ArgbToPixel(kRed), frame.At(0, 0, 5, kFontUnderlineRow));
+  EXPECT_EQ(ArgbToPixel(kBlue), frame.At(0, 1, 0, 0));
+  for (int x = 0; x < kFontCellWidth; x++) {
+    EXPECT_EQ(ArgbToPixel(kRed), frame.At(0, 1, x, kFontUnderlineRow));
+  }
+}
+
+void TestInvisibleDrawsBackgroundOnly() {
+  CellRenderer renderer(kFontCellWidth, kFontCellHeight, kFontUnderlineRow);
+  LoadFont(&renderer);
+
+  Frame frame(1, 1);
+  frame.SetText("#");
+  frame.flags[0] = connectbot::kCellInvisible;
+  EXPECT_EQ(-1, frame.Render(renderer, 0));
+  for (int y = 0; y < kFontCellHeight; y++) {
+    for (int x = 0; x < kFontCellWidth; x++) {
+      EXPECT_EQ(ArgbToPixel(kBlack), frame.At(0, 0, x, y));
+    }
+  }
+}
+
+void TestMissingGlyphLeavesRowUntouched() {
+  CellRenderer renderer(kFontCellWidth, kFontCellHeight, kFontUnderlineRow);
+  LoadFont(&renderer);
+
+  Frame frame(3, 1);
+  frame.SetText("ab");
+  frame.chars[2] = 0x00e9;
+  EXPECT_EQ(2, frame.Render(renderer, 0));
+  EXPECT_EQ(0xdeadbeef, frame.At(0, 0, 0, 0));
+
+  std::vector<uint8_t> glyph = FontGlyph('e');
+  renderer.AddGlyph(0x00e9, false, glyph.data(), kFontCellWidth);
+  EXPECT_EQ(-1, frame.Render(renderer, 0));
+}
+
+void TestWideGlyphSpansTwoCells() {
+  CellRenderer renderer(kFontCellWidth, kFontCellHeight, kFontUnderlineRow);
+
+  std::vector<uint8_t> glyph(2 * kFontCellWidth * kFontCellHeight, 0);
+  for (int y = 0; y < kFontCellHeight; y++) {
+    glyph[y * 2 * kFontCellWidth + 2 * kFontCellWidth - 1] = 255;
+  }
+  renderer.AddGlyph(0x4e2d, true, glyph.data(), 2 * kFontCellWidth);
+
+  Frame frame(2, 1);
+  frame.chars[0] = 0x4e2d;
+  frame.chars[1] = 0;
+  frame.flags[0] = connectbot::kCellWide;
+  EXPECT_EQ(-1, frame.Render(renderer, 0));
+  EXPECT_EQ(ArgbToPixel(kBlack), frame.At(0, 0, 0, 3));
+  EXPECT_EQ(ArgbToPixel(kWhite), frame.At(0, 1, kFontCellWidth - 1, 3));
+}
+
+void TestSimdMatchesScalar() {
+  std::vector<uint8_t> coverage(257);
+  for (size_t i = 0; i < coverage.size(); i++) {
+    coverage[i] = static_cast<uint8_t>(i * 37 + 11);
+  }
+  const uint32_t fg = ArgbToPixel(0xfff0e0d0);
+  const uint32_t bg = ArgbToPixel(0xff102030);
+
+  std::vector<uint32_t> simd(coverage.size());
+  std::vector<uint32_t> scalar(coverage.size());
+  connectbot::BlendSpan(simd.data(), coverage.data(), coverage.size(), fg, bg);
+  connectbot::BlendSpanScalar(scalar.data(), coverage.data(), coverage.size(),
+                              fg, bg);
+  for (size_t i = 0; i < coverage.size(); i++) {
+    EXPECT_EQ(scalar[i], simd[i]);
+  }
+
+  // Half coverage lands halfway between the colors, rounded.
+  uint8_t half = 128;
+  uint32_t out;
+  connectbot::BlendSpanScalar(&out, &half, 1, ArgbToPixel(kWhite),
+                              ArgbToPixel(kBlack));
+  EXPECT_EQ(ArgbToPixel(0xff808080), out);
+}
+
+}  // namespace
+
+int main() {
+  TestPixelOrder();
+  TestGlyphsMatchFont();
+  TestInverseAndUnderline();
+  TestInvisibleDrawsBackgroundOnly();
+  TestMissingGlyphLeavesRowUntouched();
+  TestWideGlyphSpansTwoCells();
+  TestSimdMatchesScalar();
+
+  if (failures != 0) {
+    fprintf(stderr, "%d failures\n", failures);
+    return EXIT_FAILURE;
+  }
+  printf("All cell renderer tests passed\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Times EC public key computation on each curve, with the fixed-base table
+// against plain double-and-add. Not run by ctest; build the
+// ec_scalar_benchmark target and run it directly.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#include "ec_scalar.h"
+
+using connectbot::EcCoordinateLength;
+using connectbot::EcCurve;
+using connectbot::EcMultiplyBase;
+using connectbot::EcMultiplyBaseReference;
+
+namespace {
+
+typedef bool (*Multiply)(EcCurve, const uint8_t*, size_t, uint8_t*, uint8_t*);
+
+double Time(Multiply multiply, EcCurve curve, int iterations, uint8_t* sink) {
+  size_t len = EcCoordinateLength(curve);
+  std::vector<uint8_t> k(len), x(len), y(len);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    // A different scalar below the order every time.
+    for (size_t j = 0; j < len; j++) {
+      k[j] = static_cast<uint8_t>(i * 131 + j * 7 + 1);
+    }
+    k[0] = 0;
+    multiply(curve, k.data(), k.size(), x.data(), y.data());
+    *sink ^= x[0];
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations * 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? atoi(argv[1]) : 200;
+  const struct {
+    EcCurve curve;
+    const char* name;
+  } kCurves[] = {
+    {connectbot::kEcP256, "P-256"},
+    {connectbot::kEcP384, "P-384"},
+    {connectbot::kEcP521, "P-521"},
+  };
+
+  uint8_t sink = 0;
+  for (size_t i = 0; i < sizeof(kCurves) / sizeof(kCurves[0]); i++) {
+    // The first call builds the table.
+    auto start = std::chrono::steady_clock::now();
+    Time(EcMultiplyBase, kCurves[i].curve, 1, &sink);
+    std::chrono::duration<double> setup =
+        std::chrono::steady_clock::now() - start;
+
+    double fixed = Time(EcMultiplyBase, kCurves[i].curve, iterations, &sink);
+    double reference =
+        Time(EcMultiplyBaseReference, kCurves[i].curve, iterations, &sink);
+    printf("%s: fixed-base %.1f us, double-and-add %.1f us, table %.1f ms\n",
+           kCurves[i].name, fixed, reference, setup.count() * 1e3);
+  }
+  // Use the output so the work cannot be optimized away.
+  return sink == 0x5a ? EXIT_FAILURE : EXIT_SUCCESS;
+}
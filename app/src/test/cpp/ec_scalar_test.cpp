@@ -0,0 +1,258 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Host tests for the native EC scalar multiplication. Build with the host
+// CMake configuration of app/CMakeLists.txt and run through ctest. The
+// expected points were computed independently with affine arithmetic.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ec_scalar.h"
+
+using connectbot::EcCoordinateLength;
+using connectbot::EcCurve;
+using connectbot::EcFindCurve;
+using connectbot::EcMultiplyBase;
+using connectbot::EcMultiplyBaseReference;
+using connectbot::kEcP256;
+using connectbot::kEcP384;
+using connectbot::kEcP521;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT_TRUE(condition)                                              \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,         \
+              #condition);                                                  \
+      failures++;                                                           \
+    }                                                                       \
+  } while (0)
+
+#define EXPECT_HEX(expected, bytes, len)                                    \
+  do {                                                                      \
+    std::string actual = ToHex(bytes, len);                                 \
+    if (actual != (expected)) {                                             \
+      fprintf(stderr, "%s:%d: expected %s, got %s\n", __FILE__, __LINE__, \
+              (expected), actual.c_str());                                  \
+      failures++;                                                           \
+    }                                                                       \
+  } while (0)
+
+struct Vector {
+  EcCurve curve;
+  const char* k;
+  const char* x;
+  const char* y;
+};
+
+// k = 1, 2, 3, 15, 16, 17, two random scalars and n - 1 for each curve.
+const Vector kVectors[] = {
+    {kEcP256, "0000000000000000000000000000000000000000000000000000000000000001",
+     "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296",
+     "4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5"},
+    {kEcP256, "0000000000000000000000000000000000000000000000000000000000000002",
+     "7cf27b188d034f7e8a52380304b51ac3c08969e277f21b35a60b48fc47669978",
+     "07775510db8ed040293d9ac69f7430dbba7dade63ce982299e04b79d227873d1"},
+    {kEcP256, "0000000000000000000000000000000000000000000000000000000000000003",
+     "5ecbe4d1a6330a44c8f7ef951d4bf165e6c6b721efada985fb41661bc6e7fd6c",
+     "8734640c4998ff7e374b06ce1a64a2ecd82ab036384fb83d9a79b127a27d5032"},
+    {kEcP256, "000000000000000000000000000000000000000000000000000000000000000f",
+     "f0454dc6971abae7adfb378999888265ae03af92de3a0ef163668c63e59b9d5f",
+     "b5b93ee3592e2d1f4e6594e51f9643e62a3b21ce75b5fa3f47e59cde0d034f36"},
+    {kEcP256, "0000000000000000000000000000000000000000000000000000000000000010",
+     "76a94d138a6b41858b821c629836315fcd28392eff6ca038a5eb4787e1277c6e",
+     "a985fe61341f260e6cb0a1b5e11e87208599a0040fc78baa0e9ddd724b8c5110"},
+    {kEcP256, "0000000000000000000000000000000000000000000000000000000000000011",
+     "47776904c0f1cc3a9c0984b66f75301a5fa68678f0d64af8ba1abce34738a73e",
+     "aa005ee6b5b957286231856577648e8381b2804428d5733f32f787ff71f1fcdc"},
+    {kEcP256, "d9476dc26e42800f4d70481547b4370dd2e270f91fc641862ebc12938bfb2fd0",
+     "d61af65b650aac8b75d595c7976c20edb99d2526db4dfe01825a643aff64d841",
+     "2687d916b96db3831951a9b6caac03291f8e2759f03e997863091aa415e06319"},
+    {kEcP256, "9859778a6db610794e2b2fd5f3b83b295ef39b377f89b8c2aff15e4c0453377e",
+     "417a8a1ceb4d683ca89dc673478a02d5b04f96a1f5650b4db1876c3b8293e840",
+     "89d9e2228ce9bfffc33554bc4419235afd9dc4d1bbff8ff0ef8eb57bc8a47fb2"},
+    {kEcP256, "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632550",
+     "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296",
+     "b01cbd1c01e58065711814b583f061e9d431cca994cea1313449bf97c840ae0a"},
+    {kEcP384, "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001",
+     "aa87ca22be8b05378eb1c71ef320ad746e1d3b628ba79b9859f741e082542a385502f25dbf55296c3a545e3872760ab7",
+     "3617de4a96262c6f5d9e98bf9292dc29f8f41dbd289a147ce9da3113b5f0b8c00a60b1ce1d7e819d7a431d7c90ea0e5f"},
+    {kEcP384, "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000002",
+     "08d999057ba3d2d969260045c55b97f089025959a6f434d651d207d19fb96e9e4fe0e86ebe0e64f85b96a9c75295df61",
+     "8e80f1fa5b1b3cedb7bfe8dffd6dba74b275d875bc6cc43e904e505f256ab4255ffd43e94d39e22d61501e700a940e80"},
+    {kEcP384, "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000003",
+     "077a41d4606ffa1464793c7e5fdc7d98cb9d3910202dcd06bea4f240d3566da6b408bbae5026580d02d7e5c70500c831",
+     "c995f7ca0b0c42837d0bbe9602a9fc998520b41c85115aa5f7684c0edc111eacc24abd6be4b5d298b65f28600a2f1df1"},
+    {kEcP384, "00000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000f",
+     "b3d13fc8b32b01058cc15c11d813525522a94156fff01c205b21f9f7da7c4e9ca849557a10b6383b4b88701a9606860b",
+     "152919e7df9162a61b049b2536164b1beebac4a11d749af484d1114373dfbfd9838d24f8b284af50985d588d33f7bd62"},
+    {kEcP384, "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000010",
+     "d5d89c3b5282369c5fbd88e2b231511a6b80dff0e5152cf6a464fa9428a8583bac8ebc773d157811a462b892401dafcf",
+     "d815229de12906d241816d5e9a9448f1d41d4fc40e2a3bdb9caba57e440a7abad1210cb8f49bf2236822b755ebab3673"},
+    {kEcP384, "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000011",
+     "4099952208b4889600a5ebbcb13e1a32692befb0733b41e6dcc614e42e5805f817012a991af1f486caf3a9add9ffcc03",
+     "5ecf94777833059839474594af603598163ad3f8008ad0cd9b797d277f2388b304da4d2faa9680ecfa650ef5e23b09a0"},
+    {kEcP384, "ebc49189f5bd6d5b5b62a5806f9e2874be7ea2ac0356a08d6f74a7ae0539224089969decf5c4497c46271d27d582b55a",
+     "3375df9845e8d52071361aa409833ccc6014701e939a8aca5a1196fdcf202cba10d76beb0ee0859d07d4ec80a7d8d6bd",
+     "45e02fb7a60b8a62d7fd73cf6cbfa99742f981f28bd057f3bdc1d38611a3ec467080d0ae400f1cb14c82aca6702350d8"},
+    {kEcP384, "d4dbb0d3a4cde252d7a86f737743b973695d9fc80b8c4f89b9182228abeacde436b8df02cc34fbc059b7cf227459a939",
+     "2f90fad8d3ed7af8512d640728f50f3c42af04b6b44d32f9438057ac75efaa5e23ee0be718feab38f20b51b0c0566aca",
+     "d632de5bd8eefcd219fce6d4f238e78cd6d544759adbaa0ede765bc0d370d5d52331c8e2d4b85dbbb9253ca9c9b29632"},
+    {kEcP384, "ffffffffffffffffffffffffffffffffffffffffffffffffc7634d81f4372ddf581a0db248b0a77aecec196accc52972",
+     "aa87ca22be8b05378eb1c71ef320ad746e1d3b628ba79b9859f741e082542a385502f25dbf55296c3a545e3872760ab7",
+     "c9e821b569d9d390a26167406d6d23d6070be242d765eb831625ceec4a0f473ef59f4e30e2817e6285bce2846f15f1a0"},
+    {kEcP521, "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001",
+     "00c6858e06b70404e9cd9e3ecb662395b4429c648139053fb521f828af606b4d3dbaa14b5e77efe75928fe1dc127a2ffa8de3348b3c1856a429bf97e7e31c2e5bd66",
+     "011839296a789a3bc0045c8a5fb42c7d1bd998f54449579b446817afbd17273e662c97ee72995ef42640c550b9013fad0761353c7086a272c24088be94769fd16650"},
+    {kEcP521, "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000002",
+     "00433c219024277e7e682fcb288148c282747403279b1ccc06352c6e5505d769be97b3b204da6ef55507aa104a3a35c5af41cf2fa364d60fd967f43e3933ba6d783d",
+     "00f4bb8cc7f86db26700a7f3eceeeed3f0b5c6b5107c4da97740ab21a29906c42dbbb3e377de9f251f6b93937fa99a3248f4eafcbe95edc0f4f71be356d661f41b02"},
+    {kEcP521, "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000003",
+     "01a73d352443de29195dd91d6a64b5959479b52a6e5b123d9ab9e5ad7a112d7a8dd1ad3f164a3a4832051da6bd16b59fe21baeb490862c32ea05a5919d2ede37ad7d",
+     "013e9b03b97dfa62ddd9979f86c6cab814f2f1557fa82a9d0317d2f8ab1fa355ceec2e2dd4cf8dc575b02d5aced1dec3c70cf105c9bc93a590425f588ca1ee86c0e5"},
+    {kEcP521, "00000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000f",
+     "006b6ad89abcb92465f041558fc546d4300fb8fbcc30b40a0852d697b532df128e11b91cce27dbd00ffe7875bd1c8fc0331d9b8d96981e3f92bde9afe337bcb8db55",
+     "01b468da271571391d6a7ce64d2333edbf63df0496a9bad20cba4b62106997485ed57e9062c899470a802148e2232c96c99246fd90cc446abdd956343480a1475465"},
+    {kEcP521, "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000010",
+     "01d17d10d8a89c8ad05dda97da26ac743b0b2a87f66192fd3f3dd632f8d20b188a52943ff18861ca00a0e5965da7985630df0dbf5c8007dcdc533a6c508f81a8402f",
+     "007a37343c582d77001fc714b18d3d3e69721335e4c3b800d50ec7ca30c94b6b82c1c182e1398db547aa0b3075ac9d9988529e3004d28d18633352e272f89bc73abe"},
+    {kEcP521, "000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000011",
+     "01b00ddb707f130eda13a0b874645923906a99ee9e269fa2b3b4d66524f269250858760a69e674fe0287df4e799b5681380ff8c3042af0d1a41076f817a853110ae0",
+     "0085683f1d7db16576dbc111d4e4aeddd106b799534cf69910a98d68ac2b22a1323df9da564ef6dd0bf0d2f6757f16adf420e6905594c2b755f535b9cb7c70e64647"},
+    {kEcP521, "01936e465ac15fe469fdcfc147751376a042dd6cf94646f77426ffdb58a3b0d0a659796a466b4ce2446cf661a7d9aadda2c6179d87aa21d8cac943059c7628e3549f",
+     "01b8a4858c0f4bd0733908fd3aa7b63fd2f5f418a9130c287166c0bdd75af8dfdc3f7ee885717c378a8ba5094a4d847531faed4c6a82d2fafd890e67f805e4f121d5",
+     "009c94dc2927fbaa4dbca47c358eb7a48e6ed2391ddebdad1b33910a133d5ea58983a25b1d9dd62922733cbd4f64d3f97f3ceb4886a2573d3fc80ae195abd0ffd66b"},
+    {kEcP521, "00873ddc169d560a8c54733c8199de5f50f90a7fe23939cbbab7ddebc93eaae2bbe446ec4fb904c8b9d6c6209aa5f643bafc8bc35b750a4095aa5951bd13a18172e6",
+     "00a531f1edede52ccd1f7ada9126242cae7319f5b31182fec7117d2c49754e36c7d3c27833cfb1ac66aa4d5017c6dbcdcc7e8814d70bdc1257afcab3fa141b4fa4c3",
+     "01f219f5f38810537ec1f59af496f3a8fe868ca07ce239648f2ecdfa8579ec83d6e7fa629cf04ce6be8892853a2dde005a644c75b619c52e2f062953a0dedd37e32b"},
+    {kEcP521, "01fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffa51868783bf2f966b7fcc0148f709a5d03bb5c9b8899c47aebb6fb71e91386408",
+     "00c6858e06b70404e9cd9e3ecb662395b4429c648139053fb521f828af606b4d3dbaa14b5e77efe75928fe1dc127a2ffa8de3348b3c1856a429bf97e7e31c2e5bd66",
+     "00e7c6d6958765c43ffba375a04bd382e426670abbb6a864bb97e85042e8d8c199d368118d66a10bd9bf3aaf46fec052f89ecac38f795d8d3dbf77416b89602e99af"},
+};
+
+std::vector<uint8_t> FromHex(const char* hex) {
+  std::vector<uint8_t> out;
+  for (size_t i = 0; hex[i] != '\0' && hex[i + 1] != '\0'; i += 2) {
+    char byte[3] = {hex[i], hex[i + 1], '\0'};
+    out.push_back(static_cast<uint8_t>(strtoul(byte, NULL, 16)));
+  }
+  return out;
+}
+
+std::string ToHex(const uint8_t* bytes, size_t len) {
+  std::string out;
+  char buf[3];
+  for (size_t i = 0; i < len; i++) {
+    snprintf(buf, sizeof(buf), "%02x", bytes[i]);
+    out += buf;
+  }
+  return out;
+}
+
+void TestKnownMultiples() {
+  for (size_t i = 0; i < sizeof(kVectors) / sizeof(kVectors[0]); i++) {
+    const Vector& v = kVectors[i];
+    size_t len = EcCoordinateLength(v.curve);
+    std::vector<uint8_t> k = FromHex(v.k);
+    std::vector<uint8_t> x(len), y(len);
+
+    EXPECT_TRUE(EcMultiplyBase(v.curve, &k[0], k.size(), &x[0], &y[0]));
+    EXPECT_HEX(v.x, &x[0], len);
+    EXPECT_HEX(v.y, &y[0], len);
+
+    std::fill(x.begin(), x.end(), 0);
+    std::fill(y.begin(), y.end(), 0);
+    EXPECT_TRUE(EcMultiplyBaseReference(v.curve, &k[0], k.size(), &x[0], &y[0]));
+    EXPECT_HEX(v.x, &x[0], len);
+    EXPECT_HEX(v.y, &y[0], len);
+  }
+}
+
+void TestScalarRange() {
+  uint8_t x[66], y[66];
+
+  // BigInteger.toByteArray adds a sign byte; leading zeros are fine.
+  const uint8_t one[] = {0, 0, 0, 1};
+  EXPECT_TRUE(EcMultiplyBase(kEcP256, one, sizeof(one), x, y));
+
+  const uint8_t zero[] = {0};
+  EXPECT_TRUE(!EcMultiplyBase(kEcP256, zero, sizeof(zero), x, y));
+
+  // The order itself and anything too long are rejected.
+  std::vector<uint8_t> n = FromHex(
+      "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551");
+  EXPECT_TRUE(!EcMultiplyBase(kEcP256, &n[0], n.size(), x, y));
+  n.insert(n.begin(), 1);
+  EXPECT_TRUE(!EcMultiplyBase(kEcP256, &n[0], n.size(), x, y));
+}
+
+void TestFindCurve() {
+  for (size_t i = 0; i < sizeof(kVectors) / sizeof(kVectors[0]); i++) {
+    const Vector& v = kVectors[i];
+    std::vector<uint8_t> k = FromHex(v.k);
+    if (k.back() != 1 || k.size() - 1 != static_cast<size_t>(
+            std::count(k.begin(), k.end(), 0))) {
+      continue;
+    }
+
+    // 1 * G is the generator itself.
+    std::vector<uint8_t> gx = FromHex(v.x), gy = FromHex(v.y);
+    std::vector<uint8_t> p;
+    if (v.curve == kEcP256) {
+      p = FromHex("ffffffff00000001000000000000000000000000ffffffffffffffffffffffff");
+    } else if (v.curve == kEcP384) {
+      p = FromHex("fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffe"
+                  "ffffffff0000000000000000ffffffff");
+    } else {
+      p.assign(66, 0xff);
+      p[0] = 0x01;
+    }
+    p.insert(p.begin(), 0);
+
+    EcCurve found;
+    EXPECT_TRUE(EcFindCurve(&p[0], p.size(), &gx[0], gx.size(), &gy[0],
+                            gy.size(), &found));
+    EXPECT_TRUE(found == v.curve);
+
+    gy[gy.size() - 1] ^= 1;
+    EXPECT_TRUE(!EcFindCurve(&p[0], p.size(), &gx[0], gx.size(), &gy[0],
+                             gy.size(), &found));
+  }
+}
+
+}  // namespace
+
+int main() {
+  TestKnownMultiples();
+  TestScalarRange();
+  TestFindCurve();
+
+  if (failures != 0) {
+    fprintf(stderr, "%d failures\n", failures);
+    return EXIT_FAILURE;
+  }
+  printf("All EC scalar tests passed\n");
+  return EXIT_SUCCESS;
+}
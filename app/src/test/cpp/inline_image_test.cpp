@@ -0,0 +1,195 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Host tests for the native inline image decoders. Build with the host
+// CMake configuration of app/CMakeLists.txt and run through ctest.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "inline_image.h"
+
+using connectbot::Base64Decoder;
+using connectbot::SixelDecoder;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT_TRUE(condition)                                              \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,         \
+              #condition);                                                  \
+      failures++;                                                           \
+    }                                                                       \
+  } while (0)
+
+const uint32_t kRed = 0xffff0000;
+const uint32_t kGreen = 0xff00ff00;
+const uint32_t kClear = 0;
+
+std::vector<uint32_t> Pixels(const SixelDecoder& decoder) {
+  std::vector<uint32_t> pixels(decoder.width() * decoder.height());
+  if (!pixels.empty()) {
+    decoder.CopyPixels(&pixels[0]);
+  }
+  return pixels;
+}
+
+void Feed(SixelDecoder* decoder, const char* data) {
+  decoder->Feed(data, strlen(data));
+}
+
+void TestSingleBand() {
+  SixelDecoder decoder(1000, 1000);
+  // Red, then a full column, a column with only the top pixel and a blank.
+  Feed(&decoder, "#1;2;100;0;0~@?");
+  EXPECT_TRUE(decoder.width() == 3);
+  EXPECT_TRUE(decoder.height() == 6);
+
+  std::vector<uint32_t> pixels = Pixels(decoder);
+  for (int y = 0; y < 6; y++) {
+    EXPECT_TRUE(pixels[y * 3] == kRed);
+    EXPECT_TRUE(pixels[y * 3 + 1] == (y == 0 ? kRed : kClear));
+    EXPECT_TRUE(pixels[y * 3 + 2] == kClear);
+  }
+}
+
+void TestRepeatAndBands() {
+  SixelDecoder decoder(1000, 1000);
+  Feed(&decoder, "#1;2;100;0;0!10~-#2;2;0;100;0!4~$#1~");
+  EXPECT_TRUE(decoder.width() == 10);
+  EXPECT_TRUE(decoder.height() == 12);
+
+  std::vector<uint32_t> pixels = Pixels(decoder);
+  EXPECT_TRUE(pixels[5 * 10 + 9] == kRed);
+  // "$" went back to the start of the second band and drew red over green.
+  EXPECT_TRUE(pixels[6 * 10] == kRed);
+  EXPECT_TRUE(pixels[6 * 10 + 1] == kGreen);
+  EXPECT_TRUE(pixels[11 * 10 + 3] == kGreen);
+  EXPECT_TRUE(pixels[11 * 10 + 4] == kClear);
+}
+
+void TestSplitAnywhere() {
+  const char kImage[] = "\"1;1;7;8#5;2;0;100;0#5!7~-!7A";
+  SixelDecoder whole(1000, 1000);
+  Feed(&whole, kImage);
+
+  // Every split point, including inside numbers, gives the same image.
+  for (size_t split = 0; split < sizeof(kImage) - 1; split++) {
+    SixelDecoder pieces(1000, 1000);
+    pieces.Feed(kImage, split);
+    pieces.Feed(kImage + split, sizeof(kImage) - 1 - split);
+    EXPECT_TRUE(pieces.width() == whole.width());
+    EXPECT_TRUE(pieces.height() == whole.height());
+    EXPECT_TRUE(Pixels(pieces) == Pixels(whole));
+  }
+}
+
+void TestRasterAttributesTrimLastBand() {
+  SixelDecoder decoder(1000, 1000);
+  Feed(&decoder, "\"1;1;7;8#5;2;0;100;0#5!7~-!7A");
+  EXPECT_TRUE(decoder.width() == 7);
+  EXPECT_TRUE(decoder.height() == 8);
+  EXPECT_TRUE(Pixels(decoder)[7 * 7 + 6] == kGreen);
+}
+
+void TestRasterAttributesAnnounceSize() {
+  SixelDecoder decoder(1000, 1000);
+  Feed(&decoder, "\"1;1;20;30#1~");
+  EXPECT_TRUE(decoder.width() == 20);
+  EXPECT_TRUE(decoder.height() == 30);
+  EXPECT_TRUE(Pixels(decoder)[29 * 20 + 19] == kClear);
+}
+
+void TestHlsColors() {
+  SixelDecoder decoder(1000, 1000);
+  // DEC hues: 120 degrees is red, 240 green, 0 blue.
+  Feed(&decoder, "#1;1;120;50;100~#2;1;240;50;100~#3;1;0;50;100~");
+  std::vector<uint32_t> pixels = Pixels(decoder);
+  EXPECT_TRUE(pixels[0] == kRed);
+  EXPECT_TRUE(pixels[1] == kGreen);
+  EXPECT_TRUE(pixels[2] == 0xff0000ff);
+}
+
+void TestDefaultPalette() {
+  SixelDecoder decoder(1000, 1000);
+  // Register 2 is the VT340's red, 80% 13% 13%.
+  Feed(&decoder, "#2~");
+  EXPECT_TRUE(Pixels(decoder)[0] == 0xffcc2121);
+}
+
+void TestClipsToMaximum() {
+  SixelDecoder decoder(16, 8);
+  Feed(&decoder, "#1;2;100;0;0!100~-~-~-~");
+  EXPECT_TRUE(decoder.width() == 16);
+  EXPECT_TRUE(decoder.height() == 8);
+
+  // Announced sizes are clipped too.
+  SixelDecoder announced(16, 8);
+  Feed(&announced, "\"1;1;100000000;100000000#0");
+  EXPECT_TRUE(announced.width() == 16);
+  EXPECT_TRUE(announced.height() == 8);
+}
+
+void TestBase64() {
+  const char kEncoded[] = "SGVsbG8s\r\nIHdvcmxkIQ==";
+  Base64Decoder whole(100);
+  EXPECT_TRUE(whole.Feed(kEncoded, sizeof(kEncoded) - 1));
+  std::string text(whole.bytes().begin(), whole.bytes().end());
+  EXPECT_TRUE(text == "Hello, world!");
+
+  for (size_t split = 0; split < sizeof(kEncoded) - 1; split++) {
+    Base64Decoder pieces(100);
+    pieces.Feed(kEncoded, split);
+    pieces.Feed(kEncoded + split, sizeof(kEncoded) - 1 - split);
+    EXPECT_TRUE(pieces.bytes() == whole.bytes());
+  }
+}
+
+void TestBase64Limit() {
+  Base64Decoder decoder(4);
+  EXPECT_TRUE(decoder.Feed("AAAA", 4));
+  EXPECT_TRUE(!decoder.Feed("AAAA", 4));
+  EXPECT_TRUE(decoder.bytes().size() == 4);
+}
+
+}  // namespace
+
+int main() {
+  TestSingleBand();
+  TestRepeatAndBands();
+  TestSplitAnywhere();
+  TestRasterAttributesTrimLastBand();
+  TestRasterAttributesAnnounceSize();
+  TestHlsColors();
+  TestDefaultPalette();
+  TestClipsToMaximum();
+  TestBase64();
+  TestBase64Limit();
+
+  if (failures != 0) {
+    fprintf(stderr, "%d failures\n", failures);
+    return EXIT_FAILURE;
+  }
+  printf("All inline image tests passed\n");
+  return EXIT_SUCCESS;
+}
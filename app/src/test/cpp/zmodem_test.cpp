@@ -0,0 +1,308 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Host tests for the native ZMODEM engine. Build with the host CMake
+// configuration of app/CMakeLists.txt and run through ctest. The transfers
+// run one engine as sender against another as receiver over an in-memory
+// line, which can be made to corrupt bytes.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "zmodem.h"
+
+using connectbot::ZmodemCrc16;
+using connectbot::ZmodemCrc32;
+using connectbot::ZmodemEngine;
+using connectbot::ZmodemHost;
+
+namespace {
+
+int failures = 0;
+
+#define EXPECT_TRUE(condition)                                              \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,         \
+              #condition);                                                  \
+      failures++;                                                           \
+    }                                                                       \
+  } while (0)
+
+typedef std::vector<uint8_t> Bytes;
+
+class MemoryHost : public ZmodemHost {
+ public:
+  MemoryHost() : next_(0), closed_complete_(0), closed_incomplete_(0) {}
+
+  void AddFile(const std::string& name, const Bytes& data) {
+    outgoing_.push_back(std::make_pair(name, data));
+  }
+
+  bool Write(const uint8_t* data, size_t len) override {
+    wire.insert(wire.end(), data, data + len);
+    return true;
+  }
+
+  bool OpenReceived(const std::string& name, int64_t size) override {
+    if (name == "skip-me") {
+      return false;
+    }
+    current_ = name;
+    sizes[name] = size;
+    received[name].clear();
+    return true;
+  }
+
+  bool WriteReceived(const uint8_t* data, size_t len) override {
+    Bytes& file = received[current_];
+    file.insert(file.end(), data, data + len);
+    return true;
+  }
+
+  void CloseReceived(bool complete) override {
+    (complete ? closed_complete_ : closed_incomplete_)++;
+  }
+
+  bool NextToSend(std::string* name, int64_t* size) override {
+    if (next_ >= outgoing_.size()) {
+      return false;
+    }
+    *name = outgoing_[next_].first;
+    *size = outgoing_[next_].second.size();
+    next_++;
+    return true;
+  }
+
+  int64_t ReadToSend(int64_t offset, uint8_t* data, size_t len) override {
+    const Bytes& file = outgoing_[next_ - 1].second;
+    if (offset >= static_cast<int64_t>(file.size())) {
+      return 0;
+    }
+    size_t n = std::min(len, static_cast<size_t>(file.size() - offset));
+    memcpy(data, &file[offset], n);
+    return n;
+  }
+
+  void CloseSent(bool complete) override {
+    (complete ? closed_complete_ : closed_incomplete_)++;
+  }
+
+  int closed_complete() const { return closed_complete_; }
+  int closed_incomplete() const { return closed_incomplete_; }
+
+  Bytes wire;
+  std::map<std::string, Bytes> received;
+  std::map<std::string, int64_t> sizes;
+
+ private:
+  std::vector<std::pair<std::string, Bytes> > outgoing_;
+  size_t next_;
+  std::string current_;
+  int closed_complete_;
+  int closed_incomplete_;
+};
+
+Bytes Pattern(size_t len, uint32_t seed) {
+  Bytes data(len);
+  for (size_t i = 0; i < len; i++) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = seed >> 16;
+  }
+  return data;
+}
+
+// ZRQINIT as sz sends it.
+Bytes RequestInit() {
+  const char kHeader[] = "rz\r**\030B00000000000000\r\x8a\x11";
+  return Bytes(kHeader, kHeader + sizeof(kHeader) - 1);
+}
+
+// Moves everything |from| wrote to |to|, flipping the byte at |*corrupt|
+// (counted over the whole stream) once.
+void Deliver(MemoryHost* from, ZmodemEngine* to, size_t* sent,
+             size_t* corrupt) {
+  Bytes bytes;
+  bytes.swap(from->wire);
+  if (*corrupt >= *sent && *corrupt < *sent + bytes.size()) {
+    bytes[*corrupt - *sent] ^= 0x01;
+    *corrupt = static_cast<size_t>(-1);
+  }
+  *sent += bytes.size();
+  if (!bytes.empty()) {
+    to->Feed(bytes.data(), bytes.size());
+  }
+}
+
+// Runs a whole session between a sender and a receiver engine.
+bool Transfer(MemoryHost* sender_host, MemoryHost* receiver_host,
+              size_t corrupt_sender, size_t corrupt_receiver) {
+  ZmodemEngine sender(sender_host);
+  ZmodemEngine receiver(receiver_host);
+
+  Bytes start = RequestInit();
+  size_t skip = 3;  // "rz\r" goes to the terminal
+  receiver.Feed(start.data() + skip, start.size() - skip);
+
+  size_t to_sender = 0;
+  size_t to_receiver = 0;
+  for (int round = 0; round < 100000; round++) {
+    Deliver(receiver_host, &sender, &to_sender, &corrupt_receiver);
+    sender.Pump();
+    Deliver(sender_host, &receiver, &to_receiver, &corrupt_sender);
+    if (sender.finished() && receiver.finished()
+        && sender_host->wire.empty() && receiver_host->wire.empty()) {
+      return sender.succeeded() && receiver.succeeded();
+    }
+  }
+  return false;
+}
+
+void TestCrc() {
+  const uint8_t kCheck[] = "123456789";
+  EXPECT_TRUE(ZmodemCrc16(0, kCheck, 9) == 0x31c3);
+  EXPECT_TRUE(~ZmodemCrc32(0xffffffff, kCheck, 9) == 0xcbf43926);
+
+  // Split updates give the same result.
+  uint32_t crc = ZmodemCrc32(0xffffffff, kCheck, 4);
+  EXPECT_TRUE(~ZmodemCrc32(crc, kCheck + 4, 5) == 0xcbf43926);
+}
+
+void TestSendAndReceive() {
+  MemoryHost sender_host;
+  MemoryHost receiver_host;
+  // Empty, smaller than a block, exactly a block and several windows long.
+  sender_host.AddFile("empty", Bytes());
+  sender_host.AddFile("small.txt", Pattern(100, 1));
+  sender_host.AddFile("block", Pattern(1024, 2));
+  sender_host.AddFile("large.bin", Pattern(200000, 3));
+
+  EXPECT_TRUE(Transfer(&sender_host, &receiver_host, static_cast<size_t>(-1),
+                       static_cast<size_t>(-1)));
+  EXPECT_TRUE(receiver_host.received["empty"].empty());
+  EXPECT_TRUE(receiver_host.received["small.txt"] == Pattern(100, 1));
+  EXPECT_TRUE(receiver_host.received["block"] == Pattern(1024, 2));
+  EXPECT_TRUE(receiver_host.received["large.bin"] == Pattern(200000, 3));
+  EXPECT_TRUE(receiver_host.sizes["large.bin"] == 200000);
+  EXPECT_TRUE(receiver_host.closed_complete() == 4);
+  EXPECT_TRUE(sender_host.closed_complete() == 4);
+}
+
+void TestEscapedBytes() {
+  // Every byte value, and the runs that need ZDLE escaping.
+  Bytes data;
+  for (int i = 0; i < 256; i++) {
+    data.push_back(i);
+  }
+  const uint8_t kSpecial[] = {0x18, 0x18, 0x18, 0x18, 0x18, 0x18, '@', '\r',
+                              0x11, 0x13, 0x91, 0x93, 0x10, 0x90, '*', '*'};
+  data.insert(data.end(), kSpecial, kSpecial + sizeof(kSpecial));
+
+  MemoryHost sender_host;
+  MemoryHost receiver_host;
+  sender_host.AddFile("bytes", data);
+  EXPECT_TRUE(Transfer(&sender_host, &receiver_host, static_cast<size_t>(-1),
+                       static_cast<size_t>(-1)));
+  EXPECT_TRUE(receiver_host.received["bytes"] == data);
+}
+
+void TestRecoversFromCorruption() {
+  Bytes data = Pattern(100000, 4);
+  // Somewhere in the middle of the data, and in an acknowledgement.
+  const size_t kOffsets[] = {500, 50000, 99000};
+  for (size_t offset : kOffsets) {
+    MemoryHost sender_host;
+    MemoryHost receiver_host;
+    sender_host.AddFile("data", data);
+    EXPECT_TRUE(Transfer(&sender_host, &receiver_host, offset, 100));
+    EXPECT_TRUE(receiver_host.received["data"] == data);
+  }
+}
+
+void TestSkippedFile() {
+  MemoryHost sender_host;
+  MemoryHost receiver_host;
+  sender_host.AddFile("skip-me", Pattern(5000, 5));
+  sender_host.AddFile("keep", Pattern(5000, 6));
+  EXPECT_TRUE(Transfer(&sender_host, &receiver_host, static_cast<size_t>(-1),
+                       static_cast<size_t>(-1)));
+  EXPECT_TRUE(receiver_host.received.count("skip-me") == 0);
+  EXPECT_TRUE(receiver_host.received["keep"] == Pattern(5000, 6));
+  EXPECT_TRUE(sender_host.closed_incomplete() == 1);
+}
+
+void TestHandsBackTrailingOutput() {
+  MemoryHost host;
+  ZmodemEngine receiver(&host);
+  Bytes start = RequestInit();
+  receiver.Feed(start.data() + 3, start.size() - 3);
+
+  // ZFIN, then the sender's "OO" and the shell prompt.
+  const char kEnd[] = "**\030B0800000000022d\r\x8aOO$ ";
+  size_t len = sizeof(kEnd) - 1;
+  size_t used = receiver.Feed(reinterpret_cast<const uint8_t*>(kEnd), len);
+  EXPECT_TRUE(used == len - 2);
+  EXPECT_TRUE(receiver.succeeded());
+}
+
+void TestRemoteCancel() {
+  MemoryHost host;
+  ZmodemEngine receiver(&host);
+  Bytes start = RequestInit();
+  receiver.Feed(start.data() + 3, start.size() - 3);
+
+  const char kCancel[] = "\030\030\030\030\030\030\030\030\b\b\b\b\b\b\b\b";
+  size_t used = receiver.Feed(reinterpret_cast<const uint8_t*>(kCancel),
+                              sizeof(kCancel) - 1);
+  EXPECT_TRUE(used == 5);
+  EXPECT_TRUE(receiver.finished());
+  EXPECT_TRUE(!receiver.succeeded());
+}
+
+void TestNothingToSend() {
+  // rz started with no files queued: the session ends cleanly.
+  MemoryHost sender_host;
+  MemoryHost receiver_host;
+  EXPECT_TRUE(Transfer(&sender_host, &receiver_host, static_cast<size_t>(-1),
+                       static_cast<size_t>(-1)));
+  EXPECT_TRUE(receiver_host.received.empty());
+}
+
+}  // namespace
+
+int main() {
+  TestCrc();
+  TestSendAndReceive();
+  TestEscapedBytes();
+  TestRecoversFromCorruption();
+  TestSkippedFile();
+  TestHandsBackTrailingOutput();
+  TestRemoteCancel();
+  TestNothingToSend();
+
+  if (failures != 0) {
+    fprintf(stderr, "%d failures\n", failures);
+    return EXIT_FAILURE;
+  }
+  printf("All ZMODEM tests passed\n");
+  return EXIT_SUCCESS;
+}
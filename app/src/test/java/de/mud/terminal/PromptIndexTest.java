@@ -0,0 +1,115 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.mud.terminal;
+
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNull;
+
+@RunWith(AndroidJUnit4.class)
+public class PromptIndexTest {
+	@Test
+	public void navigatesBetweenPrompts() {
+		PromptIndex index = new PromptIndex();
+		index.markPrompt(0);
+		index.markPrompt(10);
+		index.markPrompt(25);
+
+		assertEquals(10, index.getPreviousPrompt(25));
+		assertEquals(25, index.getPreviousPrompt(30));
+		assertEquals(PromptIndex.NONE, index.getPreviousPrompt(0));
+		assertEquals(10, index.getNextPrompt(0));
+		assertEquals(PromptIndex.NONE, index.getNextPrompt(25));
+	}
+
+	@Test
+	public void outputRangeFollowsScrollback() {
+		PromptIndex index = new PromptIndex();
+		index.markPrompt(100);
+		index.markCommand(100);
+		index.markOutput(101);
+		index.markEnd(140, 1);
+		index.markPrompt(140);
+
+		index.linesDropped(50);
+
+		assertArrayEquals(new int[] { 51, 90 }, index.getLastOutputRange());
+		assertEquals(1, index.getLastExitCode());
+		assertEquals(50, index.getPreviousPrompt(90));
+	}
+
+	@Test
+	public void promptsScrolledOffAreForgotten() {
+		PromptIndex index = new PromptIndex();
+		index.markPrompt(5);
+		index.markPrompt(20);
+
+		index.linesDropped(10);
+
+		assertEquals(PromptIndex.NONE, index.getPreviousPrompt(10));
+		assertEquals(10, index.getPreviousPrompt(11));
+	}
+
+	@Test
+	public void redrawnPromptReplacesLaterMarks() {
+		PromptIndex index = new PromptIndex();
+		index.markPrompt(10);
+		index.markPrompt(20);
+		// the screen was cleared and a prompt drawn higher up
+		index.markPrompt(12);
+
+		assertEquals(12, index.getPreviousPrompt(30));
+		assertEquals(10, index.getPreviousPrompt(12));
+	}
+
+	@Test
+	public void runningCommandHasNoOutputYet() {
+		PromptIndex index = new PromptIndex();
+		index.markPrompt(0);
+		index.markOutput(1);
+
+		assertNull(index.getLastOutputRange());
+	}
+
+	@Test
+	public void osc133MarksAreRecorded() {
+		vt320 buffer = new vt320() {
+			@Override
+			public void write(byte[] b) {}
+			@Override
+			public void write(int b) {}
+			@Override
+			public void sendTelnetCommand(byte cmd) {}
+			@Override
+			public void setWindowSize(int c, int r) {}
+			@Override
+			public void debug(String s) {}
+		};
+		buffer.setScreenSize(20, 5, false);
+
+		buffer.putString("\u001b]133;A\u0007$ \u001b]133;B\u0007ls\r\n"
+				+ "\u001b]133;C\u0007one\r\ntwo\r\n\u001b]133;D;0\u0007");
+
+		int[] range = buffer.prompts.getLastOutputRange();
+		assertArrayEquals(new int[] { buffer.screenBase + 1, buffer.screenBase + 3 }, range);
+	}
+}
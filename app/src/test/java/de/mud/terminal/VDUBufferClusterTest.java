@@ -0,0 +1,115 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.mud.terminal;
+
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class VDUBufferClusterTest {
+	private vt320 buffer;
+
+	@Before
+	public void setUp() {
+		buffer = new vt320() {
+			@Override
+			public void write(byte[] b) {}
+			@Override
+			public void write(int b) {}
+			@Override
+			public void sendTelnetCommand(byte cmd) {}
+			@Override
+			public void setWindowSize(int c, int r) {}
+			@Override
+			public void debug(String s) {}
+		};
+		buffer.setScreenSize(20, 5, false);
+	}
+
+	@Test
+	public void asciiStaysInline() {
+		buffer.putString("abc");
+
+		for (int c = 0; c < 3; c++)
+			assertFalse(VDUBuffer.isClusterHandle(buffer.getChar(c, 0)));
+		assertEquals("b", buffer.getCellText(1, 0));
+	}
+
+	@Test
+	public void emojiTakesTwoCellsWithOneHandle() {
+		buffer.putString("a😀b");
+
+		assertEquals("a", buffer.getCellText(0, 0));
+		assertTrue(VDUBuffer.isClusterHandle(buffer.getChar(1, 0)));
+		assertEquals("😀", buffer.getCellText(1, 0));
+		assertTrue((buffer.getAttributes(1, 0) & VDUBuffer.FULLWIDTH) != 0);
+		assertEquals("b", buffer.getCellText(3, 0));
+		assertEquals(4, buffer.getCursorColumn());
+	}
+
+	@Test
+	public void zwjSequenceIsOneCluster() {
+		String family = "👨‍👩‍👧";
+		buffer.putString(family + "x");
+
+		assertEquals(family, buffer.getCellText(0, 0));
+		assertEquals("x", buffer.getCellText(2, 0));
+	}
+
+	@Test
+	public void flagIsOnePairOfRegionalIndicators() {
+		String flag = "🇯🇵";
+		buffer.putString(flag + flag);
+
+		assertEquals(flag, buffer.getCellText(0, 0));
+		assertEquals(flag, buffer.getCellText(2, 0));
+		assertEquals(buffer.getChar(0, 0), buffer.getChar(2, 0));
+	}
+
+	@Test
+	public void combiningMarksPrecomposeOrCluster() {
+		buffer.putString("e\u0301q\u0301");
+
+		assertEquals("\u00e9", buffer.getCellText(0, 0));
+		assertEquals("q\u0301", buffer.getCellText(1, 0));
+	}
+
+	@Test
+	public void surrogatePairSplitAcrossWrites() {
+		buffer.putString("\ud83d");
+		buffer.putString("\ude00");
+
+		assertEquals("😀", buffer.getCellText(0, 0));
+	}
+
+	@Test
+	public void unreferencedClustersAreReclaimed() {
+		for (int i = 0; i < VDUBuffer.MAX_CLUSTERS + 10; i++) {
+			buffer.putString("\r" + new String(Character.toChars(0x20000 + i)));
+		}
+
+		assertEquals(new String(Character.toChars(0x20000 + VDUBuffer.MAX_CLUSTERS + 9)),
+				buffer.getCellText(0, 0));
+	}
+}
@@ -0,0 +1,194 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.mud.terminal;
+
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class VDUBufferImageTest {
+	private vt320 buffer;
+
+	private int format = -1;
+	private String params;
+	private StringBuilder payload;
+	private boolean finished;
+	private boolean aborted;
+
+	@Before
+	public void setUp() {
+		buffer = new vt320() {
+			@Override
+			public void write(byte[] b) {}
+			@Override
+			public void write(int b) {}
+			@Override
+			public void sendTelnetCommand(byte cmd) {}
+			@Override
+			public void setWindowSize(int c, int r) {}
+			@Override
+			public void debug(String s) {}
+
+			@Override
+			protected ImageReceiver beginImage(int imageFormat, String imageParams) {
+				format = imageFormat;
+				params = imageParams;
+				payload = new StringBuilder();
+				return new ImageReceiver() {
+					@Override
+					public void append(char[] data, int offset, int length) {
+						payload.append(data, offset, length);
+					}
+
+					@Override
+					public void finish() {
+						finished = true;
+					}
+
+					@Override
+					public void abort() {
+						aborted = true;
+					}
+				};
+			}
+		};
+		buffer.setScreenSize(20, 5, false);
+	}
+
+	@Test
+	public void sixelPayloadGoesToReceiver() {
+		buffer.putString("a\u001bP0;1q\"1;1;2;6#0~~-\u001b\\b");
+
+		assertEquals(vt320.IMAGE_SIXEL, format);
+		assertEquals("0;1", params);
+		assertEquals("\"1;1;2;6#0~~-", payload.toString());
+		assertTrue(finished);
+		assertEquals("b", buffer.getCellText(1, 0));
+	}
+
+	@Test
+	public void payloadMaySpanReads() {
+		buffer.putString("\u001bPq#0;2;100;0;0");
+		buffer.putString("!5~\r\n");
+		buffer.putString("-~\u001b\\");
+
+		assertEquals("#0;2;100;0;0!5~\r\n-~", payload.toString());
+		assertTrue(finished);
+	}
+
+	@Test
+	public void iterm2FileGoesToReceiver() {
+		buffer.putString("\u001b]1337;File=name=YS5wbmc=;inline=1:iVBORw0KGgo=\u0007x");
+
+		assertEquals(vt320.IMAGE_FILE, format);
+		assertEquals("name=YS5wbmc=;inline=1", params);
+		assertEquals("iVBORw0KGgo=", payload.toString());
+		assertTrue(finished);
+		assertEquals("x", buffer.getCellText(0, 0));
+	}
+
+	@Test
+	public void cancelAbortsImage() {
+		buffer.putString("\u001bPq#0~~\u0018y");
+
+		assertTrue(aborted);
+		assertFalse(finished);
+		assertEquals("y", buffer.getCellText(0, 0));
+	}
+
+	@Test
+	public void otherDeviceControlStringsAreNotImages() {
+		buffer.putString("\u001bP$qm\u001b\\");
+
+		assertEquals(-1, format);
+		assertNull(payload);
+	}
+
+	@Test
+	public void outputCannotCreateImageCells() {
+		buffer.putString("a\ufdd0b");
+
+		assertEquals('\ufffd', buffer.getChar(1, 0));
+		assertEquals("\ufffd", buffer.getCellText(1, buffer.screenBase));
+		assertEquals("b", buffer.getCellText(2, buffer.screenBase));
+	}
+
+	@Test
+	public void placeImageFillsCellsAndMovesCursor() {
+		buffer.putString("\r\n  ");
+		buffer.placeImage(7, 3, 2);
+
+		for (int row = 0; row < 2; row++) {
+			for (int col = 0; col < 3; col++) {
+				assertEquals(VDUBuffer.IMAGE_CELL, buffer.getChar(2 + col, 1 + row));
+				long attr = buffer.getAttributes(2 + col, 1 + row);
+				assertEquals(7, VDUBuffer.getImageId(attr));
+				assertEquals(col, VDUBuffer.getImageColumn(attr));
+				assertEquals(row, VDUBuffer.getImageRow(attr));
+			}
+		}
+		assertEquals(" ", buffer.getCellText(2, buffer.screenBase + 1));
+		assertEquals(2, buffer.getCursorColumn());
+		assertEquals(3, buffer.getCursorRow());
+	}
+
+	@Test
+	public void placeImageScrollsAtBottom() {
+		buffer.setBufferSize(10);
+		buffer.putString("\r\n\r\n\r\n\r\n");
+		buffer.placeImage(1, 2, 3);
+
+		assertEquals(VDUBuffer.IMAGE_CELL, buffer.getChar(0, 1));
+		assertEquals(2, VDUBuffer.getImageRow(buffer.getAttributes(0, 3)));
+		assertEquals(4, buffer.getCursorRow());
+	}
+
+	@Test
+	public void clearImageBlanksScrollbackAndScreen() {
+		buffer.setBufferSize(20);
+		buffer.putString("\r\n\r\n\r\n\r\n");
+		buffer.placeImage(1, 2, 3);
+		buffer.placeImage(2, 2, 3);
+		int version = buffer.historyVersion;
+
+		buffer.clearImage(1);
+
+		int images = 0;
+		for (int row = 0; row < buffer.bufSize; row++) {
+			for (int col = 0; col < buffer.width; col++) {
+				if (buffer.charArray[row][col] != VDUBuffer.IMAGE_CELL)
+					continue;
+				assertEquals(2, VDUBuffer.getImageId(buffer.charAttributes[row][col]));
+				images++;
+			}
+		}
+		assertEquals(6, images);
+		// the first image was scrolled half into the scrollback
+		assertEquals(6, buffer.screenBase);
+		assertEquals(' ', buffer.charArray[4][0]);
+		assertEquals(0, buffer.charAttributes[4][0]);
+		assertTrue(buffer.historyVersion != version);
+	}
+}
@@ -0,0 +1,87 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.mud.terminal;
+
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNull;
+
+@RunWith(AndroidJUnit4.class)
+public class VDUBufferLinkTest {
+	private static final String URI = "https://connectbot.org/";
+
+	private vt320 buffer;
+
+	@Before
+	public void setUp() {
+		buffer = new vt320() {
+			@Override
+			public void write(byte[] b) {}
+			@Override
+			public void write(int b) {}
+			@Override
+			public void sendTelnetCommand(byte cmd) {}
+			@Override
+			public void setWindowSize(int c, int r) {}
+			@Override
+			public void debug(String s) {}
+		};
+		buffer.setScreenSize(20, 5, false);
+	}
+
+	@Test
+	public void osc8MarksCellsUntilClosed() {
+		buffer.putString("a\u001b]8;;" + URI + "\u0007link\u001b]8;;\u0007b");
+
+		assertNull(buffer.getLinkAt(0, 0));
+		for (int c = 1; c <= 4; c++)
+			assertEquals(URI, buffer.getLinkAt(c, 0));
+		assertNull(buffer.getLinkAt(5, 0));
+	}
+
+	@Test
+	public void stringTerminatorAndParamsAreStripped() {
+		buffer.putString("\u001b]8;id=1;" + URI + "\u001b\\x\u001b]8;;\u001b\\");
+
+		assertEquals(URI, buffer.getLinkAt(0, 0));
+	}
+
+	@Test
+	public void sgrResetKeepsLinkOpen() {
+		buffer.putString("\u001b]8;;" + URI + "\u0007\u001b[1ma\u001b[0mb");
+
+		assertEquals(URI, buffer.getLinkAt(1, 0));
+	}
+
+	@Test
+	public void sameTargetSharesId() {
+		assertEquals(buffer.internLink(URI), buffer.internLink(URI));
+	}
+
+	@Test
+	public void unreferencedLinksAreReclaimed() {
+		for (int i = 0; i < VDUBuffer.MAX_LINKS + 5; i++)
+			buffer.putString("\r\u001b]8;;" + URI + i + "\u0007x\u001b]8;;\u0007");
+
+		assertEquals(URI + (VDUBuffer.MAX_LINKS + 4), buffer.getLinkAt(0, 0));
+	}
+}
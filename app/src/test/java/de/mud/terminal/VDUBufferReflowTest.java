@@ -0,0 +1,216 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.mud.terminal;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
+import java.io.IOException;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class VDUBufferReflowTest {
+	private vt320 buffer;
+
+	@Before
+	public void setUp() {
+		buffer = newTerminal();
+	}
+
+	private static vt320 newTerminal() {
+		vt320 terminal = new vt320() {
+			@Override
+			public void write(byte[] b) {}
+			@Override
+			public void write(int b) {}
+			@Override
+			public void sendTelnetCommand(byte cmd) {}
+			@Override
+			public void setWindowSize(int c, int r) {}
+			@Override
+			public void debug(String s) {}
+		};
+		terminal.setScreenSize(20, 5, false);
+		return terminal;
+	}
+
+	private static String repeat(char ch, int count) {
+		char[] chars = new char[count];
+		Arrays.fill(chars, ch);
+		return new String(chars);
+	}
+
+	private String row(int l) {
+		return new String(buffer.charArray[l]).replaceAll(" +$", "");
+	}
+
+	/** @return the text of every row with a prompt mark, top to bottom */
+	private List<String> promptRows() {
+		List<String> rows = new ArrayList<>();
+		int r = buffer.prompts.getNextPrompt(-1);
+		while (r != PromptIndex.NONE) {
+			rows.add(row(r));
+			r = buffer.prompts.getNextPrompt(r);
+		}
+		return rows;
+	}
+
+	@Test
+	public void autowrapMarksRow() {
+		buffer.putString(repeat('a', 25) + "\r\nb");
+
+		assertTrue(buffer.isWrapped(buffer.screenBase));
+		assertFalse(buffer.isWrapped(buffer.screenBase + 1));
+		assertFalse(buffer.isWrapped(buffer.screenBase + 2));
+	}
+
+	@Test
+	public void eraseToEndOfLineEndsWrap() {
+		buffer.putString(repeat('a', 25) + "\u001b[1;5H\u001b[K");
+
+		assertFalse(buffer.isWrapped(buffer.screenBase));
+	}
+
+	@Test
+	public void narrowingWrapsScreenAgain() {
+		buffer.putString("abcdefghijklmnopqrstuvwxy\r\n$ ");
+		buffer.setScreenSize(10, 5, false);
+
+		int base = buffer.screenBase;
+		assertEquals("abcdefghij", row(base));
+		assertEquals("klmnopqrst", row(base + 1));
+		assertEquals("uvwxy", row(base + 2));
+		assertEquals("$", row(base + 3));
+		assertTrue(buffer.isWrapped(base));
+		assertTrue(buffer.isWrapped(base + 1));
+		assertFalse(buffer.isWrapped(base + 2));
+		assertEquals(2, buffer.getCursorColumn());
+		assertEquals(3, buffer.getCursorRow());
+	}
+
+	@Test
+	public void wideningJoinsWrappedRows() {
+		buffer.putString("abcdefghijklmnopqrstuvwxy");
+		buffer.setScreenSize(30, 5, false);
+
+		assertEquals("abcdefghijklmnopqrstuvwxy", row(buffer.screenBase));
+		assertFalse(buffer.isWrapped(buffer.screenBase));
+		assertEquals(25, buffer.getCursorColumn());
+		assertEquals(0, buffer.getCursorRow());
+	}
+
+	@Test
+	public void scrollbackIsWrappedWhenScrolledTo() {
+		for (int i = 0; i < 8; i++)
+			buffer.putString(repeat((char) ('a' + i), 25) + "\r\n");
+		buffer.setScreenSize(10, 5, false);
+
+		// only the screen is laid out for the new width so far
+		assertEquals(20, buffer.charArray[0].length);
+		for (int l = 0; l < 5; l++)
+			assertEquals(10, buffer.charArray[buffer.screenBase + l].length);
+		assertEquals("hhhhh", row(buffer.screenBase + 3));
+		assertEquals(0, buffer.getCursorColumn());
+		assertEquals(4, buffer.getCursorRow());
+
+		int linesAbove = buffer.screenBase;
+		buffer.setWindowBase(0);
+
+		for (int l = 0; l < buffer.getBufferSize(); l++)
+			assertEquals(10, buffer.charArray[l].length);
+		assertEquals(repeat('a', 10), row(0));
+		assertEquals(repeat('a', 5), row(2));
+		assertTrue(buffer.isWrapped(0));
+		assertTrue(buffer.isWrapped(1));
+		assertFalse(buffer.isWrapped(2));
+		assertEquals(buffer.screenBase - linesAbove, buffer.getWindowBase());
+	}
+
+	@Test
+	public void marksFollowTheirRowsWhenRotated() {
+		buffer.setBufferSize(100);
+		List<String> prompts = new ArrayList<>();
+		for (int i = 0; i < 6; i++) {
+			buffer.putString("\u001b]133;A\u0007$ " + i + "\r\n\u001b]133;C\u0007"
+					+ repeat((char) ('a' + i), 25) + "\r\n\u001b]133;D;0\u0007");
+			prompts.add("$ " + i);
+		}
+		// the last prompt is on the screen, the others in the history
+		assertEquals(buffer.screenBase + 1, buffer.prompts.getPreviousPrompt(buffer.bufSize));
+
+		buffer.setScreenSize(10, 5, false);
+
+		assertEquals(prompts, promptRows());
+		int last = buffer.prompts.getPreviousPrompt(buffer.bufSize);
+		assertTrue(last >= buffer.screenBase);
+		int[] output = buffer.prompts.getOutputRange(last);
+		assertEquals(last + 1, output[0]);
+		assertEquals(last + 4, output[1]);
+		assertEquals("fffff", row(output[1] - 1));
+
+		// wrap the history for the new width too
+		buffer.setWindowBase(0);
+
+		assertEquals(prompts, promptRows());
+		int first = buffer.prompts.getNextPrompt(-1);
+		output = buffer.prompts.getOutputRange(first);
+		assertEquals(first + 1, output[0]);
+		assertEquals(first + 4, output[1]);
+		assertEquals(repeat('a', 10), row(output[0]));
+		assertEquals("aaaaa", row(output[1] - 1));
+
+		buffer.setScreenSize(20, 5, false);
+		buffer.setWindowBase(0);
+
+		assertEquals(prompts, promptRows());
+		output = buffer.prompts.getOutputRange(buffer.prompts.getNextPrompt(-1));
+		assertEquals(2, output[1] - output[0]);
+		assertEquals(repeat('a', 20), row(output[0]));
+	}
+
+	@Test
+	public void savedScreenKeepsSoftWraps() throws IOException {
+		buffer.putString(repeat('a', 25) + "\r\nb");
+		ByteArrayOutputStream state = new ByteArrayOutputStream();
+		buffer.saveScreenState(new DataOutputStream(state));
+
+		buffer = newTerminal();
+		buffer.putString(repeat('x', 25));
+		buffer.restoreScreenState(new DataInputStream(new ByteArrayInputStream(state.toByteArray())));
+
+		assertTrue(buffer.isWrapped(buffer.screenBase));
+		assertFalse(buffer.isWrapped(buffer.screenBase + 1));
+
+		// a resize after a seek joins the wrapped line, not just its rows
+		buffer.setScreenSize(30, 5, false);
+		assertEquals(repeat('a', 25), row(buffer.screenBase));
+		assertEquals("b", row(buffer.screenBase + 1));
+	}
+}
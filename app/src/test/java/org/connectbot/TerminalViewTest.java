@@ -0,0 +1,55 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot;
+
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import android.net.Uri;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class TerminalViewTest {
+	private static boolean allowed(String link) {
+		return TerminalView.isLinkAllowed(Uri.parse(link));
+	}
+
+	@Test
+	public void webAndMailLinksAreAllowed() {
+		assertTrue(allowed("http://example.com/"));
+		assertTrue(allowed("HTTPS://example.com/path?q=1"));
+		assertTrue(allowed("mailto:root@example.com"));
+	}
+
+	@Test
+	public void otherSchemesAreRefused() {
+		assertFalse(allowed("intent://scan/#Intent;scheme=zxing;end"));
+		assertFalse(allowed("content://com.example.provider/secret"));
+		assertFalse(allowed("tel:5551234"));
+		assertFalse(allowed("file:///sdcard/private"));
+		assertFalse(allowed("javascript:alert(1)"));
+	}
+
+	@Test
+	public void linksWithoutSchemeAreRefused() {
+		assertFalse(allowed("example.com"));
+		assertFalse(allowed(""));
+	}
+}
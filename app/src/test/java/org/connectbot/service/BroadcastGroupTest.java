@@ -0,0 +1,198 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.io.IOException;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.LinkedBlockingQueue;
+import java.util.concurrent.TimeUnit;
+
+import org.connectbot.bean.HostBean;
+import org.connectbot.mock.NullTransport;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertSame;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class BroadcastGroupTest {
+	@Test
+	public void membershipIsTrackedOnBridge() {
+		BroadcastGroup group = new BroadcastGroup();
+		TerminalBridge first = new TerminalBridge();
+		TerminalBridge second = new TerminalBridge();
+
+		assertTrue(group.add(first));
+		assertTrue(group.add(second));
+		assertFalse(group.add(first));
+
+		assertEquals(2, group.size());
+		assertSame(group, first.getBroadcastGroup());
+
+		assertTrue(group.remove(first));
+		assertFalse(group.contains(first));
+		assertNull(first.getBroadcastGroup());
+
+		group.clear();
+		assertEquals(0, group.size());
+		assertNull(second.getBroadcastGroup());
+	}
+
+	@Test
+	public void singleBytesAreShared() {
+		assertSame(BroadcastGroup.singleByte('a'), BroadcastGroup.singleByte('a'));
+		assertEquals((byte) 0xff, BroadcastGroup.singleByte(0xff)[0]);
+	}
+
+	@Test
+	public void inputIsSentToEveryOtherMember() throws Exception {
+		BroadcastGroup group = new BroadcastGroup();
+		RecordingTransport sourceHost = new RecordingTransport();
+		RecordingTransport firstHost = new RecordingTransport();
+		RecordingTransport secondHost = new RecordingTransport();
+		TerminalBridge source = bridge("source", sourceHost);
+		TerminalBridge first = bridge("first", firstHost);
+		TerminalBridge second = bridge("second", secondHost);
+		group.add(source);
+		group.add(first);
+		group.add(second);
+
+		byte[] keys = "ls\r".getBytes("UTF-8");
+		source.sendInput(keys);
+		source.sendInput('q');
+
+		assertArrayEquals(keys, sourceHost.next());
+		assertArrayEquals(keys, firstHost.next());
+		assertArrayEquals(keys, secondHost.next());
+		assertArrayEquals(new byte[] {'q'}, firstHost.next());
+		assertArrayEquals(new byte[] {'q'}, secondHost.next());
+		// the source already wrote its own input once
+		assertArrayEquals(new byte[] {'q'}, sourceHost.next());
+		assertNull(sourceHost.written.poll());
+
+		group.clear();
+	}
+
+	@Test
+	public void slowMemberIsDroppedWithoutHoldingUpOthers() throws Exception {
+		BroadcastGroup group = new BroadcastGroup();
+		BlockedTransport slowHost = new BlockedTransport();
+		RecordingTransport fastHost = new RecordingTransport();
+		TerminalBridge source = bridge("source", new RecordingTransport());
+		TerminalBridge slow = bridge("slow", slowHost);
+		TerminalBridge fast = bridge("fast", fastHost);
+		group.add(source);
+		group.add(slow);
+		group.add(fast);
+
+		// The slow host never finishes its first write, so nothing it was sent
+		// stops counting against it.
+		byte[] chunk = new byte[BroadcastGroup.MAX_PENDING_BYTES / 2 + 1];
+		source.sendInput(chunk);
+		assertTrue(group.contains(slow));
+
+		source.sendInput(chunk);
+		assertFalse(group.contains(slow));
+		assertNull(slow.getBroadcastGroup());
+		assertTrue(group.contains(fast));
+
+		assertArrayEquals(chunk, fastHost.next());
+		assertArrayEquals(chunk, fastHost.next());
+
+		slowHost.release.countDown();
+		group.clear();
+	}
+
+	@Test
+	public void memberIsDroppedWhenItDisconnects() throws Exception {
+		BroadcastGroup group = new BroadcastGroup();
+		RecordingTransport goneHost = new RecordingTransport();
+		RecordingTransport otherHost = new RecordingTransport();
+		TerminalBridge source = bridge("source", new RecordingTransport());
+		TerminalBridge gone = bridge("gone", goneHost);
+		TerminalBridge other = bridge("other", otherHost);
+		group.add(source);
+		group.add(gone);
+		group.add(other);
+
+		gone.dispatchDisconnect(true);
+
+		assertFalse(group.contains(gone));
+		assertNull(gone.getBroadcastGroup());
+		assertEquals(2, group.size());
+
+		source.sendInput('x');
+		assertArrayEquals(new byte[] {'x'}, otherHost.next());
+		assertNull(goneHost.written.poll());
+
+		group.clear();
+	}
+
+	private static TerminalBridge bridge(String nickname, NullTransport transport) {
+		TerminalBridge bridge = new TerminalBridge();
+		bridge.host = new HostBean();
+		bridge.host.setNickname(nickname);
+		bridge.transport = transport;
+		return bridge;
+	}
+
+	private static class RecordingTransport extends NullTransport {
+		final LinkedBlockingQueue<byte[]> written = new LinkedBlockingQueue<>();
+
+		@Override
+		public boolean isSessionOpen() {
+			return true;
+		}
+
+		@Override
+		public void write(byte[] buffer) {
+			written.add(buffer);
+		}
+
+		@Override
+		public void write(int c) {
+			written.add(new byte[] {(byte) c});
+		}
+
+		/** Wait for the member's writer thread to hand over the next write. */
+		byte[] next() throws InterruptedException {
+			byte[] data = written.poll(10, TimeUnit.SECONDS);
+			assertTrue("expected more input", data != null);
+			return data;
+		}
+	}
+
+	private static class BlockedTransport extends RecordingTransport {
+		final CountDownLatch release = new CountDownLatch(1);
+
+		@Override
+		public void write(byte[] buffer) {
+			try {
+				release.await();
+			} catch (InterruptedException e) {
+				Thread.currentThread().interrupt();
+			}
+		}
+	}
+}
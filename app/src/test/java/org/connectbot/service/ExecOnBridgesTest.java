@@ -0,0 +1,201 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.io.ByteArrayOutputStream;
+import java.io.IOException;
+import java.io.InterruptedIOException;
+import java.io.OutputStream;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.Future;
+import java.util.concurrent.TimeUnit;
+
+import org.connectbot.mock.NullTransport;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertTrue;
+import static org.junit.Assert.fail;
+
+@RunWith(AndroidJUnit4.class)
+public class ExecOnBridgesTest {
+	private TerminalManager manager;
+	private final Map<TerminalBridge, ByteArrayOutputStream> stdout = new HashMap<>();
+	private final Map<TerminalBridge, ByteArrayOutputStream> stderr = new HashMap<>();
+
+	private final ExecOutputProvider outputs = new ExecOutputProvider() {
+		@Override
+		public OutputStream getStdout(TerminalBridge bridge) {
+			return stdout.get(bridge);
+		}
+
+		@Override
+		public OutputStream getStderr(TerminalBridge bridge) {
+			return stderr.get(bridge);
+		}
+	};
+
+	@Before
+	public void setUp() {
+		manager = new TerminalManager();
+	}
+
+	@Test
+	public void exitStatusOfEachHostIsReturnedInOrder() throws Exception {
+		TerminalBridge first = bridge(new ExecTransport("", "", 0));
+		TerminalBridge second = bridge(new ExecTransport("", "", 3));
+
+		List<Future<Integer>> results = manager.execOnBridges(Arrays.asList(first, second),
+				"true", outputs, 0);
+
+		assertEquals(2, results.size());
+		assertEquals(0, (int) results.get(0).get());
+		assertEquals(3, (int) results.get(1).get());
+	}
+
+	@Test
+	public void outputIsCapturedPerHost() throws Exception {
+		TerminalBridge first = bridge(new ExecTransport("one\n", "warn one\n", 0));
+		TerminalBridge second = bridge(new ExecTransport("two\n", "", 1));
+
+		List<Future<Integer>> results = manager.execOnBridges(Arrays.asList(first, second),
+				"hostname", outputs, 0);
+		for (Future<Integer> result : results)
+			result.get();
+
+		assertEquals("one\n", stdout.get(first).toString());
+		assertEquals("warn one\n", stderr.get(first).toString());
+		assertEquals("two\n", stdout.get(second).toString());
+		assertEquals("", stderr.get(second).toString());
+	}
+
+	@Test
+	public void deadlineEndsCommandThatKeepsRunning() throws Exception {
+		HangingTransport hanging = new HangingTransport();
+		ExecTransport quick = new ExecTransport("done\n", "", 0);
+		TerminalBridge slow = bridge(hanging);
+		TerminalBridge fast = bridge(quick);
+
+		long start = System.nanoTime();
+		List<Future<Integer>> results = manager.execOnBridges(Arrays.asList(slow, fast),
+				"sleep 100", outputs, 25);
+
+		try {
+			results.get(0).get(5, TimeUnit.SECONDS);
+			fail("command past its deadline should fail");
+		} catch (ExecutionException e) {
+			assertTrue(e.getCause() instanceof InterruptedIOException);
+		}
+		long elapsedMillis = TimeUnit.NANOSECONDS.toMillis(System.nanoTime() - start);
+		assertTrue("ended before its deadline: " + elapsedMillis + "ms", elapsedMillis >= 25);
+		assertTrue(hanging.interrupted);
+		assertEquals(25, hanging.timeoutMillis);
+
+		assertEquals(0, (int) results.get(1).get());
+		assertEquals(25, quick.timeoutMillis);
+		assertEquals("done\n", stdout.get(fast).toString());
+	}
+
+	@Test
+	public void hostThatCannotExecFails() throws Exception {
+		TerminalBridge bridge = bridge(new NullTransport());
+
+		List<Future<Integer>> results = manager.execOnBridges(Arrays.asList(bridge),
+				"true", outputs, 0);
+
+		try {
+			results.get(0).get();
+			fail("host without exec support should fail");
+		} catch (ExecutionException e) {
+			assertTrue(e.getCause() instanceof IOException);
+		}
+	}
+
+	private TerminalBridge bridge(NullTransport transport) {
+		TerminalBridge bridge = new TerminalBridge();
+		bridge.transport = transport;
+		stdout.put(bridge, new ByteArrayOutputStream());
+		stderr.put(bridge, new ByteArrayOutputStream());
+		return bridge;
+	}
+
+	private static class ExecTransport extends NullTransport {
+		private final String out;
+		private final String err;
+		private final int exitStatus;
+		volatile long timeoutMillis = -1;
+
+		ExecTransport(String out, String err, int exitStatus) {
+			this.out = out;
+			this.err = err;
+			this.exitStatus = exitStatus;
+		}
+
+		@Override
+		public boolean isConnected() {
+			return true;
+		}
+
+		@Override
+		public boolean canExec() {
+			return true;
+		}
+
+		@Override
+		public int exec(String command, OutputStream stdout, OutputStream stderr,
+				long timeoutMillis) throws IOException {
+			this.timeoutMillis = timeoutMillis;
+			stdout.write(out.getBytes("UTF-8"));
+			stderr.write(err.getBytes("UTF-8"));
+			return exitStatus;
+		}
+	}
+
+	/**
+	 * Runs a command that never finishes and ignores its timeout, so only
+	 * the deadline of execOnBridges can end it.
+	 */
+	private static class HangingTransport extends ExecTransport {
+		private final CountDownLatch never = new CountDownLatch(1);
+		volatile boolean interrupted;
+
+		HangingTransport() {
+			super("", "", 0);
+		}
+
+		@Override
+		public int exec(String command, OutputStream stdout, OutputStream stderr,
+				long timeoutMillis) throws IOException {
+			this.timeoutMillis = timeoutMillis;
+			try {
+				never.await();
+			} catch (InterruptedException e) {
+				interrupted = true;
+			}
+			throw new IOException("Channel closed");
+		}
+	}
+}
@@ -0,0 +1,141 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.concurrent.TimeUnit;
+
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+
+@RunWith(AndroidJUnit4.class)
+public class FrameSchedulerTest {
+	private FakeClock clock;
+	private FrameScheduler scheduler;
+	private List<String> painted;
+
+	@Before
+	public void setUp() {
+		clock = new FakeClock();
+		scheduler = new FrameScheduler(clock);
+		// No real frames; each test runs doFrame itself.
+		scheduler.quit();
+		painted = new ArrayList<>();
+	}
+
+	@Test
+	public void repeatedDamageIsPaintedOncePerFrame() {
+		Target scrolling = new Target("scrolling", 0);
+		Target other = new Target("other", 0);
+
+		// a burst of scrolling reports damage many times before the frame
+		for (int i = 0; i < 10; i++)
+			scheduler.requestFrame(scrolling);
+		scheduler.requestFrame(other);
+		scheduler.requestFrame(scrolling);
+		scheduler.doFrame();
+
+		assertEquals(Arrays.asList("scrolling", "other"), painted);
+		assertEquals(0, scheduler.getDeferredTargets());
+
+		scheduler.doFrame();
+		assertEquals(2, painted.size());
+	}
+
+	@Test
+	public void targetsPastTheBudgetWaitForTheNextFrame() {
+		Target first = new Target("first", 5);
+		Target second = new Target("second", 5);
+		Target third = new Target("third", 5);
+		scheduler.requestFrame(first);
+		scheduler.requestFrame(second);
+		scheduler.requestFrame(third);
+
+		scheduler.doFrame();
+
+		assertEquals(Arrays.asList("first", "second"), painted);
+		assertEquals(1, scheduler.getDeferredTargets());
+		assertEquals(TimeUnit.MILLISECONDS.toNanos(10), scheduler.getLastFrameNanos());
+
+		// the target that was put off goes ahead of newer damage
+		scheduler.requestFrame(first);
+		painted.clear();
+		scheduler.doFrame();
+
+		assertEquals(Arrays.asList("third", "first"), painted);
+		assertEquals(0, scheduler.getDeferredTargets());
+	}
+
+	@Test
+	public void slowTargetIsStillPaintedEachFrame() {
+		Target slow = new Target("slow", 20);
+		Target next = new Target("next", 0);
+		scheduler.requestFrame(slow);
+		scheduler.requestFrame(next);
+
+		scheduler.doFrame();
+		assertEquals(Arrays.asList("slow"), painted);
+
+		scheduler.doFrame();
+		assertEquals(Arrays.asList("slow", "next"), painted);
+	}
+
+	@Test
+	public void cancelledDamageIsDropped() {
+		Target gone = new Target("gone", 0);
+		Target kept = new Target("kept", 0);
+		scheduler.requestFrame(gone);
+		scheduler.requestFrame(kept);
+		scheduler.cancel(gone);
+
+		scheduler.doFrame();
+
+		assertEquals(Arrays.asList("kept"), painted);
+	}
+
+	private class Target implements FrameScheduler.Target {
+		private final String name;
+		private final long costNanos;
+
+		Target(String name, long costMillis) {
+			this.name = name;
+			this.costNanos = TimeUnit.MILLISECONDS.toNanos(costMillis);
+		}
+
+		@Override
+		public void renderFrame() {
+			painted.add(name);
+			clock.now += costNanos;
+		}
+	}
+
+	private static class FakeClock implements FrameScheduler.Clock {
+		long now;
+
+		@Override
+		public long nanoTime() {
+			return now;
+		}
+	}
+}
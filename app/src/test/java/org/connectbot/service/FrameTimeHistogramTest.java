@@ -0,0 +1,56 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.concurrent.TimeUnit;
+
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class FrameTimeHistogramTest {
+	@Test
+	public void record_SortsIntoBuckets() {
+		FrameTimeHistogram histogram = new FrameTimeHistogram("test");
+		histogram.record(TimeUnit.MICROSECONDS.toNanos(500));
+		histogram.record(TimeUnit.MILLISECONDS.toNanos(1));
+		histogram.record(TimeUnit.MILLISECONDS.toNanos(12));
+		histogram.record(TimeUnit.MILLISECONDS.toNanos(200));
+
+		assertEquals(4, histogram.getCount());
+		assertEquals(1, histogram.getBucketCount(0));
+		assertEquals(1, histogram.getBucketCount(1));
+		assertEquals(1, histogram.getBucketCount(4));
+		assertEquals(1, histogram.getBucketCount(FrameTimeHistogram.BOUNDS_MILLIS.length));
+		assertTrue(histogram.toString().contains("max 200.0 ms"));
+	}
+
+	@Test
+	public void reset_ClearsCounts() {
+		FrameTimeHistogram histogram = new FrameTimeHistogram("test");
+		histogram.record(TimeUnit.MILLISECONDS.toNanos(3));
+		histogram.reset();
+
+		assertEquals(0, histogram.getCount());
+		assertEquals(0, histogram.getBucketCount(2));
+	}
+}
@@ -0,0 +1,85 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.Map;
+
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertEquals;
+
+@RunWith(AndroidJUnit4.class)
+public class InlineImageTest {
+	private static final int CHAR_WIDTH = 10;
+	private static final int CHAR_HEIGHT = 20;
+	private static final int SCREEN_WIDTH = 800;
+	private static final int SCREEN_HEIGHT = 480;
+
+	private static int[] size(String params, int imageWidth, int imageHeight, int maxWidth) {
+		return InlineImage.computeSize(InlineImage.parseArguments(params), imageWidth,
+				imageHeight, CHAR_WIDTH, CHAR_HEIGHT, SCREEN_WIDTH, SCREEN_HEIGHT, maxWidth);
+	}
+
+	@Test
+	public void parsesArguments() {
+		Map<String, String> arguments = InlineImage.parseArguments("name=Zm9v;size=3;inline=1");
+
+		assertEquals("Zm9v", arguments.get("name"));
+		assertEquals("3", arguments.get("size"));
+		assertEquals("1", arguments.get("inline"));
+	}
+
+	@Test
+	public void parsesDimensions() {
+		assertEquals(-1, InlineImage.parseDimension(null, CHAR_WIDTH, SCREEN_WIDTH));
+		assertEquals(-1, InlineImage.parseDimension("auto", CHAR_WIDTH, SCREEN_WIDTH));
+		assertEquals(50, InlineImage.parseDimension("5", CHAR_WIDTH, SCREEN_WIDTH));
+		assertEquals(123, InlineImage.parseDimension("123px", CHAR_WIDTH, SCREEN_WIDTH));
+		assertEquals(400, InlineImage.parseDimension("50%", CHAR_WIDTH, SCREEN_WIDTH));
+		assertEquals(-1, InlineImage.parseDimension("wide", CHAR_WIDTH, SCREEN_WIDTH));
+	}
+
+	@Test
+	public void autoKeepsImageSize() {
+		assertArrayEquals(new int[] { 200, 100 }, size("inline=1", 200, 100, SCREEN_WIDTH));
+	}
+
+	@Test
+	public void oneDimensionKeepsAspectRatio() {
+		assertArrayEquals(new int[] { 100, 50 }, size("width=10", 200, 100, SCREEN_WIDTH));
+		assertArrayEquals(new int[] { 80, 40 }, size("height=2", 200, 100, SCREEN_WIDTH));
+	}
+
+	@Test
+	public void bothDimensionsFitInsideBox() {
+		assertArrayEquals(new int[] { 100, 50 },
+				size("width=100px;height=100px", 200, 100, SCREEN_WIDTH));
+		assertArrayEquals(new int[] { 100, 100 },
+				size("width=100px;height=100px;preserveAspectRatio=0", 200, 100, SCREEN_WIDTH));
+	}
+
+	@Test
+	public void shrinksToAvailableWidth() {
+		assertArrayEquals(new int[] { 300, 150 }, size("inline=1", 1000, 500, 300));
+		assertArrayEquals(new int[] { 300, 500 },
+				size("preserveAspectRatio=0", 1000, 500, 300));
+	}
+}
@@ -0,0 +1,110 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.TimeUnit;
+
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+import org.robolectric.shadows.ShadowLooper;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+
+@RunWith(AndroidJUnit4.class)
+public class ResizeCoordinatorTest {
+	private final List<String> sent = new ArrayList<>();
+	private ResizeCoordinator resizer;
+
+	@Before
+	public void setUp() {
+		resizer = new ResizeCoordinator(new ResizeCoordinator.Sink() {
+			@Override
+			public void setDimensions(int columns, int rows, int width, int height) {
+				sent.add(columns + "x" + rows);
+			}
+		});
+	}
+
+	private static void settle() {
+		ShadowLooper.idleMainLooper(ResizeCoordinator.SETTLE_MILLIS, TimeUnit.MILLISECONDS);
+	}
+
+	@Test
+	public void sendsOnlyTheLastSizeOfABurst() {
+		resizer.request(80, 24, 800, 480);
+		resizer.request(60, 40, 600, 800);
+		resizer.request(60, 30, 600, 600);
+		assertEquals(0, sent.size());
+
+		settle();
+
+		assertEquals(1, sent.size());
+		assertEquals("60x30", sent.get(0));
+		assertEquals(2, resizer.getSuppressedCount());
+	}
+
+	@Test
+	public void waitsForTheSizeToSettle() {
+		resizer.request(80, 24, 800, 480);
+		ShadowLooper.idleMainLooper(ResizeCoordinator.SETTLE_MILLIS - 50, TimeUnit.MILLISECONDS);
+		resizer.request(100, 24, 1000, 480);
+		ShadowLooper.idleMainLooper(ResizeCoordinator.SETTLE_MILLIS - 50, TimeUnit.MILLISECONDS);
+		assertEquals(0, sent.size());
+
+		settle();
+
+		assertEquals(1, sent.size());
+		assertEquals("100x24", sent.get(0));
+	}
+
+	@Test
+	public void suppressesRepeatedSize() {
+		resizer.request(80, 24, 800, 480);
+		settle();
+		resizer.request(60, 40, 600, 800);
+		resizer.request(80, 24, 800, 480);
+		settle();
+
+		assertEquals(1, sent.size());
+		assertEquals(1, resizer.getSentCount());
+	}
+
+	@Test
+	public void resetSendsSameSizeAgain() {
+		resizer.request(80, 24, 800, 480);
+		resizer.flush();
+		resizer.reset();
+		resizer.request(80, 24, 800, 480);
+		resizer.flush();
+
+		assertEquals(2, sent.size());
+	}
+
+	@Test
+	public void cancelDropsPendingSize() {
+		resizer.request(80, 24, 800, 480);
+		resizer.cancel();
+		settle();
+
+		assertEquals(0, sent.size());
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.util.Collections;
+import java.util.HashSet;
+import java.util.Set;
+import java.util.concurrent.atomic.AtomicIntegerArray;
+
+import org.junit.After;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import android.graphics.Bitmap;
+import android.graphics.Canvas;
+import android.graphics.Paint;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class RowRenderPoolTest {
+	private final RowRenderPool pool = new RowRenderPool(4);
+
+	@After
+	public void tearDown() {
+		pool.shutdown();
+	}
+
+	@Test
+	public void smallRepaintsAreNotSplit() {
+		assertFalse(pool.shouldSplit(2 * RowRenderPool.MIN_ROWS_PER_BAND - 1));
+		assertTrue(pool.shouldSplit(2 * RowRenderPool.MIN_ROWS_PER_BAND));
+		assertFalse(new RowRenderPool(1).shouldSplit(100));
+	}
+
+	@Test
+	public void everyRowIsPaintedOnceBeforeReturning() {
+		final int count = 100;
+		int[] rows = new int[count];
+		for (int i = 0; i < count; i++)
+			rows[i] = i * 2;
+
+		final AtomicIntegerArray painted = new AtomicIntegerArray(2 * count);
+		final Set<Canvas> canvases = Collections.synchronizedSet(new HashSet<Canvas>());
+		final Set<Paint> paints = Collections.synchronizedSet(new HashSet<Paint>());
+
+		Bitmap bitmap = Bitmap.createBitmap(10, 10, Bitmap.Config.ARGB_8888);
+		pool.render(bitmap, new Paint(), rows, count, new RowRenderPool.RowPainter() {
+			@Override
+			public void paintRow(Canvas canvas, Paint paint, int row) {
+				painted.incrementAndGet(row);
+				canvases.add(canvas);
+				paints.add(paint);
+			}
+		});
+
+		for (int i = 0; i < 2 * count; i++)
+			assertEquals("row " + i, i % 2 == 0 ? 1 : 0, painted.get(i));
+		assertEquals(4, canvases.size());
+		assertEquals(4, paints.size());
+	}
+
+	@Test
+	public void bandsStartFromTemplatePaint() {
+		int[] rows = new int[32];
+		final Paint template = new Paint();
+		template.setTextSize(23f);
+
+		final AtomicIntegerArray mismatches = new AtomicIntegerArray(1);
+		pool.render(Bitmap.createBitmap(10, 10, Bitmap.Config.ARGB_8888), template, rows,
+				rows.length, new RowRenderPool.RowPainter() {
+					@Override
+					public void paintRow(Canvas canvas, Paint paint, int row) {
+						if (paint == template || paint.getTextSize() != 23f)
+							mismatches.incrementAndGet(0);
+					}
+				});
+
+		assertEquals(0, mismatches.get(0));
+	}
+}
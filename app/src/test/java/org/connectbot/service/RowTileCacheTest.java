@@ -0,0 +1,91 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import android.graphics.Bitmap;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertSame;
+
+@RunWith(AndroidJUnit4.class)
+public class RowTileCacheTest {
+	private RowTileCache tiles;
+
+	@Before
+	public void setUp() {
+		tiles = new RowTileCache();
+		tiles.setTileSize(80, 10, 3);
+	}
+
+	@Test
+	public void get_ReturnsObtainedTile() {
+		Bitmap tile = tiles.obtain(100);
+
+		assertEquals(80, tile.getWidth());
+		assertEquals(10, tile.getHeight());
+		assertSame(tile, tiles.get(100));
+		assertNull(tiles.get(101));
+		assertEquals(1, tiles.getHits());
+		assertEquals(1, tiles.getMisses());
+	}
+
+	@Test
+	public void obtain_ReusesLeastRecentlyUsedWhenFull() {
+		Bitmap first = tiles.obtain(1);
+		tiles.obtain(2);
+		tiles.obtain(3);
+
+		// touch 1 so that 2 is the oldest
+		assertNotNull(tiles.get(1));
+		Bitmap reused = tiles.obtain(4);
+
+		assertEquals(3, tiles.size());
+		assertNull(tiles.get(2));
+		assertSame(first, tiles.get(1));
+		assertNotNull(tiles.get(3));
+		assertSame(reused, tiles.get(4));
+	}
+
+	@Test
+	public void setVersion_DropsTilesOnChange() {
+		tiles.setVersion(1);
+		Bitmap tile = tiles.obtain(5);
+
+		tiles.setVersion(1);
+		assertSame(tile, tiles.get(5));
+
+		tiles.setVersion(2);
+		assertNull(tiles.get(5));
+		assertSame(tile, tiles.obtain(6));
+	}
+
+	@Test
+	public void setTileSize_DropsTilesOfOldSize() {
+		tiles.obtain(7);
+		tiles.setTileSize(80, 12, 3);
+
+		assertNull(tiles.get(7));
+		assertEquals(12, tiles.obtain(7).getHeight());
+	}
+}
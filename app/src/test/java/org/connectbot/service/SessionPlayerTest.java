@@ -0,0 +1,214 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.io.File;
+import java.io.IOException;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+import de.mud.terminal.VDUBuffer;
+import de.mud.terminal.VDUDisplay;
+import de.mud.terminal.vt320;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class SessionPlayerTest {
+	private static final int LINES = 200;
+	private static final int LINE_MILLIS = 100;
+
+	private File file;
+	private long clock;
+
+	@Before
+	public void setUp() throws IOException {
+		file = File.createTempFile("session", ".cbrec");
+
+		vt320 source = newTerminal();
+		SessionRecorder recorder = new SessionRecorder(file, source, 256) {
+			@Override
+			long now() {
+				return clock;
+			}
+		};
+		for (int i = 0; i < LINES; i++) {
+			clock = i * LINE_MILLIS;
+			char[] line = lineFor(i).toCharArray();
+			source.putString(line, null, 0, line.length);
+			recorder.onOutput(line, line.length);
+		}
+		recorder.close();
+	}
+
+	@After
+	public void tearDown() {
+		file.delete();
+	}
+
+	private static String lineFor(int i) {
+		return "\u001b[3" + (i % 8) + "mline " + i + "\r\n";
+	}
+
+	private static vt320 newTerminal() {
+		vt320 terminal = new vt320() {
+			@Override
+			public void write(byte[] b) {}
+			@Override
+			public void write(int b) {}
+			@Override
+			public void sendTelnetCommand(byte cmd) {}
+			@Override
+			public void setWindowSize(int c, int r) {}
+			@Override
+			public void debug(String s) {}
+		};
+		terminal.setDisplay(new VDUDisplay() {
+			@Override
+			public void redraw() {}
+			@Override
+			public void updateScrollBar() {}
+			@Override
+			public void setVDUBuffer(VDUBuffer buffer) {}
+			@Override
+			public VDUBuffer getVDUBuffer() { return null; }
+			@Override
+			public void setColor(int index, int red, int green, int blue) {}
+			@Override
+			public void resetColors() {}
+		});
+		terminal.setScreenSize(20, 5, false);
+		return terminal;
+	}
+
+	/** Screen of a terminal that was given every line up to {@code last}. */
+	private static vt320 replayedUpTo(int last) {
+		vt320 terminal = newTerminal();
+		for (int i = 0; i <= last; i++)
+			terminal.putString(lineFor(i));
+		return terminal;
+	}
+
+	private static void assertSameScreen(vt320 expected, vt320 actual) {
+		assertEquals(expected.getCursorRow(), actual.getCursorRow());
+		assertEquals(expected.getCursorColumn(), actual.getCursorColumn());
+		for (int l = 0; l < expected.height; l++) {
+			for (int c = 0; c < expected.width; c++) {
+				assertEquals("char at " + c + "," + l, expected.getChar(c, l), actual.getChar(c, l));
+				assertEquals("attributes at " + c + "," + l,
+						expected.getAttributes(c, l), actual.getAttributes(c, l));
+			}
+		}
+	}
+
+	@Test
+	public void seeksForwardAndBack() throws IOException {
+		vt320 terminal = newTerminal();
+		SessionPlayer player = new SessionPlayer(file, terminal);
+		try {
+			assertEquals((LINES - 1) * LINE_MILLIS, player.getDuration());
+
+			player.seek(150 * LINE_MILLIS);
+			assertSameScreen(replayedUpTo(150), terminal);
+
+			player.seek(37 * LINE_MILLIS + 50);
+			assertSameScreen(replayedUpTo(37), terminal);
+
+			player.seek(38 * LINE_MILLIS);
+			assertSameScreen(replayedUpTo(38), terminal);
+		} finally {
+			player.close();
+		}
+	}
+
+	@Test
+	public void seekStartsFromNearbyKeyframe() throws IOException {
+		SessionPlayer player = new SessionPlayer(file, newTerminal());
+		try {
+			assertTrue(player.findKeyframe(150 * LINE_MILLIS) > 0);
+		} finally {
+			player.close();
+		}
+	}
+
+	@Test
+	public void advanceAppliesSpeed() throws IOException {
+		vt320 terminal = newTerminal();
+		SessionPlayer player = new SessionPlayer(file, terminal);
+		try {
+			player.setSpeed(4f);
+			player.advance(10 * LINE_MILLIS);
+
+			assertEquals(40 * LINE_MILLIS, player.getTime());
+			assertSameScreen(replayedUpTo(40), terminal);
+		} finally {
+			player.close();
+		}
+	}
+
+	@Test
+	public void forwardPlaybackFollowsResize() throws IOException {
+		File resized = File.createTempFile("resized", ".cbrec");
+		try {
+			clock = 0;
+			vt320 source = newTerminal();
+			// no keyframes from output, only the first one and the resize
+			SessionRecorder recorder = new SessionRecorder(resized, source, 1 << 20) {
+				@Override
+				long now() {
+					return clock;
+				}
+			};
+			for (int i = 0; i < 20; i++) {
+				clock = i * LINE_MILLIS;
+				if (i == 10) {
+					source.setScreenSize(30, 8, false);
+					recorder.requestKeyframe();
+				}
+				char[] line = lineFor(i).toCharArray();
+				source.putString(line, null, 0, line.length);
+				recorder.onOutput(line, line.length);
+			}
+			recorder.close();
+
+			vt320 terminal = newTerminal();
+			SessionPlayer player = new SessionPlayer(resized, terminal);
+			try {
+				player.advance(5 * LINE_MILLIS);
+				assertEquals(20, terminal.getColumns());
+				assertEquals(5, terminal.getRows());
+
+				player.advance(5 * LINE_MILLIS);
+				assertEquals(30, terminal.getColumns());
+				assertEquals(8, terminal.getRows());
+
+				player.advance(10 * LINE_MILLIS);
+				assertTrue(player.isFinished());
+				assertSameScreen(source, terminal);
+			} finally {
+				player.close();
+			}
+		} finally {
+			resized.delete();
+		}
+	}
+}
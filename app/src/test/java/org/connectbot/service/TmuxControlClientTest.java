@@ -0,0 +1,215 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.io.IOException;
+import java.io.UnsupportedEncodingException;
+import java.util.ArrayList;
+import java.util.List;
+
+import org.connectbot.mock.NullTransport;
+import org.connectbot.transport.TmuxPane;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class TmuxControlClientTest {
+	private CommandLog commands;
+	private int commandNumber;
+	@Test
+	public void unescapesOctal() {
+		byte[] bytes = TmuxControlClient.unescape("%output %1 ls\\015\\012\\134x", 11);
+		assertArrayEquals(new byte[] {'l', 's', '\r', '\n', '\\', 'x'}, bytes);
+	}
+
+	@Test
+	public void unescapeEncodesTextAsUtf8() {
+		byte[] bytes = TmuxControlClient.unescape("\u00e9\u20ac\ud83d\ude00", 0);
+		assertArrayEquals(new byte[] {
+				(byte) 0xc3, (byte) 0xa9,
+				(byte) 0xe2, (byte) 0x82, (byte) 0xac,
+				(byte) 0xf0, (byte) 0x9f, (byte) 0x98, (byte) 0x80}, bytes);
+	}
+
+	@Test
+	public void unescapeKeepsIncompleteEscape() {
+		assertArrayEquals(new byte[] {'a', '\\', '0', '1'},
+				TmuxControlClient.unescape("a\\01", 0));
+	}
+
+	@Test
+	public void stopsAfterExit() {
+		TmuxControlClient client = new TmuxControlClient(new TerminalBridge());
+		char[] data = ("%begin 1 2 0\r\n%end 1 2 0\r\n%output %1 hi\r\n%exit\r\n\033\\$ ")
+				.toCharArray();
+
+		int used = client.feed(data, 0, data.length);
+
+		assertTrue(client.isExited());
+		assertEquals("\033\\$ ", new String(data, used, data.length - used));
+	}
+
+	@Test
+	public void exitInsideBlockIsOutput() {
+		TmuxControlClient client = new TmuxControlClient(new TerminalBridge());
+		char[] data = "%begin 1 2 0\n%exit\n".toCharArray();
+
+		assertEquals(data.length, client.feed(data, 0, data.length));
+		assertFalse(client.isExited());
+	}
+
+	@Test
+	public void listedPanesAreCreatedAndCaptured() {
+		TmuxControlClient client = attach();
+		assertEquals(1, commands.sent.size());
+		assertTrue(commands.sent.get(0).startsWith("list-panes -s -F "));
+
+		respond(client, "%1 80 24 bash", "%2 100 30 vim");
+
+		assertNotNull(client.getPane("%1"));
+		assertNotNull(client.getPane("%2"));
+		assertNull(client.getPane("%3"));
+		assertEquals(3, commands.sent.size());
+		assertTrue(commands.sent.get(1).contains("capture-pane -p -e -t %1"));
+		assertTrue(commands.sent.get(2).contains("capture-pane -p -e -t %2"));
+	}
+
+	@Test
+	public void outputGoesToItsOwnPane() throws IOException {
+		TmuxControlClient client = attach();
+		respond(client, "%1 80 24 bash", "%2 80 24 vim");
+		TmuxPane first = client.getPane("%1");
+		TmuxPane second = client.getPane("%2");
+		first.setBridge(new TerminalBridge());
+		second.setBridge(new TerminalBridge());
+
+		// output from before the screen was captured is already on it
+		feed(client, "%output %1 early\n");
+
+		respond(client, "0 0");
+		respond(client, "first screen");
+		respond(client, "0 0");
+		respond(client, "second screen");
+
+		feed(client, "%output %2 hello\\015\\012\n");
+		feed(client, "%output %1 one\n");
+		feed(client, "%extended-output %2 12 : two\n");
+
+		String firstText = readAll(first);
+		assertTrue(firstText.contains("first screen"));
+		assertFalse(firstText.contains("early"));
+		assertTrue(firstText.endsWith("one"));
+		assertFalse(firstText.contains("hello"));
+
+		String secondText = readAll(second);
+		assertTrue(secondText.contains("second screen"));
+		assertTrue(secondText.endsWith("hello\r\ntwo"));
+		assertFalse(secondText.contains("one"));
+	}
+
+	@Test
+	public void layoutChangeResizesAndClosesPanes() throws IOException {
+		TmuxControlClient client = attach();
+		respond(client, "%1 80 24 bash", "%2 80 24 vim");
+		TmuxPane first = client.getPane("%1");
+		TmuxPane second = client.getPane("%2");
+		TerminalBridge firstBridge = new TerminalBridge();
+		first.setBridge(firstBridge);
+		for (int i = 0; i < 2; i++) {
+			respond(client, "0 0");
+			respond(client, "");
+		}
+
+		feed(client, "%layout-change @1 b25d,100x30,0,0,1 b25d,100x30,0,0,1 *\n");
+		assertTrue(commands.sent.get(commands.sent.size() - 1).startsWith("list-panes"));
+
+		respond(client, "%1 100 30 bash");
+
+		assertNull(client.getPane("%2"));
+		assertFalse(second.isConnected());
+		assertTrue(first.isConnected());
+
+		readAll(first);
+		assertEquals(100, firstBridge.buffer.getColumns());
+		assertEquals(30, firstBridge.buffer.getRows());
+	}
+
+	private TmuxControlClient attach() {
+		TerminalBridge gateway = new TerminalBridge();
+		commands = new CommandLog();
+		gateway.transport = commands;
+		return new TmuxControlClient(gateway);
+	}
+
+	private static void feed(TmuxControlClient client, String text) {
+		char[] data = text.toCharArray();
+		assertEquals(data.length, client.feed(data, 0, data.length));
+	}
+
+	/** Answer the oldest command still waiting, as tmux would. */
+	private void respond(TmuxControlClient client, String... lines) {
+		commandNumber++;
+		String guard = " 1700000000 " + commandNumber + " 1";
+		StringBuilder block = new StringBuilder("%begin").append(guard).append('\n');
+		for (String line : lines)
+			block.append(line).append('\n');
+		block.append("%end").append(guard).append('\n');
+		feed(client, block.toString());
+	}
+
+	/**
+	 * Everything queued for {@code pane} so far, as its terminal would read
+	 * it, running the queued tasks on the way.
+	 */
+	private static String readAll(TmuxPane pane) throws IOException {
+		final boolean[] done = new boolean[1];
+		pane.post(new Runnable() {
+			@Override
+			public void run() {
+				done[0] = true;
+			}
+		});
+
+		StringBuilder text = new StringBuilder();
+		byte[] buf = new byte[4096];
+		while (!done[0]) {
+			int n = pane.read(buf, 0, buf.length);
+			text.append(new String(buf, 0, n, "UTF-8"));
+		}
+		return text.toString();
+	}
+
+	/** The gateway's connection, which only collects the commands sent to tmux. */
+	private static class CommandLog extends NullTransport {
+		final List<String> sent = new ArrayList<>();
+
+		@Override
+		public void write(byte[] buffer) throws UnsupportedEncodingException {
+			String command = new String(buffer, "UTF-8");
+			sent.add(command.substring(0, command.length() - 1));
+		}
+	}
+}
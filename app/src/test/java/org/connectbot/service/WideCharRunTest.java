@@ -0,0 +1,59 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.connectbot.service;
+
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertEquals;
+
+@RunWith(AndroidJUnit4.class)
+public class WideCharRunTest {
+	@Test
+	public void gathersEveryOtherCellTwoCellsApart() {
+		char[] line = "ab中 文 字 z".toCharArray();
+		WideCharRun run = new WideCharRun();
+
+		int count = run.gather(line, 2, 6, 20f, 15f, 10);
+
+		assertEquals(3, count);
+		assertEquals("中文字", new String(run.glyphs, 0, count));
+		float[] expected = {20f, 15f, 40f, 15f, 60f, 15f};
+		float[] actual = new float[count * 2];
+		System.arraycopy(run.positions, 0, actual, 0, actual.length);
+		assertArrayEquals(expected, actual, 0f);
+	}
+
+	@Test
+	public void scratchGrowsForLongerRuns() {
+		char[] line = new char[200];
+		for (int i = 0; i < line.length; i += 2) {
+			line[i] = (char) (0x4e00 + i);
+			line[i + 1] = ' ';
+		}
+		WideCharRun run = new WideCharRun();
+
+		assertEquals(2, run.gather(line, 0, 4, 0f, 0f, 8));
+		assertEquals(100, run.gather(line, 0, 200, 0f, 0f, 8));
+		assertEquals((char) (0x4e00 + 198), run.glyphs[99]);
+		assertEquals(99 * 16f, run.positions[198], 0f);
+	}
+}
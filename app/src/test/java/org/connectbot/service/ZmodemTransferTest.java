@@ -0,0 +1,74 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.service;
+
+import java.io.File;
+import java.io.IOException;
+
+import org.junit.Rule;
+import org.junit.Test;
+import org.junit.rules.TemporaryFolder;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class ZmodemTransferTest {
+	@Rule
+	public TemporaryFolder folder = new TemporaryFolder();
+
+	@Test
+	public void safeName_KeepsOrdinaryNames() {
+		assertEquals("report-2020_v1.tar.gz", ZmodemTransfer.safeName("report-2020_v1.tar.gz"));
+	}
+
+	@Test
+	public void safeName_StripsDirectories() {
+		assertEquals("passwd", ZmodemTransfer.safeName("../../etc/passwd"));
+		assertEquals("file", ZmodemTransfer.safeName("/tmp/"));
+	}
+
+	@Test
+	public void safeName_NeverHidden() {
+		assertEquals("profile", ZmodemTransfer.safeName(".profile"));
+		assertEquals("file", ZmodemTransfer.safeName(".."));
+	}
+
+	@Test
+	public void safeName_ReplacesOddCharacters() {
+		assertEquals("a_b_c", ZmodemTransfer.safeName("a\\b:c"));
+	}
+
+	@Test
+	public void uniqueFile_DoesNotOverwrite() throws IOException {
+		File directory = folder.getRoot();
+		assertEquals(new File(directory, "notes.txt"),
+				ZmodemTransfer.uniqueFile(directory, "notes.txt"));
+
+		assertTrue(new File(directory, "notes.txt").createNewFile());
+		assertTrue(new File(directory, "notes-1.txt").createNewFile());
+		assertEquals(new File(directory, "notes-2.txt"),
+				ZmodemTransfer.uniqueFile(directory, "notes.txt"));
+
+		assertTrue(new File(directory, "README").createNewFile());
+		assertEquals(new File(directory, "README-1"),
+				ZmodemTransfer.uniqueFile(directory, "README"));
+	}
+}
@@ -0,0 +1,182 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.transport;
+
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+
+@RunWith(AndroidJUnit4.class)
+public class ChannelSchedulerTest {
+	@Test
+	public void bulkWritesAreChunkedByQuantum() throws Exception {
+		ChannelScheduler scheduler = new ChannelScheduler();
+		ChannelScheduler.BulkChannel channel = scheduler.register();
+
+		assertEquals(ChannelScheduler.QUANTUM, scheduler.acquire(channel, 1 << 20));
+		assertEquals(100, scheduler.acquire(channel, 100));
+	}
+
+	@Test
+	public void loneChannelIsNotStarvedAfterItsQuantum() throws Exception {
+		ChannelScheduler scheduler = new ChannelScheduler();
+		ChannelScheduler.BulkChannel busy = scheduler.register();
+		scheduler.register();
+
+		for (int i = 0; i < 4; i++)
+			assertEquals(ChannelScheduler.QUANTUM, scheduler.acquire(busy, ChannelScheduler.QUANTUM));
+	}
+
+	@Test
+	public void interactiveWriteHoldsBulkBack() throws Exception {
+		FakeClock clock = new FakeClock();
+		ChannelScheduler scheduler = new ChannelScheduler(clock);
+		ChannelScheduler.BulkChannel channel = scheduler.register();
+
+		scheduler.onInteractiveWrite();
+		scheduler.acquire(channel, 1);
+
+		assertEquals(TimeUnit.MILLISECONDS.toNanos(ChannelScheduler.INTERACTIVE_HOLD_MILLIS),
+				clock.now);
+	}
+
+	@Test
+	public void bulkIsNotHeldOnceTheHoldHasPassed() throws Exception {
+		FakeClock clock = new FakeClock();
+		ChannelScheduler scheduler = new ChannelScheduler(clock);
+		ChannelScheduler.BulkChannel channel = scheduler.register();
+
+		scheduler.onInteractiveWrite();
+		clock.now += TimeUnit.MILLISECONDS.toNanos(ChannelScheduler.INTERACTIVE_HOLD_MILLIS);
+		long before = clock.now;
+		scheduler.acquire(channel, 1);
+
+		assertEquals(before, clock.now);
+	}
+
+	@Test
+	public void bulkProceedsWhenHeldChannelGoesIdle() throws Exception {
+		GateClock clock = new GateClock();
+		final ChannelScheduler scheduler = new ChannelScheduler(clock);
+		final ChannelScheduler.BulkChannel held = scheduler.register();
+		final ChannelScheduler.BulkChannel busy = scheduler.register();
+
+		assertEquals(ChannelScheduler.QUANTUM, scheduler.acquire(busy, ChannelScheduler.QUANTUM));
+		scheduler.onInteractiveWrite();
+
+		// held waits out the interactive hold with most of its quantum left
+		final AtomicInteger heldSent = new AtomicInteger();
+		Thread heldThread = new Thread(new Runnable() {
+			@Override
+			public void run() {
+				try {
+					heldSent.set(scheduler.acquire(held, 100));
+				} catch (InterruptedException e) {
+					// test failed
+				}
+			}
+		});
+		heldThread.start();
+		clock.gated.await();
+
+		// busy has used up its quantum and waits for held to finish the round
+		final AtomicInteger busySent = new AtomicInteger();
+		Thread busyThread = new Thread(new Runnable() {
+			@Override
+			public void run() {
+				try {
+					busySent.set(scheduler.acquire(busy, 100));
+				} catch (InterruptedException e) {
+					// test failed
+				}
+			}
+		});
+		busyThread.start();
+		while (busyThread.getState() != Thread.State.WAITING)
+			Thread.sleep(1);
+
+		// held sends a small chunk and then has nothing more to send
+		clock.open();
+		heldThread.join(5000);
+		assertEquals(100, heldSent.get());
+
+		busyThread.join(5000);
+		boolean stuck = busyThread.isAlive();
+		busyThread.interrupt();
+		assertFalse("bulk channel never woke up", stuck);
+		assertEquals(100, busySent.get());
+	}
+
+	/**
+	 * Time that only moves when the scheduler waits, by exactly as long as it
+	 * asked to wait.
+	 */
+	private static class FakeClock implements ChannelScheduler.Clock {
+		long now;
+
+		@Override
+		public long nanoTime() {
+			return now;
+		}
+
+		@Override
+		public void waitNanos(Object lock, long nanos) {
+			now += nanos;
+		}
+	}
+
+	/**
+	 * Like {@link FakeClock}, except that the first wait blocks until
+	 * {@link #open()} is called.
+	 */
+	private static class GateClock extends FakeClock {
+		final CountDownLatch gated = new CountDownLatch(1);
+		private Object lock;
+		private boolean opened;
+
+		@Override
+		public void waitNanos(Object lock, long nanos) {
+			if (this.lock == null) {
+				this.lock = lock;
+				gated.countDown();
+				while (!opened) {
+					try {
+						lock.wait();
+					} catch (InterruptedException e) {
+						return;
+					}
+				}
+			}
+			super.waitNanos(lock, nanos);
+		}
+
+		void open() {
+			synchronized (lock) {
+				opened = true;
+				lock.notifyAll();
+			}
+		}
+	}
+}
@@ -0,0 +1,264 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.transport;
+
+import java.util.ArrayList;
+import java.util.List;
+
+import org.connectbot.bean.HostBean;
+import org.connectbot.service.TerminalBridge;
+import org.connectbot.util.HostDatabase;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.core.app.ApplicationProvider;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import com.trilead.ssh2.Connection;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertSame;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class JumpHostPoolTest {
+	private HostDatabase hostdb;
+
+	/** Jump host transport that pretends to connect and authenticate. */
+	private static class FakeSSH extends SSH {
+		final HostBean jumpHost;
+		final Connection connection;
+		boolean succeeds = true;
+		boolean connected;
+		int closes;
+
+		FakeSSH(HostBean jumpHost) {
+			this.jumpHost = jumpHost;
+			connection = new Connection(jumpHost.getHostname(), jumpHost.getPort());
+		}
+
+		@Override
+		public void connect() {
+			connected = succeeds;
+		}
+
+		@Override
+		public boolean isConnected() {
+			return connected;
+		}
+
+		@Override
+		boolean isAuthenticated() {
+			return connected;
+		}
+
+		@Override
+		Connection getConnection() {
+			return connection;
+		}
+
+		@Override
+		public void close() {
+			connected = false;
+			closes++;
+		}
+	}
+
+	/** Pool that records the transports it creates instead of connecting. */
+	private static class FakePool extends JumpHostPool {
+		final List<FakeSSH> transports = new ArrayList<>();
+		boolean succeeds = true;
+
+		FakePool() {
+			super(null);
+		}
+
+		@Override
+		SSH createTransport(HostBean jumpHost, TerminalBridge bridge) {
+			FakeSSH transport = new FakeSSH(jumpHost);
+			transport.succeeds = succeeds;
+			transports.add(transport);
+			return transport;
+		}
+	}
+
+	@Before
+	public void setUp() {
+		hostdb = HostDatabase.get(ApplicationProvider.getApplicationContext());
+		hostdb.resetDatabase();
+	}
+
+	private HostBean addHost(String nickname, long jumpHostId) {
+		HostBean host = new HostBean(nickname, "ssh", "user", nickname + ".example.com", 22);
+		host.setJumpHostId(jumpHostId);
+		return hostdb.saveHost(host);
+	}
+
+	@Test
+	public void directHostIsValid() {
+		HostBean host = addHost("direct", HostDatabase.JUMPHOSTID_NONE);
+		assertTrue(JumpHostPool.isChainValid(hostdb, host));
+	}
+
+	@Test
+	public void chainEndingInDirectHostIsValid() {
+		HostBean bastion = addHost("bastion", HostDatabase.JUMPHOSTID_NONE);
+		HostBean inner = addHost("inner", bastion.getId());
+		HostBean target = addHost("target", inner.getId());
+		assertTrue(JumpHostPool.isChainValid(hostdb, target));
+	}
+
+	@Test
+	public void loopIsRefused() {
+		HostBean a = addHost("a", HostDatabase.JUMPHOSTID_NONE);
+		HostBean b = addHost("b", a.getId());
+		a.setJumpHostId(b.getId());
+		hostdb.saveHost(a);
+
+		assertFalse(JumpHostPool.isChainValid(hostdb, hostdb.findHostById(b.getId())));
+	}
+
+	@Test
+	public void missingJumpHostIsRefused() {
+		HostBean target = addHost("target", 12345);
+		assertFalse(JumpHostPool.isChainValid(hostdb, target));
+	}
+
+	@Test
+	public void chainLongerThanLimitIsRefused() {
+		HostBean host = addHost("h0", HostDatabase.JUMPHOSTID_NONE);
+		for (int i = 1; i <= JumpHostPool.MAX_CHAIN_LENGTH; i++)
+			host = addHost("h" + i, host.getId());
+		assertTrue(JumpHostPool.isChainValid(hostdb, host));
+
+		host = addHost("too-far", host.getId());
+		assertFalse(JumpHostPool.isChainValid(hostdb, host));
+	}
+
+	@Test
+	public void deletingJumpHostMakesTargetsDirect() {
+		HostBean bastion = addHost("bastion", HostDatabase.JUMPHOSTID_NONE);
+		HostBean target = addHost("target", bastion.getId());
+
+		hostdb.deleteHost(bastion);
+
+		assertEquals(HostDatabase.JUMPHOSTID_NONE,
+				hostdb.findHostById(target.getId()).getJumpHostId());
+	}
+
+	@Test
+	public void hostsBehindSameJumpHostShareOneConnection() {
+		HostBean bastion = addHost("bastion", HostDatabase.JUMPHOSTID_NONE);
+		FakePool pool = new FakePool();
+
+		Connection first = pool.acquire(bastion, new TerminalBridge());
+		Connection second = pool.acquire(bastion, new TerminalBridge());
+
+		assertNotNull(first);
+		assertSame(first, second);
+		assertEquals(1, pool.transports.size());
+	}
+
+	@Test
+	public void jumpHostClosesWhenLastUserReleases() {
+		HostBean bastion = addHost("bastion", HostDatabase.JUMPHOSTID_NONE);
+		FakePool pool = new FakePool();
+		pool.acquire(bastion, new TerminalBridge());
+		pool.acquire(bastion, new TerminalBridge());
+		FakeSSH transport = pool.transports.get(0);
+
+		pool.release(bastion);
+		assertEquals(0, transport.closes);
+		assertTrue(transport.isConnected());
+
+		pool.release(bastion);
+		assertEquals(1, transport.closes);
+
+		// an extra release must not close anything again
+		pool.release(bastion);
+		assertEquals(1, transport.closes);
+	}
+
+	@Test
+	public void acquireAfterLastReleaseConnectsAgain() {
+		HostBean bastion = addHost("bastion", HostDatabase.JUMPHOSTID_NONE);
+		FakePool pool = new FakePool();
+		Connection first = pool.acquire(bastion, new TerminalBridge());
+		pool.release(bastion);
+
+		Connection second = pool.acquire(bastion, new TerminalBridge());
+
+		assertEquals(2, pool.transports.size());
+		assertSame(pool.transports.get(1).connection, second);
+		assertTrue(first != second);
+	}
+
+	@Test
+	public void droppedJumpHostIsReplaced() {
+		HostBean bastion = addHost("bastion", HostDatabase.JUMPHOSTID_NONE);
+		FakePool pool = new FakePool();
+		pool.acquire(bastion, new TerminalBridge());
+		FakeSSH dropped = pool.transports.get(0);
+		dropped.connected = false;
+
+		Connection connection = pool.acquire(bastion, new TerminalBridge());
+
+		assertEquals(2, pool.transports.size());
+		assertSame(pool.transports.get(1).connection, connection);
+		assertEquals(1, dropped.closes);
+
+		// both users now hold the replacement
+		pool.release(bastion);
+		pool.release(bastion);
+		assertEquals(1, pool.transports.get(1).closes);
+	}
+
+	@Test
+	public void failedConnectGivesUpItsReference() {
+		HostBean bastion = addHost("bastion", HostDatabase.JUMPHOSTID_NONE);
+		FakePool pool = new FakePool();
+		pool.succeeds = false;
+
+		assertNull(pool.acquire(bastion, new TerminalBridge()));
+
+		pool.succeeds = true;
+		Connection connection = pool.acquire(bastion, new TerminalBridge());
+		assertSame(pool.transports.get(1).connection, connection);
+
+		pool.release(bastion);
+		assertEquals(1, pool.transports.get(1).closes);
+	}
+
+	@Test
+	public void differentJumpHostsAreSeparate() {
+		HostBean east = addHost("east", HostDatabase.JUMPHOSTID_NONE);
+		HostBean west = addHost("west", HostDatabase.JUMPHOSTID_NONE);
+		FakePool pool = new FakePool();
+
+		Connection a = pool.acquire(east, new TerminalBridge());
+		Connection b = pool.acquire(west, new TerminalBridge());
+		assertTrue(a != b);
+
+		pool.release(east);
+		assertEquals(1, pool.transports.get(0).closes);
+		assertEquals(0, pool.transports.get(1).closes);
+	}
+}
@@ -0,0 +1,117 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.transport;
+
+import java.io.IOException;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertTrue;
+
+@RunWith(AndroidJUnit4.class)
+public class KeepaliveMonitorTest {
+	private static final long INTERVAL = 50;
+	private static final long STALL_TIMEOUT = 100;
+
+	private static class Stalls implements KeepaliveMonitor.StallListener {
+		final CountDownLatch latch = new CountDownLatch(1);
+		final AtomicInteger count = new AtomicInteger();
+
+		@Override
+		public void onStall(long silentMillis) {
+			count.incrementAndGet();
+			latch.countDown();
+		}
+	}
+
+	@Test
+	public void droppedProbeIsReportedQuickly() throws Exception {
+		final CountDownLatch never = new CountDownLatch(1);
+		Stalls stalls = new Stalls();
+		KeepaliveMonitor monitor = new KeepaliveMonitor("dropped", new KeepaliveMonitor.Probe() {
+			@Override
+			public boolean probe() throws IOException {
+				// Like a proxy that swallows the request: no answer ever comes.
+				try {
+					never.await();
+				} catch (InterruptedException e) {
+					throw new IOException(e);
+				}
+				return true;
+			}
+		}, stalls, INTERVAL, INTERVAL, STALL_TIMEOUT);
+
+		monitor.start();
+		try {
+			assertTrue("stall was not reported",
+					stalls.latch.await(1, TimeUnit.SECONDS));
+		} finally {
+			monitor.stop();
+		}
+		assertEquals(1, stalls.count.get());
+	}
+
+	@Test
+	public void failedProbeIsReported() throws Exception {
+		Stalls stalls = new Stalls();
+		KeepaliveMonitor monitor = new KeepaliveMonitor("failed", new KeepaliveMonitor.Probe() {
+			@Override
+			public boolean probe() throws IOException {
+				throw new IOException("Connection timed out");
+			}
+		}, stalls, INTERVAL, INTERVAL, STALL_TIMEOUT);
+
+		monitor.start();
+		try {
+			assertTrue(stalls.latch.await(1, TimeUnit.SECONDS));
+		} finally {
+			monitor.stop();
+		}
+	}
+
+	@Test
+	public void answeredProbesTrackRoundTrip() throws Exception {
+		final CountDownLatch probes = new CountDownLatch(3);
+		Stalls stalls = new Stalls();
+		KeepaliveMonitor monitor = new KeepaliveMonitor("answered", new KeepaliveMonitor.Probe() {
+			@Override
+			public boolean probe() throws IOException {
+				probes.countDown();
+				return true;
+			}
+		}, stalls, INTERVAL, INTERVAL, STALL_TIMEOUT);
+
+		monitor.start();
+		try {
+			assertTrue(probes.await(1, TimeUnit.SECONDS));
+		} finally {
+			monitor.stop();
+		}
+		assertFalse(stalls.latch.getCount() == 0);
+		assertTrue(monitor.getRoundTripTime() >= 0);
+		assertTrue("interval should grow while probes succeed",
+				monitor.getInterval() > INTERVAL);
+	}
+}
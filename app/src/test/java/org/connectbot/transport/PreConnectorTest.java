@@ -0,0 +1,84 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.transport;
+
+import java.util.ArrayList;
+import java.util.List;
+
+import org.connectbot.bean.HostBean;
+import org.connectbot.util.HostDatabase;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import androidx.test.core.app.ApplicationProvider;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+
+@RunWith(AndroidJUnit4.class)
+public class PreConnectorTest {
+	private static HostBean host(String nickname, String protocol, long lastConnect) {
+		HostBean host = new HostBean(nickname, protocol, "user", nickname + ".example.com", 22);
+		host.setLastConnect(lastConnect);
+		return host;
+	}
+
+	@Test
+	public void picksFirstSshHostsUpToLimit() {
+		List<HostBean> recent = new ArrayList<>();
+		recent.add(host("a", "ssh", 50));
+		recent.add(host("b", "telnet", 40));
+		recent.add(host("c", "ssh", 30));
+		recent.add(host("d", "ssh", 20));
+
+		List<HostBean> picked = PreConnector.pickHosts(recent, 2);
+
+		assertEquals(2, picked.size());
+		assertEquals("a", picked.get(0).getNickname());
+		assertEquals("c", picked.get(1).getNickname());
+	}
+
+	@Test
+	public void skipsHostsBehindJumpHost() {
+		List<HostBean> recent = new ArrayList<>();
+		HostBean tunneled = host("tunneled", "ssh", 50);
+		tunneled.setJumpHostId(1);
+		recent.add(tunneled);
+		recent.add(host("direct", "ssh", 40));
+
+		List<HostBean> picked = PreConnector.pickHosts(recent, PreConnector.MAX_HOSTS);
+
+		assertEquals(1, picked.size());
+		assertEquals("direct", picked.get(0).getNickname());
+	}
+
+	@Test
+	public void recentHostsAreNewestFirstAndSinceCutoff() {
+		HostDatabase hostdb = HostDatabase.get(ApplicationProvider.getApplicationContext());
+		hostdb.resetDatabase();
+
+		hostdb.saveHost(host("old", "ssh", 100));
+		hostdb.saveHost(host("newer", "ssh", 300));
+		hostdb.saveHost(host("new", "ssh", 200));
+
+		List<HostBean> recent = hostdb.getRecentHosts(150);
+
+		assertEquals(2, recent.size());
+		assertEquals("newer", recent.get(0).getNickname());
+		assertEquals("new", recent.get(1).getNickname());
+	}
+}
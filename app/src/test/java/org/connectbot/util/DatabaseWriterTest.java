@@ -0,0 +1,101 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import java.util.ArrayList;
+import java.util.List;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import android.database.sqlite.SQLiteDatabase;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+
+/**
+ * @author Kenny Root
+ */
+@RunWith(AndroidJUnit4.class)
+public class DatabaseWriterTest {
+	private SQLiteDatabase db;
+	private DatabaseWriter writer;
+	private List<String> applied;
+
+	@Before
+	public void setUp() {
+		db = SQLiteDatabase.create(null);
+		db.execSQL("CREATE TABLE t (k TEXT PRIMARY KEY, v INTEGER)");
+		writer = DatabaseWriter.get();
+		writer.flush();
+		applied = new ArrayList<>();
+	}
+
+	@After
+	public void tearDown() {
+		writer.flush();
+		db.close();
+	}
+
+	private DatabaseWriter.Write put(final String key, final int value) {
+		return new DatabaseWriter.Write() {
+			@Override
+			public void apply(SQLiteDatabase db) {
+				applied.add(key + "=" + value);
+				db.execSQL("INSERT OR REPLACE INTO t (k, v) VALUES (?, ?)",
+						new Object[] { key, value });
+			}
+		};
+	}
+
+	@Test
+	public void sameKey_CoalescesToLastWrite() {
+		for (int i = 0; i < 10; i++)
+			writer.enqueue(db, "a", put("a", i));
+
+		assertEquals(1, writer.getPendingCount());
+		writer.flush();
+
+		assertEquals(1, applied.size());
+		assertEquals("a=9", applied.get(0));
+		assertEquals(9, db.compileStatement("SELECT v FROM t WHERE k = 'a'").simpleQueryForLong());
+	}
+
+	@Test
+	public void differentKeys_AppliedInOrderOfLastWrite() {
+		writer.enqueue(db, "a", put("a", 1));
+		writer.enqueue(db, "b", put("b", 2));
+		writer.enqueue(db, "a", put("a", 3));
+		writer.flush();
+
+		assertEquals(2, applied.size());
+		assertEquals("b=2", applied.get(0));
+		assertEquals("a=3", applied.get(1));
+	}
+
+	@Test
+	public void flush_EmptiesQueue() {
+		writer.enqueue(db, "a", put("a", 1));
+		writer.flush();
+		assertEquals(0, writer.getPendingCount());
+
+		writer.flush();
+		assertEquals(1, applied.size());
+	}
+}
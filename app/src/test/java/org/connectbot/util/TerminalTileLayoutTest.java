@@ -0,0 +1,138 @@
+/*
+ * ConnectBot: simple, powerful, open-source SSH client for Android
+ * Copyright 2007 Kenny Root, Jeffrey Sharkey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package org.connectbot.util;
+
+import org.connectbot.TerminalView;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import android.graphics.Rect;
+import android.view.View;
+import android.view.View.MeasureSpec;
+import androidx.test.core.app.ApplicationProvider;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+
+import static org.junit.Assert.assertEquals;
+
+@RunWith(AndroidJUnit4.class)
+public class TerminalTileLayoutTest {
+	private CountingTileLayout layout;
+
+	@Before
+	public void setUp() {
+		layout = new CountingTileLayout();
+	}
+
+	@Test
+	public void singleTileFillsTheLayout() {
+		View only = addTile();
+
+		layOut(800, 600);
+
+		assertEquals(new Rect(0, 0, 800, 600), bounds(only));
+	}
+
+	@Test
+	public void twoTilesSplitAlongTheLongerSideAndFollowAResize() {
+		View first = addTile();
+		View second = addTile();
+
+		layOut(1001, 500);
+		assertEquals(new Rect(0, 0, 500, 500), bounds(first));
+		assertEquals(new Rect(501, 0, 1001, 500), bounds(second));
+		assertEquals(500, first.getMeasuredWidth());
+
+		// rotating to portrait stacks them instead
+		layOut(500, 1001);
+		assertEquals(new Rect(0, 0, 500, 500), bounds(first));
+		assertEquals(new Rect(0, 501, 500, 1001), bounds(second));
+		assertEquals(500, second.getMeasuredHeight());
+	}
+
+	@Test
+	public void fourTilesShareAGrid() {
+		View[] tiles = new View[TerminalTileLayout.MAX_TILES];
+		for (int i = 0; i < tiles.length; i++)
+			tiles[i] = addTile();
+
+		layOut(1001, 801);
+
+		assertEquals(new Rect(0, 0, 500, 400), bounds(tiles[0]));
+		assertEquals(new Rect(501, 0, 1001, 400), bounds(tiles[1]));
+		assertEquals(new Rect(0, 401, 500, 801), bounds(tiles[2]));
+		assertEquals(new Rect(501, 401, 1001, 801), bounds(tiles[3]));
+	}
+
+	@Test
+	public void changingTheActiveTileRedrawsTheOutlineOnce() {
+		View first = addTile();
+		View second = addTile();
+		layOut(1001, 500);
+		final int[] changes = new int[1];
+		layout.setOnActiveTileChangedListener(new TerminalTileLayout.OnActiveTileChangedListener() {
+			@Override
+			public void onActiveTileChanged(TerminalView terminal) {
+				changes[0]++;
+			}
+		});
+
+		layout.invalidations = 0;
+		layout.requestChildFocus(second, second);
+		assertEquals(1, layout.invalidations);
+		assertEquals(1, changes[0]);
+
+		// focus moving within the same tile changes nothing
+		layout.requestChildFocus(second, second);
+		assertEquals(1, layout.invalidations);
+		assertEquals(1, changes[0]);
+
+		layout.requestChildFocus(first, first);
+		assertEquals(2, layout.invalidations);
+		assertEquals(2, changes[0]);
+	}
+
+	private View addTile() {
+		View tile = new View(ApplicationProvider.getApplicationContext());
+		layout.addView(tile);
+		return tile;
+	}
+
+	private void layOut(int width, int height) {
+		layout.measure(MeasureSpec.makeMeasureSpec(width, MeasureSpec.EXACTLY),
+				MeasureSpec.makeMeasureSpec(height, MeasureSpec.EXACTLY));
+		layout.layout(0, 0, width, height);
+	}
+
+	private static Rect bounds(View view) {
+		return new Rect(view.getLeft(), view.getTop(), view.getRight(), view.getBottom());
+	}
+
+	private static class CountingTileLayout extends TerminalTileLayout {
+		int invalidations;
+
+		CountingTileLayout() {
+			super(ApplicationProvider.getApplicationContext());
+		}
+
+		@Override
+		public void invalidate() {
+			invalidations++;
+			super.invalidate();
+		}
+	}
+}